@@ -36,11 +36,352 @@
 #include "variant.h"
 #include "list.h"
 #include "image.h"
+#include "os/os.h"
+#include "os/thread.h"
+#include "os/mutex.h"
+#include "hash_map.h"
+#include "oa_hash_map.h"
+#include "object_type_db.h"
+#include "os/worker_thread_pool.h"
 
 namespace TestContainers {
 
+struct DVectorBenchData {
+
+	DVector<int> source;
+	int iterations;
+};
+
+static void _dvector_bench_thread(void *p_ud) {
+
+	DVectorBenchData *bd = (DVectorBenchData*)p_ud;
+
+	for(int i=0;i<bd->iterations;i++) {
+
+		DVector<int> copy = bd->source;
+		DVector<int> copy2 = copy;
+		if (copy2.size()!=bd->source.size()) {
+			ERR_PRINT("DVector copy size mismatch");
+		}
+	}
+}
+
+static uint64_t _dvector_bench(int p_threads,int p_iterations) {
+
+	DVectorBenchData bd;
+	bd.source.resize(256);
+	bd.iterations=p_iterations;
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+
+	Vector<Thread*> threads;
+	for(int i=0;i<p_threads;i++) {
+		threads.push_back(Thread::create(_dvector_bench_thread,&bd));
+	}
+	for(int i=0;i<threads.size();i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+
+	return OS::get_singleton()->get_ticks_usec()-from;
+}
+
+static void test_dvector_refcount() {
+
+	static const int iterations=100000;
+
+	for(int t=1;t<=8;t*=2) {
+
+		Mutex *prev_lock=dvector_lock;
+
+		dvector_lock=Mutex::create();
+		uint64_t locked = _dvector_bench(t,iterations);
+		memdelete(dvector_lock);
+
+		dvector_lock=NULL;
+		uint64_t atomic = _dvector_bench(t,iterations);
+
+		dvector_lock=prev_lock;
+
+		print_line("DVector refcount, "+itos(t)+" threads: locked "+itos(locked/1000)+" msec, atomic "+itos(atomic/1000)+" msec.");
+	}
+}
+
+template<class M>
+static void _hash_map_bench(const String& p_name,int p_elements) {
+
+	M map;
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<p_elements;i++) {
+		map.set(i*7919,i);
+	}
+
+	uint64_t insert_time = OS::get_singleton()->get_ticks_usec()-from;
+	from = OS::get_singleton()->get_ticks_usec();
+
+	int found=0;
+	for(int j=0;j<8;j++) {
+		for(int i=0;i<p_elements*2;i++) {
+			if (map.getptr(i*7919))
+				found++;
+		}
+	}
+
+	uint64_t lookup_time = OS::get_singleton()->get_ticks_usec()-from;
+	from = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<p_elements;i+=2) {
+		map.erase(i*7919);
+	}
+
+	uint64_t erase_time = OS::get_singleton()->get_ticks_usec()-from;
+
+	if (found!=p_elements*8 || (int)map.size()!=p_elements/2) {
+		ERR_PRINT("Hash map results mismatch");
+	}
+
+	print_line(p_name+": insert "+itos(insert_time)+" usec, lookup "+itos(lookup_time)+" usec, erase "+itos(erase_time)+" usec.");
+}
+
+static void test_hash_maps() {
+
+	static const int elements=100000;
+
+	_hash_map_bench< HashMap<int,int> >("HashMap",elements);
+	_hash_map_bench< OAHashMap<int,int> >("OAHashMap",elements);
+}
+
+class _SignalBenchListener : public Object {
+
+	OBJ_TYPE(_SignalBenchListener,Object);
+public:
+
+	int calls;
+	Object *source;
+	bool disconnect_on_call;
+
+	void _on_signal(int p_value) {
+
+		calls+=p_value;
+		if (disconnect_on_call && source->is_connected("bench",this,"_on_signal"))
+			source->disconnect("bench",this,"_on_signal");
+	}
+
+	static void _bind_methods() {
+
+		ObjectTypeDB::bind_method(_MD("_on_signal"),&_SignalBenchListener::_on_signal);
+	}
+
+	_SignalBenchListener() { calls=0; source=NULL; disconnect_on_call=false; }
+};
+
+static void test_signals() {
+
+	static const int listeners=100;
+	static const int emissions=10000;
+
+	ObjectTypeDB::register_type<_SignalBenchListener>();
+
+	Object *source = memnew( Object );
+	source->add_user_signal(MethodInfo("bench",PropertyInfo(Variant::INT,"value")));
+
+	Vector<_SignalBenchListener*> targets;
+	for(int i=0;i<listeners;i++) {
+
+		_SignalBenchListener *l = memnew( _SignalBenchListener );
+		l->source=source;
+		source->connect("bench",l,"_on_signal");
+		targets.push_back(l);
+	}
+
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<emissions;i++) {
+		source->emit_signal("bench",1);
+	}
+
+	uint64_t emit_time = OS::get_singleton()->get_ticks_usec()-from;
+
+	print_line("Signals: "+itos(emissions)+" emissions to "+itos(listeners)+" listeners in "+itos(emit_time/1000)+" msec.");
+
+	//listeners disconnecting themselves while emitting must still be called once
+	for(int i=0;i<listeners;i+=2) {
+		targets[i]->disconnect_on_call=true;
+	}
+
+	source->emit_signal("bench",1);
+	source->emit_signal("bench",1);
+
+	int total=0;
+	for(int i=0;i<listeners;i++) {
+		total+=targets[i]->calls;
+	}
+
+	if (total!=listeners*emissions+listeners+listeners/2) {
+		ERR_PRINT("Signal call count mismatch");
+	}
+
+	for(int i=0;i<listeners;i++) {
+		memdelete(targets[i]);
+	}
+
+	memdelete(source);
+}
+
+struct WorkerPoolTestData {
+
+	SafeRefCount *hits; // start at 1, so one run of each index leaves 2
+	SafeRefCount first_done; // jobs of the first group that finished, plus one
+	int *seen; // first_done as seen by each job of the dependent group
+	WorkerThreadPool *pool;
+};
+
+static void _worker_pool_count(void *p_ud,int p_from,int p_to) {
+
+	WorkerPoolTestData *td = (WorkerPoolTestData*)p_ud;
+	for(int i=p_from;i<p_to;i++) {
+		td->hits[i].ref();
+	}
+}
+
+static void _worker_pool_first(void *p_ud,int p_from,int p_to) {
+
+	WorkerPoolTestData *td = (WorkerPoolTestData*)p_ud;
+	OS::get_singleton()->delay_usec(100); // give the dependent group a chance to start too early
+	td->first_done.ref();
+}
+
+static void _worker_pool_dependent(void *p_ud,int p_from,int p_to) {
+
+	WorkerPoolTestData *td = (WorkerPoolTestData*)p_ud;
+	td->seen[p_from]=td->first_done.get();
+}
+
+static void _worker_pool_nested(void *p_ud,int p_from,int p_to) {
+
+	WorkerPoolTestData *td = (WorkerPoolTestData*)p_ud;
+	for(int i=p_from;i<p_to;i++) {
+		//every outer index counts its own block of 64 inner ones
+		td->pool->parallel_for(i*64,(i+1)*64,_worker_pool_count,td,1);
+	}
+}
+
+static void _worker_pool_nested_groups(void *p_ud,int p_from,int p_to) {
+
+	WorkerPoolTestData *td = (WorkerPoolTestData*)p_ud;
+	for(int i=p_from;i<p_to;i++) {
+		//same blocks, but waiting on a group whose jobs are only queued once another one is done
+		WorkerThreadPool::Group *first = td->pool->group_create();
+		WorkerThreadPool::Group *dependent = td->pool->group_create();
+		td->pool->group_add_dependency(dependent,first);
+		for(int j=0;j<64;j+=8) {
+			td->pool->group_add_task(first,_worker_pool_count,td,i*64+j,i*64+j+4);
+			td->pool->group_add_task(dependent,_worker_pool_count,td,i*64+j+4,i*64+j+8);
+		}
+		td->pool->group_commit(dependent);
+		td->pool->group_commit(first);
+		td->pool->group_wait(dependent);
+		td->pool->group_wait(first);
+	}
+}
+
+static bool _worker_pool_check_hits(WorkerPoolTestData *td,int p_count) {
+
+	for(int i=0;i<p_count;i++) {
+		if (td->hits[i].get()!=2)
+			return false;
+	}
+	return true;
+}
+
+static void test_worker_thread_pool() {
+
+	WorkerThreadPool *pool = WorkerThreadPool::get_singleton();
+	bool own_pool = !pool;
+	if (own_pool)
+		pool = memnew( WorkerThreadPool(4) );
+
+	static const int elements=100000;
+	static const int first_jobs=64;
+	static const int outer=256; // more outer jobs than workers, so they all end up waiting
+
+	WorkerPoolTestData td;
+	td.hits=memnew_arr(SafeRefCount,elements);
+	td.seen=memnew_arr(int,first_jobs);
+	td.first_done.init();
+	td.pool=pool;
+
+	bool ok=true;
+
+	//every index exactly once
+	for(int i=0;i<elements;i++)
+		td.hits[i].init();
+
+	pool->parallel_for(0,elements,_worker_pool_count,&td);
+
+	if (!_worker_pool_check_hits(&td,elements)) {
+		ERR_PRINT("WorkerThreadPool: parallel_for did not run every index exactly once");
+		ok=false;
+	}
+
+	//a group must not start before the one it depends on is done
+	WorkerThreadPool::Group *first = pool->group_create();
+	WorkerThreadPool::Group *dependent = pool->group_create();
+	pool->group_add_dependency(dependent,first);
+	for(int i=0;i<first_jobs;i++) {
+		pool->group_add_task(first,_worker_pool_first,&td,i,i+1);
+		pool->group_add_task(dependent,_worker_pool_dependent,&td,i,i+1);
+	}
+	pool->group_commit(dependent);
+	pool->group_commit(first);
+	pool->group_wait(first);
+	pool->group_wait(dependent);
+
+	for(int i=0;i<first_jobs;i++) {
+		if (td.seen[i]!=first_jobs+1) {
+			ERR_PRINT("WorkerThreadPool: group ran before its dependency was done");
+			ok=false;
+			break;
+		}
+	}
+
+	//nested parallel_for from inside jobs
+	for(int i=0;i<outer*64;i++)
+		td.hits[i].init();
+
+	pool->parallel_for(0,outer,_worker_pool_nested,&td);
+
+	if (!_worker_pool_check_hits(&td,outer*64)) {
+		ERR_PRINT("WorkerThreadPool: nested parallel_for did not run every index exactly once");
+		ok=false;
+	}
+
+	for(int i=0;i<outer*64;i++)
+		td.hits[i].init();
+
+	pool->parallel_for(0,outer,_worker_pool_nested_groups,&td);
+
+	if (!_worker_pool_check_hits(&td,outer*64)) {
+		ERR_PRINT("WorkerThreadPool: nested dependent groups did not run every index exactly once");
+		ok=false;
+	}
+
+	print_line(String("WorkerThreadPool: ")+(ok?"OK":"FAILED")+", "+itos(pool->get_worker_count())+" workers.");
+
+	memdelete_arr(td.hits);
+	memdelete_arr(td.seen);
+	if (own_pool)
+		memdelete(pool);
+}
+
 MainLoop * test() {
 
+	test_dvector_refcount();
+	test_hash_maps();
+	test_signals();
+	test_worker_thread_pool();
+
 
 	/*
 	HashMap<int,int> int_map;
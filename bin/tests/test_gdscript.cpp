@@ -32,6 +32,9 @@
 #include "os/main_loop.h"
 #include "os/os.h"
 #include "os/file_access.h"
+#include "os/dir_access.h"
+#include "os/worker_thread_pool.h"
+#include "globals.h"
 
 #ifdef GDSCRIPT_ENABLED
 
@@ -39,6 +42,7 @@
 #include "modules/gdscript/gd_parser.h"
 #include "modules/gdscript/gd_compiler.h"
 #include "modules/gdscript/gd_script.h"
+#include "modules/gdscript/gd_compiled_script.h"
 
 
 namespace TestGDScript {
@@ -518,10 +522,18 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 
 			switch(code[ip]) {
 
-				case GDFunction::OPCODE_OPERATOR: {
+				case GDFunction::OPCODE_OPERATOR:
+				case GDFunction::OPCODE_OPERATOR_POLY:
+				case GDFunction::OPCODE_OPERATOR_INT:
+				case GDFunction::OPCODE_OPERATOR_REAL: {
 
 					int op = code[ip+1];
-					txt+="op ";
+					if (code[ip]==GDFunction::OPCODE_OPERATOR_INT)
+						txt+="op-int ";
+					else if (code[ip]==GDFunction::OPCODE_OPERATOR_REAL)
+						txt+="op-real ";
+					else
+						txt+="op ";
 
 					String opname = Variant::get_operator_name(Variant::Operator(op));
 
@@ -563,21 +575,21 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					txt+="[\"";
 					txt+=func.get_global_name(code[ip+2]);
 					txt+="\"]=";
-					txt+=DADDR(3);
-					incr+=4;
+					txt+=DADDR(4);
+					incr+=5;
 
 
 				} break;
 				case GDFunction::OPCODE_GET_NAMED: {
 
 					txt+=" get_named ";
-					txt+=DADDR(3);
+					txt+=DADDR(4);
 					txt+="=";
 					txt+=DADDR(1);
 					txt+="[\"";
 					txt+=func.get_global_name(code[ip+2]);
 					txt+="\"]";
-					incr+=4;
+					incr+=5;
 
 				} break;
 				case GDFunction::OPCODE_ASSIGN: {
@@ -679,7 +691,7 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 
 					int argc=code[ip+1];
 					if (ret) {
-						txt+=DADDR(4+argc)+"=";
+						txt+=DADDR(5+argc)+"=";
 					}
 
 					txt+=DADDR(2)+".";
@@ -689,12 +701,12 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					for(int i=0;i<argc;i++) {
 						if (i>0)
 							txt+=", ";
-						txt+=DADDR(4+i);
+						txt+=DADDR(5+i);
 					}
-					txt+=")";
+					txt+=") cache "+itos(code[ip+4]);
 
 
-					incr=5+argc;
+					incr=6+argc;
 
 				} break;
 				case GDFunction::OPCODE_CALL_BUILT_IN: {
@@ -812,6 +824,25 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 					txt+=" for-loop "+DADDR(4)+" in "+DADDR(2)+" counter "+DADDR(1)+" end "+itos(code[ip+3]);
 					incr+=5;
 
+				} break;
+				case GDFunction::OPCODE_ITERATE_RANGE_BEGIN: {
+
+					int argc=code[ip+1];
+					txt+=" for-range-init "+DADDR(6+argc)+" in range(";
+					for(int i=0;i<argc;i++) {
+						if (i>0)
+							txt+=", ";
+						txt+=DADDR(2+i);
+					}
+					txt+=") counter "+DADDR(2+argc)+" left "+DADDR(3+argc)+" step "+DADDR(4+argc)+" end "+itos(code[ip+5+argc]);
+					incr+=7+argc;
+
+				} break;
+				case GDFunction::OPCODE_ITERATE_RANGE: {
+
+					txt+=" for-range-loop "+DADDR(5)+" counter "+DADDR(1)+" left "+DADDR(2)+" step "+DADDR(3)+" end "+itos(code[ip+4]);
+					incr+=6;
+
 				} break;
 				case GDFunction::OPCODE_LINE: {
 
@@ -852,8 +883,132 @@ static void _disassemble_class(const Ref<GDScript>& p_class,const Vector<String>
 	}
 }
 
+static const char *_yield_bench_code=
+	"extends Reference\n"
+	"\n"
+	"func worker(frames):\n"
+	"\tvar acc=0\n"
+	"\tfor i in range(frames):\n"
+	"\t\tacc+=i\n"
+	"\t\tyield()\n"
+	"\treturn acc\n";
+
+static void _yield_bench() {
+
+	//many coroutines alive at once, each resumed once per frame
+	const int coroutines=10000;
+	const int frames=60;
+
+	Ref<GDScript> gds = memnew( GDScript );
+	gds->set_source_code(_yield_bench_code);
+	Error err = gds->reload();
+	ERR_FAIL_COND(err!=OK);
+
+	Ref<Reference> owner = memnew( Reference );
+	owner->set_script(gds.get_ref_ptr());
+
+	for(int batch=0;batch<2;batch++) {
+
+		Array states(true);
+		states.resize(coroutines);
+
+		uint64_t from = OS::get_singleton()->get_ticks_usec();
+		for(int i=0;i<coroutines;i++) {
+			states[i]=owner->call("worker",frames);
+		}
+		uint64_t start_time = OS::get_singleton()->get_ticks_usec()-from;
+
+		uint64_t resume_time=0;
+		uint64_t worst_frame=0;
+		for(int f=0;f<frames;f++) {
+
+			from = OS::get_singleton()->get_ticks_usec();
+			if (batch) {
+				GDFunctionState::resume_batch(states);
+			} else {
+				for(int i=0;i<coroutines;i++) {
+					Ref<GDFunctionState> gdfs = states[i];
+					if (gdfs.is_valid())
+						states[i]=gdfs->resume();
+				}
+			}
+			uint64_t frame_time = OS::get_singleton()->get_ticks_usec()-from;
+			resume_time+=frame_time;
+			worst_frame=MAX(worst_frame,frame_time);
+		}
+
+		print_line(String(batch?"resume_batch":"resume")+": "+itos(coroutines)+" coroutines, start "+itos(start_time)+" usec, frame avg "+itos(resume_time/frames)+" usec, worst "+itos(worst_frame)+" usec");
+	}
+}
+
+static void _find_scripts(const String& p_dir,Vector<String>& r_paths) {
+
+	DirAccess *da = DirAccess::open(p_dir);
+	if (!da)
+		return;
+
+	da->list_dir_begin();
+	String f=da->get_next();
+	while(f!="") {
+
+		if (f!="." && f!="..") {
+
+			if (da->current_is_dir())
+				_find_scripts(p_dir.plus_file(f),r_paths);
+			else if (f.extension()=="gd")
+				r_paths.push_back(p_dir.plus_file(f));
+		}
+		f=da->get_next();
+	}
+	da->list_dir_end();
+	memdelete(da);
+}
+
+static void _load_bench(const String& p_dir) {
+
+	Vector<String> paths;
+	_find_scripts(Globals::get_singleton()->localize_path(p_dir),paths);
+	int workers = WorkerThreadPool::get_singleton() ? WorkerThreadPool::get_singleton()->get_worker_count() : 0;
+	print_line(itos(paths.size())+" scripts, "+itos(workers)+" workers");
+
+	//batch first, once its scripts are freed the serial loads find nothing cached
+	uint64_t from = OS::get_singleton()->get_ticks_usec();
+	Vector<Ref<GDScript> > scripts;
+	GDScriptLanguage::get_singleton()->load_scripts(paths,&scripts);
+	uint64_t batch_time = OS::get_singleton()->get_ticks_usec()-from;
+
+	int valid=0;
+	for(int i=0;i<scripts.size();i++) {
+		if (scripts[i].is_valid() && scripts[i]->is_valid())
+			valid++;
+	}
+
+	//while the batch holds them, loading must find the same instances instead of compiling again
+	for(int i=0;i<scripts.size();i++) {
+
+		RES again = ResourceLoader::load(scripts[i]->get_path());
+		if (again.ptr()!=scripts[i].ptr())
+			print_line("ERROR: "+scripts[i]->get_path()+" was loaded again instead of coming from the cache");
+	}
+	scripts.clear();
+
+	from = OS::get_singleton()->get_ticks_usec();
+	Vector<RES> serial;
+	for(int i=0;i<paths.size();i++)
+		serial.push_back(ResourceLoader::load(paths[i]));
+	uint64_t serial_time = OS::get_singleton()->get_ticks_usec()-from;
+
+	print_line("serial: "+itos(serial_time)+" usec, batch: "+itos(batch_time)+" usec ("+itos(valid)+" valid)");
+}
+
 MainLoop* test(TestType p_test) {
 
+	if (p_test==TEST_YIELD) {
+
+		_yield_bench();
+		return NULL;
+	}
+
 	List<String> cmdlargs = OS::get_singleton()->get_cmdline_args();
 
 	if (cmdlargs.empty()) {
@@ -863,6 +1018,12 @@ MainLoop* test(TestType p_test) {
 
 	String test = cmdlargs.back()->get();
 
+	if (p_test==TEST_LOAD) {
+
+		_load_bench(test);
+		return NULL;
+	}
+
 	FileAccess *fa = FileAccess::open(test,FileAccess::READ);
 
 	if (!fa) {
@@ -1007,6 +1168,133 @@ MainLoop* test(TestType p_test) {
 		FileAccess *fw = FileAccess::open(dst,FileAccess::WRITE);
 		fw->store_buffer(buf.ptr(),buf.size());
 		memdelete(fw);
+	} else if (p_test==TEST_COMPILED) {
+
+		//compare startup cost of compiling tokens against loading the compiled cache
+		Vector<uint8_t> tokens = GDTokenizerBuffer::parse_code_string(code);
+
+		uint64_t from = OS::get_singleton()->get_ticks_usec();
+
+		GDParser parser;
+		Error err = parser.parse_bytecode(tokens,"","");
+		if (err) {
+			print_line("Parse Error:\n"+itos(parser.get_error_line())+":"+itos(parser.get_error_column())+":"+parser.get_error());
+			memdelete(fa);
+			return NULL;
+		}
+
+		Ref<GDScript> gds = memnew( GDScript );
+		GDCompiler gdc;
+		err = gdc.compile(&parser,gds.ptr());
+		if (err) {
+			print_line("Compile Error:\n"+itos(gdc.get_error_line())+":"+itos(gdc.get_error_column())+":"+gdc.get_error());
+			memdelete(fa);
+			return NULL;
+		}
+
+		uint64_t compile_time = OS::get_singleton()->get_ticks_usec()-from;
+
+		Vector<uint8_t> compiled = GDCompiledScript::save(gds,tokens);
+		if (compiled.empty()) {
+			print_line("Script references data that can't be cached.");
+			memdelete(fa);
+			return NULL;
+		}
+
+		from = OS::get_singleton()->get_ticks_usec();
+
+		Ref<GDScript> loaded = memnew( GDScript );
+		err = GDCompiledScript::load(compiled,loaded.ptr());
+
+		uint64_t load_time = OS::get_singleton()->get_ticks_usec()-from;
+
+		if (err) {
+			print_line("Error loading compiled script: "+itos(err));
+			memdelete(fa);
+			return NULL;
+		}
+
+		//caches from the other kind of build or cut short must fall back to tokens, never run
+		Vector<uint8_t> bad=compiled;
+		bad[36]^=1; //build type
+		Ref<GDScript> rejected = memnew( GDScript );
+		if (GDCompiledScript::load(bad,rejected.ptr())==OK)
+			print_line("ERROR: compiled script from another build type was accepted");
+		bad=compiled;
+		bad.resize(bad.size()-4);
+		rejected = Ref<GDScript>( memnew( GDScript ) );
+		if (GDCompiledScript::load(bad,rejected.ptr())==OK)
+			print_line("ERROR: truncated compiled script was accepted");
+
+		print_line("** LOADED CLASS **");
+		_disassemble_class(loaded,lines);
+
+		print_line("tokens: "+itos(tokens.size())+" bytes, compiled: "+itos(compiled.size())+" bytes");
+		print_line("parse+compile: "+itos(compile_time)+" usec, load compiled: "+itos(load_time)+" usec");
+
+		String dst = test.basename()+".gdc";
+		FileAccess *fw = FileAccess::open(dst,FileAccess::WRITE);
+		fw->store_buffer(compiled.ptr(),compiled.size());
+		memdelete(fw);
+	} else if (p_test==TEST_OPTIMIZE) {
+
+		//compile twice, without and with the optimization pass, static bench* functions are timed on both
+		Ref<GDScript> scripts[2];
+		for(int i=0;i<2;i++) {
+
+			GDParser parser;
+			Error err = parser.parse(code);
+			if (err) {
+				print_line("Parse Error:\n"+itos(parser.get_error_line())+":"+itos(parser.get_error_column())+":"+parser.get_error());
+				memdelete(fa);
+				return NULL;
+			}
+
+			scripts[i] = Ref<GDScript>( memnew( GDScript ) );
+			GDCompiler gdc;
+			gdc.set_optimize(i==1);
+			err = gdc.compile(&parser,scripts[i].ptr());
+			if (err) {
+				print_line("Compile Error:\n"+itos(gdc.get_error_line())+":"+itos(gdc.get_error_column())+":"+gdc.get_error());
+				memdelete(fa);
+				return NULL;
+			}
+		}
+
+		const Map<StringName,GDFunction>& plain = scripts[0]->debug_get_member_functions();
+		const Map<StringName,GDFunction>& optimized = scripts[1]->debug_get_member_functions();
+		int plain_size=0;
+		int optimized_size=0;
+
+		for(const Map<StringName,GDFunction>::Element *E=plain.front();E;E=E->next()) {
+
+			const Map<StringName,GDFunction>::Element *O=optimized.find(E->key());
+			if (!O)
+				continue;
+
+			const GDFunction &a=E->get();
+			const GDFunction &b=O->get();
+			plain_size+=a.get_code_size();
+			optimized_size+=b.get_code_size();
+			print_line(String(E->key())+": code "+itos(a.get_code_size())+" -> "+itos(b.get_code_size())+", stack "+itos(a.get_max_stack_size())+" -> "+itos(b.get_max_stack_size()));
+
+			if (!a.is_static() || a.get_argument_count()!=0 || !String(E->key()).begins_with("bench"))
+				continue;
+
+			uint64_t time[2];
+			Variant ret[2];
+			for(int i=0;i<2;i++) {
+
+				Variant::CallError ce;
+				uint64_t from = OS::get_singleton()->get_ticks_usec();
+				ret[i]=static_cast<Object*>(scripts[i].ptr())->call(E->key(),NULL,0,ce);
+				time[i]=OS::get_singleton()->get_ticks_usec()-from;
+			}
+
+			print_line("\t"+itos(time[0])+" usec -> "+itos(time[1])+" usec"+(ret[0]==ret[1]?String():String(", RESULTS DIFFER: ")+String(ret[0])+" vs "+String(ret[1])));
+		}
+
+		print_line("total code: "+itos(plain_size)+" -> "+itos(optimized_size));
 	}
 
 
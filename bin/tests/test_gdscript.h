@@ -38,6 +38,10 @@ enum TestType {
 	TEST_PARSER,
 	TEST_COMPILER,
 	TEST_BYTECODE,
+	TEST_COMPILED,
+	TEST_YIELD,
+	TEST_OPTIMIZE,
+	TEST_LOAD,
 };
 
 MainLoop* test(TestType p_type);
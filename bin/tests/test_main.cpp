@@ -90,11 +90,36 @@ MainLoop* test_main(String p_test,const List<String>& p_args) {
 		return TestPhysics::test();
 	}
 
+	if (p_test=="physics_heightmap") {
+
+		return TestPhysics::test_heightmap();
+	}
+
+	if (p_test=="physics_broadphase") {
+
+		return TestPhysics::test_broadphase();
+	}
+
+	if (p_test=="physics_batch_rays") {
+
+		return TestPhysics::test_batch_rays();
+	}
+
+	if (p_test=="physics_trimesh") {
+
+		return TestPhysics::test_trimesh();
+	}
+
 	if (p_test=="physics_2d") {
 
 		return TestPhysics2D::test();
 	}
 
+	if (p_test=="physics_2d_broadphase") {
+
+		return TestPhysics2D::test_broadphase();
+	}
+
   	if (p_test=="misc") {
 	
 		return TestMisc::test();
@@ -157,6 +182,26 @@ MainLoop* test_main(String p_test,const List<String>& p_args) {
 		return TestGDScript::test(TestGDScript::TEST_BYTECODE);
 	}
 
+	if (p_test=="gd_compiled") {
+
+		return TestGDScript::test(TestGDScript::TEST_COMPILED);
+	}
+
+	if (p_test=="gd_yield") {
+
+		return TestGDScript::test(TestGDScript::TEST_YIELD);
+	}
+
+	if (p_test=="gd_optimize") {
+
+		return TestGDScript::test(TestGDScript::TEST_OPTIMIZE);
+	}
+
+	if (p_test=="gd_load") {
+
+		return TestGDScript::test(TestGDScript::TEST_LOAD);
+	}
+
 	if (p_test=="image") {
 
 		return TestImage::test();
@@ -37,6 +37,10 @@
 #include "map.h"
 #include "os/os.h"
 #include "quick_hull.h"
+#include "servers/physics/body_sw.h"
+#include "servers/physics/broad_phase_octree.h"
+#include "servers/physics/broad_phase_bvh.h"
+#include "servers/physics/shape_sw.h"
 
 class TestPhysicsMainLoop : public MainLoop {
 
@@ -208,7 +212,8 @@ protected:
 		PhysicsServer * ps = PhysicsServer::get_singleton();
 		RID trimesh_shape = ps->shape_create(PhysicsServer::SHAPE_CONCAVE_POLYGON);
 		ps->shape_set_data(trimesh_shape, p_faces);
-		p_faces=ps->shape_get_data(trimesh_shape); // optimized one
+		Dictionary trimesh_data=ps->shape_get_data(trimesh_shape);
+		p_faces=trimesh_data["faces"]; // optimized one
 		Vector<Vector3> normals; // for drawing
 		for (int i=0;i<p_faces.size()/3;i++) {
 
@@ -659,4 +664,449 @@ MainLoop* test() {
 
 }
 
+/* HEIGHTMAP BENCHMARK */
+
+enum {
+	HEIGHTMAP_SIZE=256,
+	HEIGHTMAP_RAYS=20000,
+	HEIGHTMAP_SPHERES=400,
+	HEIGHTMAP_STEPS=240
+};
+
+static float _heightmap_height(int p_x,int p_z) {
+
+	return Math::sin(p_x*0.15)*2.0+Math::cos(p_z*0.1)*3.0+Math::sin((p_x+p_z)*0.05)*4.0;
+}
+
+static void _heightmap_bench_shape(const String& p_name,RID p_shape) {
+
+	PhysicsServer *ps=PhysicsServer::get_singleton();
+
+	RID space=ps->space_create();
+	ps->space_set_active(space,true);
+
+	RID ground=ps->body_create(PhysicsServer::BODY_MODE_STATIC);
+	ps->body_set_space(ground,space);
+	ps->body_add_shape(ground,p_shape);
+
+	/* rays, straight down and slanted, same sequence for every shape */
+
+	PhysicsDirectSpaceState *dss=ps->space_get_direct_state(space);
+	float extent=(HEIGHTMAP_SIZE-1);
+	uint32_t seed=1;
+	int hits=0;
+	double checksum=0;
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<HEIGHTMAP_RAYS;i++) {
+
+		Vector3 from( Math::rand_from_seed(&seed)%10000*extent/10000.0, 50, Math::rand_from_seed(&seed)%10000*extent/10000.0 );
+		Vector3 to=from+Vector3( (i&1)?float(Math::rand_from_seed(&seed)%200)-100:0, -100, (i&1)?float(Math::rand_from_seed(&seed)%200)-100:0 );
+
+		PhysicsDirectSpaceState::RayResult rr;
+		if (dss->intersect_ray(from,to,rr)) {
+			hits++;
+			checksum+=rr.position.y;
+		}
+	}
+
+	uint64_t ray_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	/* spheres dropped on the ground */
+
+	RID sphere=ps->shape_create(PhysicsServer::SHAPE_SPHERE);
+	ps->shape_set_data(sphere,0.5);
+
+	List<RID> spheres;
+	int side=Math::sqrt((double)HEIGHTMAP_SPHERES);
+	for(int i=0;i<HEIGHTMAP_SPHERES;i++) {
+
+		RID b=ps->body_create(PhysicsServer::BODY_MODE_RIGID);
+		ps->body_set_space(b,space);
+		ps->body_add_shape(b,sphere);
+		Vector3 pos( (i%side+0.5)*extent/side, 15, (i/side+0.5)*extent/side );
+		ps->body_set_state(b,PhysicsServer::BODY_STATE_TRANSFORM,Transform(Matrix3(),pos));
+		spheres.push_back(b);
+	}
+
+	begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<HEIGHTMAP_STEPS;i++) {
+		ps->step(1.0/60.0);
+	}
+
+	uint64_t step_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	int fell=0;
+	for(List<RID>::Element *E=spheres.front();E;E=E->next()) {
+
+		Transform t=ps->body_get_state(E->get(),PhysicsServer::BODY_STATE_TRANSFORM);
+		if (t.origin.y < -20)
+			fell++;
+		ps->free(E->get());
+	}
+
+	print_line(p_name+": rays "+itos(ray_usec/1000)+" msec ("+itos(hits)+" hits, checksum "+rtos(checksum)+"), steps "+itos(step_usec/1000)+" msec ("+itos(fell)+" spheres fell through)");
+
+	ps->free(sphere);
+	ps->free(ground);
+	ps->free(space);
+}
+
+MainLoop* test_heightmap() {
+
+	PhysicsServer *ps=PhysicsServer::get_singleton();
+
+	DVector<float> heights;
+	heights.resize(HEIGHTMAP_SIZE*HEIGHTMAP_SIZE);
+	{
+		DVector<float>::Write w=heights.write();
+		for(int i=0;i<HEIGHTMAP_SIZE;i++) {
+			for(int j=0;j<HEIGHTMAP_SIZE;j++) {
+				w[i*HEIGHTMAP_SIZE+j]=_heightmap_height(j,i);
+			}
+		}
+	}
+
+	// the same surface as a triangle mesh, two triangles per cell wound like the heightmap's
+	DVector<Vector3> faces;
+	faces.resize((HEIGHTMAP_SIZE-1)*(HEIGHTMAP_SIZE-1)*6);
+	{
+		DVector<Vector3>::Write w=faces.write();
+		int idx=0;
+		for(int i=0;i<HEIGHTMAP_SIZE-1;i++) {
+			for(int j=0;j<HEIGHTMAP_SIZE-1;j++) {
+
+				Vector3 v00( j, _heightmap_height(j,i), i );
+				Vector3 v10( j+1, _heightmap_height(j+1,i), i );
+				Vector3 v01( j, _heightmap_height(j,i+1), i+1 );
+				Vector3 v11( j+1, _heightmap_height(j+1,i+1), i+1 );
+				w[idx++]=v00; w[idx++]=v10; w[idx++]=v01;
+				w[idx++]=v10; w[idx++]=v11; w[idx++]=v01;
+			}
+		}
+	}
+
+	Dictionary d;
+	d["width"]=HEIGHTMAP_SIZE;
+	d["depth"]=HEIGHTMAP_SIZE;
+	d["cell_size"]=1.0;
+	d["heights"]=heights;
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+	RID heightmap=ps->shape_create(PhysicsServer::SHAPE_HEIGHTMAP);
+	ps->shape_set_data(heightmap,d);
+	uint64_t heightmap_setup=OS::get_singleton()->get_ticks_usec()-begin;
+
+	begin=OS::get_singleton()->get_ticks_usec();
+	RID trimesh=ps->shape_create(PhysicsServer::SHAPE_CONCAVE_POLYGON);
+	ps->shape_set_data(trimesh,faces);
+	uint64_t trimesh_setup=OS::get_singleton()->get_ticks_usec()-begin;
+
+	print_line("heightmap "+itos(HEIGHTMAP_SIZE)+"x"+itos(HEIGHTMAP_SIZE)+": "+itos(heights.size()*sizeof(float))+" bytes of heights, setup "+itos(heightmap_setup/1000)+" msec");
+	print_line("trimesh: "+itos(faces.size()/3)+" triangles, "+itos(faces.size()*sizeof(Vector3))+" bytes of faces before the BVH, setup "+itos(trimesh_setup/1000)+" msec");
+
+	_heightmap_bench_shape("heightmap",heightmap);
+	_heightmap_bench_shape("trimesh",trimesh);
+
+	ps->free(heightmap);
+	ps->free(trimesh);
+
+	return NULL;
+}
+
+
+/* BROADPHASE BENCHMARK */
+
+enum {
+	BROADPHASE_BODIES=10000,
+	BROADPHASE_STATIC=1000,
+	BROADPHASE_FRAMES=100
+};
+
+#define BROADPHASE_WORLD_SIZE 250.0
+
+struct BroadPhaseBenchPairs {
+
+	int paired;
+	int unpaired;
+};
+
+static void* _broadphase_bench_pair(CollisionObjectSW *A,int p_subindex_A,CollisionObjectSW *B,int p_subindex_B,void *p_self) {
+
+	((BroadPhaseBenchPairs*)p_self)->paired++;
+	return NULL;
+}
+
+static void _broadphase_bench_unpair(CollisionObjectSW *A,int p_subindex_A,CollisionObjectSW *B,int p_subindex_B,void *p_data,void *p_self) {
+
+	((BroadPhaseBenchPairs*)p_self)->unpaired++;
+}
+
+static void _broadphase_bench(const String& p_name,BroadPhaseSW *p_bp) {
+
+	BroadPhaseBenchPairs pairs;
+	pairs.paired=0;
+	pairs.unpaired=0;
+	p_bp->set_pair_callback(_broadphase_bench_pair,&pairs);
+	p_bp->set_unpair_callback(_broadphase_bench_unpair,&pairs);
+
+	/* same boxes and velocities for every broadphase */
+
+	Vector<BodySW*> owners;
+	Vector<BroadPhaseSW::ID> ids;
+	Vector<AABB> boxes;
+	Vector<Vector3> velocities;
+	owners.resize(BROADPHASE_BODIES);
+	ids.resize(BROADPHASE_BODIES);
+	boxes.resize(BROADPHASE_BODIES);
+	velocities.resize(BROADPHASE_BODIES);
+
+	uint32_t seed=1;
+	for(int i=0;i<BROADPHASE_BODIES;i++) {
+
+		Vector3 size( 1+Math::rand_from_seed(&seed)%200/100.0, 1+Math::rand_from_seed(&seed)%200/100.0, 1+Math::rand_from_seed(&seed)%200/100.0 );
+		Vector3 pos( Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0, Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0, Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0 );
+		boxes[i]=AABB(pos,size);
+		if (i<BROADPHASE_STATIC)
+			velocities[i]=Vector3();
+		else
+			velocities[i]=Vector3( Math::rand_from_seed(&seed)%200-100.0, Math::rand_from_seed(&seed)%200-100.0, Math::rand_from_seed(&seed)%200-100.0 )*0.005;
+
+		owners[i]=memnew( BodySW );
+		ids[i]=p_bp->create(owners[i]);
+		p_bp->set_static(ids[i],i<BROADPHASE_STATIC);
+		p_bp->move(ids[i],boxes[i]);
+	}
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+	p_bp->update();
+	uint64_t insert_usec=OS::get_singleton()->get_ticks_usec()-begin;
+	int initial_pairs=pairs.paired;
+
+	begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int f=0;f<BROADPHASE_FRAMES;f++) {
+
+		for(int i=BROADPHASE_STATIC;i<BROADPHASE_BODIES;i++) {
+
+			AABB &box=boxes[i];
+			Vector3 &vel=velocities[i];
+			box.pos+=vel;
+			for(int j=0;j<3;j++) {
+				if ((box.pos[j]<0 && vel[j]<0) || (box.pos[j]>BROADPHASE_WORLD_SIZE && vel[j]>0))
+					vel[j]=-vel[j];
+			}
+			p_bp->move(ids[i],box);
+		}
+
+		p_bp->update();
+	}
+
+	uint64_t frames_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	print_line(p_name+": first update "+itos(insert_usec/1000)+" msec ("+itos(initial_pairs)+" pairs), "+itos(BROADPHASE_FRAMES)+" frames "+itos(frames_usec/1000)+" msec, "+rtos(frames_usec/1000.0/BROADPHASE_FRAMES)+" msec/frame ("+itos(pairs.paired-pairs.unpaired)+" pairs at the end, "+itos(pairs.paired+pairs.unpaired)+" pair changes)");
+
+	for(int i=0;i<BROADPHASE_BODIES;i++) {
+		p_bp->remove(ids[i]);
+		memdelete(owners[i]);
+	}
+}
+
+MainLoop* test_broadphase() {
+
+	// the BVH keeps pairs between fattened aabbs, so it reports more pairs than the octree
+
+	BroadPhaseSW *octree=BroadPhaseOctree::_create();
+	_broadphase_bench("octree",octree);
+	memdelete(octree);
+
+	BroadPhaseSW *bvh=BroadPhaseBVH::_create();
+	_broadphase_bench("bvh",bvh);
+	memdelete(bvh);
+
+	return NULL;
+}
+
+
+/* BATCHED RAY BENCHMARK */
+
+enum {
+	BATCH_RAYS_AGENTS=20000,
+	BATCH_RAYS_BOXES=2000
+};
+
+MainLoop* test_batch_rays() {
+
+	PhysicsServer *ps=PhysicsServer::get_singleton();
+
+	RID space=ps->space_create();
+	ps->space_set_active(space,true);
+
+	RID box=ps->shape_create(PhysicsServer::SHAPE_BOX);
+	ps->shape_set_data(box,Vector3(1,2,1));
+
+	uint32_t seed=1;
+	List<RID> bodies;
+	for(int i=0;i<BATCH_RAYS_BOXES;i++) {
+
+		RID b=ps->body_create(PhysicsServer::BODY_MODE_STATIC);
+		ps->body_set_space(b,space);
+		ps->body_add_shape(b,box);
+		Vector3 pos( Math::rand_from_seed(&seed)%2000/10.0, 2, Math::rand_from_seed(&seed)%2000/10.0 );
+		ps->body_set_state(b,PhysicsServer::BODY_STATE_TRANSFORM,Transform(Matrix3(),pos));
+		bodies.push_back(b);
+	}
+
+	ps->step(1.0/60.0); // let the broadphase pair up
+
+	/* line of sight from agents spread around the map to a few targets, sorted by target like an AI would */
+
+	Vector<PhysicsDirectSpaceState::RayQuery> rays;
+	rays.resize(BATCH_RAYS_AGENTS);
+	for(int i=0;i<BATCH_RAYS_AGENTS;i++) {
+
+		Vector3 target( (i*4/BATCH_RAYS_AGENTS)*50+25, 1.5, 100 );
+		Vector3 agent=target+Vector3( Math::rand_from_seed(&seed)%400/10.0-20, 0, Math::rand_from_seed(&seed)%400/10.0-20 );
+		rays[i].from=agent;
+		rays[i].to=target;
+	}
+
+	PhysicsDirectSpaceState *dss=ps->space_get_direct_state(space);
+
+	Vector<PhysicsDirectSpaceState::RayResult> single_results;
+	Vector<bool> single_hits;
+	single_results.resize(BATCH_RAYS_AGENTS);
+	single_hits.resize(BATCH_RAYS_AGENTS);
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+	for(int i=0;i<BATCH_RAYS_AGENTS;i++) {
+		single_hits[i]=dss->intersect_ray(rays[i].from,rays[i].to,single_results[i]);
+	}
+	uint64_t single_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	Vector<PhysicsDirectSpaceState::RayResult> batch_results;
+	Vector<bool> batch_hits;
+	batch_results.resize(BATCH_RAYS_AGENTS);
+	batch_hits.resize(BATCH_RAYS_AGENTS);
+
+	begin=OS::get_singleton()->get_ticks_usec();
+	int hits=dss->intersect_rays(rays.ptr(),rays.size(),batch_results.ptr(),batch_hits.ptr());
+	uint64_t batch_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	int mismatches=0;
+	for(int i=0;i<BATCH_RAYS_AGENTS;i++) {
+
+		if (single_hits[i]!=batch_hits[i])
+			mismatches++;
+		else if (single_hits[i] && (single_results[i].rid!=batch_results[i].rid || single_results[i].position.distance_to(batch_results[i].position)>0.001))
+			mismatches++;
+	}
+
+	print_line("rays: "+itos(BATCH_RAYS_AGENTS)+", one by one "+itos(single_usec/1000)+" msec, batched "+itos(batch_usec/1000)+" msec, "+itos(hits)+" hits, "+itos(mismatches)+" mismatches");
+
+	for(List<RID>::Element *E=bodies.front();E;E=E->next()) {
+		ps->free(E->get());
+	}
+	ps->free(box);
+	ps->free(space);
+
+	return NULL;
+}
+
+
+/* TRIANGLE MESH BENCHMARK */
+
+enum {
+	TRIMESH_SIZE=708, // 708*708*2 is about a million triangles
+	TRIMESH_QUERIES=100000
+};
+
+static void _trimesh_bench_count(void* p_userdata,ShapeSW *p_convex) {
+
+	(*(int*)p_userdata)++;
+}
+
+static void _trimesh_bench_queries(const String& p_name,const ConcavePolygonShapeSW& p_shape) {
+
+	uint32_t seed=1;
+	int hits=0;
+	real_t checksum=0;
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<TRIMESH_QUERIES;i++) {
+
+		Vector3 from( Math::rand_from_seed(&seed)%10000*TRIMESH_SIZE/10000.0, 20, Math::rand_from_seed(&seed)%10000*TRIMESH_SIZE/10000.0 );
+		Vector3 to=from+Vector3( float(Math::rand_from_seed(&seed)%200)-100, -40, float(Math::rand_from_seed(&seed)%200)-100 );
+
+		Vector3 r,n;
+		if (p_shape.intersect_segment(from,to,r,n)) {
+			hits++;
+			checksum+=r.y;
+		}
+	}
+
+	uint64_t ray_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	int faces=0;
+	begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<TRIMESH_QUERIES;i++) {
+
+		Vector3 pos( Math::rand_from_seed(&seed)%10000*TRIMESH_SIZE/10000.0, 0, Math::rand_from_seed(&seed)%10000*TRIMESH_SIZE/10000.0 );
+		p_shape.cull(AABB(pos-Vector3(1,4,1),Vector3(2,8,2)),_trimesh_bench_count,&faces);
+	}
+
+	uint64_t cull_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	print_line(p_name+": "+itos(TRIMESH_QUERIES)+" segments "+itos(ray_usec/1000)+" msec ("+itos(hits)+" hits, checksum "+rtos(checksum)+"), "+itos(TRIMESH_QUERIES)+" culls "+itos(cull_usec/1000)+" msec ("+itos(faces)+" faces)");
+}
+
+MainLoop* test_trimesh() {
+
+	DVector<Vector3> faces;
+	faces.resize(TRIMESH_SIZE*TRIMESH_SIZE*6);
+	{
+		DVector<Vector3>::Write w=faces.write();
+		int idx=0;
+		for(int i=0;i<TRIMESH_SIZE;i++) {
+			for(int j=0;j<TRIMESH_SIZE;j++) {
+
+				Vector3 v00( j, _heightmap_height(j,i), i );
+				Vector3 v10( j+1, _heightmap_height(j+1,i), i );
+				Vector3 v01( j, _heightmap_height(j,i+1), i+1 );
+				Vector3 v11( j+1, _heightmap_height(j+1,i+1), i+1 );
+				w[idx++]=v00; w[idx++]=v10; w[idx++]=v01;
+				w[idx++]=v10; w[idx++]=v11; w[idx++]=v01;
+			}
+		}
+	}
+
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+	ConcavePolygonShapeSW *built=memnew( ConcavePolygonShapeSW );
+	built->set_data(faces);
+	uint64_t build_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	// what a saved resource would hold
+	Dictionary data=built->get_data();
+	DVector<uint8_t> blob=data["bvh"];
+
+	begin=OS::get_singleton()->get_ticks_usec();
+	ConcavePolygonShapeSW *loaded=memnew( ConcavePolygonShapeSW );
+	loaded->set_data(data);
+	uint64_t load_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	print_line("trimesh: "+itos(faces.size()/3)+" triangles, build "+itos(build_usec/1000)+" msec, load from "+itos(blob.size())+" bytes of BVH "+itos(load_usec/1000)+" msec");
+
+	_trimesh_bench_queries("built",*built);
+	_trimesh_bench_queries("loaded",*loaded);
+
+	memdelete(built);
+	memdelete(loaded);
+
+	return NULL;
+}
+
 }
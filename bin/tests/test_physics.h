@@ -38,6 +38,10 @@
 namespace TestPhysics {
 
 MainLoop* test();
+MainLoop* test_heightmap();
+MainLoop* test_broadphase();
+MainLoop* test_batch_rays();
+MainLoop* test_trimesh();
 
 }
 
@@ -34,6 +34,9 @@
 #include "map.h"
 #include "scene/resources/texture.h"
 #include "os/os.h"
+#include "servers/physics_2d/body_2d_sw.h"
+#include "servers/physics_2d/broad_phase_2d_hash_grid.h"
+#include "test_physics_2d_old_grid.h"
 
 static const unsigned char convex_png[]={
 0x89,0x50,0x4e,0x47,0xd,0xa,0x1a,0xa,0x0,0x0,0x0,0xd,0x49,0x48,0x44,0x52,0x0,0x0,0x0,0x40,0x0,0x0,0x0,0x40,0x8,0x6,0x0,0x0,0x0,0xaa,0x69,0x71,0xde,0x0,0x0,0x0,0x1,0x73,0x52,0x47,0x42,0x0,0xae,0xce,0x1c,0xe9,0x0,0x0,0x0,0x6,0x62,0x4b,0x47,0x44,0x0,0x0,0x0,0x0,0x0,0x0,0xf9,0x43,0xbb,0x7f,0x0,0x0,0x0,0x9,0x70,0x48,0x59,0x73,0x0,0x0,0xb,0x13,0x0,0x0,0xb,0x13,0x1,0x0,0x9a,0x9c,0x18,0x0,0x0,0x0,0x7,0x74,0x49,0x4d,0x45,0x7,0xdb,0x6,0xa,0x3,0x13,0x31,0x66,0xa7,0xac,0x79,0x0,0x0,0x4,0xef,0x49,0x44,0x41,0x54,0x78,0xda,0xed,0x9b,0xdd,0x4e,0x2a,0x57,0x14,0xc7,0xf7,0x1e,0xc0,0x19,0x38,0x32,0x80,0xa,0x6a,0xda,0x18,0xa3,0xc6,0x47,0x50,0x7b,0xa1,0xd9,0x36,0x27,0x7e,0x44,0xed,0x45,0x4d,0x93,0x3e,0x40,0x1f,0x64,0x90,0xf4,0x1,0xbc,0xf0,0xc2,0x9c,0x57,0x30,0x4d,0xbc,0xa8,0x6d,0xc,0x69,0x26,0xb5,0x68,0x8b,0x35,0x7e,0x20,0xb4,0xf5,0x14,0xbf,0x51,0x3c,0x52,0xe,0xc,0xe,0xc8,0xf0,0xb1,0x7a,0x51,0x3d,0xb1,0x9e,0x19,0x1c,0x54,0x70,0x1c,0xdc,0x9,0x17,0x64,0x8,0xc9,0xff,0xb7,0xd6,0x7f,0xcd,0x3f,0x2b,0xd9,0x8,0xbd,0x9c,0xda,0x3e,0xf8,0x31,0xff,0xc,0x0,0x8,0x42,0x88,0x9c,0x9f,0x9f,0xbf,0xa,0x87,0xc3,0xad,0x7d,0x7d,0x7d,0x7f,0x23,0x84,0x78,0x8c,0x31,0xaf,0x55,0x0,0xc6,0xc7,0x14,0x1e,0x8f,0xc7,0xbf,0x38,0x3c,0x3c,0x6c,0x9b,0x9f,0x9f,0x6f,0xb8,0x82,0x9b,0xee,0xe8,0xe8,0xf8,0x12,0x0,0xbe,0xd3,0x2a,0x8,0xfc,0x50,0xd1,0xf9,0x7c,0x9e,0x8a,0x46,0xa3,0x5f,0x9d,0x9e,0x9e,0x7e,0xb2,0xb0,0xb0,0x60,0xe5,0x79,0x1e,0xf1,0xfc,0x7f,0x3a,0x9,0x21,0x88,0x10,0x82,0x26,0x26,0x26,0xde,0x77,0x75,0x75,0x85,0x59,0x96,0xfd,0x5e,0x6b,0x20,0xf0,0x7d,0x85,0x4b,0x92,0xf4,0xfa,0xe0,0xe0,0xe0,0xd3,0xb9,0xb9,0xb9,0x46,0x49,0x92,0xea,0x6f,0xa,0xbf,0x7d,0x8,0x21,0x68,0x70,0x70,0xb0,0x38,0x39,0x39,0x79,0xd6,0xd9,0xd9,0xb9,0xcf,0x30,0xcc,0xa2,0xd6,0xad,0x21,0x2b,0x1c,0x0,0x38,0x41,0x10,0xfc,0xdb,0xdb,0xdb,0x27,0x1e,0x8f,0x27,0x4b,0x8,0x1,0x84,0x90,0xea,0xf,0x21,0x4,0x3c,0x1e,0x4f,0x76,0x67,0x67,0x67,0x3f,0x9f,0xcf,0xff,0x7c,0x5,0xf3,0xd9,0x0,0xe0,0x2,0x81,0xc0,0xa9,0xdb,0xed,0x2e,0x94,0x2b,0x5c,0xe,0xc4,0xca,0xca,0x8a,0x18,0x8d,0x46,0x3,0x0,0xc0,0x69,0x1e,0x4,0x0,0x90,0x48,0x24,0x12,0xe4,0x38,0xee,0x41,0xc2,0x6f,0x43,0xe0,0x38,0xe,0xfc,0x7e,0xbf,0x10,0x8b,0xc5,0xd6,0x35,0xd,0x22,0x9b,0xcd,0x7a,0x96,0x97,0x97,0x33,0xf,0xad,0x7c,0x29,0x10,0x9b,0x9b,0x9b,0xef,0x2e,0x2e,0x2e,0x7e,0xd5,0x1c,0x8,0x0,0x20,0xe1,0x70,0x38,0xfc,0x98,0xd5,0x57,0x2,0xe1,0x76,0xbb,0xf3,0xa1,0x50,0xe8,0x38,0x9b,0xcd,0xfe,0xa2,0x9,0x8,0x0,0x40,0x2e,0x2f,0x2f,0x7d,0x4b,0x4b,0x4b,0xb9,0x4a,0x54,0x5f,0x9,0xc4,0xd2,0xd2,0x92,0xb4,0xb7,0xb7,0xf7,0x36,0x97,0xcb,0x4d,0x3d,0x29,0x8,0x0,0xe0,0x42,0xa1,0xd0,0x71,0xb5,0xc4,0xdf,0xb6,0xc5,0x93,0xe,0x4a,0x0,0x20,0xa9,0x54,0xea,0x37,0xb7,0xdb,0x5d,0xa8,0xa6,0x78,0x39,0x10,0x6b,0x6b,0x6b,0xf1,0x64,0x32,0xb9,0x5a,0x55,0x10,0x0,0xc0,0x6d,0x6c,0x6c,0x9c,0x57,0xbb,0xfa,0x25,0x40,0x14,0x3,0x81,0x40,0x34,0x93,0xc9,0x2c,0x57,0x1c,0x4,0x0,0x90,0x58,0x2c,0xb6,0x5e,0xe9,0xc1,0x77,0x1f,0x10,0x53,0x53,0x53,0x52,0xc5,0x83,0x14,0x0,0x70,0x7e,0xbf,0x5f,0xd0,0x42,0xf5,0x95,0x40,0xf8,0x7c,0xbe,0xcb,0xa3,0xa3,0xa3,0x3f,0x1e,0xbd,0x1b,0x0,0x80,0x1c,0x1f,0x1f,0x87,0xb4,0x56,0xfd,0xaa,0x5,0x29,0x51,0x14,0xbf,0xf5,0xf9,0x7c,0x97,0x5a,0xad,0xbe,0x12,0x88,0xf5,0xf5,0xf5,0xd8,0x83,0x83,0x54,0xb5,0x42,0x8f,0x66,0x83,0x94,0xd6,0xbd,0x5f,0xce,0x7c,0x38,0x3c,0x3c,0xfc,0xb3,0x50,0x28,0xb8,0xcb,0x2,0x1,0x0,0xdc,0xf4,0xf4,0xf4,0xfe,0x73,0x15,0x2f,0x17,0xa4,0x22,0x91,0x48,0x50,0xb5,0x2d,0x0,0x80,0x9b,0x99,0x99,0x79,0xfb,0xdc,0x1,0xc8,0x5,0xa9,0x44,0x22,0xf1,0xfb,0x9d,0x10,0x0,0x80,0x9b,0x9d,0x9d,0xd,0xea,0x5,0xc0,0xad,0xfd,0x43,0x1a,0x0,0xb8,0xdb,0x9a,0xa9,0x8f,0xb6,0xa4,0x46,0xa3,0xa4,0xb7,0xd5,0x37,0xcf,0xf3,0x68,0x75,0x75,0xf5,0x4c,0xee,0x99,0x1c,0x80,0x9c,0x1e,0xf7,0xff,0x16,0x8b,0x45,0x50,0x5,0xa0,0xb7,0xb7,0xb7,0x85,0x10,0xa2,0x2b,0xf1,0x84,0x10,0xd4,0xdf,0xdf,0x6f,0x57,0x3,0x80,0x37,0x18,0xc,0x5,0x3d,0x2,0xa0,0x69,0x3a,0x8b,0x10,0xe2,0x4b,0x2,0xc0,0x18,0xf3,0xc1,0x60,0x70,0x47,0x8f,0x16,0x38,0x3a,0x3a,0x5a,0x93,0x5b,0xc3,0x7f,0x64,0x81,0xba,0xba,0x3a,0x49,0x8f,0x0,0x1a,0x1a,0x1a,0xd4,0xcd,0x0,0x93,0xc9,0xa4,0xcb,0x21,0xe8,0x74,0x3a,0xd5,0x1,0xa0,0x69,0x5a,0x77,0x1d,0x80,0x31,0x2e,0x38,0x9d,0x4e,0xb1,0x66,0x1,0x30,0xc,0x23,0x28,0x3d,0x93,0x9b,0x1,0xb9,0x9a,0x6,0x60,0x36,0x9b,0x75,0xd7,0x1,0x4a,0x21,0xa8,0x26,0x0,0x94,0xa,0x41,0xb2,0x0,0x18,0x86,0xc9,0xe9,0xd,0x80,0x52,0x8,0x92,0x5,0x60,0xb1,0x58,0x74,0x67,0x1,0xa5,0x10,0xa4,0x4,0x40,0x77,0x43,0xd0,0xe1,0x70,0xa8,0x9f,0x1,0x14,0x45,0x1,0x45,0x51,0x79,0x3d,0x1,0x68,0x6e,0x6e,0x4e,0xaa,0x6,0x80,0x10,0x42,0x6,0x83,0x41,0x37,0x36,0x28,0x15,0x82,0x6a,0x2,0x0,0x4d,0xd3,0xa9,0x52,0xcf,0x95,0x0,0xe8,0x66,0xe,0x98,0xcd,0x66,0xa1,0x6c,0x0,0x7a,0x5a,0x8b,0x59,0x2c,0x96,0x64,0xcd,0x2,0xb8,0x2b,0x4,0xe9,0xde,0x2,0x77,0x85,0xa0,0x9a,0xb0,0x40,0xa9,0x10,0xa4,0x8,0xc0,0x64,0x32,0xe9,0x6,0x40,0xa9,0x10,0x54,0xaa,0x3,0x74,0xf3,0x16,0x70,0xb9,0x5c,0xe5,0x3,0xe8,0xe9,0xe9,0x69,0xd5,0xc3,0x66,0x18,0x63,0x5c,0x68,0x6a,0x6a,0x12,0xcb,0x5,0xa0,0x9b,0xd5,0x38,0x4d,0xd3,0x29,0x8a,0xa2,0xa0,0x2c,0x0,0x18,0x63,0x3e,0x14,0xa,0xfd,0x55,0xb,0x21,0x48,0xd1,0x2,0x7a,0x59,0x8d,0xdf,0x1b,0x80,0x1e,0x56,0xe3,0x84,0x10,0x34,0x30,0x30,0x60,0xbb,0xeb,0x77,0x46,0x5,0xef,0x48,0xcf,0x4d,0xec,0x8d,0x99,0x5,0xf5,0xf5,0xf5,0xef,0x46,0x47,0x47,0xb,0x2e,0x97,0xeb,0xbc,0x54,0x8,0x52,0x4,0xc0,0x30,0x8c,0xf4,0x5c,0x4,0x9b,0x4c,0xa6,0xf4,0xf8,0xf8,0xb8,0xc8,0xb2,0x6c,0x32,0x9d,0x4e,0xff,0xd4,0xdd,0xdd,0x7d,0x66,0x34,0x1a,0x8b,0xd7,0x3,0xfd,0xae,0x5b,0x29,0xb2,0x57,0x66,0xb6,0xb6,0xb6,0xde,0xc4,0xe3,0xf1,0x6f,0xae,0xaf,0xc1,0x28,0x5d,0x85,0x79,0x2,0xc1,0x60,0xb5,0x5a,0xa3,0xa3,0xa3,0xa3,0x45,0xab,0xd5,0x9a,0x2a,0x16,0x8b,0x8b,0x6d,0x6d,0x6d,0xef,0xd5,0x8a,0x55,0xd,0x20,0x91,0x48,0xbc,0x3e,0x38,0x38,0xf8,0xda,0x6e,0xb7,0xf7,0x5f,0x5c,0x5c,0xd4,0x7b,0xbd,0xde,0xbc,0x20,0x8,0xcd,0x85,0x42,0x81,0xfe,0xf0,0xae,0xac,0x10,0x98,0x9b,0xd5,0xc5,0x18,0x17,0x59,0x96,0x3d,0x1d,0x19,0x19,0x1,0x96,0x65,0x5,0x8a,0xa2,0x7e,0x6c,0x69,0x69,0x49,0x3d,0x44,0xb0,0x2a,0x0,0x1f,0xcc,0x74,0x75,0x41,0xea,0xfa,0x7b,0x32,0x99,0x64,0x76,0x77,0x77,0x5d,0xe,0x87,0xa3,0x5f,0x14,0xc5,0x57,0x57,0x60,0x5a,0x8b,0xc5,0xa2,0xf1,0xbe,0x50,0x6e,0xa,0x66,0x18,0x26,0x31,0x36,0x36,0x96,0x65,0x59,0x36,0x29,0x49,0x92,0xb7,0xbd,0xbd,0xfd,0x9f,0x72,0xda,0xf9,0xd1,0x1,0xa8,0x1,0x93,0xcf,0xe7,0xa9,0x93,0x93,0x13,0x1b,0x4d,0xd3,0x9f,0xb,0x82,0x60,0xf5,0x7a,0xbd,0xd9,0x54,0x2a,0xe5,0xcc,0x64,0x32,0xe,0xb9,0x6e,0xb9,0x16,0x8c,0x31,0x2e,0xda,0x6c,0xb6,0xc8,0xd0,0xd0,0x10,0x65,0xb3,0xd9,0x92,0x95,0xa8,0x6e,0xc5,0x0,0xa8,0xe9,0x96,0x68,0x34,0x6a,0xdd,0xdf,0xdf,0x6f,0x76,0xb9,0x5c,0x9f,0x89,0xa2,0x58,0xbf,0xb8,0xb8,0x8,0x26,0x93,0x29,0x3b,0x3c,0x3c,0x8c,0xed,0x76,0x7b,0xd2,0x68,0x34,0xfe,0xd0,0xd8,0xd8,0x98,0xae,0xb6,0xe0,0x8a,0x1,0x50,0xb,0xe6,0xa9,0x5,0xbf,0x9c,0x97,0xf3,0xff,0xf3,0x2f,0x6a,0x82,0x7f,0xf6,0x4e,0xca,0x1b,0xf5,0x0,0x0,0x0,0x0,0x49,0x45,0x4e,0x44,0xae,0x42,0x60,0x82
@@ -464,4 +467,165 @@ MainLoop* test() {
 }
 
 
+/* BROADPHASE BENCHMARK */
+
+enum {
+	BROADPHASE_BODIES=11000,
+	BROADPHASE_STATIC=1000,
+	BROADPHASE_LARGE=4, // static, big enough to skip the grid
+	BROADPHASE_FRAMES=100,
+	BROADPHASE_QUERIES=500
+};
+
+#define BROADPHASE_WORLD_SIZE 8000.0
+
+struct BroadPhaseBenchResult {
+
+	int paired;
+	int unpaired;
+	Vector<int> culled; // subindices returned by the queries, sorted per query
+};
+
+static void* _broadphase_bench_pair(CollisionObject2DSW *A,int p_subindex_A,CollisionObject2DSW *B,int p_subindex_B,void *p_self) {
+
+	((BroadPhaseBenchResult*)p_self)->paired++;
+	return NULL;
+}
+
+static void _broadphase_bench_unpair(CollisionObject2DSW *A,int p_subindex_A,CollisionObject2DSW *B,int p_subindex_B,void *p_data,void *p_self) {
+
+	((BroadPhaseBenchResult*)p_self)->unpaired++;
+}
+
+static void _broadphase_bench_add_culled(BroadPhaseBenchResult &r_result,int *p_indices,int p_count) {
+
+	Vector<int> found;
+	found.resize(p_count);
+	for(int i=0;i<p_count;i++)
+		found[i]=p_indices[i];
+	found.sort();
+
+	r_result.culled.push_back(-1); // separator
+	for(int i=0;i<p_count;i++)
+		r_result.culled.push_back(found[i]);
+}
+
+static void _broadphase_bench(const String& p_name,BroadPhase2DSW *p_bp,BroadPhaseBenchResult &r_result) {
+
+	r_result.paired=0;
+	r_result.unpaired=0;
+	r_result.culled.clear();
+	p_bp->set_pair_callback(_broadphase_bench_pair,&r_result);
+	p_bp->set_unpair_callback(_broadphase_bench_unpair,&r_result);
+
+	/* same rects and velocities for every broadphase */
+
+	Vector<Body2DSW*> owners;
+	Vector<BroadPhase2DSW::ID> ids;
+	Vector<Rect2> rects;
+	Vector<Vector2> velocities;
+	owners.resize(BROADPHASE_BODIES);
+	ids.resize(BROADPHASE_BODIES);
+	rects.resize(BROADPHASE_BODIES);
+	velocities.resize(BROADPHASE_BODIES);
+
+	uint32_t seed=1;
+	for(int i=0;i<BROADPHASE_BODIES;i++) {
+
+		Vector2 size( 8+Math::rand_from_seed(&seed)%24, 8+Math::rand_from_seed(&seed)%24 );
+		if (i<BROADPHASE_LARGE)
+			size=Vector2(BROADPHASE_WORLD_SIZE*0.4,BROADPHASE_WORLD_SIZE*0.4);
+		Vector2 pos( Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0, Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0 );
+		rects[i]=Rect2(pos,size);
+		if (i<BROADPHASE_STATIC)
+			velocities[i]=Vector2();
+		else
+			velocities[i]=Vector2( Math::rand_from_seed(&seed)%800-400.0, Math::rand_from_seed(&seed)%800-400.0 )*0.01;
+
+		owners[i]=memnew( Body2DSW );
+		ids[i]=p_bp->create(owners[i],i);
+		p_bp->set_static(ids[i],i<BROADPHASE_STATIC);
+		p_bp->move(ids[i],rects[i]);
+	}
+
+	int initial_pairs=r_result.paired;
+	uint64_t begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int f=0;f<BROADPHASE_FRAMES;f++) {
+
+		for(int i=BROADPHASE_STATIC;i<BROADPHASE_BODIES;i++) {
+
+			Rect2 &rect=rects[i];
+			Vector2 &vel=velocities[i];
+			rect.pos+=vel;
+			if ((rect.pos.x<0 && vel.x<0) || (rect.pos.x>BROADPHASE_WORLD_SIZE && vel.x>0))
+				vel.x=-vel.x;
+			if ((rect.pos.y<0 && vel.y<0) || (rect.pos.y>BROADPHASE_WORLD_SIZE && vel.y>0))
+				vel.y=-vel.y;
+			p_bp->move(ids[i],rect);
+		}
+
+		p_bp->update();
+	}
+
+	uint64_t frames_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	CollisionObject2DSW *results[BROADPHASE_BODIES];
+	int result_indices[BROADPHASE_BODIES];
+
+	begin=OS::get_singleton()->get_ticks_usec();
+
+	for(int i=0;i<BROADPHASE_QUERIES;i++) {
+
+		Vector2 from( Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0, Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0 );
+		Vector2 to( Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0, Math::rand_from_seed(&seed)%10000*BROADPHASE_WORLD_SIZE/10000.0 );
+
+		int count=p_bp->cull_aabb(Rect2(from,Vector2(1,1)).expand(from+(to-from)*0.1),results,BROADPHASE_BODIES,result_indices);
+		_broadphase_bench_add_culled(r_result,result_indices,count);
+		count=p_bp->cull_segment(from,to,results,BROADPHASE_BODIES,result_indices);
+		_broadphase_bench_add_culled(r_result,result_indices,count);
+	}
+
+	uint64_t query_usec=OS::get_singleton()->get_ticks_usec()-begin;
+
+	print_line(p_name+": "+itos(initial_pairs)+" initial pairs, "+itos(BROADPHASE_FRAMES)+" frames "+itos(frames_usec/1000)+" msec, "+rtos(frames_usec/1000.0/BROADPHASE_FRAMES)+" msec/frame ("+itos(r_result.paired-r_result.unpaired)+" pairs at the end, "+itos(r_result.paired+r_result.unpaired)+" pair changes), "+itos(BROADPHASE_QUERIES*2)+" queries "+itos(query_usec/1000)+" msec");
+
+	for(int i=0;i<BROADPHASE_BODIES;i++) {
+		p_bp->remove(ids[i]);
+		memdelete(owners[i]);
+	}
+}
+
+MainLoop* test_broadphase() {
+
+	// 10k bodies moving every frame over a thousand static ones, on the current grid and the one it replaced
+
+	BroadPhaseBenchResult results[2];
+
+	BroadPhase2DSW *grid=BroadPhase2DHashGrid::_create();
+	_broadphase_bench("hash grid",grid,results[0]);
+	memdelete(grid);
+
+	BroadPhase2DSW *old_grid=BroadPhase2DHashGridOld::_create();
+	_broadphase_bench("old hash grid",old_grid,results[1]);
+	memdelete(old_grid);
+
+	if (results[0].paired!=results[1].paired || results[0].unpaired!=results[1].unpaired)
+		print_line("ERROR: pair/unpair counts differ from the old grid");
+	if (results[0].culled.size()!=results[1].culled.size())
+		print_line("ERROR: cull results differ from the old grid");
+	else {
+		for(int i=0;i<results[0].culled.size();i++) {
+			if (results[0].culled[i]!=results[1].culled[i]) {
+				print_line("ERROR: cull results differ from the old grid");
+				break;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+
 }
@@ -35,6 +35,7 @@
 namespace TestPhysics2D {
 
 MainLoop* test();
+MainLoop* test_broadphase();
 
 }
 
@@ -37,14 +37,23 @@
 */
 
 
+/*
+	The reference count is stored at the head of the allocated block as a
+	SafeRefCount, so reference() and unreference() are atomic and don't need a
+	global lock. If dvector_lock is set, every refcount change is also
+	serialized through it (the old behavior, kept around for comparison).
+*/
+
 extern Mutex* dvector_lock;
 
 template<class T>
 class DVector {
 
 	mutable MID mem;
-		
-		
+
+	_FORCE_INLINE_ static SafeRefCount* _get_refcount(MID_Lock& p_lock) { return (SafeRefCount*)p_lock.data(); }
+	_FORCE_INLINE_ static T* _get_data(MID_Lock& p_lock) { return (T*)((int*)p_lock.data()+1); }
+
 	void copy_on_write() {
 		
 		if (!mem.is_valid())
@@ -55,8 +64,9 @@ class DVector {
 					
 		MID_Lock lock( mem );
 		
+		SafeRefCount *rc = _get_refcount(lock);
 
-		if ( *(int*)lock.data()  == 1 ) {
+		if ( rc->get() == 1 ) {
 			// one reference, means no refcount changes
 			if (dvector_lock)
 				dvector_lock->unlock();
@@ -74,13 +84,11 @@ class DVector {
 		
 		MID_Lock dst_lock( new_mem );
 		
-		int *rc = (int*)dst_lock.data();
+		_get_refcount(dst_lock)->init();
 		
-		*rc=1;
+		T * dst = _get_data(dst_lock);
 		
-		T * dst = (T*)(rc + 1 );
-		
-		T * src =(T*) ((int*)lock.data() + 1 );
+		T * src = _get_data(lock);
 		
 		int count = (mem.get_size() - sizeof(int)) / sizeof(T);
 		
@@ -89,7 +97,13 @@ class DVector {
 			memnew_placement( &dst[i], T(src[i]) );
 		}
 		
-		(*(int*)lock.data())--;
+		if (rc->unref()) {
+			// other owners released it while copying, destruct the old elements
+			for (int i=0;i<count;i++) {
+
+				src[i].~T();
+			}
+		}
 		
 		// unlock all
 		dst_lock=MID_Lock();
@@ -118,8 +132,7 @@ class DVector {
 		
 		MID_Lock lock(p_dvector.mem);
 		
-		int * rc = (int*)lock.data();
-		(*rc)++;
+		_get_refcount(lock)->ref();
 		
 		lock = MID_Lock();
 		mem=p_dvector.mem;
@@ -144,13 +157,10 @@ class DVector {
 		
 		MID_Lock lock(mem);
 		
-		int * rc = (int*)lock.data();
-		(*rc)--;
-		
-		if (*rc==0) {
+		if (_get_refcount(lock)->unref()) {
 			// no one else using it, destruct
 			
-			T * t= (T*)(rc+1);
+			T * t= _get_data(lock);
 			int count = (mem.get_size() - sizeof(int)) / sizeof(T);
 			
 			for (int i=0;i<count;i++) {
@@ -373,8 +383,7 @@ Error DVector<T>::resize(int p_size) {
 
 			mem = dynalloc( p_size * sizeof(T) + sizeof(int) );
 			lock=MID_Lock(mem);
-			int *rc = ((int*)lock.data());
-			*rc=1;
+			_get_refcount(lock)->init();
 			
 		} else {
 
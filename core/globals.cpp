@@ -383,6 +383,10 @@ bool Globals::has(String p_var) const {
 	
 	_THREAD_SAFE_METHOD_
 
+	//a name nobody interned can't be a setting, don't intern it just to miss
+	if (!StringName::find_unique_pointer(p_var))
+		return false;
+
 	return props.has(p_var);
 }
 
@@ -1297,8 +1301,13 @@ void Globals::add_singleton(const Singleton &p_singleton) {
 
 Object* Globals::get_singleton_object(const String& p_name) const {
 
+	//singleton names are held alive, so comparing unique pointers is enough
+	const void *name_ptr = StringName::find_unique_pointer(p_name);
+	if (!name_ptr)
+		return NULL;
+
 	for(const List<Singleton>::Element *E=singletons.front();E;E=E->next()) {
-		if (E->get().name == p_name) {
+		if (E->get().name.get_data_unique_pointer() == name_ptr) {
 			return E->get().ptr;
 		};
 	};
@@ -1477,6 +1486,7 @@ Globals::Globals() {
 	custom_prop_info["render/mipmap_policy"]=PropertyInfo(Variant::INT,"render/mipmap_policy",PROPERTY_HINT_ENUM,"Allow,Allow For Po2,Disallow");
 	custom_prop_info["render/thread_model"]=PropertyInfo(Variant::INT,"render/thread_model",PROPERTY_HINT_ENUM,"Single-Unsafe,Single-Safe,Multi-Threaded");
 	custom_prop_info["physics_2d/thread_model"]=PropertyInfo(Variant::INT,"physics_2d/thread_model",PROPERTY_HINT_ENUM,"Single-Unsafe,Single-Safe,Multi-Threaded");
+	custom_prop_info["physics/thread_model"]=PropertyInfo(Variant::INT,"physics/thread_model",PROPERTY_HINT_ENUM,"Single-Unsafe,Single-Safe,Multi-Threaded");
 	set("display/emulate_touchscreen",false);
 
 	using_datapack=false;
@@ -0,0 +1,479 @@
+/*************************************************************************/
+/*  oa_hash_map.h                                                        */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef OA_HASH_MAP_H
+#define OA_HASH_MAP_H
+
+#include "hash_map.h"
+
+/**
+ * @class OAHashMap
+ *
+ * Open addressing variant of HashMap, with the same API. Keys and data are stored inline in a
+ * single array and collisions are resolved with Robin Hood linear probing, so lookups don't chase
+ * pointers and inserts don't allocate unless the table grows. Erasing uses backward shift, so no
+ * tombstones are left behind.
+ *
+ * Unlike HashMap, pointers returned by getptr() or operator[] are only valid until the next
+ * insertion or erase, as elements move around the table.
+ *
+ * @param TKey  Key, search is based on it, needs to be hasheable. It is unique in this container.
+ * @param TData Data, data associated with the key
+ * @param Hasher Hasher object, needs to provide a valid static hash function for TKey
+ * @param MIN_HASH_TABLE_POWER Miminum size of the hash table, as a power of two.
+ * @param MAX_LOAD_PERCENT Load factor (in percent) at which the table is grown.
+ *
+*/
+
+template<class TKey, class TData, class Hasher=HashMapHahserDefault,uint8_t MIN_HASH_TABLE_POWER=3,uint8_t MAX_LOAD_PERCENT=80>
+class OAHashMap {
+public:
+
+	struct Pair {
+
+		TKey key;
+		TData data;
+
+		Pair() {}
+		Pair(const TKey& p_key, const TData& p_data) { key=p_key; data=p_data; }
+	};
+
+private:
+
+	enum {
+		EMPTY_HASH=0,
+		INVALID_POS=0xFFFFFFFF
+	};
+
+	uint32_t *hashes;
+	Pair *pairs;
+	uint32_t capacity;
+	uint32_t elements;
+
+	static _FORCE_INLINE_ uint32_t _fix_hash(uint32_t p_hash) {
+
+		return p_hash==EMPTY_HASH ? EMPTY_HASH+1 : p_hash;
+	}
+
+	static _FORCE_INLINE_ uint32_t _hash(const TKey& p_key) {
+
+		return _fix_hash( Hasher::hash( p_key ) );
+	}
+
+	_FORCE_INLINE_ uint32_t _get_probe_length(uint32_t p_pos, uint32_t p_hash) const {
+
+		uint32_t ideal = p_hash&(capacity-1);
+		return (p_pos-ideal+capacity)&(capacity-1);
+	}
+
+	template<class C>
+	_FORCE_INLINE_ uint32_t _find_pos(const C& p_key, uint32_t p_hash) const {
+
+		if (!hashes)
+			return INVALID_POS;
+
+		uint32_t mask = capacity-1;
+		uint32_t pos = p_hash&mask;
+		uint32_t distance = 0;
+
+		while(true) {
+
+			uint32_t h = hashes[pos];
+
+			if (h==EMPTY_HASH)
+				return INVALID_POS;
+
+			/* an element closer to its home than we are means the key isn't here */
+			if (distance > _get_probe_length(pos,h))
+				return INVALID_POS;
+
+			/* checking hash first avoids comparing key, which may take longer */
+			if (h==p_hash && pairs[pos].key==p_key)
+				return pos;
+
+			pos=(pos+1)&mask;
+			distance++;
+		}
+
+		return INVALID_POS;
+	}
+
+	/* inserts a key known not to be in the table, returns the position it landed on */
+	uint32_t _insert(uint32_t p_hash, const TKey& p_key, const TData& p_data) {
+
+		uint32_t mask = capacity-1;
+		uint32_t hash = p_hash;
+		Pair pair(p_key,p_data);
+		uint32_t pos = hash&mask;
+		uint32_t distance = 0;
+		uint32_t result = INVALID_POS;
+
+		while(true) {
+
+			if (hashes[pos]==EMPTY_HASH) {
+
+				memnew_placement(&pairs[pos],Pair(pair));
+				hashes[pos]=hash;
+				elements++;
+				return result==INVALID_POS ? pos : result;
+			}
+
+			/* robin hood: take the place of elements that are richer (closer to home) */
+			uint32_t existing_distance = _get_probe_length(pos,hashes[pos]);
+			if (existing_distance < distance) {
+
+				SWAP(hash,hashes[pos]);
+				SWAP(pair,pairs[pos]);
+				distance=existing_distance;
+				if (result==INVALID_POS)
+					result=pos;
+			}
+
+			pos=(pos+1)&mask;
+			distance++;
+		}
+
+		return INVALID_POS;
+	}
+
+	void _resize(uint32_t p_capacity) {
+
+		uint32_t old_capacity = capacity;
+		uint32_t *old_hashes = hashes;
+		Pair *old_pairs = pairs;
+
+		capacity = p_capacity;
+		elements = 0;
+		hashes = (uint32_t*)memalloc( sizeof(uint32_t)*capacity );
+		pairs = (Pair*)memalloc( sizeof(Pair)*capacity );
+
+		for(uint32_t i=0;i<capacity;i++) {
+			hashes[i]=EMPTY_HASH;
+		}
+
+		if (!old_hashes)
+			return;
+
+		for(uint32_t i=0;i<old_capacity;i++) {
+
+			if (old_hashes[i]==EMPTY_HASH)
+				continue;
+
+			_insert(old_hashes[i],old_pairs[i].key,old_pairs[i].data);
+			old_pairs[i].~Pair();
+		}
+
+		memfree(old_hashes);
+		memfree(old_pairs);
+	}
+
+	_FORCE_INLINE_ static uint32_t _capacity_for(uint32_t p_elements) {
+
+		uint32_t c = 1<<MIN_HASH_TABLE_POWER;
+		while( (uint64_t)p_elements*100 > (uint64_t)c*MAX_LOAD_PERCENT ) {
+			c<<=1;
+		}
+		return c;
+	}
+
+	_FORCE_INLINE_ void _check_grow() {
+
+		if (!hashes) {
+			_resize(1<<MIN_HASH_TABLE_POWER);
+		} else if ( (uint64_t)(elements+1)*100 > (uint64_t)capacity*MAX_LOAD_PERCENT ) {
+			_resize(capacity<<1);
+		}
+	}
+
+	void copy_from(const OAHashMap& p_map) {
+
+		if (&p_map==this)
+			return;
+
+		clear();
+
+		if (!p_map.hashes)
+			return;
+
+		capacity = p_map.capacity;
+		elements = p_map.elements;
+		hashes = (uint32_t*)memalloc( sizeof(uint32_t)*capacity );
+		pairs = (Pair*)memalloc( sizeof(Pair)*capacity );
+
+		for(uint32_t i=0;i<capacity;i++) {
+
+			hashes[i]=p_map.hashes[i];
+			if (hashes[i]!=EMPTY_HASH)
+				memnew_placement(&pairs[i],Pair(p_map.pairs[i]));
+		}
+	}
+
+public:
+
+	void set( const TKey& p_key, const TData& p_data ) {
+
+		uint32_t hash = _hash(p_key);
+		uint32_t pos = _find_pos(p_key,hash);
+
+		if (pos!=INVALID_POS) {
+			pairs[pos].data=p_data;
+			return;
+		}
+
+		_check_grow();
+		_insert(hash,p_key,p_data);
+	}
+
+	void set( const Pair& p_pair ) {
+
+		set(p_pair.key,p_pair.data);
+	}
+
+	bool has( const TKey& p_key ) const {
+
+		return _find_pos(p_key,_hash(p_key))!=INVALID_POS;
+	}
+
+	/**
+	 * Get a key from data, return a const reference.
+	 * WARNING: this doesn't check errors, use either getptr and check NULL, or check
+	 * first with has(key)
+	 */
+
+	const TData& get( const TKey& p_key ) const {
+
+		const TData* res = getptr(p_key);
+		ERR_FAIL_COND_V(!res,*res);
+		return *res;
+	}
+
+	TData& get( const TKey& p_key )  {
+
+		TData* res = getptr(p_key);
+		ERR_FAIL_COND_V(!res,*res);
+		return *res;
+	}
+
+	_FORCE_INLINE_ TData* getptr( const TKey& p_key ) {
+
+		uint32_t pos = _find_pos(p_key,_hash(p_key));
+		if (pos==INVALID_POS)
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	_FORCE_INLINE_ const TData* getptr( const TKey& p_key ) const {
+
+		uint32_t pos = _find_pos(p_key,_hash(p_key));
+		if (pos==INVALID_POS)
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	/**
+	 * Same as getptr, but takes a hash and a custom key (that should support operator==()).
+	 */
+
+	template<class C>
+	_FORCE_INLINE_ TData* custom_getptr( C p_custom_key,uint32_t p_custom_hash ) {
+
+		uint32_t pos = _find_pos(p_custom_key,_fix_hash(p_custom_hash));
+		if (pos==INVALID_POS)
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	template<class C>
+	_FORCE_INLINE_ const TData* custom_getptr( C p_custom_key,uint32_t p_custom_hash ) const {
+
+		uint32_t pos = _find_pos(p_custom_key,_fix_hash(p_custom_hash));
+		if (pos==INVALID_POS)
+			return NULL;
+		return &pairs[pos].data;
+	}
+
+	/**
+	 * Erase an item, return true if erasing was succesful
+	 */
+
+	bool erase( const TKey& p_key ) {
+
+		uint32_t pos = _find_pos(p_key,_hash(p_key));
+		if (pos==INVALID_POS)
+			return false;
+
+		/* backward shift the following displaced elements, so no tombstone is needed */
+		uint32_t mask = capacity-1;
+		uint32_t next = (pos+1)&mask;
+
+		while(hashes[next]!=EMPTY_HASH && _get_probe_length(next,hashes[next])!=0) {
+
+			hashes[pos]=hashes[next];
+			pairs[pos]=pairs[next];
+			pos=next;
+			next=(next+1)&mask;
+		}
+
+		hashes[pos]=EMPTY_HASH;
+		pairs[pos].~Pair();
+		elements--;
+
+		return true;
+	}
+
+	inline const TData& operator[](const TKey& p_key) const { //constref
+
+		return get(p_key);
+	}
+
+	inline TData& operator[](const TKey& p_key ) { //assignment
+
+		uint32_t hash = _hash(p_key);
+		uint32_t pos = _find_pos(p_key,hash);
+
+		if (pos==INVALID_POS) {
+			_check_grow();
+			pos=_insert(hash,p_key,TData());
+		}
+
+		return pairs[pos].data;
+	}
+
+	/**
+	 * Get the next key to p_key, and the first key if p_key is null.
+	 * Returns a pointer to the next key if found, NULL otherwise.
+	 * Adding/Removing elements while iterating will, of course, have unexpected results, don't do it.
+	 */
+
+	const TKey* next(const TKey* p_key) const {
+
+		if (!hashes)
+			return NULL;
+
+		uint32_t from=0;
+
+		if (p_key) {
+			/* keys live inside the pair array, so the position can be computed directly */
+			from = ( (const uint8_t*)p_key - (const uint8_t*)&pairs[0].key ) / sizeof(Pair);
+			ERR_FAIL_COND_V( from>=capacity || hashes[from]==EMPTY_HASH, NULL ); /* invalid key supplied */
+			from++;
+		}
+
+		for(uint32_t i=from;i<capacity;i++) {
+
+			if (hashes[i]!=EMPTY_HASH)
+				return &pairs[i].key;
+		}
+
+		return NULL; /* nothing found */
+	}
+
+	inline unsigned int size() const {
+
+		return elements;
+	}
+
+	inline bool empty() const {
+
+		return elements==0;
+	}
+
+	/**
+	 * Make room for at least p_elements without growing the table again.
+	 */
+
+	void reserve(uint32_t p_elements) {
+
+		uint32_t new_capacity = _capacity_for(p_elements);
+		if (new_capacity>capacity)
+			_resize(new_capacity);
+	}
+
+	void clear() {
+
+		if (hashes) {
+
+			for(uint32_t i=0;i<capacity;i++) {
+
+				if (hashes[i]!=EMPTY_HASH)
+					pairs[i].~Pair();
+			}
+
+			memfree(hashes);
+			memfree(pairs);
+		}
+
+		hashes=NULL;
+		pairs=NULL;
+		capacity=0;
+		elements=0;
+	}
+
+	void get_key_list(List<TKey> *p_keys) const {
+
+		if (!hashes)
+			return;
+
+		for(uint32_t i=0;i<capacity;i++) {
+
+			if (hashes[i]!=EMPTY_HASH)
+				p_keys->push_back(pairs[i].key);
+		}
+	}
+
+	void operator=(const OAHashMap& p_map) {
+
+		copy_from(p_map);
+	}
+
+	OAHashMap() {
+
+		hashes=NULL;
+		pairs=NULL;
+		capacity=0;
+		elements=0;
+	}
+
+	OAHashMap(const OAHashMap& p_map) {
+
+		hashes=NULL;
+		pairs=NULL;
+		capacity=0;
+		elements=0;
+
+		copy_from(p_map);
+	}
+
+	~OAHashMap() {
+
+		clear();
+	}
+
+};
+
+#endif
@@ -38,19 +38,6 @@
 
 #ifdef DEBUG_ENABLED
 
-struct _ObjectDebugLock {
-
-	Object *obj;
-
-	_ObjectDebugLock(Object *p_obj) {
-		obj=p_obj;
-		obj->_lock_index.ref();
-	}
-	~_ObjectDebugLock() {
-		obj->_lock_index.unref();
-	}
-};
-
 #define OBJ_DEBUG_LOCK _ObjectDebugLock _debug_lock(this);
 
 #else
@@ -1080,7 +1067,7 @@ bool Object::_has_user_signal(const StringName& p_name) const {
 struct _ObjectSignalDisconnectData {
 
 	StringName signal;
-	Object *target;
+	ObjectID target;
 	StringName method;
 
 };
@@ -1145,57 +1132,91 @@ void Object::emit_signal(const StringName& p_name,VARIANT_ARG_DECLARE) {
 
 	List<_ObjectSignalDisconnectData> disconnect_data;
 
+	//slots are called in place, without copying them. Disconnecting while emitting only marks
+	//the slot as removed (it's erased when the outermost emission is done) and slots connected
+	//while emitting are skipped, so the slots seen by this emission never change under it.
+	//Targets disconnect themselves when deleted, so the cached target pointer is valid as long
+	//as the slot was not removed.
 
-	//copy on write will ensure that disconnecting the signal or even deleting the object will not affect the signal calling.
-	//this happens automatically and will not change the performance of calling.
-	//awesome, isn't it?
-	VMap<Signal::Target,Signal::Slot> slot_map = s->slot_map;
+	_EmitGuard guard;
+	guard.deleted=false;
+	guard.prev=_emit_guard;
+	_emit_guard=&guard;
 
-	int ssize = slot_map.size();
+	uint32_t serial = s->connect_serial;
+	s->lock++;
 
-	OBJ_DEBUG_LOCK
+#ifdef DEBUG_ENABLED
+	//like OBJ_DEBUG_LOCK, but released by hand since the emitter may not be there anymore
+	_lock_index.ref();
+#endif
 
-	for(int i=0;i<ssize;i++) {
+	for(int i=0;i<s->slot_map.size();i++) {
 
-		const Connection &c = slot_map.getv(i).conn;
-		VARIANT_ARGPTRS
+		const Signal::Slot &slot = s->slot_map.getv(i);
 
-		Object *target;
-#ifdef DEBUG_ENABLED
-		target = ObjectDB::get_instance(slot_map.getk(i)._id);
-		ERR_CONTINUE(!target);
-#else
-		target=c.target;
-#endif
+		if (slot.removed || slot.serial>=serial)
+			continue;
+
+		const Connection &c = slot.conn;
+		Object *target = c.target;
+		Signal::Target key = s->slot_map.getk(i);
+		uint32_t flags = c.flags;
 
+		VARIANT_ARGPTRS
 
+		//keep a reference to the binds, in case the slot is replaced while calling
+		Vector<Variant> binds;
 		int bind_count=c.binds.size();
-		int bind=0;
 
-		for(int i=0;bind < bind_count && i<VARIANT_ARG_MAX;i++) {
+		if (bind_count) {
 
-			if (argptr[i]->get_type()==Variant::NIL) {
-				argptr[i]=&c.binds[bind];
-				bind++;
+			binds=c.binds;
+			int bind=0;
+
+			for(int j=0;bind < bind_count && j<VARIANT_ARG_MAX;j++) {
+
+				if (argptr[j]->get_type()==Variant::NIL) {
+					argptr[j]=&binds[bind];
+					bind++;
+				}
 			}
 		}
 
-		if (c.flags&CONNECT_DEFERRED) {
-			MessageQueue::get_singleton()->push_call(target->get_instance_ID(),c.method,VARIANT_ARGPTRS_PASS);
+		if (flags&CONNECT_DEFERRED) {
+			MessageQueue::get_singleton()->push_call(key._id,key.method,VARIANT_ARGPTRS_PASS);
 		} else {
-			target->call( c.method, VARIANT_ARGPTRS_PASS );
+			target->call( key.method, VARIANT_ARGPTRS_PASS );
 		}
 
-		if (c.flags&CONNECT_ONESHOT) {
+		if (guard.deleted) {
+			//this object was deleted by the target, nothing else can be touched
+			return;
+		}
+
+		if (flags&CONNECT_ONESHOT) {
 			_ObjectSignalDisconnectData dd;
 			dd.signal=p_name;
-			dd.target=target;
-			dd.method=c.method;
+			dd.target=key._id;
+			dd.method=key.method;
 			disconnect_data.push_back(dd);
 		}
 
+		//slots may have been connected before this one while calling, find it again
+		if (i>=s->slot_map.size() || s->slot_map.getk(i)._id!=key._id || s->slot_map.getk(i).method!=key.method)
+			i=s->slot_map.find(key);
 	}
 
+#ifdef DEBUG_ENABLED
+	_lock_index.unref();
+#endif
+
+	_emit_guard=guard.prev;
+	s->lock--;
+
+	if (s->lock==0 && s->removed_count)
+		_purge_removed_slots(p_name,s);
+
 #if 0
 
 	//old (deprecated and dangerous code)
@@ -1244,13 +1265,31 @@ void Object::emit_signal(const StringName& p_name,VARIANT_ARG_DECLARE) {
 	while (!disconnect_data.empty()) {
 
 		const _ObjectSignalDisconnectData &dd = disconnect_data.front()->get();
-		disconnect(dd.signal,dd.target,dd.method);
+		Object *target = ObjectDB::get_instance(dd.target);
+		if (target && is_connected(dd.signal,target,dd.method))
+			disconnect(dd.signal,target,dd.method);
 		disconnect_data.pop_front();
 	}
 
 }
 
 
+void Object::_purge_removed_slots(const StringName& p_signal,Signal *p_s) {
+
+	for(int i=p_s->slot_map.size()-1;i>=0;i--) {
+
+		if (p_s->slot_map.getv(i).removed)
+			p_s->slot_map.erase(p_s->slot_map.getk(i));
+	}
+
+	p_s->removed_count=0;
+
+	if (p_s->slot_map.empty() && ObjectTypeDB::has_signal(get_type_name(),p_signal )) {
+		//not user signal, delete
+		signal_map.erase(p_signal);
+	}
+}
+
 void Object::_add_user_signal(const String& p_name, const Array& p_args) {
 
 	// this version of add_user_signal is meant to be used from scripts or external apis
@@ -1334,7 +1373,8 @@ void Object::get_all_signal_connections(List<Connection> *p_connections) const {
 
 		for(int i=0;i<s->slot_map.size();i++) {
 
-			p_connections->push_back(s->slot_map.getv(i).conn);
+			if (!s->slot_map.getv(i).removed)
+				p_connections->push_back(s->slot_map.getv(i).conn);
 		}
 	}
 
@@ -1346,8 +1386,11 @@ void Object::get_signal_connection_list(const StringName& p_signal,List<Connecti
 	if (!s)
 		return; //nothing
 
-	for(int i=0;i<s->slot_map.size();i++)
-		p_connections->push_back(s->slot_map.getv(i).conn);
+	for(int i=0;i<s->slot_map.size();i++) {
+
+		if (!s->slot_map.getv(i).removed)
+			p_connections->push_back(s->slot_map.getv(i).conn);
+	}
 
 }
 
@@ -1372,7 +1415,8 @@ Error Object::connect(const StringName& p_signal, Object *p_to_object, const Str
 	}
 
 	Signal::Target target(p_to_object->get_instance_ID(),p_to_method);
-	if (s->slot_map.has(target)) {
+	int existing = s->slot_map.find(target);
+	if (existing!=-1 && !s->slot_map.getv(existing).removed) {
 		ERR_EXPLAIN("Signal '"+p_signal+"'' already connected to given method '"+p_to_method+"' in that object.");
 		ERR_FAIL_COND_V(s->slot_map.has(target),ERR_INVALID_PARAMETER);
 	}
@@ -1388,7 +1432,15 @@ Error Object::connect(const StringName& p_signal, Object *p_to_object, const Str
 	conn.binds=p_binds;
 	slot.conn=conn;
 	slot.cE=p_to_object->connections.push_back(conn);
-	s->slot_map[target]=slot;
+	slot.serial=s->connect_serial++;
+
+	if (existing!=-1) {
+		//was disconnected while emitting and not erased yet, reuse it
+		s->removed_count--;
+		s->slot_map.getv(existing)=slot;
+	} else {
+		s->slot_map[target]=slot;
+	}
 
 	return OK;
 }
@@ -1407,7 +1459,8 @@ bool Object::is_connected(const StringName& p_signal, Object *p_to_object, const
 
 	Signal::Target target(p_to_object->get_instance_ID(),p_to_method);
 
-	return s->slot_map.has(target);
+	int idx = s->slot_map.find(target);
+	return idx!=-1 && !s->slot_map.getv(idx).removed;
 	//const Map<Signal::Target,Signal::Slot>::Element *E = s->slot_map.find(target);
 	//return (E!=NULL);
 
@@ -1421,19 +1474,25 @@ void Object::disconnect(const StringName& p_signal, Object *p_to_object, const S
 		ERR_EXPLAIN("Nonexistent signal: "+p_signal);
 		ERR_FAIL_COND(!s);
 	}
-	if (s->lock>0) {
-		ERR_EXPLAIN("Attempt to disconnect signal '"+p_signal+"' while emitting (locks: "+itos(s->lock)+")");
-		ERR_FAIL_COND(s->lock>0);
-	}
-
 	Signal::Target target(p_to_object->get_instance_ID(),p_to_method);
 
-	if (!s->slot_map.has(target)) {
+	int idx = s->slot_map.find(target);
+	if (idx==-1 || s->slot_map.getv(idx).removed) {
 		ERR_EXPLAIN("Disconnecting nonexistent signal '"+p_signal+"', slot: "+itos(target._id)+":"+target.method);
 		ERR_FAIL();
 	}
-	int prev = p_to_object->connections.size();
-	p_to_object->connections.erase(s->slot_map[target].cE);
+
+	Signal::Slot &slot = s->slot_map.getv(idx);
+	p_to_object->connections.erase(slot.cE);
+
+	if (s->lock>0) {
+		//emitting, erase it when done
+		slot.removed=true;
+		slot.cE=NULL;
+		s->removed_count++;
+		return;
+	}
+
 	s->slot_map.erase(target);
 
 	if (s->slot_map.empty() && ObjectTypeDB::has_signal(get_type_name(),p_signal )) {
@@ -1712,6 +1771,7 @@ Object::Object() {
 	
 	_type_ptr=NULL;
 	_block_signals=false;
+	_emit_guard=NULL;
 	_predelete_ok=0;
 	_instance_ID=0;
 	_instance_ID = ObjectDB::add_instance(this);
@@ -1740,6 +1800,12 @@ Object::~Object() {
 		memdelete(script_instance);
 	script_instance=NULL;
 
+	//emissions in progress from this object must stop
+	for(_EmitGuard *g=_emit_guard;g;g=g->prev) {
+		g->deleted=true;
+	}
+	_emit_guard=NULL;
+
 
 	List<Connection> sconnections;
 	const StringName *S=NULL;
@@ -1748,12 +1814,10 @@ Object::~Object() {
 
 		Signal *s=&signal_map[*S];
 
-		ERR_EXPLAIN("Attempt to delete an object in the middle of a signal emission from it");
-		ERR_CONTINUE(s->lock>0);
-
 		for(int i=0;i<s->slot_map.size();i++) {
 
-			sconnections.push_back(s->slot_map.getv(i).conn);
+			if (!s->slot_map.getv(i).removed)
+				sconnections.push_back(s->slot_map.getv(i).conn);
 		}
 	}
 
@@ -1789,9 +1853,9 @@ void postinitialize_handler(Object *p_object) {
 	p_object->_postinitialize();
 }
 
-HashMap<uint32_t,Object*> ObjectDB::instances;
+OAHashMap<uint32_t,Object*> ObjectDB::instances;
 uint32_t ObjectDB::instance_counter=1;
-HashMap<Object*,ObjectID,ObjectDB::ObjectPtrHash> ObjectDB::instance_checks;
+OAHashMap<Object*,ObjectID,ObjectDB::ObjectPtrHash> ObjectDB::instance_checks;
 uint32_t ObjectDB::add_instance(Object *p_object) {
 
 	GLOBAL_LOCK_FUNCTION;
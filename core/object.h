@@ -34,6 +34,7 @@
 #include "set.h"
 #include "map.h"
 #include "vmap.h"
+#include "oa_hash_map.h"
 
 #define VARIANT_ARG_LIST const Variant& p_arg1=Variant(),const Variant& p_arg2=Variant(),const Variant& p_arg3=Variant(),const Variant& p_arg4=Variant(),const Variant& p_arg5=Variant()
 #define VARIANT_ARG_PASS p_arg1,p_arg2,p_arg3,p_arg4,p_arg5
@@ -363,15 +364,26 @@ friend void postinitialize_handler(Object*);
 
 			Connection conn;
 			List<Connection>::Element *cE;
+			uint32_t serial; // connection order, emissions skip slots connected after they started
+			bool removed; // disconnected while emitting, erased once the emission is done
+			Slot() { cE=NULL; serial=0; removed=false; }
 		};
 
 		MethodInfo user;
 		VMap<Target,Slot> slot_map;
 		int lock;
-		Signal() { lock=0; }
+		int removed_count;
+		uint32_t connect_serial;
+		Signal() { lock=0; removed_count=0; connect_serial=0; }
 
 	};
 
+	struct _EmitGuard {
+
+		bool deleted;
+		_EmitGuard *prev;
+	};
+
 
 	HashMap< StringName, Signal, StringNameHasher> signal_map;
 	List<Connection> connections;
@@ -379,6 +391,7 @@ friend void postinitialize_handler(Object*);
 	SafeRefCount _lock_index;
 #endif
 	bool _block_signals;
+	_EmitGuard *_emit_guard; // emissions in progress, told if the object gets deleted
 	int _predelete_ok;
 	Set<Object*> change_receptors;
 	uint32_t _instance_ID;
@@ -397,6 +410,7 @@ friend void postinitialize_handler(Object*);
 	void _add_user_signal(const String& p_name, const Array& p_pargs=Array());
 	bool _has_user_signal(const StringName& p_name) const;
 	Variant _emit_signal(const Variant** p_args, int p_argcount, Variant::CallError& r_error);
+	void _purge_removed_slots(const StringName& p_signal,Signal *p_s);
 	Array _get_signal_list() const;
 	Array _get_signal_connection_list(const String& p_signal) const;
 	void _set_bind(const String& p_set,const Variant& p_value);
@@ -630,6 +644,23 @@ public:
 bool predelete_handler(Object *p_object);
 void postinitialize_handler(Object *p_object);
 
+#ifdef DEBUG_ENABLED
+
+struct _ObjectDebugLock {
+
+	Object *obj;
+
+	_ObjectDebugLock(Object *p_obj) {
+		obj=p_obj;
+		obj->_lock_index.ref();
+	}
+	~_ObjectDebugLock() {
+		obj->_lock_index.unref();
+	}
+};
+
+#endif
+
 class ObjectDB {
 
 	struct ObjectPtrHash {
@@ -645,8 +676,8 @@ class ObjectDB {
 		}
 	};
 
-	static HashMap<uint32_t,Object*> instances;
-	static HashMap<Object*,ObjectID,ObjectPtrHash> instance_checks;
+	static OAHashMap<uint32_t,Object*> instances;
+	static OAHashMap<Object*,ObjectID,ObjectPtrHash> instance_checks;
 
 	static uint32_t instance_counter;
 friend class Object;	
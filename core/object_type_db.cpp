@@ -719,6 +719,31 @@ bool ObjectTypeDB::get_property(Object* p_object,const StringName& p_property, V
 }
 
 
+bool ObjectTypeDB::get_property_binds(const StringName& p_type,const StringName& p_property,MethodBind **r_setter,MethodBind **r_getter,int *r_index) {
+
+	//resolves a property the same way set_property and get_property do, so callers can skip the lookup next time
+	TypeInfo *type=types.getptr(p_type);
+	TypeInfo *check=type;
+	bool shadowed=false;
+	while(check) {
+		const PropertySetGet *psg = check->property_setget.getptr(p_property);
+		if (psg) {
+
+			*r_setter = psg->setter ? psg->_setptr : NULL;
+			*r_getter = (psg->getter && !shadowed) ? psg->_getptr : NULL;
+			*r_index = psg->index;
+			return true;
+		}
+
+		if (check->constant_map.has(p_property))
+			shadowed=true; //get_property returns the constant before any inherited property
+
+		check=check->inherits_ptr;
+	}
+
+	return false;
+}
+
 void ObjectTypeDB::set_method_flags(StringName p_type,StringName p_method,int p_flags) {
 
 	TypeInfo *type=types.getptr(p_type);
@@ -122,8 +122,8 @@ class ObjectTypeDB {
 	struct TypeInfo {
 		
 		TypeInfo *inherits_ptr;
-		HashMap<StringName,MethodBind*,StringNameHasher> method_map;
-		HashMap<StringName,int,StringNameHasher> constant_map;
+		OAHashMap<StringName,MethodBind*,StringNameHasher> method_map;
+		OAHashMap<StringName,int,StringNameHasher> constant_map;
 		HashMap<StringName,MethodInfo,StringNameHasher> signal_map;
 		List<PropertyInfo> property_list;
 #ifdef DEBUG_METHODS_ENABLED
@@ -458,6 +458,7 @@ public:
 	static void get_property_list(StringName p_type,List<PropertyInfo> *p_list,bool p_no_inheritance=false);
 	static bool set_property(Object* p_object,const StringName& p_property, const Variant& p_value);
 	static bool get_property(Object* p_object,const StringName& p_property, Variant& r_value);
+	static bool get_property_binds(const StringName& p_type,const StringName& p_property,MethodBind **r_setter,MethodBind **r_getter,int *r_index);
 
 
 
@@ -51,7 +51,8 @@ public:
 	struct Settings {
 		
 		Priority priority;
-		Settings() { priority=PRIORITY_NORMAL; }
+		int stack_size; ///< in bytes, 0 for the platform default
+		Settings() { priority=PRIORITY_NORMAL; stack_size=0; }
 	};
 	
 
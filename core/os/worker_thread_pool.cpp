@@ -0,0 +1,467 @@
+/*************************************************************************/
+/*  worker_thread_pool.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "worker_thread_pool.h"
+#include "os/os.h"
+#include "os/memory.h"
+
+WorkerThreadPool *WorkerThreadPool::singleton=NULL;
+
+WorkerThreadPool *WorkerThreadPool::get_singleton() {
+
+	return singleton;
+}
+
+WorkerThreadPool::Group::Group() {
+
+	pending.init();
+	blocked.init();
+	finished=false;
+	done=Semaphore::create();
+	next_free=NULL;
+}
+
+WorkerThreadPool::Group::~Group() {
+
+	if (done)
+		memdelete(done);
+}
+
+/* JobDeque */
+
+void WorkerThreadPool::JobDeque::push_back(const Job& p_job) {
+
+	lock->lock();
+
+	if (tail-head==capacity) {
+
+		int new_capacity = capacity ? capacity*2 : 64;
+		Job *new_jobs = memnew_arr(Job,new_capacity);
+		for(int i=head;i<tail;i++) {
+			new_jobs[i-head]=jobs[i&(capacity-1)];
+		}
+		if (jobs)
+			memdelete_arr(jobs);
+		jobs=new_jobs;
+		tail-=head;
+		head=0;
+		capacity=new_capacity;
+	}
+
+	jobs[tail&(capacity-1)]=p_job;
+	tail++;
+
+	lock->unlock();
+}
+
+bool WorkerThreadPool::JobDeque::pop_back(Job& r_job) {
+
+	lock->lock();
+
+	if (head==tail) {
+		lock->unlock();
+		return false;
+	}
+
+	tail--;
+	r_job=jobs[tail&(capacity-1)];
+
+	lock->unlock();
+	return true;
+}
+
+bool WorkerThreadPool::JobDeque::pop_front(Job& r_job) {
+
+	lock->lock();
+
+	if (head==tail) {
+		lock->unlock();
+		return false;
+	}
+
+	r_job=jobs[head&(capacity-1)];
+	head++;
+
+	lock->unlock();
+	return true;
+}
+
+WorkerThreadPool::JobDeque::JobDeque() {
+
+	lock=Mutex::create();
+	jobs=NULL;
+	capacity=0;
+	head=0;
+	tail=0;
+}
+
+WorkerThreadPool::JobDeque::~JobDeque() {
+
+	if (jobs)
+		memdelete_arr(jobs);
+	memdelete(lock);
+}
+
+/* Pool */
+
+int WorkerThreadPool::_get_worker_index() const {
+
+	if (worker_count==0)
+		return -1;
+
+	Thread::ID id = Thread::get_caller_ID();
+	for(int i=0;i<worker_count;i++) {
+
+		if (workers[i].id==id)
+			return i;
+	}
+
+	return -1;
+}
+
+void WorkerThreadPool::_push_job(const Job& p_job) {
+
+	int idx = _get_worker_index();
+
+	if (idx<0) {
+		// not a worker, spread the jobs among the workers
+		idx = worker_count ? int(uint32_t(next_deque.refval())%uint32_t(worker_count)) : worker_count;
+	}
+
+	deques[idx].push_back(p_job);
+
+	if (worker_count)
+		work_semaphore->post();
+}
+
+bool WorkerThreadPool::_pop_job(int p_worker,Job& r_job) {
+
+	if (p_worker>=0 && deques[p_worker].pop_back(r_job))
+		return true;
+
+	int deque_count = worker_count+1;
+	int from = p_worker>=0 ? p_worker+1 : 0;
+
+	for(int i=0;i<deque_count;i++) {
+
+		int idx = (from+i)%deque_count;
+		if (idx==p_worker)
+			continue;
+		if (deques[idx].pop_front(r_job))
+			return true;
+	}
+
+	return false;
+}
+
+void WorkerThreadPool::_run_job(int p_worker,const Job& p_job) {
+
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+
+	p_job.func(p_job.userdata,p_job.from,p_job.to);
+
+	uint64_t end = OS::get_singleton()->get_ticks_usec();
+
+	if (p_worker>=0) {
+		workers[p_worker].busy_usec+=end-begin;
+		workers[p_worker].jobs_run++;
+	}
+
+	if (instrumentation_func)
+		instrumentation_func(instrumentation_userdata,p_worker,begin,end);
+
+	if (p_job.group->pending.unref())
+		_finish_group(p_job.group);
+}
+
+void WorkerThreadPool::_release_group(Group *p_group) {
+
+	for(int i=0;i<p_group->jobs.size();i++) {
+
+		_push_job(p_group->jobs[i]);
+	}
+
+	// drop the reference held while the jobs were not queued
+	if (p_group->pending.unref())
+		_finish_group(p_group);
+}
+
+void WorkerThreadPool::_finish_group(Group *p_group) {
+
+	group_lock->lock();
+	p_group->finished=true;
+	Vector<Group*> dependents = p_group->dependents;
+	p_group->dependents.clear();
+	group_lock->unlock();
+
+	for(int i=0;i<dependents.size();i++) {
+
+		if (dependents[i]->blocked.unref())
+			_release_group(dependents[i]);
+	}
+
+	// the waiter may free the group as soon as this is posted, don't touch it afterwards
+	p_group->done->post();
+}
+
+void WorkerThreadPool::_thread_func(void *p_worker) {
+
+	Worker *w = (Worker*)p_worker;
+	WorkerThreadPool *pool = w->pool;
+
+	w->id=Thread::get_caller_ID();
+
+	while(!pool->exit_threads) {
+
+		Job job;
+		if (pool->_pop_job(w->index,job)) {
+
+			pool->_run_job(w->index,job);
+			continue;
+		}
+
+		pool->work_semaphore->wait();
+	}
+}
+
+WorkerThreadPool::Group *WorkerThreadPool::group_create() {
+
+	group_lock->lock();
+	Group *group=free_groups;
+	if (group)
+		free_groups=group->next_free;
+	group_lock->unlock();
+
+	if (!group)
+		return memnew( Group );
+
+	group->pending.init();
+	group->blocked.init();
+	group->finished=false;
+	group->next_free=NULL;
+	return group;
+}
+
+void WorkerThreadPool::group_add_dependency(Group *p_group,Group *p_depends_on) {
+
+	ERR_FAIL_COND(!p_group || !p_depends_on);
+
+	group_lock->lock();
+	if (!p_depends_on->finished) {
+		p_group->blocked.ref();
+		p_depends_on->dependents.push_back(p_group);
+	}
+	group_lock->unlock();
+}
+
+void WorkerThreadPool::group_add_task(Group *p_group,TaskFunc p_func,void *p_userdata,int p_from,int p_to) {
+
+	ERR_FAIL_COND(!p_group || !p_func);
+
+	Job job;
+	job.func=p_func;
+	job.userdata=p_userdata;
+	job.from=p_from;
+	job.to=p_to;
+	job.group=p_group;
+
+	p_group->pending.ref();
+	p_group->jobs.push_back(job);
+}
+
+void WorkerThreadPool::group_commit(Group *p_group) {
+
+	ERR_FAIL_COND(!p_group);
+
+	if (p_group->blocked.unref())
+		_release_group(p_group);
+}
+
+void WorkerThreadPool::group_wait(Group *p_group) {
+
+	ERR_FAIL_COND(!p_group);
+
+	int idx = _get_worker_index();
+
+	// help with whatever is pending instead of just sleeping. Don't block while the group is not
+	// finished even if there is nothing to take: the running jobs may wait on nested groups or
+	// release dependent ones, and when every worker is waiting too nobody else would run them.
+	int idle=0;
+	while(!p_group->finished) {
+
+		Job job;
+		if (_pop_job(idx,job)) {
+
+			_run_job(idx,job);
+			idle=0;
+			continue;
+		}
+
+		if (idle<64)
+			idle++;
+		else
+			OS::get_singleton()->delay_usec(1);
+	}
+
+	// always wait for the post, so the group is not freed while being finished
+	p_group->done->wait();
+
+	p_group->jobs.clear();
+	group_lock->lock();
+	p_group->next_free=free_groups;
+	free_groups=p_group;
+	group_lock->unlock();
+}
+
+void WorkerThreadPool::parallel_for(int p_from,int p_to,TaskFunc p_func,void *p_userdata,int p_granularity) {
+
+	int count = p_to-p_from;
+	if (count<=0)
+		return;
+
+	if (p_granularity<1)
+		p_granularity=1;
+
+	// a few ranges per thread, so stealing can even out uneven ranges
+	int ranges = (worker_count+1)*4;
+	int range_size = MAX( (count+ranges-1)/ranges, p_granularity );
+
+	if (worker_count==0 || range_size>=count) {
+
+		p_func(p_userdata,p_from,p_to);
+		return;
+	}
+
+	Group *group = group_create();
+
+	for(int i=p_from;i<p_to;i+=range_size) {
+
+		group_add_task(group,p_func,p_userdata,i,MIN(i+range_size,p_to));
+	}
+
+	group_commit(group);
+	group_wait(group);
+}
+
+int WorkerThreadPool::get_worker_count() const {
+
+	return worker_count;
+}
+
+uint64_t WorkerThreadPool::get_worker_busy_usec(int p_worker) const {
+
+	ERR_FAIL_INDEX_V(p_worker,worker_count,0);
+	return workers[p_worker].busy_usec;
+}
+
+uint64_t WorkerThreadPool::get_worker_jobs_run(int p_worker) const {
+
+	ERR_FAIL_INDEX_V(p_worker,worker_count,0);
+	return workers[p_worker].jobs_run;
+}
+
+void WorkerThreadPool::reset_worker_stats() {
+
+	for(int i=0;i<worker_count;i++) {
+
+		workers[i].busy_usec=0;
+		workers[i].jobs_run=0;
+	}
+}
+
+void WorkerThreadPool::set_instrumentation_func(InstrumentationFunc p_func,void *p_userdata) {
+
+	instrumentation_func=p_func;
+	instrumentation_userdata=p_userdata;
+}
+
+WorkerThreadPool::WorkerThreadPool(int p_worker_count) {
+
+	singleton=this;
+
+#ifdef NO_THREADS
+	worker_count=0;
+#else
+	worker_count = p_worker_count>0 ? p_worker_count : OS::get_singleton()->get_processor_count()-1;
+	if (worker_count<0)
+		worker_count=0;
+#endif
+
+	exit_threads=false;
+	next_deque.init();
+	instrumentation_func=NULL;
+	instrumentation_userdata=NULL;
+	group_lock=Mutex::create();
+	free_groups=NULL;
+	work_semaphore=Semaphore::create();
+	deques = memnew_arr(JobDeque,worker_count+1);
+	workers = worker_count ? memnew_arr(Worker,worker_count) : NULL;
+
+	// jobs may run scripts or physics, give them more stack than the default
+	Thread::Settings settings;
+	settings.stack_size=1024*1024;
+
+	for(int i=0;i<worker_count;i++) {
+
+		workers[i].pool=this;
+		workers[i].index=i;
+		workers[i].id=0;
+		workers[i].busy_usec=0;
+		workers[i].jobs_run=0;
+		workers[i].thread=Thread::create(_thread_func,&workers[i],settings);
+	}
+}
+
+WorkerThreadPool::~WorkerThreadPool() {
+
+	exit_threads=true;
+
+	for(int i=0;i<worker_count;i++) {
+		work_semaphore->post();
+	}
+
+	for(int i=0;i<worker_count;i++) {
+
+		Thread::wait_to_finish(workers[i].thread);
+		memdelete(workers[i].thread);
+	}
+
+	if (workers)
+		memdelete_arr(workers);
+	memdelete_arr(deques);
+	while(free_groups) {
+		Group *group=free_groups;
+		free_groups=group->next_free;
+		memdelete(group);
+	}
+
+	memdelete(work_semaphore);
+	memdelete(group_lock);
+
+	singleton=NULL;
+}
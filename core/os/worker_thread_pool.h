@@ -0,0 +1,166 @@
+/*************************************************************************/
+/*  worker_thread_pool.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef WORKER_THREAD_POOL_H
+#define WORKER_THREAD_POOL_H
+
+#include "os/thread.h"
+#include "os/mutex.h"
+#include "os/semaphore.h"
+#include "safe_refcount.h"
+#include "vector.h"
+
+/**
+ * @class WorkerThreadPool
+ *
+ * Engine wide pool of worker threads. Each worker owns a job deque: it pops its own jobs from
+ * the back and steals from the front of the other deques when it runs out. Jobs are grouped,
+ * a group can depend on other groups (its jobs are not queued until they are done), and waiting
+ * for a group makes the calling thread run pending jobs instead of just blocking.
+ *
+ * The amount of workers is taken from the "application/worker_threads" setting (0 means one
+ * less than the amount of processors). With no workers, or when built with NO_THREADS, every
+ * job runs on the thread that waits for it.
+ */
+
+class WorkerThreadPool {
+public:
+
+	typedef void (*TaskFunc)(void *p_userdata,int p_from,int p_to);
+	/* called after every job, p_worker is -1 for jobs run by a non worker thread while waiting */
+	typedef void (*InstrumentationFunc)(void *p_userdata,int p_worker,uint64_t p_begin_usec,uint64_t p_end_usec);
+
+	class Group;
+
+private:
+
+	struct Job {
+
+		TaskFunc func;
+		void *userdata;
+		int from;
+		int to;
+		Group *group;
+	};
+
+public:
+
+	class Group {
+	friend class WorkerThreadPool;
+
+		SafeRefCount pending; // unfinished jobs, plus one until the jobs are queued
+		SafeRefCount blocked; // unfinished dependencies, plus one until committed
+		Vector<Job> jobs;
+		Vector<Group*> dependents;
+		volatile bool finished;
+		Semaphore *done;
+		Group *next_free;
+
+	public:
+
+		Group();
+		~Group();
+	};
+
+private:
+
+	struct JobDeque {
+
+		Mutex *lock;
+		Job *jobs;
+		int capacity;
+		int head; // thieves take from here
+		int tail; // the owner pushes and pops here
+
+		void push_back(const Job& p_job);
+		bool pop_back(Job& r_job);
+		bool pop_front(Job& r_job);
+
+		JobDeque();
+		~JobDeque();
+	};
+
+	struct Worker {
+
+		WorkerThreadPool *pool;
+		Thread *thread;
+		Thread::ID id;
+		int index;
+		uint64_t busy_usec;
+		uint64_t jobs_run;
+	};
+
+	static WorkerThreadPool *singleton;
+
+	Worker *workers;
+	int worker_count;
+	JobDeque *deques; // one per worker, plus one for jobs pushed by other threads
+	Semaphore *work_semaphore;
+	Mutex *group_lock;
+	Group *free_groups; // finished groups are reused, so their semaphores are not recreated every frame
+	volatile bool exit_threads;
+	SafeRefCount next_deque;
+
+	InstrumentationFunc instrumentation_func;
+	void *instrumentation_userdata;
+
+	static void _thread_func(void *p_worker);
+
+	int _get_worker_index() const;
+	void _push_job(const Job& p_job);
+	bool _pop_job(int p_worker,Job& r_job);
+	void _run_job(int p_worker,const Job& p_job);
+	void _release_group(Group *p_group);
+	void _finish_group(Group *p_group);
+
+public:
+
+	static WorkerThreadPool *get_singleton();
+
+	/* groups: create, add dependencies and tasks, commit, then wait (which also releases it).
+	   Dependencies must be added before the group they depend on is waited for. */
+	Group *group_create();
+	void group_add_dependency(Group *p_group,Group *p_depends_on);
+	void group_add_task(Group *p_group,TaskFunc p_func,void *p_userdata,int p_from=0,int p_to=1);
+	void group_commit(Group *p_group);
+	void group_wait(Group *p_group);
+
+	/* split [p_from,p_to) in ranges of at least p_granularity elements, run them and wait */
+	void parallel_for(int p_from,int p_to,TaskFunc p_func,void *p_userdata,int p_granularity=1);
+
+	int get_worker_count() const;
+	uint64_t get_worker_busy_usec(int p_worker) const;
+	uint64_t get_worker_jobs_run(int p_worker) const;
+	void reset_worker_stats();
+	void set_instrumentation_func(InstrumentationFunc p_func,void *p_userdata);
+
+	WorkerThreadPool(int p_worker_count=0);
+	~WorkerThreadPool();
+};
+
+#endif
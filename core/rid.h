@@ -47,6 +47,7 @@ typedef uint32_t ID;
 class RID {	
 friend class RID_OwnerBase;	
 	ID _id;
+	uint32_t _index;
 	RID_OwnerBase *owner;
 public:
 
@@ -79,6 +80,7 @@ public:
 
 	_FORCE_INLINE_ RID() {
 		_id = 0;
+		_index = 0;
 		owner=0;
 	}
 };
@@ -88,6 +90,8 @@ class RID_OwnerBase {
 protected:
 friend class RID;
 	void set_id(RID& p_rid, ID p_id) const { p_rid._id=p_id; }
+	void set_index(RID& p_rid, uint32_t p_index) const { p_rid._index=p_index; }
+	_FORCE_INLINE_ static uint32_t get_index(const RID& p_rid) { return p_rid._index; }
 	void set_ownage(RID& p_rid) const { p_rid.owner=const_cast<RID_OwnerBase*>(this); }
 	ID new_ID();
 public:
@@ -100,6 +104,17 @@ public:
 	virtual ~RID_OwnerBase() {}
 };
 
+/**
+ * RID_Owner stores its elements in a slot map. A RID carries the index of its slot besides its
+ * ID, and the slot keeps the ID of the RID that currently owns it. As IDs are never reused, the
+ * ID acts as a generation: get() is a bounds check and a load, and stale RIDs never match.
+ *
+ * Slots are allocated in chunks that never move, found through pages of chunk pointers that
+ * never move either, so get() and owns() don't lock even when thread_safe is set; only
+ * make_rid(), free() and get_owned_list() do. A chunk or page is filled before it is linked,
+ * and readers only look at what they reach through it, so there is no count to race with.
+ */
+
 template<class T,bool thread_safe=false>
 class RID_Owner : public RID_OwnerBase {
 public:
@@ -107,104 +122,231 @@ public:
 	typedef void (*ReleaseNotifyFunc)(void*user,T *p_data);
 private:	
 
+	enum {
+		CHUNK_BITS=8,
+		CHUNK_SIZE=1<<CHUNK_BITS,
+		CHUNK_MASK=CHUNK_SIZE-1,
+		PAGE_BITS=8, // chunks per page
+		PAGE_SIZE=1<<PAGE_BITS,
+		PAGE_MASK=PAGE_SIZE-1,
+		MAX_PAGES=256,
+		MAX_SLOTS=MAX_PAGES<<(PAGE_BITS+CHUNK_BITS),
+		INVALID_INDEX=0xFFFFFFFF
+	};
+
+	struct Slot {
+
+		ID id; // 0 if free
+		uint32_t dense_index; // index in dense array, or next free slot if free
+		T *data;
+	};
+
 	Mutex *mutex;
-	mutable HashMap<ID,T*> id_map;
-		
-public:
 
-	RID make_rid(T * p_data) {
-		
+	Slot **pages[MAX_PAGES]; // NULL until used, as are the chunk pointers in them
+	uint32_t chunk_count;
+
+	uint32_t *dense; // slot indices of used slots, kept packed for get_owned_list()
+	uint32_t dense_count;
+	uint32_t dense_size;
+
+	uint32_t free_slot;
+
+	void _lock() const {
+
 		if (thread_safe) {
 			mutex->lock();
 		}
+	}
+
+	void _unlock() const {
+
+		if (thread_safe) {
+			mutex->unlock();
+		}
+	}
+
+	// only for slots known to exist, as in make_rid(), free() and get_owned_list()
+	_FORCE_INLINE_ Slot& _slot(uint32_t p_idx) const {
+
+		return pages[p_idx>>(PAGE_BITS+CHUNK_BITS)][(p_idx>>CHUNK_BITS)&PAGE_MASK][p_idx&CHUNK_MASK];
+	}
+
+	_FORCE_INLINE_ Slot* _get_slot(const RID& p_rid) const {
+
+		uint32_t idx = get_index(p_rid);
+		if (idx>=MAX_SLOTS)
+			return NULL;
+		Slot **page=pages[idx>>(PAGE_BITS+CHUNK_BITS)];
+		if (!page)
+			return NULL;
+		Slot *chunk=page[(idx>>CHUNK_BITS)&PAGE_MASK];
+		if (!chunk)
+			return NULL;
+		Slot *slot=&chunk[idx&CHUNK_MASK];
+		if (slot->id==0 || slot->id!=p_rid.get_id())
+			return NULL;
+		return slot;
+	}
+
+	void _add_chunk() {
+
+		ERR_FAIL_COND((chunk_count<<CHUNK_BITS)>=MAX_SLOTS);
+
+		Slot **page = pages[chunk_count>>PAGE_BITS];
+		if (!page) {
+
+			page = (Slot**)memalloc(sizeof(Slot*)*PAGE_SIZE);
+			for(uint32_t i=0;i<PAGE_SIZE;i++) {
+				page[i]=NULL;
+			}
+			pages[chunk_count>>PAGE_BITS]=page;
+		}
+
+		Slot *chunk = (Slot*)memalloc(sizeof(Slot)*CHUNK_SIZE);
+		uint32_t base = chunk_count<<CHUNK_BITS;
+
+		for(uint32_t i=0;i<CHUNK_SIZE;i++) {
+
+			chunk[i].id=0;
+			chunk[i].data=NULL;
+			chunk[i].dense_index = (i<CHUNK_SIZE-1) ? base+i+1 : free_slot;
+		}
+
+		page[chunk_count&PAGE_MASK]=chunk;
+		chunk_count++;
+		free_slot=base;
+
+		uint32_t new_dense_size = chunk_count<<CHUNK_BITS;
+		dense=(uint32_t*)(dense ? memrealloc(dense,sizeof(uint32_t)*new_dense_size) : memalloc(sizeof(uint32_t)*new_dense_size));
+		dense_size=new_dense_size;
+	}
+
+public:
+
+	RID make_rid(T * p_data) {
 		
+		_lock();
+
+		if (free_slot==INVALID_INDEX)
+			_add_chunk();
+
+		if (free_slot==INVALID_INDEX) {
+			_unlock();
+			ERR_FAIL_V(RID());
+		}
+
+		uint32_t idx = free_slot;
+		Slot &slot = _slot(idx);
+		free_slot = slot.dense_index;
+
 		ID id = new_ID();
-		id_map[id]=p_data;
+		slot.data=p_data;
+		slot.dense_index=dense_count;
+		dense[dense_count++]=idx;
+		slot.id=id;
+
 		RID rid;
 		set_id(rid,id);
+		set_index(rid,idx);
 		set_ownage(rid);
 		
-		if (thread_safe) {
-			mutex->unlock();
-		}
+		_unlock();
 		
 		return rid;
 	}
 	
 	_FORCE_INLINE_ T * get(const RID& p_rid) {
 	
-		if (thread_safe) {
-			mutex->lock();
-		}
-	
-		T**elem = id_map.getptr(p_rid.get_id());
-		
-		if (thread_safe) {
-			mutex->unlock();
-		}
+		Slot *slot = _get_slot(p_rid);
 
-		ERR_FAIL_COND_V(!elem,NULL);
+		ERR_FAIL_COND_V(!slot,NULL);
 		
-		return *elem;
+		return slot->data;
 
 	}
 	
 	virtual bool owns(const RID& p_rid) const {
 	
-		if (thread_safe) {
-			mutex->lock();
-		}
-	
-		T**elem = id_map.getptr(p_rid.get_id());
-		
-		if (thread_safe) {
-			mutex->lock();
-		}
-		
-		return elem!=NULL;
+		return _get_slot(p_rid)!=NULL;
 	}
 	
 	virtual void free(RID p_rid) { 
 	
-		if (thread_safe) {
-			mutex->lock();
+		_lock();
+
+		Slot *slot = _get_slot(p_rid);
+		if (!slot) {
+			_unlock();
+			ERR_FAIL_COND(!slot);
 		}
-		ERR_FAIL_COND(!owns(p_rid));
-		id_map.erase(p_rid.get_id());
+
+		uint32_t idx = get_index(p_rid);
+
+		// keep the dense array packed by moving the last element in place of this one
+		uint32_t last = dense[dense_count-1];
+		dense[slot->dense_index]=last;
+		_slot(last).dense_index=slot->dense_index;
+		dense_count--;
+
+		slot->id=0;
+		slot->data=NULL;
+		slot->dense_index=free_slot;
+		free_slot=idx;
+
+		_unlock();
 	}
+
 	virtual void get_owned_list(List<RID> *p_owned) const {
 	
-		if (thread_safe) {
-			mutex->lock();
-		}
+		_lock();
 	
-		const ID*id=NULL;
-		while((id=id_map.next(id))) {
+		for(uint32_t i=0;i<dense_count;i++) {
 		
+			uint32_t idx=dense[i];
 			RID rid;
-			set_id(rid,*id);
+			set_id(rid,_slot(idx).id);
+			set_index(rid,idx);
 			set_ownage(rid);
 			p_owned->push_back(rid);
 		
 		}
 	
-		if (thread_safe) {
-			mutex->lock();
-		}
+		_unlock();
 
 	}
+
 	RID_Owner() {
 	
 		if (thread_safe) {
 		
 			mutex = Mutex::create();
 		}
+
+		for(uint32_t i=0;i<MAX_PAGES;i++) {
+			pages[i]=NULL;
+		}
+		chunk_count=0;
+		dense=NULL;
+		dense_count=0;
+		dense_size=0;
+		free_slot=INVALID_INDEX;
 		
 	}
 	
 	
 	~RID_Owner() {
 	
+		for(uint32_t i=0;i<chunk_count;i++) {
+			memfree(pages[i>>PAGE_BITS][i&PAGE_MASK]);
+		}
+		for(uint32_t i=0;i<MAX_PAGES;i++) {
+			if (pages[i])
+				memfree(pages[i]);
+		}
+		if (dense)
+			memfree(dense);
+
 		if (thread_safe) {
 		
 			memdelete(mutex);
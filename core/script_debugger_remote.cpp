@@ -538,6 +538,21 @@ void ScriptDebuggerRemote::_poll_events() {
 				insert_breakpoint(cmd[2],cmd[1]);
 			else
 				remove_breakpoint(cmd[2],cmd[1]);
+		} else if (command=="start_profiling") {
+
+			bool sample_stacks = cmd.size()>1 ? bool(cmd[1]) : false;
+			for(int i=0;i<ScriptServer::get_language_count();i++) {
+				ScriptServer::get_language(i)->profiling_start(sample_stacks);
+			}
+			profiling=true;
+			profile_frame=0;
+		} else if (command=="stop_profiling") {
+
+			for(int i=0;i<ScriptServer::get_language_count();i++) {
+				ScriptServer::get_language(i)->profiling_stop();
+			}
+			profiling=false;
+			_send_profiling_data(false);
 		} else {
 			_parse_live_edit(cmd);
 		}
@@ -546,6 +561,57 @@ void ScriptDebuggerRemote::_poll_events() {
 
 }
 
+void ScriptDebuggerRemote::_send_profiling_data(bool p_for_frame) {
+
+	//functions are sent flattened as signature, call count, total and self time (usec)
+	Array functions;
+	Array samples;
+
+	for(int i=0;i<ScriptServer::get_language_count();i++) {
+
+		ScriptLanguage *lang = ScriptServer::get_language(i);
+		int count;
+		if (p_for_frame)
+			count=lang->profiling_get_frame_data(profile_info.ptr(),profile_info.size());
+		else
+			count=lang->profiling_get_accumulated_data(profile_info.ptr(),profile_info.size());
+
+		for(int j=0;j<count;j++) {
+			const ScriptLanguage::ProfilingInfo &pi=profile_info[j];
+			functions.push_back(String(pi.signature));
+			functions.push_back(double(pi.call_count));
+			functions.push_back(double(pi.total_time));
+			functions.push_back(double(pi.self_time));
+		}
+
+		if (!p_for_frame)
+			continue;
+
+		count=lang->profiling_get_frame_samples(profile_samples.ptr(),profile_samples.size());
+		for(int j=0;j<count;j++) {
+			samples.push_back(profile_samples[j].stack);
+			samples.push_back(profile_samples[j].count);
+		}
+	}
+
+	if (p_for_frame) {
+
+		if (functions.size()==0 && samples.size()==0)
+			return;
+
+		packet_peer_stream->put_var("profile_frame");
+		packet_peer_stream->put_var(3);
+		packet_peer_stream->put_var(profile_frame);
+		packet_peer_stream->put_var(functions);
+		packet_peer_stream->put_var(samples);
+	} else {
+
+		packet_peer_stream->put_var("profile_total");
+		packet_peer_stream->put_var(1);
+		packet_peer_stream->put_var(functions);
+	}
+}
+
 
 void ScriptDebuggerRemote::idle_poll() {
 
@@ -580,6 +646,12 @@ void ScriptDebuggerRemote::idle_poll() {
 		}
 	    }
 
+	    if (profiling) {
+		//languages rolled their frame counters in frame(), right before this
+		_send_profiling_data(true);
+		profile_frame++;
+	    }
+
 	    _poll_events();
 
 }
@@ -673,6 +745,10 @@ ScriptDebuggerRemote::ScriptDebuggerRemote() {
 	char_count=0;
 	msec_count=0;
 	last_msec=0;
+	profiling=false;
+	profile_frame=0;
+	profile_info.resize(GLOBAL_DEF("debug/profiler_max_functions",16384));
+	profile_samples.resize(GLOBAL_DEF("debug/profiler_max_samples",1024));
 
 	eh.errfunc=_err_handler;
 	eh.userdata=this;
@@ -84,6 +84,13 @@ class ScriptDebuggerRemote : public ScriptDebugger {
 	void _poll_events();
 	uint32_t poll_every;
 
+	bool profiling;
+	int profile_frame;
+	Vector<ScriptLanguage::ProfilingInfo> profile_info;
+	Vector<ScriptLanguage::ProfilingSample> profile_samples;
+
+	void _send_profiling_data(bool p_for_frame);
+
 
 	bool _parse_live_edit(const Array &p_command);
 
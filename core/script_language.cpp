@@ -27,6 +27,8 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 #include "script_language.h"
+#include "io/resource_loader.h"
+#include "set.h"
 
 ScriptLanguage *ScriptServer::_languages[MAX_LANGUAGES];
 int ScriptServer::_language_count=0;
@@ -92,6 +94,38 @@ void ScriptServer::init_languages() {
 	}
 }
 
+void ScriptServer::preload_dependencies(const Vector<String>& p_paths,Vector<RES> *r_loaded) {
+
+	//walk the dependency tree without loading anything, cached resources already have theirs loaded
+	Set<String> visited;
+	Vector<String> found;
+	List<String> pending;
+
+	for(int i=0;i<p_paths.size();i++)
+		pending.push_back(p_paths[i]);
+
+	while(pending.size()) {
+
+		String path=pending.front()->get();
+		pending.pop_front();
+		if (visited.has(path))
+			continue;
+		visited.insert(path);
+		if (ResourceCache::has(path))
+			continue;
+
+		found.push_back(path);
+		List<String> deps;
+		ResourceLoader::get_dependencies(path,&deps);
+		for(List<String>::Element *E=deps.front();E;E=E->next())
+			pending.push_back(E->get());
+	}
+
+	for(int i=0;i<_language_count;i++) {
+		_languages[i]->preload_scripts(found,r_loaded);
+	}
+}
+
 Variant ScriptInstance::call(const StringName& p_method,VARIANT_ARG_DECLARE) {
 
 	VARIANT_ARGPTRS;
@@ -144,11 +178,44 @@ ScriptCodeCompletionCache::ScriptCodeCompletionCache() {
 
 
 
+void ScriptLanguage::preload_scripts(const Vector<String>& p_paths,Vector<RES> *r_loaded) {
+
+}
+
 void ScriptLanguage::frame() {
 
 
 }
 
+void ScriptLanguage::get_inline_cache_stats(int &r_hits,int &r_misses) const {
+
+	r_hits=0;
+	r_misses=0;
+}
+
+void ScriptLanguage::profiling_start(bool p_sample_stacks) {
+
+}
+
+void ScriptLanguage::profiling_stop() {
+
+}
+
+int ScriptLanguage::profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max) {
+
+	return 0;
+}
+
+int ScriptLanguage::profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max) {
+
+	return 0;
+}
+
+int ScriptLanguage::profiling_get_frame_samples(ProfilingSample *p_sample_arr,int p_sample_max) {
+
+	return 0;
+}
+
 ScriptDebugger * ScriptDebugger::singleton=NULL;
 
 
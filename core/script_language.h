@@ -56,6 +56,7 @@ public:
 	static void register_language(ScriptLanguage *p_language);
 
 	static void init_languages();
+	static void preload_dependencies(const Vector<String>& p_paths,Vector<RES> *r_loaded); ///< lets each language load the scripts these resources need ahead of time, r_loaded keeps them alive
 };
 
 
@@ -123,6 +124,7 @@ public:
 	virtual Ref<Script> get_script() const=0;
 
 	virtual ScriptLanguage *get_language()=0;
+	virtual bool is_placeholder() const { return false; }
 	virtual ~ScriptInstance();
 };
 
@@ -188,9 +190,31 @@ public:
 	virtual void get_recognized_extensions(List<String> *p_extensions) const=0;
 	virtual void get_public_functions(List<MethodInfo> *p_functions) const=0;
 	virtual void get_public_constants(List<Pair<String,Variant> > *p_constants) const=0;
+	virtual void preload_scripts(const Vector<String>& p_paths,Vector<RES> *r_loaded); ///< may load scripts among p_paths in bulk, the resource cache finds them while r_loaded holds them
 
 	virtual void frame();
 
+	/* PROFILING FUNCTIONS */
+	virtual void get_inline_cache_stats(int &r_hits,int &r_misses) const; ///< hits and misses of call and member caches during the last frame
+
+	struct ProfilingInfo {
+		StringName signature; ///< source::line::function
+		uint64_t call_count;
+		uint64_t total_time; ///< usec, including called script functions
+		uint64_t self_time; ///< usec, excluding called script functions
+	};
+
+	struct ProfilingSample {
+		String stack; ///< signatures from outermost to innermost, separated by ';'
+		int count;
+	};
+
+	virtual void profiling_start(bool p_sample_stacks=false);
+	virtual void profiling_stop();
+	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max); ///< totals since profiling_start
+	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max); ///< functions that ran during the last frame
+	virtual int profiling_get_frame_samples(ProfilingSample *p_sample_arr,int p_sample_max); ///< call stacks sampled during the last frame
+
 	virtual ~ScriptLanguage() {};	
 };
 
@@ -221,6 +245,7 @@ public:
 	virtual Ref<Script> get_script() const { return script; }
 
 	virtual ScriptLanguage *get_language() { return language; }
+	virtual bool is_placeholder() const { return true; }
 
 	Object *get_owner() { return owner; }
 
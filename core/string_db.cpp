@@ -33,7 +33,7 @@ StaticCString StaticCString::create(const char *p_ptr) {
 	StaticCString scs; scs.ptr=p_ptr; return scs;
 }
 
-StringName::_Data *StringName::_table[STRING_TABLE_LEN];
+StringName::_Shard StringName::_shards[STRING_TABLE_SHARDS];
 
 StringName _scs_create(const char *p_chr) {
 
@@ -45,40 +45,135 @@ bool StringName::configured=false;
 void StringName::setup() {
 	
 	ERR_FAIL_COND(configured);
-	for(int i=0;i<STRING_TABLE_LEN;i++) {
+	for(int i=0;i<STRING_TABLE_SHARDS;i++) {
 		
-		_table[i]=NULL;
+		_Shard &shard=_shards[i];
+		shard.lock=Mutex::create();
+		shard.bits=STRING_TABLE_INITIAL_BITS;
+		shard.count=0;
+		shard.table=(_Data**)memalloc(sizeof(_Data*)<<shard.bits);
+		for(uint32_t j=0;j<(1U<<shard.bits);j++) {
+			shard.table[j]=NULL;
+		}
 	}
 	configured=true;
 }
 
 void StringName::cleanup() {
 	
-	_global_lock();	
 	int lost_strings=0;
-	for(int i=0;i<STRING_TABLE_LEN;i++) {
+	for(int i=0;i<STRING_TABLE_SHARDS;i++) {
 		
-		while(_table[i]) {
-			
-			_Data*d=_table[i];
-			lost_strings++;
-			if (OS::get_singleton()->is_stdout_verbose()) {
-
-				if (d->cname) {
-					print_line("Orphan StringName: "+String(d->cname));
-				} else {
-					print_line("Orphan StringName: "+String(d->name));
+		_Shard &shard=_shards[i];
+		_shard_lock(shard);
+
+		for(uint32_t j=0;j<(1U<<shard.bits);j++) {
+
+			while(shard.table[j]) {
+
+				_Data*d=shard.table[j];
+				lost_strings++;
+				if (OS::get_singleton()->is_stdout_verbose()) {
+
+					if (d->cname) {
+						print_line("Orphan StringName: "+String(d->cname));
+					} else {
+						print_line("Orphan StringName: "+String(d->name));
+					}
 				}
-			}
 
-			_table[i]=_table[i]->next;			
-			memdelete(d);
+				shard.table[j]=shard.table[j]->next;
+				memdelete(d);
+			}
 		}
+
+		memfree(shard.table);
+		shard.table=NULL;
+		shard.count=0;
+		_shard_unlock(shard);
+		memdelete(shard.lock);
+		shard.lock=NULL;
 	}
 	if (OS::get_singleton()->is_stdout_verbose() && lost_strings) {
 		print_line("StringName: "+itos(lost_strings)+" unclaimed string names at exit.");
 	}
-	_global_unlock();	
+}
+
+void StringName::_shard_lock(_Shard& p_shard) {
+
+	if (p_shard.lock)
+		p_shard.lock->lock();
+}
+
+void StringName::_shard_unlock(_Shard& p_shard) {
+
+	if (p_shard.lock)
+		p_shard.lock->unlock();
+}
+
+void StringName::_shard_grow(_Shard& p_shard) {
+
+	uint32_t new_bits=p_shard.bits+1;
+	uint32_t new_len=1U<<new_bits;
+	uint32_t new_mask=new_len-1;
+
+	_Data **new_table=(_Data**)memalloc(sizeof(_Data*)*new_len);
+	ERR_FAIL_COND(!new_table);
+
+	for(uint32_t i=0;i<new_len;i++) {
+		new_table[i]=NULL;
+	}
+
+	for(uint32_t i=0;i<(1U<<p_shard.bits);i++) {
+
+		_Data *d=p_shard.table[i];
+		while(d) {
+
+			_Data *next=d->next;
+			uint32_t idx=d->hash&new_mask;
+			d->prev=NULL;
+			d->next=new_table[idx];
+			if (new_table[idx])
+				new_table[idx]->prev=d;
+			new_table[idx]=d;
+			d=next;
+		}
+	}
+
+	memfree(p_shard.table);
+	p_shard.table=new_table;
+	p_shard.bits=new_bits;
+}
+
+void StringName::_shard_insert(_Shard& p_shard,_Data *p_data) {
+
+	if (p_shard.count>=(1U<<p_shard.bits) && p_shard.bits<STRING_TABLE_MAX_BITS)
+		_shard_grow(p_shard);
+
+	uint32_t idx=p_data->hash&((1U<<p_shard.bits)-1);
+
+	p_data->next=p_shard.table[idx];
+	p_data->prev=NULL;
+	if (p_shard.table[idx])
+		p_shard.table[idx]->prev=p_data;
+	p_shard.table[idx]=p_data;
+	p_shard.count++;
+}
+
+template<class N>
+StringName::_Data* StringName::_shard_find(_Shard& p_shard,const N& p_name,uint32_t p_hash) {
+
+	_Data *d=p_shard.table[p_hash&((1U<<p_shard.bits)-1)];
+
+	while(d) {
+
+		// compare hash first
+		if (d->hash==p_hash && d->get_name()==p_name)
+			return d;
+		d=d->next;
+	}
+
+	return NULL;
 }
 
 void StringName::unref() {
@@ -87,23 +182,26 @@ void StringName::unref() {
 
 	if (_data && _data->refcount.unref()) {
 		
-		_global_lock();	
+		_Shard &shard=_get_shard(_data->hash);
+		_shard_lock(shard);
 
 		if (_data->prev) {
 			_data->prev->next=_data->next;
 		} else {
-			if (_table[_data->idx]!=_data) {
+			uint32_t idx=_data->hash&((1U<<shard.bits)-1);
+			if (shard.table[idx]!=_data) {
 				ERR_PRINT("BUG!");
 			}
-			_table[_data->idx]=_data->next;
+			shard.table[idx]=_data->next;
 		}
 		
 		if (_data->next) {
 			_data->next->prev=_data->prev;
 
 		}
+		shard.count--;
 		memdelete(_data);
-		_global_unlock();		
+		_shard_unlock(shard);
 	}
 	
 	_data=NULL;
@@ -185,30 +283,20 @@ StringName::StringName(const char *p_name) {
 
 	ERR_FAIL_COND( !p_name || !p_name[0]);
 	
-	_global_lock();	
-	
 	uint32_t hash = String::hash(p_name);
 	
-	uint32_t idx=hash&STRING_TABLE_MASK;
-	
-	_data=_table[idx];
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
 	
-	while(_data) {
-		
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-
+	_data=_shard_find(shard,p_name,hash);
 
 	if (_data) {
 		if (_data->refcount.ref()) {
 			// exists
-			_global_unlock();
+			_shard_unlock(shard);
 			return;
 		} else {
-
+			// being released by another thread, intern a new one
 		}
 	}
 
@@ -216,16 +304,10 @@ StringName::StringName(const char *p_name) {
 	_data->name=p_name;
 	_data->refcount.init();
 	_data->hash=hash;
-	_data->idx=idx;
 	_data->cname=NULL;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
-
+	_shard_insert(shard,_data);
 
-	_global_unlock();
+	_shard_unlock(shard);
 	
 }
 
@@ -237,30 +319,20 @@ StringName::StringName(const StaticCString& p_static_string) {
 
 	ERR_FAIL_COND( !p_static_string.ptr || !p_static_string.ptr[0]);
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_static_string.ptr);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_static_string.ptr)
-			break;
-		_data=_data->next;
-	}
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
 
+	_data=_shard_find(shard,p_static_string.ptr,hash);
 
 	if (_data) {
 		if (_data->refcount.ref()) {
 			// exists
-			_global_unlock();
+			_shard_unlock(shard);
 			return;
 		} else {
-
+			// being released by another thread, intern a new one
 		}
 	}
 
@@ -268,16 +340,10 @@ StringName::StringName(const StaticCString& p_static_string) {
 
 	_data->refcount.init();
 	_data->hash=hash;
-	_data->idx=idx;	
 	_data->cname=p_static_string.ptr;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
-
+	_shard_insert(shard,_data);
 
-	_global_unlock();
+	_shard_unlock(shard);
 
 }
 
@@ -288,47 +354,31 @@ StringName::StringName(const String& p_name) {
 
 	ERR_FAIL_COND(!configured);
 
-	_global_lock();	
-	
 	uint32_t hash = p_name.hash();
 	
-	uint32_t idx=hash&STRING_TABLE_MASK;
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
 
-	_data=_table[idx];
-	
-	while(_data) {
-		
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
-		
+	_data=_shard_find(shard,p_name,hash);
 
 	if (_data) {
 		if (_data->refcount.ref()) {
 			// exists
-			_global_unlock();
+			_shard_unlock(shard);
 			return;
 		} else {
-
-
+			// being released by another thread, intern a new one
 		}
 	}
 
-
 	_data = memnew( _Data );
 	_data->name=p_name;
 	_data->refcount.init();
 	_data->hash=hash;
-	_data->idx=idx;
 	_data->cname=NULL;
-	_data->next=_table[idx];
-	_data->prev=NULL;
-	if (_table[idx])
-		_table[idx]->prev=_data;
-	_table[idx]=_data;
+	_shard_insert(shard,_data);
 
-	_global_unlock();
+	_shard_unlock(shard);
 	
 }
 
@@ -340,29 +390,20 @@ StringName StringName::search(const char *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_name);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
-
-	while(_data) {
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
 
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
+	_Data *_data=_shard_find(shard,p_name,hash);
 
 	if (_data && _data->refcount.ref()) {
-		_global_unlock();
+		_shard_unlock(shard);
 		return StringName(_data);
 
 	}
 
-	_global_unlock();
+	_shard_unlock(shard);
 	return StringName(); //does not exist
 
 
@@ -376,29 +417,20 @@ StringName StringName::search(const CharType *p_name) {
 	if (!p_name[0])
 		return StringName();
 
-	_global_lock();
-
 	uint32_t hash = String::hash(p_name);
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
 
-	_Data *_data=_table[idx];
-
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && _data->get_name()==p_name)
-			break;
-		_data=_data->next;
-	}
+	_Data *_data=_shard_find(shard,p_name,hash);
 
 	if (_data && _data->refcount.ref()) {
-		_global_unlock();
+		_shard_unlock(shard);
 		return StringName(_data);
 
 	}
 
-	_global_unlock();
+	_shard_unlock(shard);
 	return StringName(); //does not exist
 
 }
@@ -406,33 +438,45 @@ StringName StringName::search(const String &p_name) {
 
 	ERR_FAIL_COND_V( p_name=="", StringName() );
 
-	_global_lock();
-
 	uint32_t hash = p_name.hash();
 
-	uint32_t idx=hash&STRING_TABLE_MASK;
-
-	_Data *_data=_table[idx];
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
 
-	while(_data) {
-
-		// compare hash first
-		if (_data->hash==hash && p_name==_data->get_name())
-			break;
-		_data=_data->next;
-	}
+	_Data *_data=_shard_find(shard,p_name,hash);
 
 	if (_data && _data->refcount.ref()) {
-		_global_unlock();
+		_shard_unlock(shard);
 		return StringName(_data);
 
 	}
 
-	_global_unlock();
+	_shard_unlock(shard);
 	return StringName(); //does not exist
 
 }
 
+const void* StringName::find_unique_pointer(const String &p_name) {
+
+	ERR_FAIL_COND_V(!configured,NULL);
+
+	if (p_name=="")
+		return NULL;
+
+	uint32_t hash = p_name.hash();
+
+	_Shard &shard=_get_shard(hash);
+	_shard_lock(shard);
+
+	_Data *_data=_shard_find(shard,p_name,hash);
+
+	// a name that is being released can't match any live StringName
+	const void *ptr = (_data && _data->refcount.get()>0) ? _data : NULL;
+
+	_shard_unlock(shard);
+	return ptr;
+}
+
 
 StringName::StringName() {
 	
@@ -48,11 +48,17 @@ struct StaticCString {
 class StringName {
 	
 
+	/* Names are interned in a sharded hash table. Each shard has its own
+	   lock and bucket array, which grows as names are added, so threads
+	   interning unrelated names rarely contend. */
+
 	enum {
 		
-		STRING_TABLE_BITS=12,
-		STRING_TABLE_LEN=1<<STRING_TABLE_BITS,
-		STRING_TABLE_MASK=STRING_TABLE_LEN-1
+		STRING_TABLE_SHARD_BITS=4,
+		STRING_TABLE_SHARDS=1<<STRING_TABLE_SHARD_BITS,
+		STRING_TABLE_SHARD_MASK=STRING_TABLE_SHARDS-1,
+		STRING_TABLE_INITIAL_BITS=8,
+		STRING_TABLE_MAX_BITS=20
 	};
 	
 	struct _Data {		
@@ -61,15 +67,29 @@ class StringName {
 		String name;
 
 		String get_name() const {  return cname?String(cname):name; }
-		int idx;
 		uint32_t hash;
 		_Data *prev;
 		_Data *next;
 		_Data() { cname=NULL; next=prev=NULL; hash=0; }
 	};
 	
-	
-	static _Data *_table[STRING_TABLE_LEN];
+	struct _Shard {
+
+		Mutex *lock;
+		_Data **table;
+		uint32_t bits;
+		uint32_t count;
+	};
+
+	static _Shard _shards[STRING_TABLE_SHARDS];
+
+	_FORCE_INLINE_ static _Shard& _get_shard(uint32_t p_hash) { return _shards[(p_hash>>(32-STRING_TABLE_SHARD_BITS))&STRING_TABLE_SHARD_MASK]; }
+	static void _shard_lock(_Shard& p_shard);
+	static void _shard_unlock(_Shard& p_shard);
+	static void _shard_insert(_Shard& p_shard,_Data *p_data);
+	static void _shard_grow(_Shard& p_shard);
+	template<class N>
+	static _Data* _shard_find(_Shard& p_shard,const N& p_name,uint32_t p_hash);
 	
 	_Data *_data;
 	
@@ -130,6 +150,12 @@ public:
 	static StringName search(const CharType *p_name);
 	static StringName search(const String &p_name);
 
+	/* Lookup-only: return the unique pointer of an interned name (NULL if it
+	   isn't interned) without creating a reference. Only use it to compare
+	   against get_data_unique_pointer() of a StringName that is held alive. */
+	static const void* find_unique_pointer(const String &p_name);
+	_FORCE_INLINE_ const void* get_data_unique_pointer() const { return _data; }
+
 	struct AlphCompare {
 
 		_FORCE_INLINE_ bool operator()(const StringName& l,const StringName& r) const {
@@ -180,6 +180,17 @@ public:
 	}
 
 
+	//unchecked access to atomic values, for script VMs. get_type() must be checked before reading.
+	_FORCE_INLINE_ int _get_int() const { return _data._int; }
+	_FORCE_INLINE_ double _get_real() const { return _data._real; }
+	_FORCE_INLINE_ void _set_int(int p_int) { if (type>REAL) clear(); type=INT; _data._int=p_int; }
+	_FORCE_INLINE_ void _set_real(double p_real) { if (type>REAL) clear(); type=REAL; _data._real=p_real; }
+	_FORCE_INLINE_ void _set_bool(bool p_bool) { if (type>REAL) clear(); type=BOOL; _data._bool=p_bool; }
+	_FORCE_INLINE_ void _set_vector3(const Vector3& p_vector3) { if (type!=VECTOR3) { if (type>REAL) clear(); type=VECTOR3; } *reinterpret_cast<Vector3*>(_data._mem)=p_vector3; }
+	_FORCE_INLINE_ const DVector<int>* _get_int_array() const { return reinterpret_cast<const DVector<int>*>(_data._mem); }
+	_FORCE_INLINE_ const DVector<real_t>* _get_real_array() const { return reinterpret_cast<const DVector<real_t>*>(_data._mem); }
+	_FORCE_INLINE_ const DVector<Vector3>* _get_vector3_array() const { return reinterpret_cast<const DVector<Vector3>*>(_data._mem); }
+
 	bool is_ref() const;
 	_FORCE_INLINE_ bool is_num() const { return type==INT || type==REAL; };
 	_FORCE_INLINE_ bool is_array() const { return type>=ARRAY; };
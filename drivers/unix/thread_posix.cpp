@@ -45,19 +45,19 @@ Thread* ThreadPosix::create_thread_posix() {
 void *ThreadPosix::thread_callback(void *userdata) {
 
 	ThreadPosix *t=reinterpret_cast<ThreadPosix*>(userdata);
-	t->callback(t->user);
 	t->id=(ID)pthread_self();
+	t->callback(t->user);
 	return NULL;
 }
 
-Thread* ThreadPosix::create_func_posix(ThreadCreateCallback p_callback,void *p_user,const Settings&) {
+Thread* ThreadPosix::create_func_posix(ThreadCreateCallback p_callback,void *p_user,const Settings& p_settings) {
 
 	ThreadPosix *tr= memnew(ThreadPosix);
 	tr->callback=p_callback;
 	tr->user=p_user;
 	pthread_attr_init(&tr->pthread_attr);
 	pthread_attr_setdetachstate(&tr->pthread_attr, PTHREAD_CREATE_JOINABLE);
-	pthread_attr_setstacksize(&tr->pthread_attr, 256 * 1024);
+	pthread_attr_setstacksize(&tr->pthread_attr, p_settings.stack_size>0 ? p_settings.stack_size : 256 * 1024);
 	
 	pthread_create(&tr->pthread, &tr->pthread_attr, thread_callback, tr);
 	
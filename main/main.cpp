@@ -38,6 +38,7 @@
 #include "script_debugger_local.h"
 #include "script_debugger_remote.h"
 #include "message_queue.h"
+#include "os/worker_thread_pool.h"
 #include "path_remap.h"
 #include "input_map.h"
 #include "io/resource_loader.h"
@@ -84,6 +85,7 @@ static bool _start_success=false;
 static ScriptDebugger *script_debugger=NULL;
 
 static MessageQueue *message_queue=NULL;
+static WorkerThreadPool *worker_thread_pool=NULL;
 static Performance *performance = NULL;
 static PathRemap *path_remap;
 static PackedData *packed_data=NULL;
@@ -726,6 +728,7 @@ Error Main::setup(const char *execpath,int argc, char *argv[],bool p_second_phas
 		OS::get_singleton()->_verbose_stdout=GLOBAL_DEF("debug/verbose_stdout",false);
 
 	message_queue = memnew( MessageQueue );
+	worker_thread_pool = memnew( WorkerThreadPool( GLOBAL_DEF("application/worker_threads",0) ) );
 
 	Globals::get_singleton()->register_global_defaults();
 
@@ -1213,6 +1216,22 @@ bool Main::start() {
 			} else {
 #endif
 
+				//the resource cache doesn't own what it holds, keep the preloaded scripts until the scene uses them
+				Vector<RES> preloaded;
+				if (GLOBAL_DEF("application/parallel_script_loading",true)) {
+					//compile the scripts of the autoloads and main scene together, using all cores
+					Vector<String> paths;
+					List<PropertyInfo> props;
+					Globals::get_singleton()->get_property_list(&props);
+					for(List<PropertyInfo>::Element *E=props.front();E;E=E->next()) {
+
+						if (E->get().name.begins_with("autoload/"))
+							paths.push_back(Globals::get_singleton()->get(E->get().name));
+					}
+					paths.push_back(local_game_path);
+					ScriptServer::preload_dependencies(paths,&preloaded);
+				}
+
 				{
 					//autoload
 					List<PropertyInfo> props;
@@ -1263,6 +1282,7 @@ bool Main::start() {
 				ERR_FAIL_COND_V(!scene,false)
 				//sml->get_root()->add_child(scene);
 				sml->add_current_scene(scene);
+				preloaded.clear();
 
 				String iconpath = GLOBAL_DEF("application/icon","Variant()""");
 				if (iconpath!="") {
@@ -1515,6 +1535,8 @@ void Main::cleanup() {
 
 
 
+	if (worker_thread_pool)
+		memdelete( worker_thread_pool );
 	memdelete( message_queue );
 
 	unregister_core_driver_types();
@@ -32,6 +32,7 @@
 #include "servers/physics_2d_server.h"
 #include "servers/physics_server.h"
 #include "message_queue.h"
+#include "script_language.h"
 #include "scene/main/scene_main_loop.h"
 Performance *Performance::singleton=NULL;
 
@@ -69,6 +70,8 @@ void Performance::_bind_methods() {
 	BIND_CONSTANT( PHYSICS_3D_ACTIVE_OBJECTS );
 	BIND_CONSTANT( PHYSICS_3D_COLLISION_PAIRS );
 	BIND_CONSTANT( PHYSICS_3D_ISLAND_COUNT );
+	BIND_CONSTANT( SCRIPT_CACHE_HITS );
+	BIND_CONSTANT( SCRIPT_CACHE_MISSES );
 
 	BIND_CONSTANT( MONITOR_MAX );
 
@@ -106,6 +109,8 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"physics_3d/active_objects",
 		"physics_3d/collision_pairs",
 		"physics_3d/islands",
+		"script/cache_hits",
+		"script/cache_misses",
 
 	};
 
@@ -155,6 +160,18 @@ float Performance::get_monitor(Monitor p_monitor) const {
 		case PHYSICS_3D_ACTIVE_OBJECTS: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_ACTIVE_OBJECTS);
 		case PHYSICS_3D_COLLISION_PAIRS: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_COLLISION_PAIRS);
 		case PHYSICS_3D_ISLAND_COUNT: return PhysicsServer::get_singleton()->get_process_info(PhysicsServer::INFO_ISLAND_COUNT);
+		case SCRIPT_CACHE_HITS:
+		case SCRIPT_CACHE_MISSES: {
+
+			int total=0;
+			for(int i=0;i<ScriptServer::get_language_count();i++) {
+
+				int hits,misses;
+				ScriptServer::get_language(i)->get_inline_cache_stats(hits,misses);
+				total+= p_monitor==SCRIPT_CACHE_HITS ? hits : misses;
+			}
+			return total;
+		};
 
 		default: {}
 	}
@@ -75,6 +75,8 @@ public:
 		PHYSICS_3D_ACTIVE_OBJECTS,
 		PHYSICS_3D_COLLISION_PAIRS,
 		PHYSICS_3D_ISLAND_COUNT,
+		SCRIPT_CACHE_HITS,
+		SCRIPT_CACHE_MISSES,
 		//physics
 		MONITOR_MAX
 	};
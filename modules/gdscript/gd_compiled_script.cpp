@@ -0,0 +1,1040 @@
+/*************************************************************************/
+/*  gd_compiled_script.cpp                                               */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "gd_compiled_script.h"
+#include "gd_functions.h"
+#include "io/marshalls.h"
+#include "io/resource_loader.h"
+#include "hashfuncs.h"
+#include "version.h"
+
+#define COMPILED_SCRIPT_VERSION 3
+#define COMPILED_SCRIPT_HEADER_SIZE 40
+
+//debug and release builds don't agree on what the compiler emits, caches only load in the same kind of build
+#ifdef DEBUG_ENABLED
+#define COMPILED_SCRIPT_BUILD_TYPE 1
+#else
+#define COMPILED_SCRIPT_BUILD_TYPE 0
+#endif
+
+enum {
+	BASE_NONE,
+	BASE_NATIVE,
+	BASE_SCRIPT
+};
+
+enum {
+	CONSTANT_VARIANT,
+	CONSTANT_SCRIPT,
+	CONSTANT_NATIVE_CLASS,
+	CONSTANT_RESOURCE
+};
+
+struct GDCompiledScript::Writer {
+
+	Vector<uint8_t> buf;
+
+	void put_32(uint32_t p_value) {
+
+		int pos=buf.size();
+		buf.resize(pos+4);
+		encode_uint32(p_value,&buf[pos]);
+	}
+
+	void put_string(const String& p_string) {
+
+		CharString cs=p_string.utf8();
+		put_32(cs.length());
+		if (cs.length()==0)
+			return;
+		int pos=buf.size();
+		buf.resize(pos+cs.length());
+		copymem(&buf[pos],cs.get_data(),cs.length());
+	}
+
+	bool put_variant(const Variant& p_value) {
+
+		int len;
+		if (encode_variant(p_value,NULL,len)!=OK)
+			return false;
+		int pos=buf.size();
+		buf.resize(pos+len);
+		encode_variant(p_value,&buf[pos],len);
+		return true;
+	}
+};
+
+struct GDCompiledScript::Reader {
+
+	const uint8_t *ptr;
+	int len;
+	int pos;
+	bool error;
+
+	uint32_t get_32() {
+
+		if (error || pos+4>len) {
+			error=true;
+			return 0;
+		}
+		uint32_t v=decode_uint32(&ptr[pos]);
+		pos+=4;
+		return v;
+	}
+
+	String get_string() {
+
+		int l=get_32();
+		if (error || l<0 || pos+l>len) {
+			error=true;
+			return String();
+		}
+		String s;
+		if (l)
+			s.parse_utf8((const char*)&ptr[pos],l);
+		pos+=l;
+		return s;
+	}
+
+	Variant get_variant() {
+
+		Variant v;
+		int vlen;
+		if (error || decode_variant(v,&ptr[pos],len-pos,&vlen)!=OK) {
+			error=true;
+			return Variant();
+		}
+		pos+=vlen;
+		return v;
+	}
+};
+
+static bool _has_objects(const Variant& p_value) {
+
+	switch(p_value.get_type()) {
+
+		case Variant::OBJECT:
+		case Variant::_RID: {
+
+			return true;
+		}
+		case Variant::ARRAY: {
+
+			Array a=p_value;
+			for(int i=0;i<a.size();i++) {
+				if (_has_objects(a[i]))
+					return true;
+			}
+		} break;
+		case Variant::DICTIONARY: {
+
+			Dictionary d=p_value;
+			List<Variant> keys;
+			d.get_key_list(&keys);
+			for(List<Variant>::Element *E=keys.front();E;E=E->next()) {
+				if (_has_objects(E->get()) || _has_objects(d[E->get()]))
+					return true;
+			}
+		} break;
+		default: {}
+	}
+
+	return false;
+}
+
+bool GDCompiledScript::_save_script_ref(Writer &w,const GDScript *p_script,const GDScript *p_root) {
+
+	//scripts are stored as the path of the file that owns them plus the chain of subclass names
+	Vector<StringName> chain;
+	const GDScript *top=p_script;
+	while(top->_owner) {
+		chain.push_back(top->name);
+		top=top->_owner;
+	}
+	chain.invert();
+
+	if (top==p_root) {
+		w.put_string(""); //same file
+	} else {
+		String path=top->get_path();
+		if (path=="" || path.find("::")!=-1 || path.begins_with("local://"))
+			return false; //built-in script
+		w.put_string(path);
+	}
+
+	w.put_32(chain.size());
+	for(int i=0;i<chain.size();i++) {
+		w.put_string(chain[i]);
+	}
+	return true;
+}
+
+Ref<GDScript> GDCompiledScript::_load_script_ref(Reader &r,GDScript *p_root) {
+
+	String path=r.get_string();
+	int chain_size=r.get_32();
+	if (r.error)
+		return Ref<GDScript>();
+
+	Ref<GDScript> script;
+	if (path=="") {
+		script=Ref<GDScript>(p_root);
+	} else {
+		script=ResourceLoader::load(path);
+		if (script.is_null() || !script->valid)
+			return Ref<GDScript>(); //missing or cyclic
+	}
+
+	for(int i=0;i<chain_size;i++) {
+
+		StringName sub=r.get_string();
+		if (r.error || !script->subclasses.has(sub))
+			return Ref<GDScript>();
+		script=script->subclasses[sub];
+	}
+
+	return script;
+}
+
+bool GDCompiledScript::_save_constant(Writer &w,const Variant& p_constant,const GDScript *p_root) {
+
+	if (p_constant.get_type()==Variant::OBJECT) {
+
+		Object *obj=p_constant;
+		if (!obj) {
+			w.put_32(CONSTANT_VARIANT);
+			return w.put_variant(p_constant);
+		}
+
+		GDScript *script=obj->cast_to<GDScript>();
+		if (script) {
+			w.put_32(CONSTANT_SCRIPT);
+			return _save_script_ref(w,script,p_root);
+		}
+
+		GDNativeClass *native=obj->cast_to<GDNativeClass>();
+		if (native) {
+			w.put_32(CONSTANT_NATIVE_CLASS);
+			w.put_string(native->get_name());
+			return true;
+		}
+
+		Resource *res=obj->cast_to<Resource>();
+		if (res) {
+			String path=res->get_path();
+			if (path=="" || path.find("::")!=-1 || path.begins_with("local://"))
+				return false; //built-in resources can't be referenced by path
+			w.put_32(CONSTANT_RESOURCE);
+			w.put_string(path);
+			return true;
+		}
+
+		return false;
+	}
+
+	if (_has_objects(p_constant))
+		return false;
+
+	w.put_32(CONSTANT_VARIANT);
+	return w.put_variant(p_constant);
+}
+
+Error GDCompiledScript::_load_constant(Reader &r,Variant& r_constant,GDScript *p_root) {
+
+	int kind=r.get_32();
+	if (r.error)
+		return ERR_FILE_CORRUPT;
+
+	switch(kind) {
+
+		case CONSTANT_VARIANT: {
+
+			r_constant=r.get_variant();
+		} break;
+		case CONSTANT_SCRIPT: {
+
+			Ref<GDScript> script=_load_script_ref(r,p_root);
+			if (script.is_null())
+				return ERR_FILE_NOT_FOUND;
+			r_constant=script;
+		} break;
+		case CONSTANT_NATIVE_CLASS: {
+
+			StringName name=r.get_string();
+			const Map<StringName,int>& globals=GDScriptLanguage::get_singleton()->get_global_map();
+			if (!globals.has(name))
+				return ERR_UNAVAILABLE;
+			r_constant=GDScriptLanguage::get_singleton()->get_global_array()[globals[name]];
+		} break;
+		case CONSTANT_RESOURCE: {
+
+			String path=r.get_string();
+			if (r.error)
+				return ERR_FILE_CORRUPT;
+			RES res=ResourceLoader::load(path);
+			if (res.is_null())
+				return ERR_FILE_NOT_FOUND;
+			r_constant=res;
+		} break;
+		default: {
+
+			return ERR_FILE_CORRUPT;
+		}
+	}
+
+	return r.error ? ERR_FILE_CORRUPT : OK;
+}
+
+bool GDCompiledScript::_save_function(Writer &w,const GDFunction *p_function,const GDScript *p_root,const Map<int,StringName>& p_globals) {
+
+	w.put_string(p_function->name);
+	w.put_32(p_function->_static ? 1 : 0);
+	w.put_32(p_function->_argument_count);
+	w.put_32(p_function->_stack_size);
+	w.put_32(p_function->_call_size);
+	w.put_32(p_function->_initial_line);
+	w.put_32(p_function->_call_cache_count);
+	w.put_32(p_function->_member_cache_count);
+
+	w.put_32(p_function->constants.size());
+	for(int i=0;i<p_function->constants.size();i++) {
+
+		if (!_save_constant(w,p_function->constants[i],p_root))
+			return false;
+	}
+
+	w.put_32(p_function->global_names.size());
+	for(int i=0;i<p_function->global_names.size();i++) {
+
+		w.put_string(p_function->global_names[i]);
+	}
+
+	w.put_32(p_function->default_arguments.size());
+	for(int i=0;i<p_function->default_arguments.size();i++) {
+
+		w.put_32(p_function->default_arguments[i]);
+	}
+
+	const Vector<int> &code=p_function->code;
+	w.put_32(code.size());
+	for(int i=0;i<code.size();i++) {
+
+		w.put_32(code[i]);
+	}
+
+	w.put_32(p_function->lines.size());
+	for(int i=0;i<p_function->lines.size();i++) {
+
+		w.put_32(p_function->lines[i]);
+	}
+
+	//global indices depend on registration order, so they are stored by name and relocated on load
+	Vector<int> addresses;
+	for(int ip=0;ip<code.size();) {
+
+		int len=GDFunction::get_instruction_operands(code.ptr(),code.size(),ip,&addresses);
+		if (len==0)
+			return false;
+		ip+=len;
+	}
+
+	Vector<int> relocations;
+	for(int i=0;i<addresses.size();i++) {
+
+		int addr=code[addresses[i]];
+		if (((addr&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS)==GDFunction::ADDR_TYPE_GLOBAL)
+			relocations.push_back(addresses[i]);
+	}
+
+	w.put_32(relocations.size());
+	for(int i=0;i<relocations.size();i++) {
+
+		int index=code[relocations[i]]&GDFunction::ADDR_MASK;
+		if (!p_globals.has(index))
+			return false;
+		w.put_32(relocations[i]);
+		w.put_string(p_globals[index]);
+	}
+
+	w.put_32(p_function->stack_debug.size());
+	for(const List<GDFunction::StackDebug>::Element *E=p_function->stack_debug.front();E;E=E->next()) {
+
+		w.put_32(E->get().line);
+		w.put_32(E->get().pos);
+		w.put_32(E->get().added ? 1 : 0);
+		w.put_string(E->get().identifier);
+	}
+
+#ifdef TOOLS_ENABLED
+	w.put_32(p_function->arg_names.size());
+	for(int i=0;i<p_function->arg_names.size();i++) {
+
+		w.put_string(p_function->arg_names[i]);
+	}
+#else
+	w.put_32(0);
+#endif
+
+	return true;
+}
+
+Error GDCompiledScript::_load_function(Reader &r,GDScript *p_script,GDScript *p_root,GDFunction *p_function) {
+
+	p_function->_static=r.get_32();
+	p_function->_argument_count=r.get_32();
+	p_function->_stack_size=r.get_32();
+	p_function->_call_size=r.get_32();
+	p_function->_initial_line=r.get_32();
+	int call_cache_count=r.get_32();
+	int member_cache_count=r.get_32();
+	if (r.error || call_cache_count<0 || member_cache_count<0)
+		return ERR_FILE_CORRUPT;
+	if (p_function->_argument_count<0 || p_function->_stack_size<p_function->_argument_count || p_function->_call_size<0)
+		return ERR_FILE_CORRUPT;
+
+	int constant_count=r.get_32();
+	if (r.error || constant_count<0)
+		return ERR_FILE_CORRUPT;
+	p_function->constants.resize(constant_count);
+	for(int i=0;i<constant_count;i++) {
+
+		Error err=_load_constant(r,p_function->constants[i],p_root);
+		if (err)
+			return err;
+	}
+
+	int name_count=r.get_32();
+	if (r.error || name_count<0)
+		return ERR_FILE_CORRUPT;
+	p_function->global_names.resize(name_count);
+	for(int i=0;i<name_count;i++) {
+
+		p_function->global_names[i]=r.get_string();
+	}
+
+	int defarg_count=r.get_32();
+	if (r.error || defarg_count<0 || defarg_count>p_function->_argument_count)
+		return ERR_FILE_CORRUPT;
+	p_function->default_arguments.resize(defarg_count);
+	for(int i=0;i<defarg_count;i++) {
+
+		p_function->default_arguments[i]=r.get_32();
+	}
+
+	int code_size=r.get_32();
+	if (r.error || code_size<0 || code_size>(r.len-r.pos)/4)
+		return ERR_FILE_CORRUPT;
+	p_function->code.resize(code_size);
+	for(int i=0;i<code_size;i++) {
+
+		p_function->code[i]=r.get_32();
+	}
+
+	int line_count=r.get_32();
+	if (r.error || line_count<0 || line_count&1 || line_count>(r.len-r.pos)/4)
+		return ERR_FILE_CORRUPT;
+	p_function->lines.resize(line_count);
+	for(int i=0;i<line_count;i++) {
+
+		p_function->lines[i]=r.get_32();
+	}
+
+	int relocation_count=r.get_32();
+	if (r.error || relocation_count<0)
+		return ERR_FILE_CORRUPT;
+
+	const Map<StringName,int>& globals=GDScriptLanguage::get_singleton()->get_global_map();
+	for(int i=0;i<relocation_count;i++) {
+
+		int pos=r.get_32();
+		StringName global=r.get_string();
+		if (r.error || pos<0 || pos>=code_size)
+			return ERR_FILE_CORRUPT;
+		if (!globals.has(global))
+			return ERR_UNAVAILABLE; //singleton or class not present in this build
+		p_function->code[pos]=(GDFunction::ADDR_TYPE_GLOBAL<<GDFunction::ADDR_BITS)|globals[global];
+	}
+
+	int stack_debug_count=r.get_32();
+	if (r.error || stack_debug_count<0)
+		return ERR_FILE_CORRUPT;
+	for(int i=0;i<stack_debug_count;i++) {
+
+		GDFunction::StackDebug sd;
+		sd.line=r.get_32();
+		sd.pos=r.get_32();
+		sd.added=r.get_32();
+		sd.identifier=r.get_string();
+		p_function->stack_debug.push_back(sd);
+	}
+
+	int arg_name_count=r.get_32();
+	if (r.error || arg_name_count<0)
+		return ERR_FILE_CORRUPT;
+	for(int i=0;i<arg_name_count;i++) {
+
+		StringName arg=r.get_string();
+#ifdef TOOLS_ENABLED
+		p_function->arg_names.push_back(arg);
+#endif
+	}
+
+	if (r.error)
+		return ERR_FILE_CORRUPT;
+
+	//caches are sized from the code, refuse anything that would make them huge
+	if (call_cache_count>code_size || member_cache_count>code_size)
+		return ERR_FILE_CORRUPT;
+
+	if (!_validate_code(p_script,p_function,call_cache_count,member_cache_count))
+		return ERR_FILE_CORRUPT;
+
+	//same setup GDCompiler::_parse_function does
+	p_function->_constant_count=p_function->constants.size();
+	p_function->_constants_ptr=p_function->constants.size() ? &p_function->constants[0] : NULL;
+	p_function->_global_names_count=p_function->global_names.size();
+	p_function->_global_names_ptr=p_function->global_names.size() ? &p_function->global_names[0] : NULL;
+	p_function->_default_arg_count=p_function->default_arguments.size();
+	p_function->_default_arg_ptr=p_function->default_arguments.size() ? &p_function->default_arguments[0] : NULL;
+	p_function->_code_size=p_function->code.size();
+	p_function->_code_ptr=p_function->code.size() ? &p_function->code[0] : NULL;
+
+	p_function->call_caches.resize(call_cache_count);
+	p_function->_call_cache_count=call_cache_count;
+	p_function->_call_cache_ptr=call_cache_count ? &p_function->call_caches[0] : NULL;
+	p_function->member_caches.resize(member_cache_count);
+	p_function->_member_cache_count=member_cache_count;
+	p_function->_member_cache_ptr=member_cache_count ? &p_function->member_caches[0] : NULL;
+
+	p_function->_script=p_script;
+	p_function->source=p_root->get_path();
+
+#ifdef DEBUG_ENABLED
+	p_function->func_cname=(String(p_function->source)+" - "+String(p_function->name)).utf8();
+	p_function->_func_cname=p_function->func_cname.get_data();
+#endif
+
+	return OK;
+}
+
+//the VM trusts the compiler, so loaded code gets every operand checked before it's allowed to run
+bool GDCompiledScript::_validate_code(const GDScript *p_script,const GDFunction *p_function,int p_call_cache_count,int p_member_cache_count) {
+
+	const Vector<int> &code=p_function->code;
+	int code_size=code.size();
+	if (code_size==0)
+		return false;
+
+	const int *c=code.ptr();
+	int name_count=p_function->global_names.size();
+	int global_count=GDScriptLanguage::get_singleton()->get_global_array_size();
+
+	Vector<uint8_t> starts;
+	starts.resize(code_size);
+	zeromem(starts.ptr(),code_size);
+
+	Vector<int> addresses;
+	Vector<int> jumps;
+	int last_opcode=-1;
+
+	for(int ip=0;ip<code_size;) {
+
+		int op=c[ip];
+		if (op<0 || op>GDFunction::OPCODE_END)
+			return false;
+
+		//immediates, checked first so the argument counts are sane when computing the length
+		switch(op) {
+
+			case GDFunction::OPCODE_OPERATOR:
+			case GDFunction::OPCODE_OPERATOR_POLY:
+			case GDFunction::OPCODE_OPERATOR_INT:
+			case GDFunction::OPCODE_OPERATOR_REAL: {
+
+				if (ip+1>=code_size || c[ip+1]<0 || c[ip+1]>=Variant::OP_MAX)
+					return false;
+			} break;
+			case GDFunction::OPCODE_SET_NAMED:
+			case GDFunction::OPCODE_GET_NAMED: {
+
+				if (ip+3>=code_size || c[ip+2]<0 || c[ip+2]>=name_count || c[ip+3]<0 || c[ip+3]>=p_member_cache_count)
+					return false;
+			} break;
+			case GDFunction::OPCODE_CONSTRUCT: {
+
+				if (ip+2>=code_size || c[ip+1]<0 || c[ip+1]>=Variant::VARIANT_MAX || c[ip+2]<0 || c[ip+2]>p_function->_call_size)
+					return false;
+			} break;
+			case GDFunction::OPCODE_CONSTRUCT_ARRAY:
+			case GDFunction::OPCODE_CONSTRUCT_DICTIONARY: {
+
+				if (ip+1>=code_size || c[ip+1]<0 || c[ip+1]>code_size)
+					return false;
+			} break;
+			case GDFunction::OPCODE_CALL:
+			case GDFunction::OPCODE_CALL_RETURN: {
+
+				if (ip+4>=code_size || c[ip+1]<0 || c[ip+1]>p_function->_call_size || c[ip+3]<0 || c[ip+3]>=name_count || c[ip+4]<0 || c[ip+4]>=p_call_cache_count)
+					return false;
+			} break;
+			case GDFunction::OPCODE_CALL_BUILT_IN: {
+
+				if (ip+2>=code_size || c[ip+1]<0 || c[ip+1]>=GDFunctions::FUNC_MAX || c[ip+2]<0 || c[ip+2]>p_function->_call_size)
+					return false;
+			} break;
+			case GDFunction::OPCODE_CALL_SELF_BASE: {
+
+				if (ip+2>=code_size || c[ip+1]<0 || c[ip+1]>=name_count || c[ip+2]<0 || c[ip+2]>p_function->_call_size)
+					return false;
+			} break;
+			case GDFunction::OPCODE_ITERATE_RANGE_BEGIN: {
+
+				if (ip+1>=code_size || c[ip+1]<1 || c[ip+1]>3 || c[ip+1]>p_function->_call_size)
+					return false;
+			} break;
+			default: {}
+		}
+
+		int from=addresses.size();
+		int len=GDFunction::get_instruction_operands(c,code_size,ip,&addresses,&jumps);
+		if (len<=0)
+			return false; //unknown opcode or truncated
+
+		for(int i=from;i<addresses.size();i++) {
+
+			int addr=c[addresses[i]];
+			unsigned int type=((unsigned int)addr)>>GDFunction::ADDR_BITS;
+			int idx=addr&GDFunction::ADDR_MASK;
+			int limit;
+
+			switch(type) {
+
+				case GDFunction::ADDR_TYPE_SELF:
+				case GDFunction::ADDR_TYPE_CLASS:
+				case GDFunction::ADDR_TYPE_NIL: limit=1; break;
+				case GDFunction::ADDR_TYPE_MEMBER: limit=p_script->member_indices.size(); break;
+				case GDFunction::ADDR_TYPE_CLASS_CONSTANT: limit=name_count; break;
+				case GDFunction::ADDR_TYPE_LOCAL_CONSTANT: limit=p_function->constants.size(); break;
+				case GDFunction::ADDR_TYPE_STACK:
+				case GDFunction::ADDR_TYPE_STACK_VARIABLE: limit=p_function->_stack_size; break;
+				case GDFunction::ADDR_TYPE_GLOBAL: limit=global_count; break;
+				default: return false;
+			}
+
+			if (idx>=limit)
+				return false;
+		}
+
+		starts[ip]=1;
+		last_opcode=op;
+		ip+=len;
+	}
+
+	//dispatch does not check for the end of the code
+	if (last_opcode!=GDFunction::OPCODE_END)
+		return false;
+
+	for(int i=0;i<jumps.size();i++) {
+
+		int to=c[jumps[i]];
+		if (to<0 || to>=code_size || !starts[to])
+			return false;
+	}
+
+	for(int i=0;i<p_function->default_arguments.size();i++) {
+
+		int to=p_function->default_arguments[i];
+		if (to<0 || to>=code_size || !starts[to])
+			return false;
+	}
+
+	return true;
+}
+
+bool GDCompiledScript::_save_class(Writer &w,const GDScript *p_script,const GDScript *p_root,const Map<int,StringName>& p_globals) {
+
+	w.put_string(p_script->name);
+	w.put_32(p_script->tool ? 1 : 0);
+
+	if (p_script->base.is_valid()) {
+
+		w.put_32(BASE_SCRIPT);
+		if (!_save_script_ref(w,p_script->base.ptr(),p_root))
+			return false;
+	} else if (p_script->native.is_valid()) {
+
+		w.put_32(BASE_NATIVE);
+		w.put_string(p_script->native->get_name());
+	} else {
+
+		w.put_32(BASE_NONE);
+	}
+
+	w.put_32(p_script->member_indices.size());
+	for(const Map<StringName,GDScript::MemberInfo>::Element *E=p_script->member_indices.front();E;E=E->next()) {
+
+		w.put_string(E->key());
+		w.put_32(E->get().index);
+		w.put_string(E->get().setter);
+		w.put_string(E->get().getter);
+	}
+
+	w.put_32(p_script->members.size());
+	for(const Set<StringName>::Element *E=p_script->members.front();E;E=E->next()) {
+
+		w.put_string(E->get());
+	}
+
+	w.put_32(p_script->member_info.size());
+	for(const Map<StringName,PropertyInfo>::Element *E=p_script->member_info.front();E;E=E->next()) {
+
+		w.put_string(E->key());
+		w.put_32(E->get().type);
+		w.put_string(E->get().name);
+		w.put_32(E->get().hint);
+		w.put_string(E->get().hint_string);
+		w.put_32(E->get().usage);
+	}
+
+#ifdef TOOLS_ENABLED
+	w.put_32(p_script->member_default_values.size());
+	for(const Map<StringName,Variant>::Element *E=p_script->member_default_values.front();E;E=E->next()) {
+
+		w.put_string(E->key());
+		if (!_save_constant(w,E->get(),p_root))
+			return false;
+	}
+#else
+	w.put_32(0);
+#endif
+
+	w.put_32(p_script->_signals.size());
+	for(const Map<StringName,Vector<StringName> >::Element *E=p_script->_signals.front();E;E=E->next()) {
+
+		w.put_string(E->key());
+		w.put_32(E->get().size());
+		for(int i=0;i<E->get().size();i++) {
+			w.put_string(E->get()[i]);
+		}
+	}
+
+	//subclasses are also constants, they are saved on their own below
+	w.put_32(p_script->constants.size()-p_script->subclasses.size());
+	for(const Map<StringName,Variant>::Element *E=p_script->constants.front();E;E=E->next()) {
+
+		if (p_script->subclasses.has(E->key()))
+			continue;
+		w.put_string(E->key());
+		if (!_save_constant(w,E->get(),p_root))
+			return false;
+	}
+
+	w.put_32(p_script->subclasses.size());
+	for(const Map<StringName,Ref<GDScript> >::Element *E=p_script->subclasses.front();E;E=E->next()) {
+
+		w.put_string(E->key());
+		if (!_save_class(w,E->get().ptr(),p_root,p_globals))
+			return false;
+	}
+
+	w.put_32(p_script->member_functions.size());
+	for(const Map<StringName,GDFunction>::Element *E=p_script->member_functions.front();E;E=E->next()) {
+
+		if (!_save_function(w,&E->get(),p_root,p_globals))
+			return false;
+	}
+
+	return true;
+}
+
+Error GDCompiledScript::_load_class(Reader &r,GDScript *p_script,GDScript *p_owner,GDScript *p_root) {
+
+	//same reset GDCompiler::_parse_class does
+	p_script->native=Ref<GDNativeClass>();
+	p_script->base=Ref<GDScript>();
+	p_script->_base=NULL;
+	p_script->members.clear();
+	p_script->constants.clear();
+	p_script->member_functions.clear();
+	p_script->member_indices.clear();
+	p_script->member_info.clear();
+	p_script->initializer=NULL;
+	p_script->subclasses.clear();
+	p_script->_signals.clear();
+	p_script->_owner=p_owner;
+	p_script->name=r.get_string();
+	p_script->tool=r.get_32();
+
+	int base_type=r.get_32();
+	if (r.error)
+		return ERR_FILE_CORRUPT;
+
+	switch(base_type) {
+
+		case BASE_NONE: {} break;
+		case BASE_NATIVE: {
+
+			StringName native=r.get_string();
+			const Map<StringName,int>& globals=GDScriptLanguage::get_singleton()->get_global_map();
+			if (r.error || !globals.has(native))
+				return ERR_UNAVAILABLE;
+			p_script->native=GDScriptLanguage::get_singleton()->get_global_array()[globals[native]];
+			if (p_script->native.is_null())
+				return ERR_UNAVAILABLE;
+		} break;
+		case BASE_SCRIPT: {
+
+			Ref<GDScript> base=_load_script_ref(r,p_root);
+			if (base.is_null())
+				return ERR_FILE_NOT_FOUND;
+			p_script->base=base;
+			p_script->_base=base.ptr();
+		} break;
+		default: {
+
+			return ERR_FILE_CORRUPT;
+		}
+	}
+
+	int member_count=r.get_32();
+	for(int i=0;i<member_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		GDScript::MemberInfo minfo;
+		minfo.index=r.get_32();
+		minfo.setter=r.get_string();
+		minfo.getter=r.get_string();
+		p_script->member_indices[name]=minfo;
+	}
+
+	if (r.error)
+		return ERR_FILE_CORRUPT;
+
+	if (p_script->_base) {
+		//member slots are inherited, the base must still have the layout this class was compiled against
+		for(const Map<StringName,GDScript::MemberInfo>::Element *E=p_script->_base->member_indices.front();E;E=E->next()) {
+
+			const Map<StringName,GDScript::MemberInfo>::Element *M=p_script->member_indices.find(E->key());
+			if (!M || M->get().index!=E->get().index)
+				return ERR_INVALID_DATA;
+		}
+	}
+
+	int own_member_count=r.get_32();
+	for(int i=0;i<own_member_count && !r.error;i++) {
+
+		p_script->members.insert(r.get_string());
+	}
+
+	int member_info_count=r.get_32();
+	for(int i=0;i<member_info_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		PropertyInfo pinfo;
+		pinfo.type=Variant::Type(r.get_32());
+		pinfo.name=r.get_string();
+		pinfo.hint=PropertyHint(r.get_32());
+		pinfo.hint_string=r.get_string();
+		pinfo.usage=r.get_32();
+		p_script->member_info[name]=pinfo;
+	}
+
+	int default_value_count=r.get_32();
+	for(int i=0;i<default_value_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		Variant value;
+		Error err=_load_constant(r,value,p_root);
+		if (err)
+			return err;
+#ifdef TOOLS_ENABLED
+		p_script->member_default_values[name]=value;
+#endif
+	}
+
+	int signal_count=r.get_32();
+	for(int i=0;i<signal_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		int argc=r.get_32();
+		if (r.error || argc<0)
+			return ERR_FILE_CORRUPT;
+		Vector<StringName> args;
+		args.resize(argc);
+		for(int j=0;j<argc;j++) {
+			args[j]=r.get_string();
+		}
+		p_script->_signals[name]=args;
+	}
+
+	int constant_count=r.get_32();
+	for(int i=0;i<constant_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		Variant value;
+		Error err=_load_constant(r,value,p_root);
+		if (err)
+			return err;
+		p_script->constants.insert(name,value);
+	}
+
+	int subclass_count=r.get_32();
+	for(int i=0;i<subclass_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		Ref<GDScript> subclass = memnew( GDScript );
+		Error err=_load_class(r,subclass.ptr(),p_script,p_root);
+		if (err)
+			return err;
+
+		p_script->constants.insert(name,subclass);
+		p_script->subclasses.insert(name,subclass);
+	}
+
+	int function_count=r.get_32();
+	for(int i=0;i<function_count && !r.error;i++) {
+
+		StringName name=r.get_string();
+		if (r.error)
+			break;
+		p_script->member_functions[name]=GDFunction();
+		GDFunction *function=&p_script->member_functions[name];
+		function->name=name;
+		Error err=_load_function(r,p_script,p_root,function);
+		if (err)
+			return err;
+
+		if (String(name)=="_init")
+			p_script->initializer=function;
+	}
+
+	if (r.error)
+		return ERR_FILE_CORRUPT;
+
+	return OK;
+}
+
+Vector<uint8_t> GDCompiledScript::save(const Ref<GDScript>& p_script,const Vector<uint8_t>& p_tokens) {
+
+	ERR_FAIL_COND_V(p_script.is_null(),Vector<uint8_t>());
+	ERR_FAIL_COND_V(p_tokens.size()==0,Vector<uint8_t>());
+
+	Map<int,StringName> globals;
+	const Map<StringName,int>& global_map=GDScriptLanguage::get_singleton()->get_global_map();
+	for(const Map<StringName,int>::Element *E=global_map.front();E;E=E->next()) {
+		globals[E->get()]=E->key();
+	}
+
+	Writer w;
+	w.buf.resize(COMPILED_SCRIPT_HEADER_SIZE);
+	w.buf[0]='G';
+	w.buf[1]='D';
+	w.buf[2]='S';
+	w.buf[3]='B';
+	encode_uint32(COMPILED_SCRIPT_VERSION,&w.buf[4]);
+	encode_uint32(VERSION_MAJOR,&w.buf[8]);
+	encode_uint32(VERSION_MINOR,&w.buf[12]);
+	encode_uint32(GDFunction::OPCODE_END+1,&w.buf[16]);
+	encode_uint32(GDFunctions::FUNC_MAX,&w.buf[20]);
+	encode_uint32(hash_djb2_buffer(p_tokens.ptr(),p_tokens.size()),&w.buf[24]);
+	encode_uint32(Variant::VARIANT_MAX,&w.buf[28]);
+	encode_uint32(p_tokens.size(),&w.buf[32]);
+	encode_uint32(COMPILED_SCRIPT_BUILD_TYPE,&w.buf[36]);
+
+	int pos=w.buf.size();
+	w.buf.resize(pos+p_tokens.size());
+	copymem(&w.buf[pos],p_tokens.ptr(),p_tokens.size());
+
+	if (!_save_class(w,p_script.ptr(),p_script.ptr(),globals))
+		return Vector<uint8_t>(); //references something that can't be stored, keep using tokens
+
+	return w.buf;
+}
+
+bool GDCompiledScript::is_compiled(const Vector<uint8_t>& p_buffer) {
+
+	return p_buffer.size()>=COMPILED_SCRIPT_HEADER_SIZE && p_buffer[0]=='G' && p_buffer[1]=='D' && p_buffer[2]=='S' && p_buffer[3]=='B';
+}
+
+Vector<uint8_t> GDCompiledScript::get_tokens(const Vector<uint8_t>& p_buffer) {
+
+	//token layout never changes, so this works for caches from any version (version 2 had a shorter header)
+	ERR_FAIL_COND_V(!is_compiled(p_buffer),Vector<uint8_t>());
+	int header_size=decode_uint32(&p_buffer.ptr()[4])<3 ? 36 : COMPILED_SCRIPT_HEADER_SIZE;
+	int token_len=decode_uint32(&p_buffer.ptr()[32]);
+	ERR_FAIL_COND_V(token_len<0 || token_len>p_buffer.size()-header_size,Vector<uint8_t>());
+
+	Vector<uint8_t> tokens;
+	tokens.resize(token_len);
+	if (token_len)
+		copymem(&tokens[0],&p_buffer.ptr()[header_size],token_len);
+	return tokens;
+}
+
+Error GDCompiledScript::load(const Vector<uint8_t>& p_buffer,GDScript *p_script) {
+
+	ERR_FAIL_COND_V(!is_compiled(p_buffer),ERR_INVALID_DATA);
+
+	const uint8_t *buf=p_buffer.ptr();
+
+	if (decode_uint32(&buf[4])!=COMPILED_SCRIPT_VERSION ||
+		decode_uint32(&buf[8])!=VERSION_MAJOR ||
+		decode_uint32(&buf[12])!=VERSION_MINOR ||
+		decode_uint32(&buf[16])!=GDFunction::OPCODE_END+1 ||
+		decode_uint32(&buf[20])!=GDFunctions::FUNC_MAX ||
+		decode_uint32(&buf[28])!=Variant::VARIANT_MAX) {
+
+		return ERR_FILE_UNRECOGNIZED; //built by another engine version
+	}
+
+	if (decode_uint32(&buf[36])!=COMPILED_SCRIPT_BUILD_TYPE)
+		return ERR_FILE_UNRECOGNIZED; //debug cache in a release build or the other way around
+
+	int token_len=decode_uint32(&buf[32]);
+	if (token_len<0 || token_len>p_buffer.size()-COMPILED_SCRIPT_HEADER_SIZE)
+		return ERR_FILE_CORRUPT;
+
+	if (hash_djb2_buffer(&buf[COMPILED_SCRIPT_HEADER_SIZE],token_len)!=decode_uint32(&buf[24]))
+		return ERR_FILE_CORRUPT; //not compiled from this source
+
+	Reader r;
+	r.ptr=&buf[COMPILED_SCRIPT_HEADER_SIZE+token_len];
+	r.len=p_buffer.size()-COMPILED_SCRIPT_HEADER_SIZE-token_len;
+	r.pos=0;
+	r.error=false;
+
+	//functions are about to be replaced, drop any call site cache pointing to them
+	GDScriptLanguage::get_singleton()->invalidate_call_caches();
+
+	Error err=_load_class(r,p_script,NULL,p_script);
+	if (err==OK && r.error)
+		err=ERR_FILE_CORRUPT;
+
+	return err;
+}
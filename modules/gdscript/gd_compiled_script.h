@@ -0,0 +1,65 @@
+/*************************************************************************/
+/*  gd_compiled_script.h                                                 */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef GD_COMPILED_SCRIPT_H
+#define GD_COMPILED_SCRIPT_H
+
+#include "gd_script.h"
+
+/* Compiled script cache. Stores the output of GDCompiler (functions, constants,
+ * global names and member layout) next to the token buffer it was built from,
+ * so exported scripts can be loaded without parsing or compiling. The token
+ * buffer is kept as a fallback for when the cache does not validate (different
+ * engine version, changed globals, etc).
+ */
+
+class GDCompiledScript {
+
+	struct Writer;
+	struct Reader;
+
+	static bool _save_class(Writer &w,const GDScript *p_script,const GDScript *p_root,const Map<int,StringName>& p_globals);
+	static bool _save_function(Writer &w,const GDFunction *p_function,const GDScript *p_root,const Map<int,StringName>& p_globals);
+	static bool _save_script_ref(Writer &w,const GDScript *p_script,const GDScript *p_root);
+	static bool _save_constant(Writer &w,const Variant& p_constant,const GDScript *p_root);
+
+	static Error _load_class(Reader &r,GDScript *p_script,GDScript *p_owner,GDScript *p_root);
+	static Error _load_function(Reader &r,GDScript *p_script,GDScript *p_root,GDFunction *p_function);
+	static Ref<GDScript> _load_script_ref(Reader &r,GDScript *p_root);
+	static Error _load_constant(Reader &r,Variant& r_constant,GDScript *p_root);
+	static bool _validate_code(const GDScript *p_script,const GDFunction *p_function,int p_call_cache_count,int p_member_cache_count);
+
+public:
+
+	static Vector<uint8_t> save(const Ref<GDScript>& p_script,const Vector<uint8_t>& p_tokens);
+	static bool is_compiled(const Vector<uint8_t>& p_buffer);
+	static Vector<uint8_t> get_tokens(const Vector<uint8_t>& p_buffer);
+	static Error load(const Vector<uint8_t>& p_buffer,GDScript *p_script);
+};
+
+#endif // GD_COMPILED_SCRIPT_H
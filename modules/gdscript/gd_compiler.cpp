@@ -61,6 +61,22 @@ bool GDCompiler::_create_unary_operator(CodeGen& codegen,const GDParser::Operato
 	return true;
 }
 
+Variant::Type GDCompiler::_guess_operand_type(CodeGen& codegen,const GDParser::Node *p_node) {
+
+	if (p_node->type==GDParser::Node::TYPE_CONSTANT) {
+
+		return static_cast<const GDParser::ConstantNode*>(p_node)->value.get_type();
+	} else if (p_node->type==GDParser::Node::TYPE_IDENTIFIER) {
+
+		const StringName &identifier = static_cast<const GDParser::IdentifierNode*>(p_node)->name;
+		const Map<StringName,int>::Element *E=codegen.stack_identifiers.find(identifier);
+		if (E && codegen.int_loop_counters.has(E->get()))
+			return Variant::INT;
+	}
+
+	return Variant::NIL; //unknown
+}
+
 bool GDCompiler::_create_binary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level,bool p_initializer) {
 
 	ERR_FAIL_COND_V(on->arguments.size()!=2,false);
@@ -76,8 +92,17 @@ bool GDCompiler::_create_binary_operator(CodeGen& codegen,const GDParser::Operat
 	if (src_address_b<0)
 		return false;
 
+	//when both types are known, start with the specialized version instead of waiting for it to quicken
+	int opcode=GDFunction::OPCODE_OPERATOR;
+	Variant::Type type_a = _guess_operand_type(codegen,on->arguments[0]);
+	Variant::Type type_b = _guess_operand_type(codegen,on->arguments[1]);
+	if (type_a!=Variant::NIL && type_b!=Variant::NIL) {
+		GDFunction::Opcode specialized = GDFunction::get_operator_opcode(op,type_a,type_b);
+		if (specialized!=GDFunction::OPCODE_OPERATOR_POLY)
+			opcode=specialized;
+	}
 
-	codegen.opcodes.push_back(GDFunction::OPCODE_OPERATOR); // perform operator
+	codegen.opcodes.push_back(opcode); // perform operator
 	codegen.opcodes.push_back(op); //which operator
 	codegen.opcodes.push_back(src_address_a); // argument 1
 	codegen.opcodes.push_back(src_address_b); // argument 2 (unary only takes one parameter)
@@ -357,6 +382,7 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 			//hell breaks loose
 
 			const GDParser::OperatorNode *on = static_cast<const GDParser::OperatorNode*>(p_expression);
+			int op_start=codegen.opcodes.size();
 			switch(on->op) {
 
 
@@ -503,8 +529,11 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 						codegen.opcodes.push_back(p_root?GDFunction::OPCODE_CALL:GDFunction::OPCODE_CALL_RETURN); // perform operator
 						codegen.opcodes.push_back(on->arguments.size()-2);
 						codegen.alloc_call(on->arguments.size()-2);
-						for(int i=0;i<arguments.size();i++)
+						for(int i=0;i<arguments.size();i++) {
 							codegen.opcodes.push_back(arguments[i]);
+							if (i==1)
+								codegen.opcodes.push_back(codegen.call_cache_count++); //call site cache, after method name
+						}
 					}
 				} break;
 				case GDParser::OperatorNode::OP_YIELD: {
@@ -587,6 +616,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 					codegen.opcodes.push_back(named?GDFunction::OPCODE_GET_NAMED:GDFunction::OPCODE_GET); // perform operator
 					codegen.opcodes.push_back(from); // argument 1
 					codegen.opcodes.push_back(index); // argument 2 (unary only takes one parameter)
+					if (named)
+						codegen.opcodes.push_back(codegen.member_cache_count++); //member access cache
 
 				} break;
 				case GDParser::OperatorNode::OP_AND: {
@@ -801,6 +832,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 							codegen.opcodes.push_back(named ? GDFunction::OPCODE_GET_NAMED : GDFunction::OPCODE_GET);
 							codegen.opcodes.push_back(prev_pos);
 							codegen.opcodes.push_back(key_idx);
+							if (named)
+								codegen.opcodes.push_back(codegen.member_cache_count++);
 							slevel++;
 							codegen.alloc_stack(slevel);
 							int dst_pos = (GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS)|slevel;
@@ -809,6 +842,8 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 
 							//add in reverse order, since it will be reverted
 							setchain.push_back(dst_pos);
+							if (named)
+								setchain.push_back(codegen.member_cache_count++);
 							setchain.push_back(key_idx);
 							setchain.push_back(prev_pos);
 							setchain.push_back(named ? GDFunction::OPCODE_SET_NAMED : GDFunction::OPCODE_SET);
@@ -853,15 +888,14 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 						codegen.opcodes.push_back(named?GDFunction::OPCODE_SET_NAMED:GDFunction::OPCODE_SET);
 						codegen.opcodes.push_back(prev_pos);
 						codegen.opcodes.push_back(set_index);
+						if (named)
+							codegen.opcodes.push_back(codegen.member_cache_count++);
 						codegen.opcodes.push_back(set_value);
 
-						for(int i=0;i<setchain.size();i+=4) {
-
+						//named sets carry a cache operand, so entries are not all the same size
+						for(int i=0;i<setchain.size();i++) {
 
-							codegen.opcodes.push_back(setchain[i+0]);
-							codegen.opcodes.push_back(setchain[i+1]);
-							codegen.opcodes.push_back(setchain[i+2]);
-							codegen.opcodes.push_back(setchain[i+3]);
+							codegen.opcodes.push_back(setchain[i]);
 						}
 
 						return retval;
@@ -932,6 +966,13 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 			int dst_addr=(p_stack_level)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
 			codegen.opcodes.push_back(dst_addr); // append the stack level as destination address of the opcode
 			codegen.alloc_stack(p_stack_level);
+
+			if (optimize) {
+				//operands the parser could not reduce (named constants) may still be constant here
+				int folded=_fold_constant_instruction(codegen,op_start);
+				if (folded>=0)
+					return folded;
+			}
 			return dst_addr;
 		} break;
 		//TYPE_TYPE,
@@ -948,6 +989,140 @@ int GDCompiler::_parse_expression(CodeGen& codegen,const GDParser::Node *p_expre
 }
 
 
+bool GDCompiler::_get_constant_value(CodeGen& codegen,int p_address,Variant& r_value) {
+
+	int idx=p_address&GDFunction::ADDR_MASK;
+
+	switch((p_address&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS) {
+
+		case GDFunction::ADDR_TYPE_LOCAL_CONSTANT: {
+
+			const Variant *K=NULL;
+			while((K=codegen.constant_map.next(K))) {
+
+				if (codegen.constant_map[*K]==idx) {
+					r_value=*K;
+					return true;
+				}
+			}
+		} break;
+		case GDFunction::ADDR_TYPE_CLASS_CONSTANT: {
+
+			for(Map<StringName,int>::Element *E=codegen.name_map.front();E;E=E->next()) {
+
+				if (E->get()!=idx)
+					continue;
+
+				//same lookup order as the VM, but constants inherited from another script may change when it's edited
+				GDScript *owner=codegen.script;
+				while(owner) {
+
+					GDScript *scr=owner;
+					while(scr) {
+
+						const Map<StringName,Variant>::Element *C=scr->constants.find(E->key());
+						if (C) {
+							if (scr!=owner)
+								return false;
+							r_value=C->get();
+							return true;
+						}
+						scr=scr->_base;
+					}
+					owner=owner->_owner;
+				}
+				break;
+			}
+		} break;
+	}
+
+	return false;
+}
+
+int GDCompiler::_fold_constant_instruction(CodeGen& codegen,int p_from) {
+
+	Vector<int> addresses;
+	int len=GDFunction::get_instruction_operands(codegen.opcodes.ptr(),codegen.opcodes.size(),p_from,&addresses);
+	if (len==0 || p_from+len!=codegen.opcodes.size() || addresses.empty())
+		return -1; //operands emitted code, so they are not constant
+
+	int opcode=codegen.opcodes[p_from];
+	switch(opcode) {
+
+		case GDFunction::OPCODE_OPERATOR:
+		case GDFunction::OPCODE_OPERATOR_POLY:
+		case GDFunction::OPCODE_OPERATOR_INT:
+		case GDFunction::OPCODE_OPERATOR_REAL:
+		case GDFunction::OPCODE_CONSTRUCT: {
+
+		} break;
+		case GDFunction::OPCODE_CALL_BUILT_IN: {
+
+			if (!GDFunctions::is_deterministic(GDFunctions::Function(codegen.opcodes[p_from+1])))
+				return -1;
+		} break;
+		default: {
+
+			return -1;
+		}
+	}
+
+	//last address is the destination
+	Vector<Variant> args;
+	args.resize(addresses.size()-1);
+	Vector<const Variant*> argptrs;
+	argptrs.resize(args.size());
+	for(int i=0;i<args.size();i++) {
+
+		if (!_get_constant_value(codegen,codegen.opcodes[addresses[i]],args[i]))
+			return -1;
+		if (args[i].get_type()==Variant::OBJECT)
+			return -1;
+		argptrs[i]=&args[i];
+	}
+
+	Variant result;
+	Variant::CallError err;
+
+	switch(opcode) {
+
+		case GDFunction::OPCODE_CONSTRUCT: {
+
+			result=Variant::construct(Variant::Type(codegen.opcodes[p_from+1]),argptrs.ptr(),args.size(),err);
+			if (err.error!=Variant::CallError::CALL_OK)
+				return -1;
+		} break;
+		case GDFunction::OPCODE_CALL_BUILT_IN: {
+
+			GDFunctions::call(GDFunctions::Function(codegen.opcodes[p_from+1]),argptrs.ptr(),args.size(),result,err);
+			if (err.error!=Variant::CallError::CALL_OK)
+				return -1;
+		} break;
+		default: {
+
+			bool valid;
+			Variant::evaluate(Variant::Operator(codegen.opcodes[p_from+1]),args[0],args[1],result,valid);
+			if (!valid)
+				return -1; //leave the error to runtime
+		}
+	}
+
+	switch(result.get_type()) {
+
+		case Variant::OBJECT:
+		case Variant::ARRAY:
+		case Variant::DICTIONARY: {
+
+			return -1; //shared by reference, each evaluation must create a new one
+		} break;
+		default: {}
+	}
+
+	codegen.opcodes.resize(p_from);
+	return codegen.get_constant_pos(result)|(GDFunction::ADDR_TYPE_LOCAL_CONSTANT<<GDFunction::ADDR_BITS);
+}
+
+
 Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_block,int p_stack_level,int p_break_addr,int p_continue_addr) {
 
 	codegen.push_stack_identifiers();
@@ -1019,50 +1194,116 @@ Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_blo
 
 
 
+						bool range_loop=false;
+						const GDParser::OperatorNode *range_call=NULL;
+						if (cf->arguments[1]->type==GDParser::Node::TYPE_OPERATOR) {
+							const GDParser::OperatorNode *on = static_cast<const GDParser::OperatorNode*>(cf->arguments[1]);
+							if (on->op==GDParser::OperatorNode::OP_CALL && on->arguments.size() && on->arguments[0]->type==GDParser::Node::TYPE_BUILT_IN_FUNCTION && static_cast<const GDParser::BuiltInFunctionNode*>(on->arguments[0])->function==GDFunctions::GEN_RANGE) {
+								range_loop=true;
+								if (on->arguments.size()>=2 && on->arguments.size()<=4)
+									range_call=on; //range() with 1 to 3 arguments is counted in place
+							}
+						}
+
 						int slevel=p_stack_level;
 						int iter_stack_pos=slevel;
 						int iterator_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
 						int counter_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
 						int container_pos = (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS);
+						int step_pos = range_call ? (slevel++)|(GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS) : 0;
 						codegen.alloc_stack(slevel);
 
 						    codegen.push_stack_identifiers();
 						      codegen.add_stack_identifier(static_cast<const GDParser::IdentifierNode*>(cf->arguments[0])->name,iter_stack_pos);
 
-						int ret = _parse_expression(codegen,cf->arguments[1],slevel,false);
-						if (ret<0)
-							return ERR_COMPILATION_FAILED;
+						int break_pos;
+						int continue_pos;
 
-						//assign container
-						codegen.opcodes.push_back(GDFunction::OPCODE_ASSIGN);
-						codegen.opcodes.push_back(container_pos);
-						codegen.opcodes.push_back(ret);
+						if (range_call) {
+
+							Vector<int> arguments;
+							int arg_slevel=slevel;
+							for(int i=1;i<range_call->arguments.size();i++) {
+
+								int ret = _parse_expression(codegen,range_call->arguments[i],arg_slevel);
+								if (ret<0)
+									return ERR_COMPILATION_FAILED;
+
+								if (ret&GDFunction::ADDR_TYPE_STACK<<GDFunction::ADDR_BITS) {
+									arg_slevel++;
+									codegen.alloc_stack(arg_slevel);
+								}
+
+								arguments.push_back(ret);
+							}
 
-						//begin loop
-						codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE_BEGIN);
-						codegen.opcodes.push_back(counter_pos);
-						codegen.opcodes.push_back(container_pos);
-						codegen.opcodes.push_back(codegen.opcodes.size()+4);
-						codegen.opcodes.push_back(iterator_pos);
-						codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
-						codegen.opcodes.push_back(codegen.opcodes.size()+8);
-						//break loop
-						int break_pos=codegen.opcodes.size();
-						codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
-						codegen.opcodes.push_back(0); //skip code for next
-						//next loop
-						int continue_pos=codegen.opcodes.size();
-						codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE);
-						codegen.opcodes.push_back(counter_pos);
-						codegen.opcodes.push_back(container_pos);
-						codegen.opcodes.push_back(break_pos);
-						codegen.opcodes.push_back(iterator_pos);
+							//begin loop, container holds the iterations left
+							codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE_RANGE_BEGIN);
+							codegen.opcodes.push_back(arguments.size());
+							codegen.alloc_call(arguments.size());
+							for(int i=0;i<arguments.size();i++)
+								codegen.opcodes.push_back(arguments[i]);
+							codegen.opcodes.push_back(counter_pos);
+							codegen.opcodes.push_back(container_pos);
+							codegen.opcodes.push_back(step_pos);
+							codegen.opcodes.push_back(codegen.opcodes.size()+4);
+							codegen.opcodes.push_back(iterator_pos);
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
+							codegen.opcodes.push_back(codegen.opcodes.size()+9);
+							//break loop
+							break_pos=codegen.opcodes.size();
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
+							codegen.opcodes.push_back(0); //skip code for next
+							//next loop
+							continue_pos=codegen.opcodes.size();
+							codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE_RANGE);
+							codegen.opcodes.push_back(counter_pos);
+							codegen.opcodes.push_back(container_pos);
+							codegen.opcodes.push_back(step_pos);
+							codegen.opcodes.push_back(break_pos);
+							codegen.opcodes.push_back(iterator_pos);
 
+						} else {
+
+							int ret = _parse_expression(codegen,cf->arguments[1],slevel,false);
+							if (ret<0)
+								return ERR_COMPILATION_FAILED;
+
+							//assign container
+							codegen.opcodes.push_back(GDFunction::OPCODE_ASSIGN);
+							codegen.opcodes.push_back(container_pos);
+							codegen.opcodes.push_back(ret);
+
+							//begin loop
+							codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE_BEGIN);
+							codegen.opcodes.push_back(counter_pos);
+							codegen.opcodes.push_back(container_pos);
+							codegen.opcodes.push_back(codegen.opcodes.size()+4);
+							codegen.opcodes.push_back(iterator_pos);
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
+							codegen.opcodes.push_back(codegen.opcodes.size()+8);
+							//break loop
+							break_pos=codegen.opcodes.size();
+							codegen.opcodes.push_back(GDFunction::OPCODE_JUMP); //skip code for next
+							codegen.opcodes.push_back(0); //skip code for next
+							//next loop
+							continue_pos=codegen.opcodes.size();
+							codegen.opcodes.push_back(GDFunction::OPCODE_ITERATE);
+							codegen.opcodes.push_back(counter_pos);
+							codegen.opcodes.push_back(container_pos);
+							codegen.opcodes.push_back(break_pos);
+							codegen.opcodes.push_back(iterator_pos);
+						}
+
+
+						if (range_loop)
+							codegen.int_loop_counters.insert(iter_stack_pos);
 
 						Error err = _parse_block(codegen,cf->body,slevel,break_pos,continue_pos);
 						if (err)
 							return err;
 
+						codegen.int_loop_counters.erase(iter_stack_pos);
 
 						codegen.opcodes.push_back(GDFunction::OPCODE_JUMP);
 						codegen.opcodes.push_back(continue_pos);
@@ -1181,6 +1422,220 @@ Error GDCompiler::_parse_block(CodeGen& codegen,const GDParser::BlockNode *p_blo
 }
 
 
+void GDCompiler::_optimize_function(CodeGen& codegen,int p_argument_count,Vector<int>& r_defarg_addr,Vector<int>& r_lines) {
+
+	int code_size=codegen.opcodes.size();
+	if (code_size==0)
+		return;
+
+	int *code=codegen.opcodes.ptr();
+
+	//decode once, give up on anything unknown rather than guess
+	Vector<int> length; //instruction length at every instruction start, 0 elsewhere
+	length.resize(code_size);
+	Vector<int> addresses;
+	Vector<int> jumps;
+
+	for(int ip=0;ip<code_size;ip++)
+		length[ip]=0;
+
+	for(int ip=0;ip<code_size;) {
+
+		int len=GDFunction::get_instruction_operands(code,code_size,ip,&addresses,&jumps);
+		if (len==0)
+			return;
+		length[ip]=len;
+		ip+=len;
+	}
+
+	Vector<bool> targeted;
+	targeted.resize(code_size+1);
+	for(int i=0;i<=code_size;i++)
+		targeted[i]=false;
+
+	for(int i=0;i<jumps.size()+r_defarg_addr.size();i++) {
+
+		int to = i<jumps.size() ? code[jumps[i]] : r_defarg_addr[i-jumps.size()];
+		if (to<0 || to>code_size || (to<code_size && length[to]==0))
+			return;
+		targeted[to]=true;
+	}
+
+	Vector<bool> removed;
+	removed.resize(code_size);
+	for(int i=0;i<code_size;i++)
+		removed[i]=false;
+
+	//copy propagation, expressions write their temporary straight into the assigned variable
+	for(int ip=0;ip<code_size;ip+=length[ip]) {
+
+		int next=ip+length[ip];
+		if (next>=code_size || code[next]!=GDFunction::OPCODE_ASSIGN || targeted[next])
+			continue;
+
+		int temp=code[next+2];
+		if (((temp&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS)!=GDFunction::ADDR_TYPE_STACK || code[next-1]!=temp)
+			continue; //the temporary must be the destination of the previous instruction
+
+		bool pure_operator=false;
+
+		switch(code[ip]) {
+
+			case GDFunction::OPCODE_OPERATOR:
+			case GDFunction::OPCODE_OPERATOR_POLY:
+			case GDFunction::OPCODE_OPERATOR_INT:
+			case GDFunction::OPCODE_OPERATOR_REAL: {
+
+				pure_operator=true; //result is computed before it's stored
+			} break;
+			case GDFunction::OPCODE_EXTENDS_TEST:
+			case GDFunction::OPCODE_GET:
+			case GDFunction::OPCODE_GET_NAMED:
+			case GDFunction::OPCODE_CONSTRUCT:
+			case GDFunction::OPCODE_CONSTRUCT_ARRAY:
+			case GDFunction::OPCODE_CONSTRUCT_DICTIONARY:
+			case GDFunction::OPCODE_CALL_RETURN:
+			case GDFunction::OPCODE_CALL_BUILT_IN:
+			case GDFunction::OPCODE_CALL_SELF_BASE:
+			case GDFunction::OPCODE_YIELD_RESUME: {
+
+			} break;
+			default: {
+
+				continue;
+			}
+		}
+
+		int dst=code[next+1];
+
+		if (!pure_operator) {
+			//assigning may free the object an input lives in (as in node=node.next), so don't alias them
+			Vector<int> operands;
+			GDFunction::get_instruction_operands(code,code_size,ip,&operands);
+			bool aliased=false;
+			for(int i=0;i<operands.size()-1;i++) {
+				if (code[operands[i]]==dst)
+					aliased=true;
+			}
+			if (aliased)
+				continue;
+		}
+
+		code[next-1]=dst;
+		removed[next]=true;
+	}
+
+	//jump threading, jumps to an unconditional jump go straight to its target
+	for(int i=0;i<jumps.size();i++) {
+
+		int to=code[jumps[i]];
+		for(int hops=0;hops<code_size && to<code_size && code[to]==GDFunction::OPCODE_JUMP;hops++)
+			to=code[to+1];
+		code[jumps[i]]=to;
+	}
+
+	for(int ip=0;ip<code_size;ip+=length[ip]) {
+
+		if (code[ip]==GDFunction::OPCODE_JUMP && code[ip+1]==ip+2)
+			removed[ip]=true;
+#ifndef DEBUG_ENABLED
+		//without a debugger lines are only needed to report errors, look them up by ip instead
+		if (code[ip]==GDFunction::OPCODE_LINE)
+			removed[ip]=true;
+#endif
+	}
+
+	//compact, removed instructions map to the next one kept
+	Vector<int> remap;
+	remap.resize(code_size+1);
+	int new_size=0;
+	for(int ip=0;ip<code_size;ip+=length[ip]) {
+
+		remap[ip]=new_size;
+		if (!removed[ip])
+			new_size+=length[ip];
+	}
+	remap[code_size]=new_size;
+
+	for(int i=0;i<jumps.size();i++)
+		code[jumps[i]]=remap[code[jumps[i]]];
+	for(int i=0;i<r_defarg_addr.size();i++)
+		r_defarg_addr[i]=remap[r_defarg_addr[i]];
+
+	Vector<int> compact;
+	compact.resize(new_size);
+	int *w=compact.ptr();
+	int pos=0;
+	for(int ip=0;ip<code_size;ip+=length[ip]) {
+
+		if (removed[ip]) {
+
+			if (code[ip]==GDFunction::OPCODE_LINE) {
+				if (r_lines.size() && r_lines[r_lines.size()-2]==pos)
+					r_lines[r_lines.size()-1]=code[ip+1];
+				else {
+					r_lines.push_back(pos);
+					r_lines.push_back(code[ip+1]);
+				}
+			}
+			continue;
+		}
+
+		for(int i=0;i<length[ip];i++)
+			w[pos++]=code[ip+i];
+	}
+
+	//close the gaps temporaries and removed copies left in the stack, debuggers show slots by position so keep them then
+	if (!codegen.debug_stack && codegen.stack_max>p_argument_count) {
+
+		addresses.clear();
+		for(int ip=0;ip<new_size;)
+			ip+=GDFunction::get_instruction_operands(w,new_size,ip,&addresses);
+
+		Vector<int> slot;
+		slot.resize(codegen.stack_max);
+		for(int i=0;i<slot.size();i++)
+			slot[i]=-1;
+
+		bool valid=true;
+		for(int i=0;i<addresses.size();i++) {
+
+			int addr=w[addresses[i]];
+			int type=(addr&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS;
+			if (type!=GDFunction::ADDR_TYPE_STACK && type!=GDFunction::ADDR_TYPE_STACK_VARIABLE)
+				continue;
+			int idx=addr&GDFunction::ADDR_MASK;
+			if (idx>=slot.size()) {
+				valid=false;
+				break;
+			}
+			slot[idx]=idx;
+		}
+
+		if (valid) {
+
+			int used=p_argument_count;
+			for(int i=p_argument_count;i<slot.size();i++) {
+				if (slot[i]!=-1)
+					slot[i]=used++;
+			}
+
+			for(int i=0;i<addresses.size();i++) {
+
+				int addr=w[addresses[i]];
+				int type=(addr&GDFunction::ADDR_TYPE_MASK)>>GDFunction::ADDR_BITS;
+				if (type==GDFunction::ADDR_TYPE_STACK || type==GDFunction::ADDR_TYPE_STACK_VARIABLE)
+					w[addresses[i]]=(addr&GDFunction::ADDR_TYPE_MASK)|slot[addr&GDFunction::ADDR_MASK];
+			}
+
+			codegen.stack_max=used;
+		}
+	}
+
+	codegen.opcodes=compact;
+}
+
+
 Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *p_class,const GDParser::FunctionNode *p_func) {
 
 	Vector<int> bytecode;
@@ -1192,6 +1647,8 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 	codegen.stack_max=0;
 	codegen.current_line=0;
 	codegen.call_max=0;
+	codegen.call_cache_count=0;
+	codegen.member_cache_count=0;
 	codegen.debug_stack=ScriptDebugger::get_singleton()!=NULL;
 	Vector<StringName> argnames;
 
@@ -1265,6 +1722,10 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 
 	codegen.opcodes.push_back(GDFunction::OPCODE_END);
 
+	Vector<int> lines;
+	if (optimize)
+		_optimize_function(codegen,p_func ? p_func->arguments.size() : 0,defarg_addr,lines);
+
 	GDFunction *gdfunc=NULL;
 
 	//if (String(p_func->name)=="") { //initializer func
@@ -1315,9 +1776,11 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 
 	if (codegen.opcodes.size()) {
 
+		codegen.opcodes.push_back(GDFunction::OPCODE_END); //dispatch does not check for the end of the code
 		gdfunc->code=codegen.opcodes;
 		gdfunc->_code_ptr=&gdfunc->code[0];
 		gdfunc->_code_size=codegen.opcodes.size();
+		gdfunc->lines=lines;
 
 	} else {
 
@@ -1325,6 +1788,28 @@ Error GDCompiler::_parse_function(GDScript *p_script,const GDParser::ClassNode *
 		gdfunc->_code_size=0;
 	}
 
+	if (codegen.call_cache_count) {
+
+		gdfunc->call_caches.resize(codegen.call_cache_count);
+		gdfunc->_call_cache_ptr=&gdfunc->call_caches[0];
+		gdfunc->_call_cache_count=codegen.call_cache_count;
+	} else {
+
+		gdfunc->_call_cache_ptr=NULL;
+		gdfunc->_call_cache_count=0;
+	}
+
+	if (codegen.member_cache_count) {
+
+		gdfunc->member_caches.resize(codegen.member_cache_count);
+		gdfunc->_member_cache_ptr=&gdfunc->member_caches[0];
+		gdfunc->_member_cache_count=codegen.member_cache_count;
+	} else {
+
+		gdfunc->_member_cache_ptr=NULL;
+		gdfunc->_member_cache_count=0;
+	}
+
 	if (defarg_addr.size()) {
 
 		gdfunc->default_arguments=defarg_addr;
@@ -1409,7 +1894,13 @@ Error GDCompiler::_parse_class(GDScript *p_script,GDScript *p_owner,const GDPars
 				}
 				path=base.get_base_dir().plus_file(path).simplify_path();
 			}
-			script = ResourceLoader::load(path);
+			if (parser->get_preloaded_resources()) {
+				const Map<String,RES>::Element *E=parser->get_preloaded_resources()->find(path);
+				if (E)
+					script=E->get();
+			} else {
+				script = ResourceLoader::load(path);
+			}
 			if (script.is_null()) {
 				_set_error("Could not load base class: "+path,p_class);
 				return ERR_FILE_NOT_FOUND;
@@ -1698,6 +2189,9 @@ Error GDCompiler::compile(const GDParser *p_parser,GDScript *p_script) {
 
 
 
+	//functions are about to be replaced, drop any call site cache pointing to them
+	GDScriptLanguage::get_singleton()->invalidate_call_caches();
+
 	Error err = _parse_class(p_script,NULL,static_cast<const GDParser::ClassNode*>(root));
 
 	if (err)
@@ -1720,8 +2214,19 @@ int GDCompiler::get_error_column() const{
 	return err_column;
 }
 
+void GDCompiler::set_optimize(bool p_enable) {
+
+	optimize=p_enable;
+}
+
+bool GDCompiler::is_optimize_enabled() const {
+
+	return optimize;
+}
+
 GDCompiler::GDCompiler()
 {
+	optimize=true;
 }
 
 
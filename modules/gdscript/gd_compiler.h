@@ -114,6 +114,8 @@ class GDCompiler {
 			return pos;
 		}
 
+		Set<int> int_loop_counters; //stack positions of range() loop counters, known to hold ints
+
 		Vector<int> opcodes;
 		void alloc_stack(int p_level) { if (p_level >= stack_max) stack_max=p_level+1; }
 		void alloc_call(int p_params) { if (p_params >= call_max) call_max=p_params; }
@@ -121,6 +123,8 @@ class GDCompiler {
         	int current_line;
 		int stack_max;
 		int call_max;
+		int call_cache_count;
+		int member_cache_count;
 	};
 
 #if 0
@@ -136,12 +140,16 @@ class GDCompiler {
 
 	void _set_error(const String& p_error,const GDParser::Node *p_node);
 
+	Variant::Type _guess_operand_type(CodeGen& codegen,const GDParser::Node *p_node);
 	bool _create_unary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level);
 	bool _create_binary_operator(CodeGen& codegen,const GDParser::OperatorNode *on,Variant::Operator op, int p_stack_level,bool p_initializer=false);
 
 	//int _parse_subexpression(CodeGen& codegen,const GDParser::BlockNode *p_block,const GDParser::Node *p_expression);
 	int _parse_assign_right_expression(CodeGen& codegen,const GDParser::OperatorNode *p_expression, int p_stack_level);
 	int _parse_expression(CodeGen& codegen,const GDParser::Node *p_expression, int p_stack_level,bool p_root=false,bool p_initializer=false);
+	bool _get_constant_value(CodeGen& codegen,int p_address,Variant& r_value);
+	int _fold_constant_instruction(CodeGen& codegen,int p_from);
+	void _optimize_function(CodeGen& codegen,int p_argument_count,Vector<int>& r_defarg_addr,Vector<int>& r_lines);
 	Error _parse_block(CodeGen& codegen,const GDParser::BlockNode *p_block,int p_stack_level=0,int p_break_addr=-1,int p_continue_addr=-1);
 	Error _parse_function(GDScript *p_script,const GDParser::ClassNode *p_class,const GDParser::FunctionNode *p_func);
 	Error _parse_class(GDScript *p_script,GDScript *p_owner,const GDParser::ClassNode *p_class);
@@ -149,6 +157,7 @@ class GDCompiler {
 	int err_column;
 	StringName source;
 	String error;
+	bool optimize;
 
 public:
 
@@ -158,6 +167,9 @@ public:
 	int get_error_line() const;
 	int get_error_column() const;
 
+	void set_optimize(bool p_enable); //folding and bytecode cleanup, on by default
+	bool is_optimize_enabled() const;
+
 	GDCompiler();
 };
 
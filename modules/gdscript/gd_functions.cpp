@@ -100,6 +100,7 @@ const char *GDFunctions::get_func_name(Function p_func) {
 		"hash",
 		"print_stack",
 		"instance_from_id",
+		"resume_batch",
 	};
 
 	return _names[p_func];
@@ -934,6 +935,33 @@ void GDFunctions::call(Function p_func,const Variant **p_args,int p_arg_count,Va
 			uint32_t id=*p_args[0];
 			r_ret=ObjectDB::get_instance(id);
 
+		} break;
+		case RESUME_BATCH: {
+
+			if (p_arg_count<1) {
+				r_error.error=Variant::CallError::CALL_ERROR_TOO_FEW_ARGUMENTS;
+				r_error.argument=1;
+				r_ret=Variant();
+				break;
+			}
+			if (p_arg_count>2) {
+				r_error.error=Variant::CallError::CALL_ERROR_TOO_MANY_ARGUMENTS;
+				r_error.argument=2;
+				r_ret=Variant();
+				break;
+			}
+			if (p_args[0]->get_type()!=Variant::ARRAY) {
+				r_error.error=Variant::CallError::CALL_ERROR_INVALID_ARGUMENT;
+				r_error.argument=0;
+				r_error.expected=Variant::ARRAY;
+				r_ret=Variant();
+				break;
+			}
+
+			//states are replaced in place by what each function returned
+			Array states=*p_args[0];
+			r_ret=GDFunctionState::resume_batch(states,p_arg_count>1?*p_args[1]:Variant());
+
 		} break;
 		case FUNC_MAX: {
 
@@ -1346,6 +1374,12 @@ MethodInfo GDFunctions::get_info(Function p_func) {
 			return mi;
 		} break;
 
+		case RESUME_BATCH: {
+			MethodInfo mi("resume_batch",PropertyInfo(Variant::ARRAY,"states"),PropertyInfo(Variant::NIL,"arg"));
+			mi.return_val.type=Variant::INT;
+			return mi;
+		} break;
+
 		case FUNC_MAX: {
 
 			ERR_FAIL_V(MethodInfo());
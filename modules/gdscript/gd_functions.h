@@ -96,6 +96,7 @@ public:
 		HASH,
 		PRINT_STACK,
 		INSTANCE_FROM_ID,
+		RESUME_BATCH,
 		FUNC_MAX
 
 	};
@@ -288,6 +288,10 @@ GDParser::Node* GDParser::_parse_expression(Node *p_parent,bool p_static,bool p_
 				//this can be too slow for just validating code
 				if (for_completion && ScriptCodeCompletionCache::get_sigleton()) {
 					res = ScriptCodeCompletionCache::get_sigleton()->get_cached_resource(path);
+				} else if (preloaded_resources) {
+					const Map<String,RES>::Element *E=preloaded_resources->find(path);
+					if (E)
+						res=E->get();
 				} else {
 					res = ResourceLoader::load(path);
 				}
@@ -2897,6 +2901,16 @@ const GDParser::Node *GDParser::get_parse_tree() const {
 	return head;
 }
 
+void GDParser::set_preloaded_resources(const Map<String,RES> *p_resources) {
+
+	preloaded_resources=p_resources;
+}
+
+const Map<String,RES> *GDParser::get_preloaded_resources() const {
+
+	return preloaded_resources;
+}
+
 void GDParser::clear() {
 
 	while(list) {
@@ -2985,6 +2999,7 @@ GDParser::GDParser() {
 	list=NULL;
 	tokenizer=NULL;
 	pending_newline=-1;
+	preloaded_resources=NULL;
 	clear();
 
 }
@@ -33,6 +33,7 @@
 #include "gd_functions.h"
 #include "map.h"
 #include "object.h"
+#include "resource.h"
 
 class GDParser {
 public:
@@ -400,6 +401,7 @@ private:
 
 	String base_path;
 	String self_path;
+	const Map<String,RES> *preloaded_resources;
 
 
 	ClassNode *current_class;
@@ -449,6 +451,10 @@ public:
 
 	const Node *get_parse_tree() const;
 
+	//resolve preload() and extends paths from here instead of loading them, so parsing and compiling can run outside the main thread
+	void set_preloaded_resources(const Map<String,RES> *p_resources);
+	const Map<String,RES> *get_preloaded_resources() const;
+
 	//completion info
 
 	CompletionType get_completion_type();
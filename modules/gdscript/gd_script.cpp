@@ -30,8 +30,13 @@
 #include "globals.h"
 #include "global_constants.h"
 #include "gd_compiler.h"
+#include "gd_compiled_script.h"
 #include "os/file_access.h"
+#include "os/os.h"
 #include "io/file_access_encrypted.h"
+#include "os/worker_thread_pool.h"
+#include "path_remap.h"
+#include "core_string_names.h"
 
 /* TODO:
 
@@ -183,6 +188,192 @@ static String _get_var_type(const Variant* p_type) {
 
 }
 
+Variant GDFunction::_call_cached(int p_cache,Object *p_obj,const StringName& p_method,const Variant** p_args,int p_argcount,Variant::CallError& r_err) {
+
+	CallCache &cache = _call_cache_ptr[p_cache];
+	GDScriptLanguage *lang = GDScriptLanguage::get_singleton();
+
+	if (cache.epoch!=lang->get_call_cache_epoch()) {
+		//a script was recompiled or freed, entries may point to dead functions
+		cache.epoch=lang->get_call_cache_epoch();
+		cache.count=0;
+		cache.megamorphic=false;
+	}
+
+	ScriptInstance *si = p_obj->get_script_instance();
+	GDInstance *instance=NULL;
+
+	if (si) {
+		if (si->get_language()!=lang || si->is_placeholder())
+			return p_obj->call(p_method,p_args,p_argcount,r_err);
+		instance=static_cast<GDInstance*>(si);
+	}
+
+	GDScript *script = instance ? instance->script.ptr() : NULL;
+	const StringName &type = p_obj->get_type_name();
+
+	const CallCache::Entry *entry=NULL;
+
+	for(int i=0;i<cache.count;i++) {
+
+		if (cache.entries[i].script==script && cache.entries[i].type==type) {
+			entry=&cache.entries[i];
+			break;
+		}
+	}
+
+#ifdef DEBUG_ENABLED
+	if (entry)
+		lang->cache_hit();
+	else
+		lang->cache_miss();
+#endif
+
+	if (!entry) {
+
+		if (cache.megamorphic || p_method==CoreStringNames::get_singleton()->_free)
+			return p_obj->call(p_method,p_args,p_argcount,r_err);
+
+		//resolve the same way Object::call does
+		GDFunction *function=NULL;
+		MethodBind *method=NULL;
+
+		for(GDScript *sptr=script;sptr;sptr=sptr->_base) {
+
+			Map<StringName,GDFunction>::Element *E = sptr->member_functions.find(p_method);
+			if (E) {
+				function=&E->get();
+				break;
+			}
+		}
+
+		if (!function)
+			method=ObjectTypeDB::get_method(type,p_method);
+
+		if (!function && !method)
+			return p_obj->call(p_method,p_args,p_argcount,r_err); //let it report the error
+
+		if (cache.count==CALL_CACHE_MAX) {
+			cache.megamorphic=true;
+			return p_obj->call(p_method,p_args,p_argcount,r_err);
+		}
+
+		CallCache::Entry &e = cache.entries[cache.count++];
+		e.script=script;
+		e.type=type;
+		e.function=function;
+		e.method=method;
+		entry=&e;
+	}
+
+#ifdef DEBUG_ENABLED
+	_ObjectDebugLock debug_lock(p_obj);
+#endif
+
+	if (entry->function)
+		return entry->function->call(instance,p_args,p_argcount,r_err);
+
+	return entry->method->call(p_obj,p_args,p_argcount,r_err);
+}
+
+const GDFunction::MemberCache::Entry *GDFunction::_get_member_cache_entry(int p_cache,Object *p_obj,const StringName& p_name,bool p_set,GDInstance **r_instance) {
+
+	MemberCache &cache = _member_cache_ptr[p_cache];
+	GDScriptLanguage *lang = GDScriptLanguage::get_singleton();
+
+	if (cache.epoch!=lang->get_call_cache_epoch()) {
+		//member indices may have moved after a recompile
+		cache.epoch=lang->get_call_cache_epoch();
+		cache.count=0;
+		cache.megamorphic=false;
+	}
+
+	ScriptInstance *si = p_obj->get_script_instance();
+	GDInstance *instance=NULL;
+
+	if (si) {
+		if (si->get_language()!=lang || si->is_placeholder())
+			return NULL;
+		instance=static_cast<GDInstance*>(si);
+	}
+
+	GDScript *script = instance ? instance->script.ptr() : NULL;
+	const StringName &type = p_obj->get_type_name();
+	*r_instance=instance;
+
+	for(int i=0;i<cache.count;i++) {
+
+		if (cache.entries[i].script==script && cache.entries[i].type==type) {
+#ifdef DEBUG_ENABLED
+			lang->cache_hit();
+#endif
+			return &cache.entries[i];
+		}
+	}
+
+#ifdef DEBUG_ENABLED
+	lang->cache_miss();
+#endif
+
+	if (cache.megamorphic)
+		return NULL;
+
+	//resolve the same way Object::get and Object::set do, anything with side effects stays uncached
+	int member=-1;
+	MethodBind *method=NULL;
+	int index=-1;
+
+	if (script) {
+
+		const Map<StringName,GDScript::MemberInfo>::Element *E = script->member_indices.find(p_name);
+		if (E) {
+			if (p_set ? bool(E->get().setter) : bool(E->get().getter))
+				return NULL;
+			member=E->get().index;
+		} else {
+
+			if (!p_set && script->constants.has(p_name))
+				return NULL;
+
+			const StringName &handler = p_set ? lang->strings._set : lang->strings._get;
+			for(GDScript *sptr=script;sptr;sptr=sptr->_base) {
+				if (sptr->member_functions.has(handler))
+					return NULL;
+			}
+		}
+	}
+
+	if (member<0) {
+
+		MethodBind *setter=NULL;
+		MethodBind *getter=NULL;
+		if (!ObjectTypeDB::get_property_binds(type,p_name,&setter,&getter,&index))
+			return NULL;
+
+		if (p_set) {
+			method=setter;
+		} else if (index<0) {
+			method=getter; //indexed getters go through Object::call, which scripts may override
+		}
+
+		if (!method)
+			return NULL;
+	}
+
+	if (cache.count==CALL_CACHE_MAX) {
+		cache.megamorphic=true;
+		return NULL;
+	}
+
+	MemberCache::Entry &e = cache.entries[cache.count++];
+	e.script=script;
+	e.type=type;
+	e.member=member;
+	e.method=method;
+	e.index=index;
+	return &e;
+}
+
 Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_argcount, Variant::CallError& r_err, CallState *p_state) {
 
 
@@ -206,17 +397,21 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 #endif
 
 	uint32_t alloca_size=0;
+	bool stack_moved=false; //yield took ownership of the stack
 	GDScript *_class;
 	int ip=0;
 	int line=_initial_line;
+	//call and member caches and operator quickening write to the function, only the main thread does it
+	bool on_main_thread = Thread::get_caller_ID()==Thread::get_main_ID();
+	bool use_caches = (_call_cache_count || _member_cache_count) && on_main_thread;
 
 	if (p_state) {
 		//use existing (supplied) state (yielded)
-		stack=(Variant*)p_state->stack.ptr();
+		stack=(Variant*)p_state->stack;
 		call_args=(Variant**)&p_state->stack[sizeof(Variant)*p_state->stack_size];
 		line=p_state->line;
 		ip=p_state->ip;
-		alloca_size=p_state->stack.size();
+		alloca_size=p_state->alloca_size;
 		_class=p_state->_class;
 		p_instance=p_state->instance;
 		defarg=p_state->defarg;
@@ -290,51 +485,211 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 	String err_text;
 
+	//operands are encoded as address type and index, resolve them with a table of
+	//base pointers instead of switching on the type. Class constants are looked up
+	//by name, so they (and anything invalid) still go through _get_variant().
+	Variant *addr_base[ADDR_TYPE_NIL+1];
+	int addr_size[ADDR_TYPE_NIL+1];
+
+	addr_base[ADDR_TYPE_SELF]=p_instance?&self:NULL;
+	addr_size[ADDR_TYPE_SELF]=1;
+	addr_base[ADDR_TYPE_CLASS]=_class?&_class->_static_ref:NULL;
+	addr_size[ADDR_TYPE_CLASS]=1;
+	addr_base[ADDR_TYPE_MEMBER]=p_instance?p_instance->members.ptr():NULL;
+	addr_size[ADDR_TYPE_MEMBER]=p_instance?p_instance->members.size():0;
+	addr_base[ADDR_TYPE_CLASS_CONSTANT]=NULL;
+	addr_size[ADDR_TYPE_CLASS_CONSTANT]=0;
+	addr_base[ADDR_TYPE_LOCAL_CONSTANT]=_constants_ptr;
+	addr_size[ADDR_TYPE_LOCAL_CONSTANT]=_constant_count;
+	addr_base[ADDR_TYPE_STACK]=stack;
+	addr_size[ADDR_TYPE_STACK]=_stack_size;
+	addr_base[ADDR_TYPE_STACK_VARIABLE]=stack;
+	addr_size[ADDR_TYPE_STACK_VARIABLE]=_stack_size;
+	addr_base[ADDR_TYPE_GLOBAL]=GDScriptLanguage::get_singleton()->get_global_array();
+	addr_size[ADDR_TYPE_GLOBAL]=GDScriptLanguage::get_singleton()->get_global_array_size();
+	addr_base[ADDR_TYPE_NIL]=&nil;
+	addr_size[ADDR_TYPE_NIL]=1;
+
+	//members are resized when the script is reloaded and globals grow when one is added,
+	//either can happen inside anything that calls out, so re-read them afterwards
+#define REFRESH_ADDR_BASES \
+	{\
+		if (p_instance) {\
+			addr_base[ADDR_TYPE_MEMBER]=p_instance->members.ptr();\
+			addr_size[ADDR_TYPE_MEMBER]=p_instance->members.size();\
+		}\
+		addr_base[ADDR_TYPE_GLOBAL]=GDScriptLanguage::get_singleton()->get_global_array();\
+		addr_size[ADDR_TYPE_GLOBAL]=GDScriptLanguage::get_singleton()->get_global_array_size();\
+	}
+
+	//threaded dispatch jumps straight from one opcode to the next through a table of
+	//label addresses, other compilers use a regular switch inside a loop.
+#if defined(__GNUC__) && !defined(NO_COMPUTED_GOTO)
+#define GDSCRIPT_COMPUTED_GOTO
+#endif
+
+#ifdef GDSCRIPT_COMPUTED_GOTO
+
+#define OPCODES_TABLE \
+	static const void *switch_table_ops[]={\
+		&&OPCODE_OPERATOR,\
+		&&OPCODE_OPERATOR_POLY,\
+		&&OPCODE_OPERATOR_INT,\
+		&&OPCODE_OPERATOR_REAL,\
+		&&OPCODE_EXTENDS_TEST,\
+		&&OPCODE_SET,\
+		&&OPCODE_GET,\
+		&&OPCODE_SET_NAMED,\
+		&&OPCODE_GET_NAMED,\
+		&&OPCODE_ASSIGN,\
+		&&OPCODE_ASSIGN_TRUE,\
+		&&OPCODE_ASSIGN_FALSE,\
+		&&OPCODE_CONSTRUCT,\
+		&&OPCODE_CONSTRUCT_ARRAY,\
+		&&OPCODE_CONSTRUCT_DICTIONARY,\
+		&&OPCODE_CALL,\
+		&&OPCODE_CALL_RETURN,\
+		&&OPCODE_CALL_BUILT_IN,\
+		&&OPCODE_CALL_SELF,\
+		&&OPCODE_CALL_SELF_BASE,\
+		&&OPCODE_YIELD,\
+		&&OPCODE_YIELD_SIGNAL,\
+		&&OPCODE_YIELD_RESUME,\
+		&&OPCODE_JUMP,\
+		&&OPCODE_JUMP_IF,\
+		&&OPCODE_JUMP_IF_NOT,\
+		&&OPCODE_JUMP_TO_DEF_ARGUMENT,\
+		&&OPCODE_RETURN,\
+		&&OPCODE_ITERATE_BEGIN,\
+		&&OPCODE_ITERATE,\
+		&&OPCODE_ITERATE_RANGE_BEGIN,\
+		&&OPCODE_ITERATE_RANGE,\
+		&&OPCODE_ASSERT,\
+		&&OPCODE_LINE,\
+		&&OPCODE_END\
+	};
+
+#define OPCODE(m_op) m_op:
+#define OPCODE_WHILE(m_test)
+#define OPCODE_SWITCH(m_test) DISPATCH_OPCODE;
+#define OPCODES_END OPSEXIT:
+#define OPCODES_OUT OPSOUT:
+#ifdef DEBUG_ENABLED
+//the table has no default case, check the opcode is in it like the switch version does
+#define DISPATCH_OPCODE \
+	{ \
+		last_opcode=_code_ptr[ip]; \
+		if (last_opcode<0 || last_opcode>OPCODE_END) { \
+			err_text="Illegal opcode "+itos(last_opcode)+" at address "+itos(ip); \
+			OPCODE_BREAK; \
+		} \
+		goto *switch_table_ops[last_opcode]; \
+	}
+#else
+#define DISPATCH_OPCODE { last_opcode=_code_ptr[ip]; goto *switch_table_ops[last_opcode]; }
+#endif
+#define OPCODE_BREAK goto OPSEXIT
+#define OPCODE_OUT goto OPSOUT
+
+#else
+
+#define OPCODES_TABLE
+#define OPCODE(m_op) case m_op:
+#define OPCODE_WHILE(m_test) while(m_test)
+#define OPCODE_SWITCH(m_test) switch(m_test)
+#define OPCODES_END
+#define OPCODES_OUT
+#define DISPATCH_OPCODE continue
+#define OPCODE_BREAK break
+#define OPCODE_OUT break
+
+#endif
+
+#define GD_ERR_BREAK(m_cond) \
+	{ if ( m_cond ) {	\
+		_err_print_error(FUNCTION_STR,__FILE__,__LINE__,"Condition ' "_STR(m_cond)" ' is true. Breaking..:");	\
+		OPCODE_BREAK;\
+	} else _err_error_exists=false;}
+
+//leave an operator to the generic version, for good if this thread may rewrite the code
+#define OPERATOR_FALLBACK \
+	{ if (on_main_thread) \
+		const_cast<int*>(_code_ptr)[ip]=OPCODE_OPERATOR_POLY; \
+	goto operator_generic; }
+
 #ifdef DEBUG_ENABLED
 
     if (ScriptDebugger::get_singleton())
         GDScriptLanguage::get_singleton()->enter_function(p_instance,this,stack,&ip,&line);
 
+	GDFunction::ProfileCall profile_call;
+	bool profiled = GDScriptLanguage::get_singleton()->is_profiling() && Thread::get_caller_ID()==Thread::get_main_ID();
+	if (profiled)
+		GDScriptLanguage::get_singleton()->profile_enter(this,&profile_call,p_state!=NULL);
+
 #define CHECK_SPACE(m_space)\
-	ERR_BREAK((ip+m_space)>_code_size)
+	GD_ERR_BREAK((ip+m_space)>_code_size)
 
 #define GET_VARIANT_PTR(m_v,m_code_ofs) \
 	Variant *m_v; \
-	m_v = _get_variant(_code_ptr[ip+m_code_ofs],p_instance,_class,self,stack,err_text);\
+	{\
+		int _addr=_code_ptr[ip+m_code_ofs];\
+		unsigned int _type=((unsigned int)_addr)>>ADDR_BITS;\
+		int _idx=_addr&ADDR_MASK;\
+		if (_type<=ADDR_TYPE_NIL && addr_base[_type] && _idx<addr_size[_type])\
+			m_v=&addr_base[_type][_idx];\
+		else\
+			m_v=_get_variant(_addr,p_instance,_class,self,stack,err_text);\
+	}\
 	if (!m_v)\
-		break;
+		OPCODE_BREAK;
 
 
 #else
 #define CHECK_SPACE(m_space)
 #define GET_VARIANT_PTR(m_v,m_code_ofs) \
 	Variant *m_v; \
-	m_v = _get_variant(_code_ptr[ip+m_code_ofs],p_instance,_class,self,stack,err_text);
+	{\
+		int _addr=_code_ptr[ip+m_code_ofs];\
+		unsigned int _type=((unsigned int)_addr)>>ADDR_BITS;\
+		if (addr_base[_type])\
+			m_v=&addr_base[_type][_addr&ADDR_MASK];\
+		else\
+			m_v=_get_variant(_addr,p_instance,_class,self,stack,err_text);\
+	}
 
 #endif
 
 
+	OPCODES_TABLE;
 
 	bool exit_ok=false;
 
-	while(ip<_code_size) {
+	OPCODE_WHILE(ip<_code_size) {
 
 
 		int last_opcode=_code_ptr[ip];
-		switch(_code_ptr[ip]) {
+		OPCODE_SWITCH(_code_ptr[ip]) {
 
-			case OPCODE_OPERATOR: {
+			OPCODE(OPCODE_OPERATOR)
+			OPCODE(OPCODE_OPERATOR_POLY) {
+			operator_generic:
 
 				CHECK_SPACE(5);
 
 				bool valid;
 				Variant::Operator op = (Variant::Operator)_code_ptr[ip+1];
-				ERR_BREAK(op>=Variant::OP_MAX);
+				GD_ERR_BREAK(op>=Variant::OP_MAX);
 
 				GET_VARIANT_PTR(a,2);
 				GET_VARIANT_PTR(b,3);
 				GET_VARIANT_PTR(dst,4);
 
+				if (on_main_thread && _code_ptr[ip]==OPCODE_OPERATOR) {
+					//quicken, next time this runs the version specialized for these types
+					const_cast<int*>(_code_ptr)[ip]=get_operator_opcode(op,a->get_type(),b->get_type());
+				}
+
 #ifdef DEBUG_ENABLED
 				Variant ret;
 				Variant::evaluate(op,*a,*b,ret,valid);
@@ -353,17 +708,108 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 						err_text="Invalid operands '"+Variant::get_type_name(a->get_type())+"' and '"+Variant::get_type_name(b->get_type())+"' in operator '"+Variant::get_operator_name(op)+"'.";
 					}
 #endif
-					break;
+					OPCODE_BREAK;
 
 				}
 #ifdef DEBUG_ENABLED
 				*dst=ret;
 #endif
+				REFRESH_ADDR_BASES;
+
+				ip+=5;
+
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_OPERATOR_INT) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+				GET_VARIANT_PTR(dst,4);
+
+				if (a->get_type()!=Variant::INT || b->get_type()!=Variant::INT) {
+					//types changed, leave it to the generic version for good
+					OPERATOR_FALLBACK;
+				}
+
+				int va=a->_get_int();
+				int vb=b->_get_int();
+
+				switch(_code_ptr[ip+1]) {
+
+					case Variant::OP_EQUAL: dst->_set_bool(va==vb); break;
+					case Variant::OP_NOT_EQUAL: dst->_set_bool(va!=vb); break;
+					case Variant::OP_LESS: dst->_set_bool(va<vb); break;
+					case Variant::OP_LESS_EQUAL: dst->_set_bool(va<=vb); break;
+					case Variant::OP_GREATER: dst->_set_bool(va>vb); break;
+					case Variant::OP_GREATER_EQUAL: dst->_set_bool(va>=vb); break;
+					case Variant::OP_ADD: dst->_set_int(va+vb); break;
+					case Variant::OP_SUBSTRACT: dst->_set_int(va-vb); break;
+					case Variant::OP_MULTIPLY: dst->_set_int(va*vb); break;
+					case Variant::OP_DIVIDE:
+					case Variant::OP_MODULE: {
+
+						if (vb==0) {
+							//let the generic version report it
+							OPERATOR_FALLBACK;
+						}
+						dst->_set_int(_code_ptr[ip+1]==Variant::OP_DIVIDE ? va/vb : va%vb);
+					} break;
+					case Variant::OP_SHIFT_LEFT: dst->_set_int(va<<vb); break;
+					case Variant::OP_SHIFT_RIGHT: dst->_set_int(va>>vb); break;
+					case Variant::OP_BIT_AND: dst->_set_int(va&vb); break;
+					case Variant::OP_BIT_OR: dst->_set_int(va|vb); break;
+					case Variant::OP_BIT_XOR: dst->_set_int(va^vb); break;
+					default: {
+
+						OPERATOR_FALLBACK;
+					}
+				}
 
 				ip+=5;
 
-			} continue;
-			case OPCODE_EXTENDS_TEST: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_OPERATOR_REAL) {
+
+				CHECK_SPACE(5);
+
+				GET_VARIANT_PTR(a,2);
+				GET_VARIANT_PTR(b,3);
+				GET_VARIANT_PTR(dst,4);
+
+				Variant::Type ta=a->get_type();
+				Variant::Type tb=b->get_type();
+
+				if ((ta!=Variant::REAL && tb!=Variant::REAL) || (ta!=Variant::REAL && ta!=Variant::INT) || (tb!=Variant::REAL && tb!=Variant::INT)) {
+					//types changed, leave it to the generic version for good
+					OPERATOR_FALLBACK;
+				}
+
+				double va=ta==Variant::REAL ? a->_get_real() : (double)a->_get_int();
+				double vb=tb==Variant::REAL ? b->_get_real() : (double)b->_get_int();
+
+				switch(_code_ptr[ip+1]) {
+
+					case Variant::OP_EQUAL: dst->_set_bool(va==vb); break;
+					case Variant::OP_NOT_EQUAL: dst->_set_bool(va!=vb); break;
+					case Variant::OP_LESS: dst->_set_bool(va<vb); break;
+					case Variant::OP_LESS_EQUAL: dst->_set_bool(va<=vb); break;
+					case Variant::OP_GREATER: dst->_set_bool(va>vb); break;
+					case Variant::OP_GREATER_EQUAL: dst->_set_bool(va>=vb); break;
+					case Variant::OP_ADD: dst->_set_real(va+vb); break;
+					case Variant::OP_SUBSTRACT: dst->_set_real(va-vb); break;
+					case Variant::OP_MULTIPLY: dst->_set_real(va*vb); break;
+					case Variant::OP_DIVIDE: dst->_set_real(va/vb); break;
+					default: {
+
+						OPERATOR_FALLBACK;
+					}
+				}
+
+				ip+=5;
+
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_EXTENDS_TEST) {
 
 				CHECK_SPACE(4);
 
@@ -376,13 +822,13 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (a->get_type()!=Variant::OBJECT || a->operator Object*()==NULL) {
 
 					err_text="Left operand of 'extends' is not an instance of anything.";
-					break;
+					OPCODE_BREAK;
 
 				}
 				if (b->get_type()!=Variant::OBJECT || b->operator Object*()==NULL) {
 
 					err_text="Right operand of 'extends' is not a class.";
-					break;
+					OPCODE_BREAK;
 
 				}
 #endif
@@ -427,7 +873,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					if (!nc) {
 
 						err_text="Right operand of 'extends' is not a class (type: '"+obj_B->get_type()+"').";
-						break;
+						OPCODE_BREAK;
 					}
 
 					extends_ok=ObjectTypeDB::is_type(obj_A->get_type_name(),nc->get_name());
@@ -436,8 +882,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*dst=extends_ok;
 				ip+=4;
 
-			} continue;
-			case OPCODE_SET: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_SET) {
 
 				CHECK_SPACE(3);
 
@@ -456,12 +902,13 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 						v="of type '"+_get_var_type(index)+"'";
 					}
 					err_text="Invalid set index "+v+" (on base: '"+_get_var_type(dst)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 
+				REFRESH_ADDR_BASES;
 				ip+=4;
-			} continue;
-			case OPCODE_GET: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_GET) {
 
 				CHECK_SPACE(3);
 
@@ -485,83 +932,155 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 						v="of type '"+_get_var_type(index)+"'";
 					}
 					err_text="Invalid get index "+v+" (on base: '"+_get_var_type(src)+"').";
-					break;
+					OPCODE_BREAK;
 				}
 #ifdef DEBUG_ENABLED
 				*dst=ret;
 #endif
+				REFRESH_ADDR_BASES;
 				ip+=4;
-			} continue;
-			case OPCODE_SET_NAMED: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_SET_NAMED) {
 
-				CHECK_SPACE(3);
+				CHECK_SPACE(4);
 
 				GET_VARIANT_PTR(dst,1);
-				GET_VARIANT_PTR(value,3);
+				GET_VARIANT_PTR(value,4);
 
 				int indexname = _code_ptr[ip+2];
+				int cache_idx = _code_ptr[ip+3];
 
-				ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(cache_idx<0 || cache_idx>=_member_cache_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
-				dst->set_named(*index,*value,&valid);
+				const MemberCache::Entry *centry=NULL;
+				GDInstance *cinstance=NULL;
+				Object *cache_obj=NULL;
 
-				if (!valid) {
-					String err_type;
-					err_text="Invalid set index '"+String(*index)+"' (on base: '"+_get_var_type(dst)+"').";
-					break;
+				if (use_caches && dst->get_type()==Variant::OBJECT) {
+
+					cache_obj=*dst;
+#ifdef DEBUG_ENABLED
+					if (cache_obj && ScriptDebugger::get_singleton() && !dst->is_ref() && !ObjectDB::instance_validate(cache_obj))
+						cache_obj=NULL;
+#endif
+					if (cache_obj)
+						centry=_get_member_cache_entry(cache_idx,cache_obj,*index,true,&cinstance);
 				}
 
-				ip+=4;
-			} continue;
-			case OPCODE_GET_NAMED: {
+				if (centry) {
 
+#ifdef TOOLS_ENABLED
+					cache_obj->set_edited(true);
+#endif
+					if (centry->member>=0) {
+						cinstance->members[centry->member]=*value;
+					} else {
+						Variant::CallError ce;
+						if (centry->index>=0) {
+							Variant pindex=centry->index;
+							const Variant* arg[2]={&pindex,value};
+							centry->method->call(cache_obj,arg,2,ce);
+						} else {
+							const Variant* arg[1]={value};
+							centry->method->call(cache_obj,arg,1,ce);
+						}
+					}
+				} else {
+
+					bool valid;
+					dst->set_named(*index,*value,&valid);
+
+					if (!valid) {
+						String err_type;
+						err_text="Invalid set index '"+String(*index)+"' (on base: '"+_get_var_type(dst)+"').";
+						OPCODE_BREAK;
+					}
+				}
+
+				REFRESH_ADDR_BASES;
+				ip+=5;
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_GET_NAMED) {
 
-				CHECK_SPACE(3);
+
+				CHECK_SPACE(4);
 
 				GET_VARIANT_PTR(src,1);
-				GET_VARIANT_PTR(dst,3);
+				GET_VARIANT_PTR(dst,4);
 
 				int indexname = _code_ptr[ip+2];
+				int cache_idx = _code_ptr[ip+3];
 
-				ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(indexname<0 || indexname>=_global_names_count);
+				GD_ERR_BREAK(cache_idx<0 || cache_idx>=_member_cache_count);
 				const StringName *index = &_global_names_ptr[indexname];
 
-				bool valid;
+				const MemberCache::Entry *centry=NULL;
+				GDInstance *cinstance=NULL;
+				Object *cache_obj=NULL;
+
+				if (use_caches && src->get_type()==Variant::OBJECT) {
+
+					cache_obj=*src;
+#ifdef DEBUG_ENABLED
+					if (cache_obj && ScriptDebugger::get_singleton() && !src->is_ref() && !ObjectDB::instance_validate(cache_obj))
+						cache_obj=NULL;
+#endif
+					if (cache_obj)
+						centry=_get_member_cache_entry(cache_idx,cache_obj,*index,false,&cinstance);
+				}
+
+				if (centry) {
+
+					//src and dst may be the same stack position
+					if (centry->member>=0) {
+						*dst=cinstance->members[centry->member];
+					} else {
+						Variant::CallError ce;
+						Variant ret = centry->method->call(cache_obj,NULL,0,ce);
+						*dst=ret;
+					}
+				} else {
+
+					bool valid;
 #ifdef DEBUG_ENABLED
 //allow better error message in cases where src and dst are the same stack position
-				Variant ret = src->get_named(*index,&valid);
+					Variant ret = src->get_named(*index,&valid);
 
 #else
-				*dst = src->get_named(*index,&valid);
+					*dst = src->get_named(*index,&valid);
 #endif
 
-				if (!valid) {
-					if (src->has_method(*index)) {
-						err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"'). Did you mean '."+index->operator String()+"()' ?";
-					} else {
-						err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"').";
+					if (!valid) {
+						if (src->has_method(*index)) {
+							err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"'). Did you mean '."+index->operator String()+"()' ?";
+						} else {
+							err_text="Invalid get index '"+index->operator String()+"' (on base: '"+_get_var_type(src)+"').";
+						}
+						OPCODE_BREAK;
 					}
-					break;
-				}
 #ifdef DEBUG_ENABLED
-				*dst=ret;
+					*dst=ret;
 #endif
-				ip+=4;
-			} continue;
-			case OPCODE_ASSIGN: {
+				}
+				REFRESH_ADDR_BASES;
+				ip+=5;
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSIGN) {
 
 				CHECK_SPACE(3);
 				GET_VARIANT_PTR(dst,1);
 				GET_VARIANT_PTR(src,2);
 
 				*dst = *src;
+				REFRESH_ADDR_BASES; //the old value's destructor may have run script code
 
 				ip+=3;
 
-			} continue;
-			case OPCODE_ASSIGN_TRUE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSIGN_TRUE) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(dst,1);
@@ -569,8 +1088,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*dst = true;
 
 				ip+=2;
-			} continue;
-			case OPCODE_ASSIGN_FALSE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSIGN_FALSE) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(dst,1);
@@ -578,8 +1097,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*dst = false;
 
 				ip+=2;
-			} continue;
-			case OPCODE_CONSTRUCT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CONSTRUCT) {
 
 				CHECK_SPACE(2);
 				Variant::Type t=Variant::Type(_code_ptr[ip+1]);
@@ -598,13 +1117,13 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (err.error!=Variant::CallError::CALL_OK) {
 
 					err_text=_get_call_error(err,"'"+Variant::get_type_name(t)+"' constructor",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 
 				ip+=4+argc;
 				//construct a basic type
-			} continue;
-			case OPCODE_CONSTRUCT_ARRAY: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CONSTRUCT_ARRAY) {
 
 				CHECK_SPACE(1);
 				int argc=_code_ptr[ip+1];
@@ -624,8 +1143,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				ip+=3+argc;
 
-			} continue;
-			case OPCODE_CONSTRUCT_DICTIONARY: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CONSTRUCT_DICTIONARY) {
 
 				CHECK_SPACE(1);
 				int argc=_code_ptr[ip+1];
@@ -647,23 +1166,25 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				ip+=3+argc*2;
 
-			} continue;
-			case OPCODE_CALL_RETURN:
-			case OPCODE_CALL: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CALL_RETURN)
+			OPCODE(OPCODE_CALL) {
 
 
-				CHECK_SPACE(4);
+				CHECK_SPACE(5);
 				bool call_ret = _code_ptr[ip]==OPCODE_CALL_RETURN;
 
 				int argc=_code_ptr[ip+1];
 				GET_VARIANT_PTR(base,2);
 				int nameg=_code_ptr[ip+3];
+				int cache_idx=_code_ptr[ip+4];
 
-				ERR_BREAK(nameg<0 || nameg>=_global_names_count);
+				GD_ERR_BREAK(nameg<0 || nameg>=_global_names_count);
 				const StringName *methodname = &_global_names_ptr[nameg];
 
-				ERR_BREAK(argc<0);
-				ip+=4;
+				GD_ERR_BREAK(cache_idx<0 || cache_idx>=_call_cache_count);
+				GD_ERR_BREAK(argc<0);
+				ip+=5;
 				CHECK_SPACE(argc+1);
 				Variant **argptrs = call_args;
 
@@ -672,14 +1193,31 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					argptrs[i]=v;
 				}
 
+				//objects go through the call site cache, same checks as Variant::call
+				Object *cache_obj=NULL;
+				if (use_caches && base->get_type()==Variant::OBJECT) {
+
+					cache_obj=*base;
+#ifdef DEBUG_ENABLED
+					if (cache_obj && ScriptDebugger::get_singleton() && !base->is_ref() && !ObjectDB::instance_validate(cache_obj))
+						cache_obj=NULL;
+#endif
+				}
+
 				Variant::CallError err;
 				if (call_ret) {
 
 					GET_VARIANT_PTR(ret,argc);
-					*ret = base->call(*methodname,(const Variant**)argptrs,argc,err);
+					if (cache_obj)
+						*ret = _call_cached(cache_idx,cache_obj,*methodname,(const Variant**)argptrs,argc,err);
+					else
+						*ret = base->call(*methodname,(const Variant**)argptrs,argc,err);
 				} else {
 
-					base->call(*methodname,(const Variant**)argptrs,argc,err);
+					if (cache_obj)
+						_call_cached(cache_idx,cache_obj,*methodname,(const Variant**)argptrs,argc,err);
+					else
+						base->call(*methodname,(const Variant**)argptrs,argc,err);
 				}
 
 				if (err.error!=Variant::CallError::CALL_OK) {
@@ -701,29 +1239,30 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 							if (base->is_ref()) {
 								err_text="Attempted to free a reference.";
-								break;
+								OPCODE_BREAK;
 							} else if (base->get_type()==Variant::OBJECT) {
 
 								err_text="Attempted to free a locked object (calling or emitting).";
-								break;
+								OPCODE_BREAK;
 							}
 						}
 					}
 					err_text=_get_call_error(err,"function '"+methodstr+"' in base '"+basestr+"'",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
 
 				//_call_func(NULL,base,*methodname,ip,argc,p_instance,stack);
+				REFRESH_ADDR_BASES;
 				ip+=argc+1;
 
-			} continue;
-			case OPCODE_CALL_BUILT_IN: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CALL_BUILT_IN) {
 
 				CHECK_SPACE(4);
 
 				GDFunctions::Function func = GDFunctions::Function(_code_ptr[ip+1]);
 				int argc=_code_ptr[ip+2];
-				ERR_BREAK(argc<0);
+				GD_ERR_BREAK(argc<0);
 
 				ip+=3;
 				CHECK_SPACE(argc+1);
@@ -745,16 +1284,17 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 					String methodstr = GDFunctions::get_func_name(func);
 					err_text=_get_call_error(err,"built-in function '"+methodstr+"'",(const Variant**)argptrs);
-					break;
+					OPCODE_BREAK;
 				}
+				REFRESH_ADDR_BASES;
 				ip+=argc+1;
 
-			} continue;
-			case OPCODE_CALL_SELF: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_CALL_SELF) {
 
 
-			} break;
-			case OPCODE_CALL_SELF_BASE: {
+			} OPCODE_BREAK;
+			OPCODE(OPCODE_CALL_SELF_BASE) {
 
 				CHECK_SPACE(2);
 				int self_fun = _code_ptr[ip+1];
@@ -763,7 +1303,7 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (self_fun<0 || self_fun>=_global_names_count) {
 
 					err_text="compiler bug, function name not found";
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				const StringName *methodname = &_global_names_ptr[self_fun];
@@ -826,14 +1366,15 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					String methodstr = *methodname;
 					err_text=_get_call_error(err,"function '"+methodstr+"'",(const Variant**)argptrs);
 
-					break;
+					OPCODE_BREAK;
 				}
 
+				REFRESH_ADDR_BASES;
 				ip+=4+argc;
 
-			} continue;
-			case OPCODE_YIELD:
-			case OPCODE_YIELD_SIGNAL: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_YIELD)
+			OPCODE(OPCODE_YIELD_SIGNAL) {
 
 				int ipofs=1;
 				if (_code_ptr[ip]==OPCODE_YIELD_SIGNAL) {
@@ -847,11 +1388,17 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				Ref<GDFunctionState> gdfs = memnew( GDFunctionState );
 				gdfs->function=this;
 
-				gdfs->state.stack.resize(alloca_size);
-				//copy variant stack
-				for(int i=0;i<_stack_size;i++) {
-					memnew_placement(&gdfs->state.stack[sizeof(Variant)*i],Variant(stack[i]));
+				if (p_state) {
+					//yielding again after a resume, the frame is handed over as is
+					gdfs->state.stack=p_state->stack;
+					p_state->stack=NULL;
+				} else {
+					//variants are relocated bitwise into the frame, the ones in alloca are not destroyed
+					gdfs->state.stack=GDScriptLanguage::get_singleton()->alloc_frame(alloca_size);
+					if (_stack_size)
+						copymem(gdfs->state.stack,stack,sizeof(Variant)*_stack_size);
 				}
+				stack_moved=true;
 				gdfs->state.stack_size=_stack_size;
 				gdfs->state.self=self;
 				gdfs->state.alloca_size=alloca_size;
@@ -872,11 +1419,11 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 					if (argobj->get_type()!=Variant::OBJECT) {
 						err_text="First argument of yield() not of type object.";
-						break;
+						OPCODE_BREAK;
 					}
 					if (argname->get_type()!=Variant::STRING) {
 						err_text="Second argument of yield() not a string (for signal name).";
-						break;
+						OPCODE_BREAK;
 					}
 					Object *obj=argobj->operator Object *();
 					String signal = argname->operator String();
@@ -884,25 +1431,25 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 					if (!obj) {
 						err_text="First argument of yield() is null.";
-						break;
+						OPCODE_BREAK;
 					}
 					if (ScriptDebugger::get_singleton()) {
 						if (!ObjectDB::instance_validate(obj)) {
 							err_text="First argument of yield() is a previously freed instance.";
-							break;
+							OPCODE_BREAK;
 						}
 					}
 					if (signal.length()==0) {
 
 						err_text="Second argument of yield() is an empty string (for signal name).";
-						break;
+						OPCODE_BREAK;
 					}
 
 #endif
 					Error err = obj->connect(signal,gdfs.ptr(),"_signal_callback",varray(gdfs),Object::CONNECT_ONESHOT);
 					if (err!=OK) {
 						err_text="Error connecting to signal: "+signal+" during yield().";
-						break;
+						OPCODE_BREAK;
 					}
 
 
@@ -910,29 +1457,29 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 				exit_ok=true;
 
-			} break;
-			case OPCODE_YIELD_RESUME: {
+			} OPCODE_BREAK;
+			OPCODE(OPCODE_YIELD_RESUME) {
 
 				CHECK_SPACE(2);
 				if (!p_state) {
 					err_text=("Invalid Resume (bug?)");
-					break;
+					OPCODE_BREAK;
 				}
 				GET_VARIANT_PTR(result,1);
 				*result=p_state->result;
 				ip+=2;
 
-			} continue;
-			case OPCODE_JUMP: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP) {
 
 				CHECK_SPACE(2);
 				int to = _code_ptr[ip+1];
 
-				ERR_BREAK(to<0 || to>_code_size);
+				GD_ERR_BREAK(to<0 || to>=_code_size);
 				ip=to;
 
-			} continue;
-			case OPCODE_JUMP_IF: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_IF) {
 
 				CHECK_SPACE(3);
 
@@ -944,18 +1491,18 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				if (result) {
 					int to = _code_ptr[ip+2];
-					ERR_BREAK(to<0 || to>_code_size);
+					GD_ERR_BREAK(to<0 || to>=_code_size);
 					ip=to;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				ip+=3;
-			} continue;
-			case OPCODE_JUMP_IF_NOT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_IF_NOT) {
 
 				CHECK_SPACE(3);
 
@@ -967,32 +1514,32 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 #endif
 				if (!result) {
 					int to = _code_ptr[ip+2];
-					ERR_BREAK(to<0 || to>_code_size);
+					GD_ERR_BREAK(to<0 || to>=_code_size);
 					ip=to;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				ip+=3;
-			} continue;
-			case OPCODE_JUMP_TO_DEF_ARGUMENT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_JUMP_TO_DEF_ARGUMENT) {
 
 				CHECK_SPACE(2);
 				ip=_default_arg_ptr[defarg];
 
-			} continue;
-			case OPCODE_RETURN: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_RETURN) {
 
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(r,1);
 				retvalue=*r;
 				exit_ok=true;
 
-			} break;
-			case OPCODE_ITERATE_BEGIN: {
+			} OPCODE_BREAK;
+			OPCODE(OPCODE_ITERATE_BEGIN) {
 
 				CHECK_SPACE(8); //space for this an regular iterate
 
@@ -1000,15 +1547,17 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				GET_VARIANT_PTR(container,2);
 
 				bool valid;
-				if (!container->iter_init(*counter,valid)) {
+				bool more=container->iter_init(*counter,valid);
+				REFRESH_ADDR_BASES;
+				if (!more) {
 					if (!valid) {
 						err_text="Unable to iterate on object of type  "+Variant::get_type_name(container->get_type())+"'.";
-						break;
+						OPCODE_BREAK;
 					}
 					int jumpto=_code_ptr[ip+3];
-					ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					GD_ERR_BREAK(jumpto<0 || jumpto>=_code_size);
 					ip=jumpto;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				GET_VARIANT_PTR(iterator,4);
 
@@ -1016,42 +1565,182 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				*iterator=container->iter_get(*counter,valid);
 				if (!valid) {
 					err_text="Unable to obtain iterator object of type  "+Variant::get_type_name(container->get_type())+"'.";
-					break;
+					OPCODE_BREAK;
 				}
 
 
+				REFRESH_ADDR_BASES;
 				ip+=5; //skip regular iterate which is always next
 
-			} continue;
-			case OPCODE_ITERATE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ITERATE) {
 
 				CHECK_SPACE(4);
 
 				GET_VARIANT_PTR(counter,1);
 				GET_VARIANT_PTR(container,2);
 
+				Variant::Type container_type=container->get_type();
+				if (container_type==Variant::INT_ARRAY || container_type==Variant::REAL_ARRAY || container_type==Variant::VECTOR3_ARRAY) {
+
+					//packed arrays are read directly instead of boxing each element through iter_get
+					GET_VARIANT_PTR(iterator,4);
+					int idx=counter->_get_int()+1;
+					bool more;
+
+					if (container_type==Variant::INT_ARRAY) {
+						const DVector<int> *arr=container->_get_int_array();
+						more=idx<arr->size();
+						if (more)
+							iterator->_set_int(arr->read()[idx]);
+					} else if (container_type==Variant::REAL_ARRAY) {
+						const DVector<real_t> *arr=container->_get_real_array();
+						more=idx<arr->size();
+						if (more)
+							iterator->_set_real(arr->read()[idx]);
+					} else {
+						const DVector<Vector3> *arr=container->_get_vector3_array();
+						more=idx<arr->size();
+						if (more)
+							iterator->_set_vector3(arr->read()[idx]);
+					}
+
+					if (!more) {
+						int jumpto=_code_ptr[ip+3];
+						GD_ERR_BREAK(jumpto<0 || jumpto>=_code_size);
+						ip=jumpto;
+						DISPATCH_OPCODE;
+					}
+
+					counter->_set_int(idx);
+					ip+=5;
+					DISPATCH_OPCODE;
+				}
+
 				bool valid;
-				if (!container->iter_next(*counter,valid)) {
+				bool more=container->iter_next(*counter,valid);
+				REFRESH_ADDR_BASES;
+				if (!more) {
 					if (!valid) {
 						err_text="Unable to iterate on object of type  "+Variant::get_type_name(container->get_type())+"' (type changed since first iteration?).";
-						break;
+						OPCODE_BREAK;
 					}
 					int jumpto=_code_ptr[ip+3];
-					ERR_BREAK(jumpto<0 || jumpto>_code_size);
+					GD_ERR_BREAK(jumpto<0 || jumpto>=_code_size);
 					ip=jumpto;
-					continue;
+					DISPATCH_OPCODE;
 				}
 				GET_VARIANT_PTR(iterator,4);
 
 				*iterator=container->iter_get(*counter,valid);
 				if (!valid) {
 					err_text="Unable to obtain iterator object of type  "+Variant::get_type_name(container->get_type())+"' (but was obtained on first iteration?).";
-					break;
+					OPCODE_BREAK;
 				}
 
+				REFRESH_ADDR_BASES;
 				ip+=5; //loop again
-			} continue;
-			case OPCODE_ASSERT: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ITERATE_RANGE_BEGIN) {
+
+				CHECK_SPACE(2);
+				int argc=_code_ptr[ip+1];
+				GD_ERR_BREAK(argc<1 || argc>3);
+				CHECK_SPACE(argc+7);
+
+				Variant **argptrs = call_args;
+				for(int i=0;i<argc;i++) {
+					GET_VARIANT_PTR(v,2+i);
+					argptrs[i]=v;
+				}
+
+				int bad_arg=-1;
+				for(int i=0;i<argc;i++) {
+					if (!argptrs[i]->is_num()) {
+						bad_arg=i;
+						break;
+					}
+				}
+
+				if (bad_arg>=0) {
+					//same error the range() built-in reports
+					Variant::CallError err;
+					err.error=Variant::CallError::CALL_ERROR_INVALID_ARGUMENT;
+					err.argument=bad_arg;
+					err.expected=Variant::REAL;
+					err_text=_get_call_error(err,"built-in function 'range'",(const Variant**)argptrs);
+					OPCODE_BREAK;
+				}
+
+				int from = argc>1 ? int(*argptrs[0]) : 0;
+				int to = argc>1 ? int(*argptrs[1]) : int(*argptrs[0]);
+				int step = argc>2 ? int(*argptrs[2]) : 1;
+
+				if (step==0) {
+					err_text="Error calling built-in function 'range': step argument is zero!";
+					OPCODE_BREAK;
+				}
+
+				//the amount of iterations is known upfront, so the counter never has to be compared against the end
+				//computed wide, the span of two ints does not fit in one
+				int64_t count64=0;
+				if (step>0 && from<to)
+					count64=((int64_t(to)-from-1)/step)+1;
+				else if (step<0 && from>to)
+					count64=((int64_t(from)-to-1)/-int64_t(step))+1;
+
+				if (count64>0x7FFFFFFF) {
+					err_text="Error calling built-in function 'range': too many iterations!";
+					OPCODE_BREAK;
+				}
+
+				int count=int(count64);
+				if (count==0) {
+					int jumpto=_code_ptr[ip+5+argc];
+					GD_ERR_BREAK(jumpto<0 || jumpto>=_code_size);
+					ip=jumpto;
+					DISPATCH_OPCODE;
+				}
+
+				GET_VARIANT_PTR(counter,2+argc);
+				GET_VARIANT_PTR(remaining,3+argc);
+				GET_VARIANT_PTR(increment,4+argc);
+				GET_VARIANT_PTR(iterator,6+argc);
+
+				counter->_set_int(from);
+				remaining->_set_int(count-1);
+				increment->_set_int(step);
+				iterator->_set_int(from);
+
+				ip+=7+argc;
+
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ITERATE_RANGE) {
+
+				CHECK_SPACE(6);
+
+				GET_VARIANT_PTR(counter,1);
+				GET_VARIANT_PTR(remaining,2);
+				GET_VARIANT_PTR(increment,3);
+
+				int left=remaining->_get_int();
+				if (left==0) {
+					int jumpto=_code_ptr[ip+4];
+					GD_ERR_BREAK(jumpto<0 || jumpto>=_code_size);
+					ip=jumpto;
+					DISPATCH_OPCODE;
+				}
+
+				GET_VARIANT_PTR(iterator,5);
+
+				int value=counter->_get_int()+increment->_get_int();
+				counter->_set_int(value);
+				remaining->_set_int(left-1);
+				iterator->_set_int(value);
+
+				ip+=6; //loop again
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_ASSERT) {
 				CHECK_SPACE(2);
 				GET_VARIANT_PTR(test,1);
 
@@ -1063,21 +1752,21 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 				if (!valid) {
 
 					err_text="cannot evaluate conditional expression of type: "+Variant::get_type_name(test->get_type());
-					break;
+					OPCODE_BREAK;
 				}
 
 
 				if (!result) {
 
 					err_text="Assertion failed.";
-					break;
+					OPCODE_BREAK;
 				}
 
 #endif
 
 				ip+=2;
-			} continue;
-			case OPCODE_LINE: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_LINE) {
 				CHECK_SPACE(2);
 
 				line=_code_ptr[ip+1];
@@ -1103,24 +1792,29 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 					}
 
 					ScriptDebugger::get_singleton()->line_poll();
+					REFRESH_ADDR_BASES; //the debugger may have reloaded the script
 
 				}
-			} continue;
-			case OPCODE_END: {
+			} DISPATCH_OPCODE;
+			OPCODE(OPCODE_END) {
 
 				exit_ok=true;
-				break;
+				OPCODE_BREAK;
 
-			} break;
+			} OPCODE_BREAK;
+#ifndef GDSCRIPT_COMPUTED_GOTO
 			default: {
 
 				err_text="Illegal opcode "+itos(_code_ptr[ip])+" at address "+itos(ip);
-			} break;
+			} OPCODE_BREAK;
+#endif
 
 		}
 
+		OPCODES_END
+
 		if (exit_ok)
-			break;
+			OPCODE_OUT;
 		//error
 		// function, file, line, error, explanation
 		String err_file;
@@ -1134,6 +1828,8 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 		if (p_instance && p_instance->script->name!="")
 			err_func=p_instance->script->name+"."+err_func;
 		int err_line=line;
+		if (lines.size())
+			err_line=_get_line(ip); //lines were stripped from the code
 		if (err_text=="") {
 			err_text="Internal Script Error! - opcode #"+itos(last_opcode)+" (report please).";
 		}
@@ -1145,14 +1841,21 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
         }
 
 
-		break;
+		OPCODE_OUT;
 	}
 
+	OPCODES_OUT
+
     if (ScriptDebugger::get_singleton())
         GDScriptLanguage::get_singleton()->exit_function();
 
+#ifdef DEBUG_ENABLED
+	if (profiled)
+		GDScriptLanguage::get_singleton()->profile_exit(&profile_call);
+#endif
 
-	if (_stack_size) {
+
+	if (_stack_size && !stack_moved) {
 		//free stack
 		for(int i=0;i<_stack_size;i++)
 			stack[i].~Variant();
@@ -1162,6 +1865,220 @@ Variant GDFunction::call(GDInstance *p_instance, const Variant **p_args, int p_a
 
 }
 
+GDFunction::Opcode GDFunction::get_operator_opcode(Variant::Operator p_op,Variant::Type p_a,Variant::Type p_b) {
+
+	switch(p_op) {
+
+		case Variant::OP_EQUAL:
+		case Variant::OP_NOT_EQUAL:
+		case Variant::OP_LESS:
+		case Variant::OP_LESS_EQUAL:
+		case Variant::OP_GREATER:
+		case Variant::OP_GREATER_EQUAL:
+		case Variant::OP_ADD:
+		case Variant::OP_SUBSTRACT:
+		case Variant::OP_MULTIPLY:
+		case Variant::OP_DIVIDE: {
+
+			if (p_a==Variant::INT && p_b==Variant::INT)
+				return OPCODE_OPERATOR_INT;
+			if ((p_a==Variant::INT || p_a==Variant::REAL) && (p_b==Variant::INT || p_b==Variant::REAL))
+				return OPCODE_OPERATOR_REAL;
+		} break;
+		case Variant::OP_MODULE:
+		case Variant::OP_SHIFT_LEFT:
+		case Variant::OP_SHIFT_RIGHT:
+		case Variant::OP_BIT_AND:
+		case Variant::OP_BIT_OR:
+		case Variant::OP_BIT_XOR: {
+
+			if (p_a==Variant::INT && p_b==Variant::INT)
+				return OPCODE_OPERATOR_INT;
+		} break;
+		default: {}
+	}
+
+	return OPCODE_OPERATOR_POLY; //no specialized version, don't try again
+}
+
+//collects the code positions of the address (and optionally jump target) operands of the instruction at p_ip, returns its length or 0 if unknown
+int GDFunction::get_instruction_operands(const int *p_code,int p_code_size,int p_ip,Vector<int> *r_addresses,Vector<int> *r_jumps) {
+
+#define ADD_ADDR(m_ofs) r_addresses->push_back(p_ip+(m_ofs))
+#define ADD_JUMP(m_ofs) if (r_jumps) r_jumps->push_back(p_ip+(m_ofs))
+#define CHECK_LEN(m_len) if (p_ip+(m_len)>p_code_size) return 0;
+
+	CHECK_LEN(1);
+
+	switch(p_code[p_ip]) {
+
+		case OPCODE_OPERATOR:
+		case OPCODE_OPERATOR_POLY:
+		case OPCODE_OPERATOR_INT:
+		case OPCODE_OPERATOR_REAL: {
+
+			CHECK_LEN(5);
+			ADD_ADDR(2); ADD_ADDR(3); ADD_ADDR(4);
+			return 5;
+		}
+		case OPCODE_EXTENDS_TEST:
+		case OPCODE_SET:
+		case OPCODE_GET: {
+
+			CHECK_LEN(4);
+			ADD_ADDR(1); ADD_ADDR(2); ADD_ADDR(3);
+			return 4;
+		}
+		case OPCODE_SET_NAMED:
+		case OPCODE_GET_NAMED: {
+
+			CHECK_LEN(5);
+			ADD_ADDR(1); ADD_ADDR(4);
+			return 5;
+		}
+		case OPCODE_ASSIGN: {
+
+			CHECK_LEN(3);
+			ADD_ADDR(1); ADD_ADDR(2);
+			return 3;
+		}
+		case OPCODE_ASSIGN_TRUE:
+		case OPCODE_ASSIGN_FALSE:
+		case OPCODE_YIELD_RESUME:
+		case OPCODE_RETURN:
+		case OPCODE_ASSERT: {
+
+			CHECK_LEN(2);
+			ADD_ADDR(1);
+			return 2;
+		}
+		case OPCODE_CONSTRUCT: {
+
+			CHECK_LEN(3);
+			int argc=p_code[p_ip+2];
+			CHECK_LEN(4+argc);
+			for(int i=0;i<=argc;i++)
+				ADD_ADDR(3+i);
+			return 4+argc;
+		}
+		case OPCODE_CONSTRUCT_ARRAY: {
+
+			CHECK_LEN(2);
+			int argc=p_code[p_ip+1];
+			CHECK_LEN(3+argc);
+			for(int i=0;i<=argc;i++)
+				ADD_ADDR(2+i);
+			return 3+argc;
+		}
+		case OPCODE_CONSTRUCT_DICTIONARY: {
+
+			CHECK_LEN(2);
+			int argc=p_code[p_ip+1]*2;
+			CHECK_LEN(3+argc);
+			for(int i=0;i<=argc;i++)
+				ADD_ADDR(2+i);
+			return 3+argc;
+		}
+		case OPCODE_CALL:
+		case OPCODE_CALL_RETURN: {
+
+			CHECK_LEN(2);
+			int argc=p_code[p_ip+1];
+			CHECK_LEN(6+argc);
+			ADD_ADDR(2);
+			for(int i=0;i<=argc;i++)
+				ADD_ADDR(5+i);
+			return 6+argc;
+		}
+		case OPCODE_CALL_BUILT_IN:
+		case OPCODE_CALL_SELF_BASE: {
+
+			CHECK_LEN(3);
+			int argc=p_code[p_ip+2];
+			CHECK_LEN(4+argc);
+			for(int i=0;i<=argc;i++)
+				ADD_ADDR(3+i);
+			return 4+argc;
+		}
+		case OPCODE_YIELD:
+		case OPCODE_JUMP_TO_DEF_ARGUMENT:
+		case OPCODE_END: {
+
+			return 1;
+		}
+		case OPCODE_YIELD_SIGNAL: {
+
+			CHECK_LEN(3);
+			ADD_ADDR(1); ADD_ADDR(2);
+			return 3;
+		}
+		case OPCODE_JUMP: {
+
+			CHECK_LEN(2);
+			ADD_JUMP(1);
+			return 2;
+		}
+		case OPCODE_LINE: {
+
+			CHECK_LEN(2);
+			return 2;
+		}
+		case OPCODE_JUMP_IF:
+		case OPCODE_JUMP_IF_NOT: {
+
+			CHECK_LEN(3);
+			ADD_ADDR(1);
+			ADD_JUMP(2);
+			return 3;
+		}
+		case OPCODE_ITERATE_BEGIN:
+		case OPCODE_ITERATE: {
+
+			CHECK_LEN(5);
+			ADD_ADDR(1); ADD_ADDR(2); ADD_ADDR(4);
+			ADD_JUMP(3);
+			return 5;
+		}
+		case OPCODE_ITERATE_RANGE_BEGIN: {
+
+			CHECK_LEN(2);
+			int argc=p_code[p_ip+1];
+			CHECK_LEN(7+argc);
+			for(int i=0;i<argc+3;i++)
+				ADD_ADDR(2+i);
+			ADD_ADDR(6+argc);
+			ADD_JUMP(5+argc);
+			return 7+argc;
+		}
+		case OPCODE_ITERATE_RANGE: {
+
+			CHECK_LEN(6);
+			ADD_ADDR(1); ADD_ADDR(2); ADD_ADDR(3); ADD_ADDR(5);
+			ADD_JUMP(4);
+			return 6;
+		}
+	}
+
+#undef ADD_ADDR
+#undef ADD_JUMP
+#undef CHECK_LEN
+
+	return 0;
+}
+
+int GDFunction::_get_line(int p_ip) const {
+
+	//last entry at or before p_ip, entries are sorted by ip
+	int line=_initial_line;
+	for(int i=0;i<lines.size();i+=2) {
+
+		if (lines[i]>p_ip)
+			break;
+		line=lines[i+1];
+	}
+	return line;
+}
+
 const int* GDFunction::get_code() const {
 
 	return _code_ptr;
@@ -1300,9 +2217,16 @@ GDFunction::GDFunction() {
 
 	_stack_size=0;
 	_call_size=0;
+	_static=false;
+	_call_cache_ptr=NULL;
+	_call_cache_count=0;
+	_member_cache_ptr=NULL;
+	_member_cache_count=0;
 	name="<anonymous>";
 #ifdef DEBUG_ENABLED
 	_func_cname=NULL;
+	_profile=NULL;
+	_profile_epoch=0;
 #endif
 
 }
@@ -1346,9 +2270,22 @@ Variant GDFunctionState::_signal_callback(const Variant** p_args, int p_argcount
 	Variant ret = function->call(NULL,NULL,0,r_error,&state);
 	function=NULL; //cleaned up;
 	state.result=Variant();
+	_free_frame();
 	return ret;
 }
 
+void GDFunctionState::_free_frame() {
+
+	if (!state.stack)
+		return;
+
+	if (GDScriptLanguage::get_singleton())
+		GDScriptLanguage::get_singleton()->free_frame(state.stack,state.alloca_size);
+	else
+		memfree(state.stack);
+	state.stack=NULL;
+}
+
 
 bool GDFunctionState::is_valid() const {
 
@@ -1357,14 +2294,39 @@ bool GDFunctionState::is_valid() const {
 
 Variant GDFunctionState::resume(const Variant& p_arg) {
 
-	ERR_FAIL_COND_V(!function,Variant());
+	ERR_FAIL_COND_V(!function,Variant());
+
+	state.result=p_arg;
+	Variant::CallError err;
+	Variant ret = function->call(NULL,NULL,0,err,&state);
+	function=NULL; //cleaned up;
+	state.result=Variant();
+	_free_frame();
+	return ret;
+}
+
+int GDFunctionState::resume_batch(Array& p_states,const Variant& p_arg) {
+
+	int resumed=0;
+
+	for(int i=0;i<p_states.size();i++) {
+
+		Variant v=p_states[i];
+		if (v.get_type()!=Variant::OBJECT)
+			continue;
+
+		//own a reference, the resumed code can modify or clear the array
+		Ref<GDFunctionState> gdfs=v;
+		if (gdfs.is_null() || !gdfs->function)
+			continue;
+
+		Variant ret=gdfs->resume(p_arg);
+		if (i<p_states.size())
+			p_states[i]=ret;
+		resumed++;
+	}
 
-	state.result=p_arg;
-	Variant::CallError err;
-	Variant ret = function->call(NULL,NULL,0,err,&state);
-	function=NULL; //cleaned up;
-	state.result=Variant();
-	return ret;
+	return resumed;
 }
 
 
@@ -1379,6 +2341,9 @@ void GDFunctionState::_bind_methods() {
 GDFunctionState::GDFunctionState() {
 
 	function=NULL;
+	state.stack=NULL;
+	state.stack_size=0;
+	state.alloca_size=0;
 }
 
 GDFunctionState::~GDFunctionState() {
@@ -1390,6 +2355,8 @@ GDFunctionState::~GDFunctionState() {
 			v->~Variant();
 		}
 	}
+
+	_free_frame();
 }
 
 ///////////////////////////
@@ -1826,11 +2793,9 @@ void GDScript::_set_subclass_path(Ref<GDScript>& p_sc,const String& p_path) {
 	}
 }
 
-Error GDScript::reload() {
-
-
-	ERR_FAIL_COND_V(instances.size(),ERR_ALREADY_IN_USE);
+Error GDScript::_compile(const Map<String,RES> *p_resources,String& r_error,int& r_error_line) {
 
+	//only touches this script, errors are returned so the caller can report them from the main thread
 	String basedir=path;
 
 	if (basedir=="")
@@ -1839,29 +2804,23 @@ Error GDScript::reload() {
 	if (basedir!="")
 		basedir=basedir.get_base_dir();
 
-
-
-
 	valid=false;
 	GDParser parser;
+	parser.set_preloaded_resources(p_resources);
 	Error err = parser.parse(source,basedir,false,path);
 	if (err) {
-		if (ScriptDebugger::get_singleton()) {
-			GDScriptLanguage::get_singleton()->debug_break_parse(get_path(),parser.get_error_line(),"Parser Error: "+parser.get_error());
-		}
-		_err_print_error("GDScript::reload",path.empty()?"built-in":(const char*)path.utf8().get_data(),parser.get_error_line(),("Parse Error: "+parser.get_error()).utf8().get_data());
-		ERR_FAIL_V(ERR_PARSE_ERROR);
+		r_error=parser.get_error();
+		r_error_line=parser.get_error_line();
+		return ERR_PARSE_ERROR;
 	}
 
 	GDCompiler compiler;
 	err = compiler.compile(&parser,this);
 
 	if (err) {
-		if (ScriptDebugger::get_singleton()) {
-			GDScriptLanguage::get_singleton()->debug_break_parse(get_path(),compiler.get_error_line(),"Parser Error: "+compiler.get_error());
-		}
-		_err_print_error("GDScript::reload",path.empty()?"built-in":(const char*)path.utf8().get_data(),compiler.get_error_line(),("Compile Error: "+compiler.get_error()).utf8().get_data());
-		ERR_FAIL_V(ERR_COMPILATION_FAILED);
+		r_error=compiler.get_error();
+		r_error_line=compiler.get_error_line();
+		return ERR_COMPILATION_FAILED;
 	}
 
 	valid=true;
@@ -1871,6 +2830,31 @@ Error GDScript::reload() {
 		_set_subclass_path(E->get(),path);
 	}
 
+	return OK;
+}
+
+void GDScript::_report_compile_error(Error p_err,const String& p_error,int p_line) {
+
+	if (ScriptDebugger::get_singleton()) {
+		GDScriptLanguage::get_singleton()->debug_break_parse(get_path(),p_line,"Parser Error: "+p_error);
+	}
+	String what = p_err==ERR_PARSE_ERROR ? "Parse Error: " : "Compile Error: ";
+	_err_print_error("GDScript::reload",path.empty()?"built-in":(const char*)path.utf8().get_data(),p_line,(what+p_error).utf8().get_data());
+}
+
+Error GDScript::reload() {
+
+
+	ERR_FAIL_COND_V(instances.size(),ERR_ALREADY_IN_USE);
+
+	String error;
+	int error_line=0;
+	Error err = _compile(NULL,error,error_line);
+	if (err) {
+		_report_compile_error(err,error,error_line);
+		ERR_FAIL_V(err);
+	}
+
 #ifdef TOOLS_ENABLED
 	/*for (Set<PlaceHolderScriptInstance*>::Element *E=placeholders.front();E;E=E->next()) {
 
@@ -2025,6 +3009,32 @@ Error GDScript::load_byte_code(const String& p_path) {
 		basedir=basedir.get_base_dir();
 
 	valid=false;
+	uint64_t load_from=OS::get_singleton()->get_ticks_usec();
+
+	if (GDCompiledScript::is_compiled(bytecode)) {
+
+		Error err = GDCompiledScript::load(bytecode,this);
+		if (err==OK) {
+
+			valid=true;
+
+			for(Map<StringName,Ref<GDScript> >::Element *E=subclasses.front();E;E=E->next()) {
+
+				_set_subclass_path(E->get(),path);
+			}
+
+			if (OS::get_singleton()->is_stdout_verbose())
+				print_line("GDScript: loaded compiled '"+path+"' in "+itos(OS::get_singleton()->get_ticks_usec()-load_from)+" usec.");
+			return OK;
+		}
+
+		if (OS::get_singleton()->is_stdout_verbose())
+			print_line("GDScript: compiled cache for '"+path+"' can't be used (error "+itos(err)+"), compiling tokens instead.");
+
+		bytecode=GDCompiledScript::get_tokens(bytecode);
+		ERR_FAIL_COND_V(bytecode.size()==0,ERR_PARSE_ERROR);
+	}
+
 	GDParser parser;
 	Error err = parser.parse_bytecode(bytecode,basedir,get_path());
 	if (err) {
@@ -2047,6 +3057,9 @@ Error GDScript::load_byte_code(const String& p_path) {
 		_set_subclass_path(E->get(),path);
 	}
 
+	if (OS::get_singleton()->is_stdout_verbose())
+		print_line("GDScript: compiled '"+path+"' from tokens in "+itos(OS::get_singleton()->get_ticks_usec()-load_from)+" usec.");
+
 	return OK;
 }
 
@@ -2171,6 +3184,13 @@ GDScript::GDScript() {
 
 }
 
+GDScript::~GDScript() {
+
+	//call sites may have cached this script or its functions
+	if (GDScriptLanguage::get_singleton())
+		GDScriptLanguage::get_singleton()->invalidate_call_caches();
+}
+
 
 
 
@@ -2612,6 +3632,263 @@ void GDScriptLanguage::frame() {
 
 //	print_line("calls: "+itos(calls));
 	calls=0;
+
+#ifdef DEBUG_ENABLED
+	last_cache_hits=cache_hits;
+	last_cache_misses=cache_misses;
+	cache_hits=0;
+	cache_misses=0;
+
+	if (profiling) {
+
+		for(int i=0;i<profiles.size();i++) {
+
+			GDFunction::Profile *p=profiles[i];
+			p->last_frame_call_count=p->frame_call_count;
+			p->last_frame_total_time=p->frame_total_time;
+			p->last_frame_self_time=p->frame_self_time;
+			p->frame_call_count=0;
+			p->frame_total_time=0;
+			p->frame_self_time=0;
+		}
+
+		profile_last_samples=profile_samples;
+		profile_samples.clear();
+	}
+#endif
+}
+
+uint8_t *GDScriptLanguage::alloc_frame(uint32_t p_size) {
+
+	if (p_size==0)
+		return NULL;
+
+	int bucket=(p_size-1)/FRAME_POOL_GRANULARITY;
+	if (bucket>=FRAME_POOL_BUCKETS)
+		return (uint8_t*)memalloc(p_size);
+
+	FramePool &pool=frame_pool[bucket];
+	if (pool.free && Thread::get_caller_ID()==Thread::get_main_ID()) {
+
+		uint8_t *frame=pool.free;
+		pool.free=*(uint8_t**)frame;
+		pool.count--;
+		return frame;
+	}
+
+	//always the full bucket size, so any frame of the bucket can reuse it
+	return (uint8_t*)memalloc((bucket+1)*FRAME_POOL_GRANULARITY);
+}
+
+void GDScriptLanguage::free_frame(uint8_t *p_frame,uint32_t p_size) {
+
+	if (!p_frame)
+		return;
+
+	int bucket=(p_size-1)/FRAME_POOL_GRANULARITY;
+	if (bucket>=FRAME_POOL_BUCKETS || frame_pool[bucket].count>=FRAME_POOL_MAX_FREE || Thread::get_caller_ID()!=Thread::get_main_ID()) {
+		memfree(p_frame);
+		return;
+	}
+
+	FramePool &pool=frame_pool[bucket];
+	*(uint8_t**)p_frame=pool.free;
+	pool.free=p_frame;
+	pool.count++;
+}
+
+void GDScriptLanguage::get_inline_cache_stats(int &r_hits,int &r_misses) const {
+
+#ifdef DEBUG_ENABLED
+	r_hits=last_cache_hits;
+	r_misses=last_cache_misses;
+#else
+	r_hits=0;
+	r_misses=0;
+#endif
+}
+
+/* PROFILER FUNCTIONS */
+
+#ifdef DEBUG_ENABLED
+
+void GDScriptLanguage::profile_enter(GDFunction *p_function,GDFunction::ProfileCall *p_call,bool p_resumed) {
+
+	if (p_function->_profile_epoch!=profile_epoch) {
+
+		//first call since profiling started, functions with the same signature share counters across reloads
+		StringName signature = String(p_function->source)+"::"+itos(p_function->_initial_line)+"::"+String(p_function->name);
+		GDFunction::Profile **P = profile_map.getptr(signature);
+		if (P) {
+			p_function->_profile=*P;
+		} else {
+			GDFunction::Profile *profile = memnew( GDFunction::Profile );
+			profile->signature=signature;
+			profile->call_count=0;
+			profile->total_time=0;
+			profile->self_time=0;
+			profile->frame_call_count=0;
+			profile->frame_total_time=0;
+			profile->frame_self_time=0;
+			profile->last_frame_call_count=0;
+			profile->last_frame_total_time=0;
+			profile->last_frame_self_time=0;
+			profiles.push_back(profile);
+			profile_map.set(signature,profile);
+			p_function->_profile=profile;
+		}
+		p_function->_profile_epoch=profile_epoch;
+	}
+
+	p_call->profile=p_function->_profile;
+	p_call->epoch=profile_epoch;
+	p_call->child_time=0;
+	p_call->parent=profile_top;
+	profile_top=p_call;
+
+	if (!p_resumed) {
+		//resuming after yield continues the same call
+		p_call->profile->call_count++;
+		p_call->profile->frame_call_count++;
+	}
+
+	uint64_t time = OS::get_singleton()->get_ticks_usec();
+	if (profile_sample_stacks)
+		_profile_sample(time);
+	p_call->start_time=time;
+}
+
+void GDScriptLanguage::profile_exit(GDFunction::ProfileCall *p_call) {
+
+	uint64_t time = OS::get_singleton()->get_ticks_usec();
+
+	if (profile_sample_stacks)
+		_profile_sample(time);
+
+	profile_top=p_call->parent;
+
+	uint64_t total = time-p_call->start_time;
+	if (profile_top)
+		profile_top->child_time+=total;
+
+	if (p_call->epoch!=profile_epoch)
+		return; //profiling was restarted while this call ran, counters are gone
+
+	uint64_t self = total>p_call->child_time ? total-p_call->child_time : 0;
+	GDFunction::Profile *p=p_call->profile;
+	p->total_time+=total;
+	p->self_time+=self;
+	p->frame_total_time+=total;
+	p->frame_self_time+=self;
+}
+
+void GDScriptLanguage::_profile_sample(uint64_t p_time) {
+
+	//stacks are sampled at function boundaries, at most once per interval
+	if (p_time-profile_last_sample < profile_sample_interval)
+		return;
+	profile_last_sample=p_time;
+
+	String stack;
+	for(GDFunction::ProfileCall *c=profile_top;c;c=c->parent) {
+
+		if (c->epoch!=profile_epoch)
+			break;
+		if (stack=="")
+			stack=c->profile->signature;
+		else
+			stack=String(c->profile->signature)+";"+stack;
+	}
+
+	if (stack=="")
+		return;
+
+	Map<String,int>::Element *E=profile_samples.find(stack);
+	if (E)
+		E->get()++;
+	else
+		profile_samples[stack]=1;
+}
+
+void GDScriptLanguage::_profile_clear() {
+
+	for(int i=0;i<profiles.size();i++) {
+		memdelete(profiles[i]);
+	}
+	profiles.clear();
+	profile_map.clear();
+	profile_samples.clear();
+	profile_last_samples.clear();
+	profile_epoch++; //functions look up their counters again
+}
+
+#endif
+
+void GDScriptLanguage::profiling_start(bool p_sample_stacks) {
+
+#ifdef DEBUG_ENABLED
+	_profile_clear();
+	profile_sample_stacks=p_sample_stacks;
+	profile_last_sample=0;
+	profiling=true;
+#endif
+}
+
+void GDScriptLanguage::profiling_stop() {
+
+#ifdef DEBUG_ENABLED
+	profiling=false;
+#endif
+}
+
+int GDScriptLanguage::profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max) {
+
+	int current=0;
+#ifdef DEBUG_ENABLED
+	for(int i=0;i<profiles.size() && current<p_info_max;i++) {
+
+		const GDFunction::Profile *p=profiles[i];
+		p_info_arr[current].signature=p->signature;
+		p_info_arr[current].call_count=p->call_count;
+		p_info_arr[current].total_time=p->total_time;
+		p_info_arr[current].self_time=p->self_time;
+		current++;
+	}
+#endif
+	return current;
+}
+
+int GDScriptLanguage::profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max) {
+
+	int current=0;
+#ifdef DEBUG_ENABLED
+	for(int i=0;i<profiles.size() && current<p_info_max;i++) {
+
+		const GDFunction::Profile *p=profiles[i];
+		if (p->last_frame_call_count==0 && p->last_frame_total_time==0)
+			continue;
+		p_info_arr[current].signature=p->signature;
+		p_info_arr[current].call_count=p->last_frame_call_count;
+		p_info_arr[current].total_time=p->last_frame_total_time;
+		p_info_arr[current].self_time=p->last_frame_self_time;
+		current++;
+	}
+#endif
+	return current;
+}
+
+int GDScriptLanguage::profiling_get_frame_samples(ProfilingSample *p_sample_arr,int p_sample_max) {
+
+	int current=0;
+#ifdef DEBUG_ENABLED
+	for(Map<String,int>::Element *E=profile_last_samples.front();E && current<p_sample_max;E=E->next()) {
+
+		p_sample_arr[current].stack=E->key();
+		p_sample_arr[current].count=E->get();
+		current++;
+	}
+#endif
+	return current;
 }
 
 /* EDITOR FUNCTIONS */
@@ -2671,6 +3948,23 @@ void GDScriptLanguage::get_reserved_words(List<String> *p_words) const  {
 GDScriptLanguage::GDScriptLanguage() {
 
 	calls=0;
+	call_cache_epoch.init(1);
+	for(int i=0;i<FRAME_POOL_BUCKETS;i++) {
+		frame_pool[i].free=NULL;
+		frame_pool[i].count=0;
+	}
+#ifdef DEBUG_ENABLED
+	cache_hits=0;
+	cache_misses=0;
+	last_cache_hits=0;
+	last_cache_misses=0;
+	profiling=false;
+	profile_sample_stacks=false;
+	profile_epoch=1;
+	profile_sample_interval=GLOBAL_DEF("debug/profiler_sample_interval_usec",1000);
+	profile_last_sample=0;
+	profile_top=NULL;
+#endif
 	ERR_FAIL_COND(singleton);
 	singleton=this;
 	strings._init = StaticCString::create("_init");
@@ -2702,12 +3996,264 @@ GDScriptLanguage::GDScriptLanguage() {
 
 GDScriptLanguage::~GDScriptLanguage() {
 
+	for(int i=0;i<FRAME_POOL_BUCKETS;i++) {
+		while(frame_pool[i].free) {
+			uint8_t *frame=frame_pool[i].free;
+			frame_pool[i].free=*(uint8_t**)frame;
+			memfree(frame);
+		}
+	}
+
+#ifdef DEBUG_ENABLED
+	_profile_clear();
+#endif
+
     if (_call_stack)  {
         memdelete_arr(_call_stack);
     }
     singleton=NULL;
 }
 
+void GDScriptLanguage::_load_scan_task(void *p_userdata,int p_from,int p_to) {
+
+	ScriptLoad **loads=(ScriptLoad**)p_userdata;
+
+	for(int i=p_from;i<p_to;i++) {
+
+		ScriptLoad *l=loads[i];
+
+		//read without the error macros, failures are left for the regular loader to report
+		FileAccess *f=FileAccess::open(l->path,FileAccess::READ);
+		if (!f) {
+			l->error=ERR_CANT_OPEN;
+			continue;
+		}
+
+		int len=f->get_len();
+		Vector<uint8_t> buf;
+		buf.resize(len+1);
+		int r=f->get_buffer(buf.ptr(),len);
+		memdelete(f);
+		if (r!=len) {
+			l->error=ERR_CANT_OPEN;
+			continue;
+		}
+		buf[len]=0;
+
+		String code;
+		if (code.parse_utf8((const char*)buf.ptr())) {
+			l->error=ERR_INVALID_DATA;
+			continue;
+		}
+
+		l->script->source=code;
+#ifdef TOOLS_ENABLED
+		l->script->source_changed_cache=true;
+#endif
+
+		//only the tokens are needed to find what has to be loaded first
+		String base_dir=l->path.get_base_dir();
+		GDTokenizerText tk;
+		tk.set_code(code);
+
+		while(tk.get_token()!=GDTokenizer::TK_EOF && tk.get_token()!=GDTokenizer::TK_ERROR) {
+
+			if (tk.get_token()==GDTokenizer::TK_PR_EXTENDS && tk.get_token(1)==GDTokenizer::TK_CONSTANT) {
+
+				String path=tk.get_token_constant(1);
+				if (path.is_rel_path())
+					path=base_dir.plus_file(path).simplify_path();
+				l->dependencies.push_back(path);
+
+			} else if (tk.get_token()==GDTokenizer::TK_PR_PRELOAD && tk.get_token(1)==GDTokenizer::TK_PARENTHESIS_OPEN && tk.get_token(2)==GDTokenizer::TK_CONSTANT) {
+
+				String path=tk.get_token_constant(2);
+				if (!path.is_abs_path() && base_dir!="")
+					path=base_dir+"/"+path;
+				l->dependencies.push_back(path.replace("///","//").simplify_path());
+			}
+
+			tk.advance();
+		}
+	}
+}
+
+void GDScriptLanguage::_load_compile_task(void *p_userdata,int p_from,int p_to) {
+
+	ScriptLoad **loads=(ScriptLoad**)p_userdata;
+
+	for(int i=p_from;i<p_to;i++) {
+
+		ScriptLoad *l=loads[i];
+		l->error=l->script->_compile(&l->resources,l->error_text,l->error_line);
+	}
+}
+
+static void _gdscript_load_run(WorkerThreadPool::TaskFunc p_func,void *p_loads,int p_from,int p_to) {
+
+	if (p_from>=p_to)
+		return;
+
+	if (WorkerThreadPool::get_singleton())
+		WorkerThreadPool::get_singleton()->parallel_for(p_from,p_to,p_func,p_loads);
+	else
+		p_func(p_loads,p_from,p_to);
+}
+
+void GDScriptLanguage::load_scripts(const Vector<String>& p_paths,Vector<Ref<GDScript> > *r_scripts) {
+
+	//the parser and compiler only read the resources handed to them, anything touching the
+	//resource cache (loading dependencies, registering paths, reporting errors) stays in this thread
+
+	Vector<ScriptLoad*> loads;
+	Map<String,int> load_map;
+	Vector<String> queue=p_paths;
+
+	int scanned=0;
+
+	while(queue.size()) {
+
+		for(int i=0;i<queue.size();i++) {
+
+			String path=Globals::get_singleton()->localize_path(queue[i]);
+			if (path.extension()!="gd" || load_map.has(path) || ResourceCache::has(path))
+				continue;
+			if (PathRemap::get_singleton()->get_remap(path)!=path)
+				continue; //exported as bytecode, the regular loader uses the compiled cache for it
+
+			ScriptLoad *l = memnew( ScriptLoad );
+			l->path=path;
+			l->script=Ref<GDScript>( memnew( GDScript ) );
+			l->pending=0;
+			l->error=OK;
+			l->error_line=0;
+			l->skip=false;
+			load_map[path]=loads.size();
+			loads.push_back(l);
+		}
+
+		_gdscript_load_run(_load_scan_task,loads.ptr(),scanned,loads.size());
+
+		//scripts found as dependencies are scanned in the next round
+		queue.clear();
+		for(int i=scanned;i<loads.size();i++) {
+
+			for(int j=0;j<loads[i]->dependencies.size();j++)
+				queue.push_back(loads[i]->dependencies[j]);
+		}
+		scanned=loads.size();
+	}
+
+	for(int i=0;i<loads.size();i++) {
+
+		for(int j=0;j<loads[i]->dependencies.size();j++) {
+
+			Map<String,int>::Element *E=load_map.find(loads[i]->dependencies[j]);
+			if (!E)
+				continue;
+			loads[E->get()]->dependents.push_back(i);
+			loads[i]->pending++;
+		}
+	}
+
+	Vector<ScriptLoad*> ready;
+	for(int i=0;i<loads.size();i++) {
+
+		if (loads[i]->pending==0)
+			ready.push_back(loads[i]);
+	}
+
+	while(ready.size()) {
+
+		Vector<ScriptLoad*> level;
+
+		for(int i=0;i<ready.size();i++) {
+
+			ScriptLoad *l=ready[i];
+			if (l->error)
+				continue;
+			if (ResourceCache::has(l->path)) {
+				l->skip=true; //a resource loaded for an earlier script needed it
+				continue;
+			}
+
+			for(int j=0;j<l->dependencies.size();j++) {
+
+				const String &dep=l->dependencies[j];
+				if (l->resources.has(dep))
+					continue;
+
+				RES res;
+				Map<String,int>::Element *E=load_map.find(dep);
+				if (E && !loads[E->get()]->skip && loads[E->get()]->error!=ERR_CANT_OPEN && loads[E->get()]->error!=ERR_INVALID_DATA)
+					res=loads[E->get()]->script; //compiled in an earlier level, maybe with errors like the regular loader would
+				else
+					res=ResourceLoader::load(dep);
+
+				if (res.is_valid())
+					l->resources[dep]=res;
+			}
+
+			l->script->set_script_path(l->path);
+			l->script->set_path(l->path);
+#ifdef TOOLS_ENABLED
+			l->script->set_edited(false);
+			if (ResourceLoader::get_timestamp_on_load())
+				l->script->set_last_modified_time(FileAccess::get_modified_time(l->path));
+#endif
+			level.push_back(l);
+		}
+
+		_gdscript_load_run(_load_compile_task,level.ptr(),0,level.size());
+
+		for(int i=0;i<level.size();i++) {
+
+			if (level[i]->error)
+				level[i]->script->_report_compile_error(level[i]->error,level[i]->error_text,level[i]->error_line);
+		}
+
+		Vector<ScriptLoad*> next;
+		for(int i=0;i<ready.size();i++) {
+
+			for(int j=0;j<ready[i]->dependents.size();j++) {
+
+				ScriptLoad *d=loads[ready[i]->dependents[j]];
+				d->pending--;
+				if (d->pending==0)
+					next.push_back(d);
+			}
+		}
+		ready=next;
+	}
+
+	for(int i=0;i<loads.size();i++) {
+
+		ScriptLoad *l=loads[i];
+		//unreadable files and dependency cycles go through the regular loader, which reports them
+		Ref<GDScript> script;
+		if (l->skip) {
+			//owned by whoever loaded it
+		} else if (l->pending || l->error==ERR_CANT_OPEN || l->error==ERR_INVALID_DATA) {
+			if (!ResourceCache::has(l->path))
+				script=ResourceLoader::load(l->path);
+		} else {
+			script=l->script;
+		}
+
+		if (script.is_valid() && r_scripts)
+			r_scripts->push_back(script);
+		memdelete(l);
+	}
+}
+
+void GDScriptLanguage::preload_scripts(const Vector<String>& p_paths,Vector<RES> *r_loaded) {
+
+	Vector<Ref<GDScript> > scripts;
+	load_scripts(p_paths,&scripts);
+	for(int i=0;i<scripts.size();i++)
+		r_loaded->push_back(scripts[i]);
+}
+
 /*************** RESOURCE ***************/
 
 RES ResourceFormatLoaderGDScript::load(const String &p_path, const String& p_original_path, Error *r_error) {
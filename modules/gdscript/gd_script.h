@@ -34,6 +34,8 @@
 #include "io/resource_saver.h"
 #include "os/thread.h"
 #include "pair.h"
+#include "hash_map.h"
+#include "safe_refcount.h"
 class GDInstance;
 class GDScript;
 
@@ -44,6 +46,9 @@ public:
 
 	enum Opcode {
 		OPCODE_OPERATOR,
+		OPCODE_OPERATOR_POLY, //generic operator that does not quicken
+		OPCODE_OPERATOR_INT, //int and int, becomes poly if types change
+		OPCODE_OPERATOR_REAL, //real and real or int
 		OPCODE_EXTENDS_TEST,
 		OPCODE_SET,
 		OPCODE_GET,
@@ -70,6 +75,8 @@ public:
 		OPCODE_RETURN,
 		OPCODE_ITERATE_BEGIN,
 		OPCODE_ITERATE,
+		OPCODE_ITERATE_RANGE_BEGIN, //for loop over range(), counts without building the array
+		OPCODE_ITERATE_RANGE,
 		OPCODE_ASSERT,
 		OPCODE_LINE,
 		OPCODE_END
@@ -98,8 +105,78 @@ public:
         StringName identifier;
     };
 
+	enum {
+		CALL_CACHE_MAX=4 //entries per call site, more than this is megamorphic
+	};
+
+	//inline cache for a call site, maps a receiver (script and native type) to the resolved function
+	struct CallCache {
+
+		struct Entry {
+			GDScript *script;
+			StringName type;
+			GDFunction *function;
+			MethodBind *method;
+		};
+
+		uint32_t epoch;
+		int count;
+		bool megamorphic;
+		Entry entries[CALL_CACHE_MAX];
+
+		CallCache() { epoch=0; count=0; megamorphic=false; }
+	};
+
+	//inline cache for a named get or set, maps a receiver to a script member slot or a native property accessor
+	struct MemberCache {
+
+		struct Entry {
+			GDScript *script;
+			StringName type;
+			int member; //script member index, or -1 for native
+			MethodBind *method; //native getter or setter
+			int index; //indexed native property, or -1
+		};
+
+		uint32_t epoch;
+		int count;
+		bool megamorphic;
+		Entry entries[CALL_CACHE_MAX];
+
+		MemberCache() { epoch=0; count=0; megamorphic=false; }
+	};
+
+#ifdef DEBUG_ENABLED
+	//profiler counters, owned by GDScriptLanguage so they survive recompiling the function
+	struct Profile {
+
+		StringName signature;
+		uint64_t call_count;
+		uint64_t total_time;
+		uint64_t self_time;
+		uint64_t frame_call_count;
+		uint64_t frame_total_time;
+		uint64_t frame_self_time;
+		uint64_t last_frame_call_count;
+		uint64_t last_frame_total_time;
+		uint64_t last_frame_self_time;
+	};
+
+	//one per running function while profiling, lives in the stack of GDFunction::call
+	struct ProfileCall {
+
+		Profile *profile;
+		uint32_t epoch;
+		uint64_t start_time;
+		uint64_t child_time;
+		ProfileCall *parent;
+	};
+#endif
+
 private:
 friend class GDCompiler;
+friend class GDCompiledScript;
+friend class GDScriptLanguage;
 
 	StringName source;
 
@@ -112,6 +189,10 @@ friend class GDCompiler;
 	int _default_arg_count;
 	const int *_code_ptr;
 	int _code_size;
+	CallCache *_call_cache_ptr;
+	int _call_cache_count;
+	MemberCache *_member_cache_ptr;
+	int _member_cache_count;
 	int _argument_count;
 	int _stack_size;
 	int _call_size;
@@ -124,9 +205,14 @@ friend class GDCompiler;
 	Vector<StringName> global_names;
 	Vector<int> default_arguments;
 	Vector<int> code;
+	Vector<int> lines; //ip,line pairs when the compiler stripped OPCODE_LINE
+	Vector<CallCache> call_caches;
+	Vector<MemberCache> member_caches;
 #ifdef DEBUG_ENABLED
 	CharString func_cname;
 	const char*_func_cname;
+	Profile *_profile;
+	uint32_t _profile_epoch;
 #endif
 
 #ifdef TOOLS_ENABLED
@@ -137,6 +223,9 @@ friend class GDCompiler;
 
 	_FORCE_INLINE_ Variant *_get_variant(int p_address,GDInstance *p_instance,GDScript *p_script,Variant &self,Variant *p_stack,String& r_error) const;
 	_FORCE_INLINE_ String _get_call_error(const Variant::CallError& p_err, const String& p_where,const Variant**argptrs) const;
+	Variant _call_cached(int p_cache,Object *p_obj,const StringName& p_method,const Variant** p_args,int p_argcount,Variant::CallError& r_err);
+	const MemberCache::Entry *_get_member_cache_entry(int p_cache,Object *p_obj,const StringName& p_name,bool p_set,GDInstance **r_instance);
+	int _get_line(int p_ip) const;
 
 
 public:
@@ -144,7 +233,7 @@ public:
 	struct CallState {
 
 		GDInstance *instance;
-		Vector<uint8_t> stack;
+		uint8_t *stack; //frame from GDScriptLanguage::alloc_frame, alloca_size bytes
 		int stack_size;
 		Variant self;
 		uint32_t alloca_size;
@@ -158,6 +247,9 @@ public:
 
 	_FORCE_INLINE_ bool is_static() const { return _static; }
 
+	static Opcode get_operator_opcode(Variant::Operator p_op,Variant::Type p_a,Variant::Type p_b);
+	static int get_instruction_operands(const int *p_code,int p_code_size,int p_ip,Vector<int> *r_addresses,Vector<int> *r_jumps=NULL);
+
 	const int* get_code() const; //used for debug
 	int get_code_size() const;
 	Variant get_constant(int p_idx) const;
@@ -199,12 +291,14 @@ friend class GDFunction;
 	GDFunction *function;
 	GDFunction::CallState state;
 	Variant _signal_callback(const Variant** p_args, int p_argcount, Variant::CallError& r_error);
+	void _free_frame();
 protected:
 	static void _bind_methods();
 public:
 
 	bool is_valid() const;
 	Variant resume(const Variant& p_arg=Variant());
+	static int resume_batch(Array& p_states,const Variant& p_arg=Variant()); ///< resumes every valid state in the array, replacing it with its return value
 	GDFunctionState();
 	~GDFunctionState();
 };
@@ -246,6 +340,7 @@ class GDScript : public Script {
 friend class GDInstance;
 friend class GDFunction;
 friend class GDCompiler;
+friend class GDCompiledScript;
 friend class GDFunctions;
 friend class GDScriptLanguage;
 
@@ -289,6 +384,8 @@ friend class GDScriptLanguage;
 	GDInstance* _create_instance(const Variant** p_args,int p_argcount,Object *p_owner,bool p_isref);
 
 	void _set_subclass_path(Ref<GDScript>& p_sc,const String& p_path);
+	Error _compile(const Map<String,RES> *p_resources,String& r_error,int& r_error_line);
+	void _report_compile_error(Error p_err,const String& p_error,int p_line);
 
 #ifdef TOOLS_ENABLED
 	Set<PlaceHolderScriptInstance*> placeholders;
@@ -354,6 +451,7 @@ public:
 	virtual ScriptLanguage *get_language() const;
 
 	GDScript();
+	~GDScript();
 };
 
 class GDInstance : public ScriptInstance {
@@ -423,6 +521,60 @@ class GDScriptLanguage : public ScriptLanguage {
     int _debug_max_call_stack;
     CallLevel *_call_stack;
 
+	SafeRefCount call_cache_epoch; //scripts may be compiled in worker threads
+
+	//one script of a load_scripts() batch
+	struct ScriptLoad {
+
+		String path;
+		Ref<GDScript> script;
+		Vector<String> dependencies; //extends and preload() paths, resolved like the parser and compiler do
+		Map<String,RES> resources; //dependencies, loaded by the main thread before compiling
+		Vector<int> dependents;
+		int pending; //dependencies in the batch not compiled yet
+		Error error;
+		String error_text;
+		int error_line;
+		bool skip; //loaded some other way in the meantime
+	};
+
+	static void _load_scan_task(void *p_userdata,int p_from,int p_to);
+	static void _load_compile_task(void *p_userdata,int p_from,int p_to);
+
+	enum {
+		FRAME_POOL_GRANULARITY=64,
+		FRAME_POOL_BUCKETS=32, //frames up to 2kb are recycled
+		FRAME_POOL_MAX_FREE=1024 //per bucket
+	};
+
+	struct FramePool {
+
+		uint8_t *free; //singly linked through the first bytes of each frame
+		int count;
+	};
+
+	FramePool frame_pool[FRAME_POOL_BUCKETS];
+#ifdef DEBUG_ENABLED
+	int cache_hits;
+	int cache_misses;
+	int last_cache_hits;
+	int last_cache_misses;
+
+	bool profiling;
+	bool profile_sample_stacks;
+	uint32_t profile_epoch;
+	uint64_t profile_sample_interval;
+	uint64_t profile_last_sample;
+	GDFunction::ProfileCall *profile_top;
+	Vector<GDFunction::Profile*> profiles;
+	HashMap<StringName,GDFunction::Profile*,StringNameHasher> profile_map;
+	Map<String,int> profile_samples;
+	Map<String,int> profile_last_samples;
+
+	void _profile_sample(uint64_t p_time);
+	void _profile_clear();
+#endif
+
 	void _add_global(const StringName& p_name,const Variant& p_value);
 
 
@@ -506,6 +658,30 @@ public:
 
 	_FORCE_INLINE_ static GDScriptLanguage *get_singleton() { return singleton; }
 
+	//call site caches hold script and function pointers, they are flushed whenever a script is compiled or freed
+	_FORCE_INLINE_ uint32_t get_call_cache_epoch() const { return call_cache_epoch.get(); }
+	_FORCE_INLINE_ void invalidate_call_caches() { call_cache_epoch.refval(); }
+
+	//frames of yielded functions, recycled in the main thread
+	uint8_t *alloc_frame(uint32_t p_size);
+	void free_frame(uint8_t *p_frame,uint32_t p_size);
+#ifdef DEBUG_ENABLED
+	_FORCE_INLINE_ void cache_hit() { cache_hits++; }
+	_FORCE_INLINE_ void cache_miss() { cache_misses++; }
+
+	//profiling is only done in the main thread, calls keep a chain of ProfileCall to tell self from total time
+	_FORCE_INLINE_ bool is_profiling() const { return profiling; }
+	void profile_enter(GDFunction *p_function,GDFunction::ProfileCall *p_call,bool p_resumed);
+	void profile_exit(GDFunction::ProfileCall *p_call);
+#endif
+	virtual void get_inline_cache_stats(int &r_hits,int &r_misses) const;
+
+	virtual void profiling_start(bool p_sample_stacks=false);
+	virtual void profiling_stop();
+	virtual int profiling_get_accumulated_data(ProfilingInfo *p_info_arr,int p_info_max);
+	virtual int profiling_get_frame_data(ProfilingInfo *p_info_arr,int p_info_max);
+	virtual int profiling_get_frame_samples(ProfilingSample *p_sample_arr,int p_sample_max);
+
 	virtual String get_name() const;
 
 	/* LANGUAGE FUNCTIONS */
@@ -548,6 +724,11 @@ public:
 	/* LOADER FUNCTIONS */
 
 	virtual void get_recognized_extensions(List<String> *p_extensions) const;
+	virtual void preload_scripts(const Vector<String>& p_paths,Vector<RES> *r_loaded);
+
+	//parses and compiles the scripts in the worker pool, base classes and preloaded scripts first.
+	//the resource cache does not own them, they stay there only as long as r_scripts (or anything else) does
+	void load_scripts(const Vector<String>& p_paths,Vector<Ref<GDScript> > *r_scripts);
 
 	GDScriptLanguage();
 	~GDScriptLanguage();
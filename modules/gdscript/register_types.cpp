@@ -26,6 +26,7 @@ ResourceFormatSaverGDScript *resource_saver_gd=NULL;
 
 #include "tools/editor/editor_import_export.h"
 #include "gd_tokenizer.h"
+#include "gd_compiled_script.h"
 #include "tools/editor/editor_node.h"
 #include "tools/editor/editor_settings.h"
 
@@ -48,6 +49,17 @@ public:
 				txt.parse_utf8((const char*)file.ptr(),file.size());
 				file = GDTokenizerBuffer::parse_code_string(txt);
 
+				if (!file.empty() && EditorImportExport::get_singleton()->script_get_precompile()) {
+					//store the compiled code along with the tokens, so the game does not need to parse it
+					Ref<GDScript> script = ResourceLoader::load(p_path);
+					if (script.is_valid() && script->is_valid() && script->get_source_code()==txt) { //skip if edited but not saved
+
+						Vector<uint8_t> compiled = GDCompiledScript::save(script,file);
+						if (!compiled.empty())
+							file=compiled;
+					}
+				}
+
 				if (!file.empty()) {
 
 					if (EditorImportExport::get_singleton()->script_get_action()==EditorImportExport::SCRIPT_ACTION_ENCRYPT) {
@@ -38,6 +38,7 @@
 #include "servers/audio/audio_server_sw.h"
 #include "servers/physics_2d/physics_2d_server_sw.h"
 #include "servers/physics_2d/physics_2d_server_wrap_mt.h"
+#include "servers/physics/physics_server_wrap_mt.h"
 #include "servers/visual/rasterizer.h"
 
 
@@ -134,7 +134,8 @@ void OSIPhone::initialize(const VideoMode& p_desired,int p_video_driver,int p_au
 	spatial_sound_2d_server->init();
 
 	//
-	physics_server = memnew( PhysicsServerSW );
+	//physics_server = memnew( PhysicsServerSW );
+	physics_server = PhysicsServerWrapMT::init_server<PhysicsServerSW>();
 	physics_server->init();
 	//physics_2d_server = memnew( Physics2DServerSW );
 	physics_2d_server = Physics2DServerWrapMT::init_server<Physics2DServerSW>();
@@ -46,6 +46,7 @@
 #include "drivers/unix/ip_unix.h"
 #include "servers/physics_2d/physics_2d_server_sw.h"
 #include "servers/physics_2d/physics_2d_server_wrap_mt.h"
+#include "servers/physics/physics_server_wrap_mt.h"
 
 
 #include <windows.h>
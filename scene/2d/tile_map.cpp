@@ -29,6 +29,7 @@
 #include "tile_map.h"
 #include "io/marshalls.h"
 #include "servers/physics_2d_server.h"
+#include "scene/resources/rectangle_shape_2d.h"
 #include "method_bind_ext.inc"
 
 int TileMap::_get_quadrant_size() const {
@@ -276,6 +277,12 @@ void TileMap::_update_dirty_quadrants() {
 		ps->body_clear_shapes(q.body);
 		int shape_idx=0;
 
+		for(int i=0;i<q.merged_shapes.size();i++) {
+			ps->free(q.merged_shapes[i]);
+		}
+		q.merged_shapes.clear();
+		Vector<MergeCell> merge_cells;
+
 		if (navigation) {
 			for(Map<PosKey,Quadrant::NavPoly>::Element *E=q.navpoly_ids.front();E;E=E->next()) {
 
@@ -398,6 +405,24 @@ void TileMap::_update_dirty_quadrants() {
 
 					_fix_cell_transform(xform,c,shape_ofs+center_ofs,s);
 
+					if (merge_tiles && shapes.size()==1 && shape->cast_to<RectangleShape2D>()) {
+
+						// a rectangle filling exactly one cell can be merged with its neighbours later
+						Vector2 extents = shape->cast_to<RectangleShape2D>()->get_extents();
+						Rect2 shape_rect = xform.xform(Rect2(-extents,extents*2));
+
+						if (ABS(shape_rect.size.x-cell_size.x)<0.01 && ABS(shape_rect.size.y-cell_size.y)<0.01) {
+
+							MergeCell mc;
+							mc.pos=E->key();
+							mc.rect=shape_rect;
+							mc.shape=shape->get_rid();
+							mc.xform=xform;
+							merge_cells.push_back(mc);
+							continue;
+						}
+					}
+
 					ps->body_add_shape(q.body,shape->get_rid(),xform);
 					ps->body_set_shape_metadata(q.body,shape_idx++,Vector2(E->key().x,E->key().y));
 
@@ -441,6 +466,9 @@ void TileMap::_update_dirty_quadrants() {
 			}
 		}
 
+		if (merge_cells.size())
+			_add_merged_shapes(q,merge_cells,shape_idx);
+
 		dirty_quadrant_list.remove( dirty_quadrant_list.first() );
 	}
 
@@ -466,6 +494,102 @@ void TileMap::_update_dirty_quadrants() {
 
 }
 
+void TileMap::_add_merged_shapes(Quadrant &q, const Vector<MergeCell>& p_cells, int &r_shape_idx) {
+
+	Physics2DServer *ps = Physics2DServer::get_singleton();
+
+	/* cells only merge when their rectangles line up on the same lattice, which is
+	   the one of the first cell. Anything else keeps its own shape */
+
+	Vector2 anchor = p_cells[0].rect.pos - Vector2(p_cells[0].pos.x*cell_size.x,p_cells[0].pos.y*cell_size.y);
+	Point2i from(p_cells[0].pos.x,p_cells[0].pos.y);
+	Point2i to=from;
+	Vector<bool> on_lattice;
+	on_lattice.resize(p_cells.size());
+
+	for(int i=0;i<p_cells.size();i++) {
+
+		const MergeCell &mc=p_cells[i];
+		Vector2 cell_anchor = mc.rect.pos - Vector2(mc.pos.x*cell_size.x,mc.pos.y*cell_size.y);
+		on_lattice[i]=cell_anchor.distance_squared_to(anchor)<0.0001;
+
+		if (!on_lattice[i]) {
+			ps->body_add_shape(q.body,mc.shape,mc.xform);
+			ps->body_set_shape_metadata(q.body,r_shape_idx++,Vector2(mc.pos.x,mc.pos.y));
+			continue;
+		}
+
+		from.x=MIN(from.x,mc.pos.x);
+		from.y=MIN(from.y,mc.pos.y);
+		to.x=MAX(to.x,mc.pos.x);
+		to.y=MAX(to.y,mc.pos.y);
+	}
+
+	int w=to.x-from.x+1;
+	int h=to.y-from.y+1;
+
+	Vector<uint8_t> solid;
+	solid.resize(w*h);
+	uint8_t *solidw=solid.ptr();
+	for(int i=0;i<w*h;i++)
+		solidw[i]=0;
+
+	for(int i=0;i<p_cells.size();i++) {
+
+		if (on_lattice[i])
+			solidw[(p_cells[i].pos.y-from.y)*w+(p_cells[i].pos.x-from.x)]=1;
+	}
+
+	/* greedy: grow each free cell into the widest run, then down as long as the
+	   whole run is solid. Shape metadata is the top-left cell of the rectangle */
+
+	for(int y=0;y<h;y++) {
+
+		for(int x=0;x<w;x++) {
+
+			if (!solidw[y*w+x])
+				continue;
+
+			int rw=1;
+			while(x+rw<w && solidw[y*w+x+rw])
+				rw++;
+
+			int rh=1;
+			while(y+rh<h) {
+
+				bool full=true;
+				for(int i=0;i<rw;i++) {
+					if (!solidw[(y+rh)*w+x+i]) {
+						full=false;
+						break;
+					}
+				}
+				if (!full)
+					break;
+				rh++;
+			}
+
+			for(int j=0;j<rh;j++) {
+				for(int i=0;i<rw;i++) {
+					solidw[(y+j)*w+x+i]=0;
+				}
+			}
+
+			Vector2 size(rw*cell_size.x,rh*cell_size.y);
+			Vector2 pos = anchor + Vector2((from.x+x)*cell_size.x,(from.y+y)*cell_size.y);
+
+			RID shape = ps->shape_create(Physics2DServer::SHAPE_RECTANGLE);
+			ps->shape_set_data(shape,size/2);
+			q.merged_shapes.push_back(shape);
+
+			Matrix32 xform;
+			xform.set_origin(pos+size/2);
+			ps->body_add_shape(q.body,shape,xform);
+			ps->body_set_shape_metadata(q.body,r_shape_idx++,Vector2(from.x+x,from.y+y));
+		}
+	}
+}
+
 void TileMap::_recompute_rect_cache() {
 
 
@@ -540,6 +664,11 @@ void TileMap::_erase_quadrant(Map<PosKey,Quadrant>::Element *Q) {
 
 	Quadrant &q=Q->get();
 	Physics2DServer::get_singleton()->free(q.body);
+	for(int i=0;i<q.merged_shapes.size();i++) {
+
+		Physics2DServer::get_singleton()->free(q.merged_shapes[i]);
+	}
+	q.merged_shapes.clear();
 	for (List<RID>::Element *E=q.canvas_items.front();E;E=E->next()) {
 
 		VisualServer::get_singleton()->free(E->get());
@@ -827,6 +956,18 @@ void TileMap::set_collision_use_kinematic(bool p_use_kinematic) {
 	_recreate_quadrants();
 }
 
+void TileMap::set_collision_merge_tiles(bool p_merge_tiles) {
+
+	_clear_quadrants();
+	merge_tiles=p_merge_tiles;
+	_recreate_quadrants();
+}
+
+bool TileMap::get_collision_merge_tiles() const {
+
+	return merge_tiles;
+}
+
 void TileMap::set_collision_friction(float p_friction) {
 
 	friction=p_friction;
@@ -1097,6 +1238,9 @@ void TileMap::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("set_collision_use_kinematic","use_kinematic"),&TileMap::set_collision_use_kinematic);
 	ObjectTypeDB::bind_method(_MD("get_collision_use_kinematic"),&TileMap::get_collision_use_kinematic);
 
+	ObjectTypeDB::bind_method(_MD("set_collision_merge_tiles","merge_tiles"),&TileMap::set_collision_merge_tiles);
+	ObjectTypeDB::bind_method(_MD("get_collision_merge_tiles"),&TileMap::get_collision_merge_tiles);
+
 	ObjectTypeDB::bind_method(_MD("set_collision_layer","mask"),&TileMap::set_collision_layer);
 	ObjectTypeDB::bind_method(_MD("get_collision_layer"),&TileMap::get_collision_layer);
 
@@ -1139,6 +1283,7 @@ void TileMap::_bind_methods() {
 	ADD_PROPERTY( PropertyInfo(Variant::INT,"cell/tile_origin",PROPERTY_HINT_ENUM,"Top Left,Center"),_SCS("set_tile_origin"),_SCS("get_tile_origin"));
 	ADD_PROPERTY( PropertyInfo(Variant::BOOL,"cell/y_sort"),_SCS("set_y_sort_mode"),_SCS("is_y_sort_mode_enabled"));
 	ADD_PROPERTY( PropertyInfo(Variant::BOOL,"collision/use_kinematic",PROPERTY_HINT_NONE,""),_SCS("set_collision_use_kinematic"),_SCS("get_collision_use_kinematic"));
+	ADD_PROPERTY( PropertyInfo(Variant::BOOL,"collision/merge_tiles"),_SCS("set_collision_merge_tiles"),_SCS("get_collision_merge_tiles"));
 	ADD_PROPERTY( PropertyInfo(Variant::REAL,"collision/friction",PROPERTY_HINT_RANGE,"0,1,0.01"),_SCS("set_collision_friction"),_SCS("get_collision_friction"));
 	ADD_PROPERTY( PropertyInfo(Variant::REAL,"collision/bounce",PROPERTY_HINT_RANGE,"0,1,0.01"),_SCS("set_collision_bounce"),_SCS("get_collision_bounce"));
 	ADD_PROPERTY( PropertyInfo(Variant::INT,"collision/layers",PROPERTY_HINT_ALL_FLAGS),_SCS("set_collision_layer"),_SCS("get_collision_layer"));
@@ -1178,6 +1323,7 @@ TileMap::TileMap() {
 	mode=MODE_SQUARE;
 	half_offset=HALF_OFFSET_DISABLED;
 	use_kinematic=false;
+	merge_tiles=false;
 	navigation=NULL;
 	y_sort_mode=false;
 
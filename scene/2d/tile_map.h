@@ -68,6 +68,7 @@ private:
 	Matrix32 custom_transform;
 	HalfOffset half_offset;
 	bool use_kinematic;
+	bool merge_tiles;
 	Navigation2D *navigation;
 
 
@@ -126,9 +127,10 @@ private:
 		Map<PosKey,Occluder> occluder_instances;
 
 		VSet<PosKey> cells;
+		Vector<RID> merged_shapes;
 
-		void operator=(const Quadrant& q) { pos=q.pos; canvas_items=q.canvas_items; body=q.body; cells=q.cells; navpoly_ids=q.navpoly_ids; occluder_instances=q.occluder_instances; }
-		Quadrant(const Quadrant& q) : dirty_list(this) { pos=q.pos; canvas_items=q.canvas_items; body=q.body; cells=q.cells; occluder_instances=q.occluder_instances; navpoly_ids=q.navpoly_ids;}
+		void operator=(const Quadrant& q) { pos=q.pos; canvas_items=q.canvas_items; body=q.body; cells=q.cells; navpoly_ids=q.navpoly_ids; occluder_instances=q.occluder_instances; merged_shapes=q.merged_shapes; }
+		Quadrant(const Quadrant& q) : dirty_list(this) { pos=q.pos; canvas_items=q.canvas_items; body=q.body; cells=q.cells; occluder_instances=q.occluder_instances; navpoly_ids=q.navpoly_ids; merged_shapes=q.merged_shapes; }
 		Quadrant() : dirty_list(this) {}
 	};
 
@@ -150,6 +152,14 @@ private:
 
 	TileOrigin tile_origin;
 
+	struct MergeCell {
+
+		PosKey pos;
+		Rect2 rect;
+		RID shape;
+		Matrix32 xform;
+	};
+
 	void _fix_cell_transform(Matrix32& xform, const Cell& p_cell, const Vector2 &p_offset, const Size2 &p_sc);
 
 	Map<PosKey,Quadrant>::Element *_create_quadrant(const PosKey& p_qk);
@@ -158,6 +168,7 @@ private:
 	void _recreate_quadrants();
 	void _clear_quadrants();
 	void _update_dirty_quadrants();
+	void _add_merged_shapes(Quadrant &q, const Vector<MergeCell>& p_cells, int &r_shape_idx);
 	void _update_quadrant_space(const RID& p_space);
 	void _update_quadrant_transform();
 	void _recompute_rect_cache();
@@ -220,6 +231,9 @@ public:
 	void set_collision_use_kinematic(bool p_use_kinematic);
 	bool get_collision_use_kinematic() const;
 
+	void set_collision_merge_tiles(bool p_merge_tiles);
+	bool get_collision_merge_tiles() const;
+
 	void set_collision_friction(float p_friction);
 	float get_collision_friction() const;
 
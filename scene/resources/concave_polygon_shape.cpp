@@ -52,7 +52,7 @@ bool ConcavePolygonShape::_get(const StringName& p_name,Variant &r_ret) const {
 }
 void ConcavePolygonShape::_get_property_list( List<PropertyInfo> *p_list) const {
 
-	p_list->push_back( PropertyInfo(Variant::ARRAY,"data") );
+	p_list->push_back( PropertyInfo(Variant::DICTIONARY,"data") );
 }
 
 
@@ -68,7 +68,8 @@ void ConcavePolygonShape::set_faces(const DVector<Vector3>& p_faces) {
 
 DVector<Vector3> ConcavePolygonShape::get_faces() const {
 
-	return PhysicsServer::get_singleton()->shape_get_data(get_shape());
+	Dictionary d=PhysicsServer::get_singleton()->shape_get_data(get_shape());
+	return d["faces"];
 
 }
 
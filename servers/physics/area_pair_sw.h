@@ -45,6 +45,8 @@ public:
 	bool setup(float p_step);
 	void solve(float p_step);
 
+	virtual bool is_setup_shared() const { return true; }
+
 	AreaPairSW(BodySW *p_body,int p_body_shape, AreaSW *p_area,int p_area_shape);
 	~AreaPairSW();
 };
@@ -62,6 +64,8 @@ public:
 	bool setup(float p_step);
 	void solve(float p_step);
 
+	virtual bool is_setup_shared() const { return true; }
+
 	Area2PairSW(AreaSW *p_area_a,int p_shape_a, AreaSW *p_area_b,int p_shape_b);
 	~Area2PairSW();
 };
@@ -500,6 +500,17 @@ void BodyPairSW::solve(float p_step) {
 
 
 
+bool BodyPairSW::is_setup_shared() const {
+
+	//contacts are reported to the static or kinematic body, which other islands may touch too
+	if (A->get_mode()<=PhysicsServer::BODY_MODE_KINEMATIC && A->can_report_contacts())
+		return true;
+	if (B->get_mode()<=PhysicsServer::BODY_MODE_KINEMATIC && B->can_report_contacts())
+		return true;
+
+	return false;
+}
+
 BodyPairSW::BodyPairSW(BodySW *p_A, int p_shape_A,BodySW *p_B, int p_shape_B) : ConstraintSW(_arr,2) {
 
 	A=p_A;
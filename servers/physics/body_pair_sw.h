@@ -91,6 +91,8 @@ public:
 	bool setup(float p_step);
 	void solve(float p_step);
 
+	virtual bool is_setup_shared() const;
+
 	BodyPairSW(BodySW *p_A, int p_shape_A,BodySW *p_B, int p_shape_B);
 	~BodyPairSW();
 
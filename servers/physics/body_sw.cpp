@@ -373,7 +373,7 @@ void BodySW::_compute_area_gravity(const AreaSW *p_area) {
 	}
 }
 
-void BodySW::integrate_forces(real_t p_step) {
+void BodySW::integrate_forces(real_t p_step,bool p_defer) {
 
 
 	if (mode==PhysicsServer::BODY_MODE_STATIC)
@@ -465,30 +465,36 @@ void BodySW::integrate_forces(real_t p_step) {
 
 
 	if (do_motion) {//shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
+		deferred_updates|=DEFERRED_SHAPES_WITH_MOTION;
+		deferred_motion=motion;
 	}
 
 
 	def_area=NULL; // clear the area, so it is set in the next frame
 	contact_count=0;
 
+	if (!p_defer)
+		apply_deferred_updates();
+
 }
 
-void BodySW::integrate_velocities(real_t p_step) {
+void BodySW::integrate_velocities(real_t p_step,bool p_defer) {
 
 	if (mode==PhysicsServer::BODY_MODE_STATIC)
 		return;
 
 	if (fi_callback)
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+		deferred_updates|=DEFERRED_STATE_QUERY;
 
 	if (mode==PhysicsServer::BODY_MODE_KINEMATIC) {
 
 		_set_transform(new_transform,false);
 		_set_inv_transform(new_transform.affine_inverse());
 		if (contacts.size()==0 && linear_velocity==Vector3() && angular_velocity==Vector3())
-			set_active(false); //stopped moving, deactivate
+			deferred_updates|=DEFERRED_DEACTIVATE; //stopped moving, deactivate
 
+		if (!p_defer)
+			apply_deferred_updates();
 		return;
 	}
 
@@ -537,17 +543,41 @@ void BodySW::integrate_velocities(real_t p_step) {
 
 	transform.origin+=total_linear_velocity * p_step;
 
-	_set_transform(transform);
+	_set_transform(transform,false);
 	_set_inv_transform(get_transform().inverse());
+	deferred_updates|=DEFERRED_SHAPES;
 
 	_update_inertia_tensor();
 
+	if (!p_defer)
+		apply_deferred_updates();
+
 	//if (fi_callback) {
 
 	//	get_space()->body_add_to_state_query_list(&direct_state_query_list);
 	//
 }
 
+void BodySW::apply_deferred_updates() {
+
+	if (!deferred_updates)
+		return;
+
+	if (deferred_updates&DEFERRED_STATE_QUERY)
+		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+
+	if (deferred_updates&DEFERRED_SHAPES_WITH_MOTION)
+		_update_shapes_with_motion(deferred_motion);
+
+	if (deferred_updates&DEFERRED_SHAPES)
+		_update_shapes();
+
+	if (deferred_updates&DEFERRED_DEACTIVATE)
+		set_active(false);
+
+	deferred_updates=0;
+}
+
 /*
 void BodySW::simulate_motion(const Transform& p_xform,real_t p_step) {
 
@@ -693,6 +723,7 @@ BodySW::BodySW() : CollisionObjectSW(TYPE_BODY), active_list(this), inertia_upda
 	island_step=0;
 	island_next=NULL;
 	island_list_next=NULL;
+	deferred_updates=0;
 	first_time_kinematic=false;
 	_set_static(false);
 	density=0;
@@ -123,6 +123,16 @@ class BodySW : public CollisionObjectSW {
 	BodySW *island_next;
 	BodySW *island_list_next;
 
+	enum {
+		DEFERRED_SHAPES=1,
+		DEFERRED_SHAPES_WITH_MOTION=2,
+		DEFERRED_STATE_QUERY=4,
+		DEFERRED_DEACTIVATE=8
+	};
+
+	int deferred_updates; // space changes left by integration, applied by apply_deferred_updates()
+	Vector3 deferred_motion;
+
 	_FORCE_INLINE_ void _compute_area_gravity(const AreaSW *p_area);
 
 	_FORCE_INLINE_ void _update_inertia_tensor();
@@ -176,18 +186,27 @@ public:
 
 	_FORCE_INLINE_ void apply_impulse(const Vector3& p_pos, const Vector3& p_j) {
 
+		if (mode<=PhysicsServer::BODY_MODE_KINEMATIC)
+			return; //no effect, and static bodies are shared by islands solved in parallel
+
 		linear_velocity += p_j * _inv_mass;
 		angular_velocity += _inv_inertia_tensor.xform( p_pos.cross(p_j) );
 	}
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector3& p_pos, const Vector3& p_j) {
 
+		if (mode<=PhysicsServer::BODY_MODE_KINEMATIC)
+			return; //no effect, and static bodies are shared by islands solved in parallel
+
 		biased_linear_velocity += p_j * _inv_mass;
 		biased_angular_velocity += _inv_inertia_tensor.xform( p_pos.cross(p_j) );
 	}
 
 	_FORCE_INLINE_ void apply_torque_impulse(const Vector3& p_j) {
 
+		if (mode<=PhysicsServer::BODY_MODE_KINEMATIC)
+			return;
+
 		angular_velocity += _inv_inertia_tensor.xform(p_j);
 	}
 
@@ -239,8 +258,11 @@ public:
 	_FORCE_INLINE_ void set_axis_lock(PhysicsServer::BodyAxisLock p_lock) { axis_lock=p_lock; }
 	_FORCE_INLINE_ PhysicsServer::BodyAxisLock get_axis_lock() const { return axis_lock; }
 
-	void integrate_forces(real_t p_step);
-	void integrate_velocities(real_t p_step);
+	/* with p_defer, the broadphase and space lists are not touched, so bodies can be integrated
+	   from several threads; apply_deferred_updates() must then be called from the stepping thread */
+	void integrate_forces(real_t p_step,bool p_defer=false);
+	void integrate_velocities(real_t p_step,bool p_defer=false);
+	void apply_deferred_updates();
 
 	_FORCE_INLINE_ Vector3 get_velocity_in_local_point(const Vector3& rel_pos) const {
 
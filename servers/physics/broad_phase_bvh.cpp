@@ -0,0 +1,608 @@
+/*************************************************************************/
+/*  broad_phase_bvh.cpp                                                  */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#include "broad_phase_bvh.h"
+#include "collision_object_sw.h"
+
+#define BVH_FAT_MARGIN 0.1 // of the longest axis
+#define BVH_MOTION_PREDICTION 4.0 // frames of motion the fat aabb is stretched along
+
+static _FORCE_INLINE_ real_t _aabb_cost(const AABB& p_aabb) {
+
+	// half the surface area
+	const Vector3 &s=p_aabb.size;
+	return s.x*s.y + s.y*s.z + s.z*s.x;
+}
+
+int BroadPhaseBVH::_alloc_node() {
+
+	if (free_node==-1) {
+
+		int from=nodes.size();
+		nodes.resize(from==0?64:from*2);
+		Node *n=nodes.ptr();
+		for(int i=nodes.size()-1;i>=from;i--) {
+			n[i].parent=free_node;
+			free_node=i;
+		}
+	}
+
+	Node *n=&nodes[free_node];
+	int idx=free_node;
+	free_node=n->parent;
+
+	n->parent=-1;
+	n->children[0]=-1;
+	n->children[1]=-1;
+	n->height=0;
+	n->element=0;
+	return idx;
+}
+
+void BroadPhaseBVH::_free_node(int p_node) {
+
+	nodes[p_node].parent=free_node;
+	nodes[p_node].height=-1;
+	free_node=p_node;
+}
+
+void BroadPhaseBVH::_refit_upwards(int p_node) {
+
+	Node *n=nodes.ptr();
+	int idx=p_node;
+
+	while(idx!=-1) {
+
+		idx=_balance(idx);
+
+		int c0=n[idx].children[0];
+		int c1=n[idx].children[1];
+		n[idx].height=1+MAX(n[c0].height,n[c1].height);
+		n[idx].aabb=n[c0].aabb.merge(n[c1].aabb);
+
+		idx=n[idx].parent;
+	}
+}
+
+void BroadPhaseBVH::_insert_leaf(int p_leaf) {
+
+	Node *n=nodes.ptr();
+
+	if (root==-1) {
+		root=p_leaf;
+		n[root].parent=-1;
+		return;
+	}
+
+	// go down the cheapest way, by the surface area the insertion adds
+	AABB leaf_aabb=n[p_leaf].aabb;
+	int idx=root;
+
+	while(!n[idx].is_leaf()) {
+
+		real_t cost=_aabb_cost(n[idx].aabb);
+		real_t combined_cost=_aabb_cost(n[idx].aabb.merge(leaf_aabb));
+
+		real_t sibling_cost=2.0*combined_cost; // make a new parent for this node and the leaf
+		real_t inheritance_cost=2.0*(combined_cost-cost); // minimum cost of pushing the leaf further down
+
+		real_t child_cost[2];
+		for(int i=0;i<2;i++) {
+
+			const Node &c=n[n[idx].children[i]];
+			real_t merged=_aabb_cost(c.aabb.merge(leaf_aabb));
+			child_cost[i]=(c.is_leaf()?merged:merged-_aabb_cost(c.aabb))+inheritance_cost;
+		}
+
+		if (sibling_cost<child_cost[0] && sibling_cost<child_cost[1])
+			break;
+
+		idx=n[idx].children[child_cost[0]<child_cost[1]?0:1];
+	}
+
+	int sibling=idx;
+	int old_parent=n[sibling].parent;
+	int new_parent=_alloc_node();
+	n=nodes.ptr(); // may have grown
+
+	n[new_parent].parent=old_parent;
+	n[new_parent].aabb=leaf_aabb.merge(n[sibling].aabb);
+	n[new_parent].height=n[sibling].height+1;
+	n[new_parent].children[0]=sibling;
+	n[new_parent].children[1]=p_leaf;
+	n[sibling].parent=new_parent;
+	n[p_leaf].parent=new_parent;
+
+	if (old_parent!=-1) {
+
+		if (n[old_parent].children[0]==sibling)
+			n[old_parent].children[0]=new_parent;
+		else
+			n[old_parent].children[1]=new_parent;
+	} else {
+
+		root=new_parent;
+	}
+
+	_refit_upwards(n[p_leaf].parent);
+}
+
+void BroadPhaseBVH::_remove_leaf(int p_leaf) {
+
+	Node *n=nodes.ptr();
+
+	if (p_leaf==root) {
+		root=-1;
+		return;
+	}
+
+	int parent=n[p_leaf].parent;
+	int grand_parent=n[parent].parent;
+	int sibling=n[parent].children[0]==p_leaf?n[parent].children[1]:n[parent].children[0];
+
+	if (grand_parent!=-1) {
+
+		if (n[grand_parent].children[0]==parent)
+			n[grand_parent].children[0]=sibling;
+		else
+			n[grand_parent].children[1]=sibling;
+		n[sibling].parent=grand_parent;
+		_free_node(parent);
+
+		_refit_upwards(grand_parent);
+	} else {
+
+		root=sibling;
+		n[sibling].parent=-1;
+		_free_node(parent);
+	}
+
+	n[p_leaf].parent=-1;
+}
+
+int BroadPhaseBVH::_balance(int p_node) {
+
+	// rotate the taller grandchild up when the children heights differ by more than one
+
+	Node *n=nodes.ptr();
+	Node *a=&n[p_node];
+
+	if (a->is_leaf() || a->height<2)
+		return p_node;
+
+	int ib=a->children[0];
+	int ic=a->children[1];
+	Node *b=&n[ib];
+	Node *c=&n[ic];
+
+	int balance=c->height-b->height;
+
+	if (balance>1 || balance<-1) {
+
+		// the taller child goes up, p_node goes down in place of its shorter grandchild
+		int i_up=balance>1?ic:ib;
+		int i_stay=balance>1?ib:ic;
+		Node *up=&n[i_up];
+
+		int i_f=up->children[0];
+		int i_g=up->children[1];
+		Node *f=&n[i_f];
+		Node *g=&n[i_g];
+
+		up->children[0]=p_node;
+		up->parent=a->parent;
+		a->parent=i_up;
+
+		if (up->parent!=-1) {
+			if (n[up->parent].children[0]==p_node)
+				n[up->parent].children[0]=i_up;
+			else
+				n[up->parent].children[1]=i_up;
+		} else {
+			root=i_up;
+		}
+
+		// keep the taller grandchild under up, the other one goes to p_node
+		int i_keep=f->height>g->height?i_f:i_g;
+		int i_move=f->height>g->height?i_g:i_f;
+
+		up->children[1]=i_keep;
+		if (balance>1)
+			a->children[1]=i_move;
+		else
+			a->children[0]=i_move;
+		n[i_move].parent=p_node;
+
+		a->aabb=n[i_stay].aabb.merge(n[i_move].aabb);
+		a->height=1+MAX(n[i_stay].height,n[i_move].height);
+		up->aabb=a->aabb.merge(n[i_keep].aabb);
+		up->height=1+MAX(a->height,n[i_keep].height);
+
+		return i_up;
+	}
+
+	return p_node;
+}
+
+void BroadPhaseBVH::_queue_pairing(ID p_id,Element *p_elem) {
+
+	if (p_elem->reinserted)
+		return;
+
+	p_elem->reinserted=true;
+	if (reinserted_count==reinserted.size())
+		reinserted.resize(reinserted_count==0?64:reinserted_count*2);
+	reinserted[reinserted_count++]=p_id;
+}
+
+bool BroadPhaseBVH::_has_pair(const Element *p_elem,ID p_with) const {
+
+	int pc=p_elem->pairs.size();
+	const Pair *p=p_elem->pairs.ptr();
+	for(int i=0;i<pc;i++) {
+		if (p[i].with==p_with)
+			return true;
+	}
+	return false;
+}
+
+void BroadPhaseBVH::_pair(ID p_a,Element *p_elem_a,ID p_b,Element *p_elem_b) {
+
+	Pair pair;
+	pair.ud=NULL;
+	if (pair_callback)
+		pair.ud=pair_callback(p_elem_a->owner,p_elem_a->subindex,p_elem_b->owner,p_elem_b->subindex,pair_userdata);
+
+	pair.with=p_b;
+	p_elem_a->pairs.push_back(pair);
+	pair.with=p_a;
+	p_elem_b->pairs.push_back(pair);
+}
+
+void BroadPhaseBVH::_unpair(ID p_a,Element *p_elem_a,ID p_b,Element *p_elem_b) {
+
+	void *ud=NULL;
+
+	for(int i=0;i<p_elem_a->pairs.size();i++) {
+		if (p_elem_a->pairs[i].with==p_b) {
+			ud=p_elem_a->pairs[i].ud;
+			p_elem_a->pairs.remove(i);
+			break;
+		}
+	}
+
+	for(int i=0;i<p_elem_b->pairs.size();i++) {
+		if (p_elem_b->pairs[i].with==p_a) {
+			p_elem_b->pairs.remove(i);
+			break;
+		}
+	}
+
+	if (unpair_callback)
+		unpair_callback(p_elem_a->owner,p_elem_a->subindex,p_elem_b->owner,p_elem_b->subindex,ud,unpair_userdata);
+}
+
+BroadPhaseSW::ID BroadPhaseBVH::create(CollisionObjectSW *p_object, int p_subindex) {
+
+	if (free_element==0) {
+
+		int from=elements.size();
+		elements.resize(from==0?64:from*2);
+		Element *e=elements.ptr();
+		for(int i=elements.size()-1;i>=from;i--) {
+			e[i].owner=NULL;
+			e[i].next_free=free_element;
+			free_element=i+1;
+		}
+	}
+
+	ID id=free_element;
+	Element *e=&elements[id-1];
+	free_element=e->next_free;
+
+	e->owner=p_object;
+	e->subindex=p_subindex;
+	e->_static=false;
+	e->reinserted=false;
+	e->aabb=AABB();
+	e->leaf=-1; // enters the tree when first moved
+	e->next_free=0;
+
+	return id;
+}
+
+void BroadPhaseBVH::move(ID p_id, const AABB& p_aabb) {
+
+	Element *e=_get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	Vector3 motion=p_aabb.pos-e->aabb.pos;
+	e->aabb=p_aabb;
+
+	if (e->leaf!=-1) {
+
+		if (nodes[e->leaf].aabb.encloses(p_aabb))
+			return; // still inside the fat aabb, nothing changes
+
+		_remove_leaf(e->leaf);
+	} else {
+
+		e->leaf=_alloc_node();
+		nodes[e->leaf].element=p_id;
+		motion=Vector3();
+	}
+
+	AABB fat=p_aabb.grow(p_aabb.get_longest_axis_size()*BVH_FAT_MARGIN);
+	fat.merge_with(AABB(fat.pos+motion*BVH_MOTION_PREDICTION,fat.size));
+	nodes[e->leaf].aabb=fat;
+
+	_insert_leaf(e->leaf);
+	_queue_pairing(p_id,e);
+}
+
+void BroadPhaseBVH::set_static(ID p_id, bool p_static) {
+
+	Element *e=_get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (e->_static==p_static)
+		return;
+
+	e->_static=p_static;
+	if (e->leaf!=-1)
+		_queue_pairing(p_id,e); // pairs between two static objects go away
+}
+
+void BroadPhaseBVH::remove(ID p_id) {
+
+	Element *e=_get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	while(e->pairs.size()) {
+
+		ID with=e->pairs[e->pairs.size()-1].with;
+		_unpair(p_id,e,with,&elements[with-1]);
+	}
+
+	if (e->leaf!=-1) {
+		_remove_leaf(e->leaf);
+		_free_node(e->leaf);
+	}
+
+	e->owner=NULL;
+	e->reinserted=false; // a stale entry may remain queued, it is skipped
+	e->pairs.clear();
+	e->next_free=free_element;
+	free_element=p_id;
+}
+
+CollisionObjectSW *BroadPhaseBVH::get_object(ID p_id) const {
+
+	ERR_FAIL_COND_V(p_id==0 || int(p_id)>elements.size(),NULL);
+	const Element *e=&elements[p_id-1];
+	ERR_FAIL_COND_V(!e->owner,NULL);
+	return e->owner;
+}
+
+bool BroadPhaseBVH::is_static(ID p_id) const {
+
+	ERR_FAIL_COND_V(p_id==0 || int(p_id)>elements.size(),false);
+	return elements[p_id-1]._static;
+}
+
+int BroadPhaseBVH::get_subindex(ID p_id) const {
+
+	ERR_FAIL_COND_V(p_id==0 || int(p_id)>elements.size(),-1);
+	return elements[p_id-1].subindex;
+}
+
+int BroadPhaseBVH::cull_segment(const Vector3& p_from, const Vector3& p_to,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices) {
+
+	if (root==-1)
+		return 0;
+
+	const Node *n=nodes.ptr();
+	const Element *elems=elements.ptr();
+
+	int stack[MAX_DEPTH];
+	int sp=0;
+	int count=0;
+	stack[sp++]=root;
+
+	while(sp && count<p_max_results) {
+
+		const Node &node=n[stack[--sp]];
+
+		if (!node.aabb.intersects_segment(p_from,p_to))
+			continue;
+
+		if (node.is_leaf()) {
+
+			const Element &e=elems[node.element-1];
+			if (!e.aabb.intersects_segment(p_from,p_to))
+				continue;
+
+			p_results[count]=e.owner;
+			if (p_result_indices)
+				p_result_indices[count]=e.subindex;
+			count++;
+		} else {
+
+			ERR_CONTINUE(sp+2>MAX_DEPTH);
+			stack[sp++]=node.children[0];
+			stack[sp++]=node.children[1];
+		}
+	}
+
+	return count;
+}
+
+int BroadPhaseBVH::cull_aabb(const AABB& p_aabb,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices) {
+
+	if (root==-1)
+		return 0;
+
+	const Node *n=nodes.ptr();
+	const Element *elems=elements.ptr();
+
+	int stack[MAX_DEPTH];
+	int sp=0;
+	int count=0;
+	stack[sp++]=root;
+
+	while(sp && count<p_max_results) {
+
+		const Node &node=n[stack[--sp]];
+
+		if (!node.aabb.intersects(p_aabb))
+			continue;
+
+		if (node.is_leaf()) {
+
+			const Element &e=elems[node.element-1];
+			if (!e.aabb.intersects(p_aabb))
+				continue;
+
+			p_results[count]=e.owner;
+			if (p_result_indices)
+				p_result_indices[count]=e.subindex;
+			count++;
+		} else {
+
+			ERR_CONTINUE(sp+2>MAX_DEPTH);
+			stack[sp++]=node.children[0];
+			stack[sp++]=node.children[1];
+		}
+	}
+
+	return count;
+}
+
+void BroadPhaseBVH::set_pair_callback(PairCallback p_pair_callback,void *p_userdata) {
+
+	pair_callback=p_pair_callback;
+	pair_userdata=p_userdata;
+}
+
+void BroadPhaseBVH::set_unpair_callback(UnpairCallback p_unpair_callback,void *p_userdata) {
+
+	unpair_callback=p_unpair_callback;
+	unpair_userdata=p_userdata;
+}
+
+void BroadPhaseBVH::update() {
+
+	// only objects that left their fat aabb (or changed static state) can gain or lose pairs
+
+	for(int i=0;i<reinserted_count;i++) {
+
+		ID id=reinserted[i];
+		Element *e=&elements[id-1];
+		if (!e->reinserted)
+			continue; // removed since
+		e->reinserted=false;
+
+		const AABB fat=nodes[e->leaf].aabb;
+
+		for(int j=0;j<e->pairs.size();) {
+
+			ID with=e->pairs[j].with;
+			Element *o=&elements[with-1];
+			if ((e->_static && o->_static) || !fat.intersects(nodes[o->leaf].aabb)) {
+				_unpair(id,e,with,o);
+			} else {
+				j++;
+			}
+		}
+
+		int stack[MAX_DEPTH];
+		int sp=0;
+		stack[sp++]=root;
+
+		while(sp) {
+
+			int idx=stack[--sp];
+			const Node &node=nodes[idx];
+
+			if (!node.aabb.intersects(fat))
+				continue;
+
+			if (node.is_leaf()) {
+
+				ID with=node.element;
+				if (with==id)
+					continue;
+				Element *o=&elements[with-1];
+				if (o->owner==e->owner || (e->_static && o->_static))
+					continue;
+				if (_has_pair(e,with))
+					continue;
+
+				_pair(id,e,with,o);
+			} else {
+
+				ERR_CONTINUE(sp+2>MAX_DEPTH);
+				stack[sp++]=node.children[0];
+				stack[sp++]=node.children[1];
+			}
+		}
+	}
+
+	reinserted_count=0;
+}
+
+int BroadPhaseBVH::get_pair_count() const {
+
+	int count=0;
+	for(int i=0;i<elements.size();i++) {
+		if (elements[i].owner)
+			count+=elements[i].pairs.size();
+	}
+	return count/2;
+}
+
+BroadPhaseSW *BroadPhaseBVH::_create() {
+
+	return memnew( BroadPhaseBVH );
+}
+
+BroadPhaseBVH::BroadPhaseBVH() {
+
+	free_node=-1;
+	root=-1;
+	free_element=0;
+	reinserted_count=0;
+	pair_callback=NULL;
+	pair_userdata=NULL;
+	unpair_callback=NULL;
+	unpair_userdata=NULL;
+}
+
+BroadPhaseBVH::~BroadPhaseBVH() {
+
+}
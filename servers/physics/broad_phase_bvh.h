@@ -0,0 +1,139 @@
+/*************************************************************************/
+/*  broad_phase_bvh.h                                                    */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef BROAD_PHASE_BVH_H
+#define BROAD_PHASE_BVH_H
+
+#include "broad_phase_sw.h"
+#include "vector.h"
+
+/**
+ * Dynamic AABB tree broadphase. Leaves hold a fattened AABB (grown by a margin and
+ * stretched along the last motion) so moving objects only touch the tree when they
+ * leave it. Pairs are kept between objects whose fat AABBs overlap, and are only
+ * updated for the objects that were reinserted since the last update().
+ */
+
+class BroadPhaseBVH : public BroadPhaseSW {
+
+	enum {
+		MAX_DEPTH=64 // enough for any balanced tree that fits in memory
+	};
+
+	struct Node {
+
+		AABB aabb;
+		int parent; // next free node when unused
+		int children[2]; // -1 for leaves
+		int height;
+		ID element;
+
+		_FORCE_INLINE_ bool is_leaf() const { return children[0]==-1; }
+	};
+
+	struct Pair {
+
+		ID with;
+		void *ud;
+	};
+
+	struct Element {
+
+		CollisionObjectSW *owner; // NULL when unused
+		int subindex;
+		bool _static;
+		bool reinserted; // queued for pairing in update()
+		AABB aabb;
+		int leaf;
+		ID next_free;
+		Vector<Pair> pairs;
+	};
+
+	Vector<Node> nodes;
+	int free_node;
+	int root;
+
+	Vector<Element> elements; // indexed by ID-1
+	ID free_element;
+
+	Vector<ID> reinserted;
+	int reinserted_count;
+
+	PairCallback pair_callback;
+	void *pair_userdata;
+	UnpairCallback unpair_callback;
+	void *unpair_userdata;
+
+	int _alloc_node();
+	void _free_node(int p_node);
+	void _insert_leaf(int p_leaf);
+	void _remove_leaf(int p_leaf);
+	int _balance(int p_node);
+	void _refit_upwards(int p_node);
+
+	_FORCE_INLINE_ Element *_get_element(ID p_id) {
+
+		ERR_FAIL_COND_V(p_id==0 || int(p_id)>elements.size(),NULL);
+		Element *e=&elements[p_id-1];
+		ERR_FAIL_COND_V(!e->owner,NULL);
+		return e;
+	}
+
+	void _queue_pairing(ID p_id,Element *p_elem);
+	bool _has_pair(const Element *p_elem,ID p_with) const;
+	void _pair(ID p_a,Element *p_elem_a,ID p_b,Element *p_elem_b);
+	void _unpair(ID p_a,Element *p_elem_a,ID p_b,Element *p_elem_b);
+
+public:
+
+	// 0 is an invalid ID
+	virtual ID create(CollisionObjectSW *p_object_, int p_subindex=0);
+	virtual void move(ID p_id, const AABB& p_aabb);
+	virtual void set_static(ID p_id, bool p_static);
+	virtual void remove(ID p_id);
+
+	virtual CollisionObjectSW *get_object(ID p_id) const;
+	virtual bool is_static(ID p_id) const;
+	virtual int get_subindex(ID p_id) const;
+
+	virtual int cull_segment(const Vector3& p_from, const Vector3& p_to,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices=NULL);
+	virtual int cull_aabb(const AABB& p_aabb,CollisionObjectSW** p_results,int p_max_results,int *p_result_indices=NULL);
+
+	virtual void set_pair_callback(PairCallback p_pair_callback,void *p_userdata);
+	virtual void set_unpair_callback(UnpairCallback p_unpair_callback,void *p_userdata);
+
+	virtual void update();
+
+	int get_pair_count() const;
+
+	static BroadPhaseSW *_create();
+	BroadPhaseBVH();
+	~BroadPhaseBVH();
+};
+
+#endif // BROAD_PHASE_BVH_H
@@ -72,11 +72,10 @@ private:
 	Transform inv_transform;
 	bool _static;
 
-	void _update_shapes();
-
 protected:
 
 
+	void _update_shapes();
 	void _update_shapes_with_motion(const Vector3& p_motion);
 	void _unregister_shapes();
 
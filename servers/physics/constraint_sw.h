@@ -70,6 +70,10 @@ public:
 	virtual bool setup(float p_step)=0;
 	virtual void solve(float p_step)=0;
 
+	/* true when setup() writes to objects shared with other islands (areas, static or kinematic
+	   bodies), such constraints are set up serially before the islands are solved in parallel */
+	virtual bool is_setup_shared() const { return false; }
+
 	virtual ~ConstraintSW() {}
 };
 
@@ -29,11 +29,13 @@
 #include "physics_server_sw.h"
 #include "broad_phase_basic.h"
 #include "broad_phase_octree.h"
+#include "broad_phase_bvh.h"
 #include "joints/pin_joint_sw.h"
 #include "joints/hinge_joint_sw.h"
 #include "joints/slider_joint_sw.h"
 #include "joints/cone_twist_joint_sw.h"
 #include "joints/generic_6dof_joint_sw.h"
+#include "globals.h"
 
 
 RID PhysicsServerSW::shape_create(ShapeType p_shape) {
@@ -1527,9 +1529,17 @@ void PhysicsServerSW::_shape_col_cbk(const Vector3& p_point_A,const Vector3& p_p
 }
 
 
+PhysicsServerSW *PhysicsServerSW::singleton=NULL;
+
 PhysicsServerSW::PhysicsServerSW() {
 
-	BroadPhaseSW::create_func=BroadPhaseOctree::_create;
+	singleton=this;
+	String broad_phase = GLOBAL_DEF("physics/broad_phase","octree");
+	Globals::get_singleton()->set_custom_property_info("physics/broad_phase",PropertyInfo(Variant::STRING,"physics/broad_phase",PROPERTY_HINT_ENUM,"octree,bvh"));
+	if (broad_phase=="bvh")
+		BroadPhaseSW::create_func=BroadPhaseBVH::_create;
+	else
+		BroadPhaseSW::create_func=BroadPhaseOctree::_create;
 	island_count=0;
 	active_objects=0;
 	collision_pairs=0;
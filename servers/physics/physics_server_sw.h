@@ -65,6 +65,8 @@ friend class PhysicsDirectSpaceStateSW;
 //	void _clear_query(QuerySW *p_query);
 public:
 
+	static PhysicsServerSW *singleton; // PhysicsServer::get_singleton() may be a wrapper
+
 	struct CollCbkData {
 
 		int max;
@@ -0,0 +1,309 @@
+/*************************************************************************/
+/*  physics_server_wrap_mt.h                                             */
+/*************************************************************************/
+/*                       This file is part of:                           */
+/*                           GODOT ENGINE                                */
+/*                    http://www.godotengine.org                         */
+/*************************************************************************/
+/* Copyright (c) 2007-2015 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+#ifndef PHYSICSSERVERWRAPMT_H
+#define PHYSICSSERVERWRAPMT_H
+
+
+#include "servers/physics_server.h"
+#include "command_queue_mt.h"
+#include "os/thread.h"
+#include "globals.h"
+
+#ifdef DEBUG_SYNC
+#define SYNC_DEBUG print_line("sync on: "+String(__FUNCTION__));
+#else
+#define SYNC_DEBUG
+#endif
+
+
+class PhysicsServerWrapMT : public PhysicsServer {
+
+	mutable PhysicsServer *physics_server;
+
+	mutable CommandQueueMT command_queue;
+
+	static void _thread_callback(void *_instance);
+	void thread_loop();
+
+	Thread::ID server_thread;
+	Thread::ID main_thread;
+	volatile bool exit;
+	Thread *thread;
+	volatile bool step_thread_up;
+	bool create_thread;
+
+	Semaphore *step_sem;
+	int step_pending; // a step was issued to the server thread and not synced yet
+	void thread_step(float p_delta);
+	void thread_flush();
+
+	void thread_exit();
+
+	void _wait_step();
+
+public:
+
+#define ServerName PhysicsServer
+#define ServerNameWrapMT PhysicsServerWrapMT
+#define server_name physics_server
+#include "servers/server_wrap_mt_common.h"
+
+	FUNC1R(RID,shape_create,ShapeType);
+	FUNC2(shape_set_data,RID,const Variant& );
+	FUNC2(shape_set_custom_solver_bias,RID,real_t );
+
+	FUNC1RC(ShapeType,shape_get_type,RID );
+	FUNC1RC(Variant,shape_get_data,RID);
+	FUNC1RC(real_t,shape_get_custom_solver_bias,RID);
+
+
+	/* SPACE API */
+
+	FUNC0R(RID,space_create);
+	FUNC2(space_set_active,RID,bool);
+	FUNC1RC(bool,space_is_active,RID);
+
+	FUNC3(space_set_param,RID,SpaceParameter,real_t);
+	FUNC2RC(real_t,space_get_param,RID,SpaceParameter);
+
+	// this function only works on fixed process, errors and returns null otherwise
+	PhysicsDirectSpaceState* space_get_direct_state(RID p_space) {
+
+		ERR_FAIL_COND_V(main_thread!=Thread::get_caller_ID(),NULL);
+		_wait_step();
+		return physics_server->space_get_direct_state(p_space);
+	}
+
+
+	/* AREA API */
+
+	FUNC0R(RID,area_create);
+
+	FUNC2(area_set_space,RID,RID);
+	FUNC1RC(RID,area_get_space,RID);
+
+	FUNC2(area_set_space_override_mode,RID,AreaSpaceOverrideMode);
+	FUNC1RC(AreaSpaceOverrideMode,area_get_space_override_mode,RID);
+
+	FUNC3(area_add_shape,RID,RID,const Transform&);
+	FUNC3(area_set_shape,RID,int,RID);
+	FUNC3(area_set_shape_transform,RID,int,const Transform&);
+
+	FUNC1RC(int,area_get_shape_count,RID);
+	FUNC2RC(RID,area_get_shape,RID,int);
+	FUNC2RC(Transform,area_get_shape_transform,RID,int);
+	FUNC2(area_remove_shape,RID,int);
+	FUNC1(area_clear_shapes,RID);
+
+	FUNC2(area_attach_object_instance_ID,RID,ObjectID);
+	FUNC1RC(ObjectID,area_get_object_instance_ID,RID);
+
+	FUNC3(area_set_param,RID,AreaParameter,const Variant&);
+	FUNC2(area_set_transform,RID,const Transform&);
+
+	FUNC2RC(Variant,area_get_param,RID,AreaParameter);
+	FUNC1RC(Transform,area_get_transform,RID);
+
+	FUNC2(area_set_monitorable,RID,bool);
+
+	FUNC3(area_set_monitor_callback,RID,Object*,const StringName&);
+	FUNC3(area_set_area_monitor_callback,RID,Object*,const StringName&);
+
+	FUNC2(area_set_ray_pickable,RID,bool);
+	FUNC1RC(bool,area_is_ray_pickable,RID);
+
+
+	/* BODY API */
+
+	FUNC2R(RID,body_create,BodyMode,bool);
+
+	FUNC2(body_set_space,RID,RID);
+	FUNC1RC(RID,body_get_space,RID);
+
+	FUNC2(body_set_mode,RID,BodyMode);
+	FUNC2RC(BodyMode,body_get_mode,RID,BodyMode);
+
+
+	FUNC3(body_add_shape,RID,RID,const Transform&);
+	FUNC3(body_set_shape,RID,int,RID);
+	FUNC3(body_set_shape_transform,RID,int,const Transform&);
+
+	FUNC1RC(int,body_get_shape_count,RID);
+	FUNC2RC(RID,body_get_shape,RID,int);
+	FUNC2RC(Transform,body_get_shape_transform,RID,int);
+
+	FUNC3(body_set_shape_as_trigger,RID,int,bool);
+	FUNC2RC(bool,body_is_shape_set_as_trigger,RID,int);
+
+	FUNC2(body_remove_shape,RID,int);
+	FUNC1(body_clear_shapes,RID);
+
+	FUNC2(body_attach_object_instance_ID,RID,uint32_t);
+	FUNC1RC(uint32_t,body_get_object_instance_ID,RID);
+
+	FUNC2(body_set_enable_continuous_collision_detection,RID,bool);
+	FUNC1RC(bool,body_is_continuous_collision_detection_enabled,RID);
+
+	FUNC2(body_set_layer_mask,RID,uint32_t);
+	FUNC2RC(uint32_t,body_get_layer_mask,RID,uint32_t);
+
+	FUNC2(body_set_user_flags,RID,uint32_t);
+	FUNC2RC(uint32_t,body_get_user_flags,RID,uint32_t);
+
+
+	FUNC3(body_set_param,RID,BodyParameter,float);
+	FUNC2RC(float,body_get_param,RID,BodyParameter);
+
+
+	FUNC3(body_set_state,RID,BodyState,const Variant&);
+	FUNC2RC(Variant,body_get_state,RID,BodyState);
+
+	FUNC2(body_set_applied_force,RID,const Vector3&);
+	FUNC1RC(Vector3,body_get_applied_force,RID);
+
+	FUNC2(body_set_applied_torque,RID,const Vector3&);
+	FUNC1RC(Vector3,body_get_applied_torque,RID);
+
+	FUNC3(body_apply_impulse,RID,const Vector3&,const Vector3&);
+	FUNC2(body_set_axis_velocity,RID,const Vector3&);
+
+	FUNC2(body_set_axis_lock,RID,BodyAxisLock);
+	FUNC1RC(BodyAxisLock,body_get_axis_lock,RID);
+
+	FUNC2(body_add_collision_exception,RID,RID);
+	FUNC2(body_remove_collision_exception,RID,RID);
+	FUNC2S(body_get_collision_exceptions,RID,List<RID>*);
+
+	FUNC2(body_set_max_contacts_reported,RID,int);
+	FUNC1RC(int,body_get_max_contacts_reported,RID);
+
+	FUNC2(body_set_contacts_reported_depth_treshold,RID,float);
+	FUNC1RC(float,body_get_contacts_reported_depth_treshold,RID);
+
+	FUNC2(body_set_omit_force_integration,RID,bool);
+	FUNC1RC(bool,body_is_omitting_force_integration,RID);
+
+	FUNC4(body_set_force_integration_callback,RID ,Object *,const StringName& ,const Variant& );
+
+	FUNC2(body_set_ray_pickable,RID,bool);
+	FUNC1RC(bool,body_is_ray_pickable,RID);
+
+
+	/* JOINT API */
+
+	FUNC1RC(JointType,joint_get_type,RID);
+
+	FUNC2(joint_set_solver_priority,RID,int);
+	FUNC1RC(int,joint_get_solver_priority,RID);
+
+	FUNC4R(RID,joint_create_pin,RID,const Vector3&,RID,const Vector3&);
+
+	FUNC3(pin_joint_set_param,RID,PinJointParam,float);
+	FUNC2RC(float,pin_joint_get_param,RID,PinJointParam);
+
+	FUNC2(pin_joint_set_local_A,RID,const Vector3&);
+	FUNC1RC(Vector3,pin_joint_get_local_A,RID);
+
+	FUNC2(pin_joint_set_local_B,RID,const Vector3&);
+	FUNC1RC(Vector3,pin_joint_get_local_B,RID);
+
+	FUNC4R(RID,joint_create_hinge,RID,const Transform&,RID,const Transform&);
+	FUNC6R(RID,joint_create_hinge_simple,RID,const Vector3&,const Vector3&,RID,const Vector3&,const Vector3&);
+
+	FUNC3(hinge_joint_set_param,RID,HingeJointParam,float);
+	FUNC2RC(float,hinge_joint_get_param,RID,HingeJointParam);
+
+	FUNC3(hinge_joint_set_flag,RID,HingeJointFlag,bool);
+	FUNC2RC(bool,hinge_joint_get_flag,RID,HingeJointFlag);
+
+	FUNC4R(RID,joint_create_slider,RID,const Transform&,RID,const Transform&);
+
+	FUNC3(slider_joint_set_param,RID,SliderJointParam,float);
+	FUNC2RC(float,slider_joint_get_param,RID,SliderJointParam);
+
+	FUNC4R(RID,joint_create_cone_twist,RID,const Transform&,RID,const Transform&);
+
+	FUNC3(cone_twist_joint_set_param,RID,ConeTwistJointParam,float);
+	FUNC2RC(float,cone_twist_joint_get_param,RID,ConeTwistJointParam);
+
+	FUNC4R(RID,joint_create_generic_6dof,RID,const Transform&,RID,const Transform&);
+
+	FUNC4(generic_6dof_joint_set_param,RID,Vector3::Axis,G6DOFJointAxisParam,float);
+	FUNC3R(float,generic_6dof_joint_get_param,RID,Vector3::Axis,G6DOFJointAxisParam);
+
+	FUNC4(generic_6dof_joint_set_flag,RID,Vector3::Axis,G6DOFJointAxisFlag,bool);
+	FUNC3R(bool,generic_6dof_joint_get_flag,RID,Vector3::Axis,G6DOFJointAxisFlag);
+
+
+	/* MISC */
+
+
+	FUNC1(free,RID);
+	FUNC1(set_active,bool);
+
+	virtual void init();
+	virtual void step(float p_step);
+	virtual void sync();
+	virtual void flush_queries();
+	virtual void finish();
+
+	int get_process_info(ProcessInfo p_info) {
+		return physics_server->get_process_info(p_info);
+	}
+
+	PhysicsServerWrapMT(PhysicsServer* p_contained,bool p_create_thread);
+	~PhysicsServerWrapMT();
+
+
+	template<class T>
+	static PhysicsServer* init_server() {
+
+		int tm = GLOBAL_DEF("physics/thread_model",1);
+		if (tm==0) //single unsafe
+			return memnew( T );
+		else if (tm==1) //single safe
+			return memnew( PhysicsServerWrapMT( memnew( T ), false ));
+		else //multi threaded, the step overlaps idle processing
+			return memnew( PhysicsServerWrapMT( memnew( T ), true ));
+
+
+	}
+
+#undef ServerNameWrapMT
+#undef ServerName
+#undef server_name
+
+};
+
+#ifdef DEBUG_SYNC
+#undef DEBUG_SYNC
+#endif
+#undef SYNC_DEBUG
+
+#endif // PHYSICSSERVERWRAPMT_H
@@ -30,6 +30,7 @@
 #include "geometry.h"
 #include "sort.h"
 #include "quick_hull.h"
+#include "hashfuncs.h"
 #define _POINT_SNAP 0.001953125
 #define _EDGE_IS_VALID_SUPPORT_TRESHOLD 0.0002
 #define _FACE_IS_VALID_SUPPORT_TRESHOLD 0.9998
@@ -1047,136 +1048,126 @@ Vector3 ConcavePolygonShapeSW::get_support(const Vector3& p_normal) const {
 
 }
 
-void ConcavePolygonShapeSW::_cull_segment(int p_idx,_SegmentCullParams *p_params) const {
-
-	const BVH *bvh=&p_params->bvh[p_idx];
-
-
-	//if (p_params->dir.dot(bvh->aabb.get_support(-p_params->dir))>p_params->min_d)
-	//	return; //test against whole AABB, which isn't very costly
-
-
-	//printf("addr: %p\n",bvh);
-	if (!bvh->aabb.intersects_segment(p_params->from,p_params->to)) {
-
-		return;
-	}
-
-
-	if (bvh->face_index>=0) {
-
-
-		Vector3 res;
-		Vector3 vertices[3]={
-			p_params->vertices[ p_params->faces[ bvh->face_index ].indices[0] ],
-			p_params->vertices[ p_params->faces[ bvh->face_index ].indices[1] ],
-			p_params->vertices[ p_params->faces[ bvh->face_index ].indices[2] ]
-		};
-
-		if (Geometry::segment_intersects_triangle(
-				p_params->from,
-				p_params->to,
-				vertices[0],
-				vertices[1],
-				vertices[2],
-				&res)) {
-
-
-			float d=p_params->dir.dot(res) - p_params->dir.dot(p_params->from);
-			//TODO, seems segmen/triangle intersection is broken :(
-			if (d>0 && d<p_params->min_d) {
-
-				p_params->min_d=d;
-				p_params->result=res;
-				p_params->normal=Plane(vertices[0],vertices[1],vertices[2]).normal;
-				if (p_params->normal.dot(p_params->dir)>0)
-					p_params->normal=-p_params->normal;
-				p_params->collisions++;
-			}
-
-		}
-
-
-
-	} else {
-
-		if (bvh->left>=0)
-			_cull_segment(bvh->left,p_params);
-		if (bvh->right>=0)
-			_cull_segment(bvh->right,p_params);
-
-
-	}
-}
-
 bool ConcavePolygonShapeSW::intersect_segment(const Vector3& p_begin,const Vector3& p_end,Vector3 &r_result, Vector3 &r_normal) const {
 
 	if (faces.size()==0)
 		return false;
 
+	Vector3 dir=p_end-p_begin;
+	real_t len=dir.length();
+	if (len<CMP_EPSILON)
+		return false;
+	dir/=len;
+
 	// unlock data
 	DVector<Face>::Read fr=faces.read();
 	DVector<Vector3>::Read vr=vertices.read();
 	DVector<BVH>::Read br=bvh.read();
 
+	const Face *f=fr.ptr();
+	const Vector3 *v=vr.ptr();
+	const BVH *nodes=br.ptr();
+
+	// slab test in quantized space, the segment is clipped to the closest hit found so far
+	Vector3 from_q=(p_begin-bvh_aabb.pos)*bvh_inv_scale;
+	Vector3 seg_q=(p_end-p_begin)*bvh_inv_scale;
+	Vector3 inv_q;
+	bool parallel[3];
+	for(int i=0;i<3;i++) {
+		parallel[i]=Math::abs(seg_q[i])<CMP_EPSILON;
+		inv_q[i]=parallel[i]?0:1.0/seg_q[i];
+	}
 
-	_SegmentCullParams params;
-	params.from=p_begin;
-	params.to=p_end;
-	params.collisions=0;
-	params.dir=(p_end-p_begin).normalized();
+	real_t max_t=1.0;
+	real_t min_d=1e20;
+	bool collided=false;
 
-	params.faces=fr.ptr();
-	params.vertices=vr.ptr();
-	params.bvh=br.ptr();
+	uint32_t stack[BVH_MAX_DEPTH];
+	int sp=0;
+	uint32_t idx=0;
 
-	params.min_d=1e20;
-	// cull
-	_cull_segment(0,&params);
+	while(true) {
 
-	if (params.collisions>0) {
+		const BVH &n=nodes[idx];
 
+		real_t t0=0;
+		real_t t1=max_t;
+		bool overlaps=true;
 
-		r_result=params.result;
-		r_normal=params.normal;
-		return true;
-	} else {
+		for(int i=0;i<3;i++) {
 
-		return false;
-	}
-}
+			if (parallel[i]) {
 
-void ConcavePolygonShapeSW::_cull(int p_idx,_CullParams *p_params) const {
+				if (from_q[i]<n.min[i] || from_q[i]>n.max[i]) {
+					overlaps=false;
+					break;
+				}
+			} else {
 
-	const BVH* bvh=&p_params->bvh[p_idx];
+				real_t ta=(n.min[i]-from_q[i])*inv_q[i];
+				real_t tb=(n.max[i]-from_q[i])*inv_q[i];
+				if (ta>tb)
+					SWAP(ta,tb);
+				t0=MAX(t0,ta);
+				t1=MIN(t1,tb);
+				if (t0>t1) {
+					overlaps=false;
+					break;
+				}
+			}
+		}
 
-	if (!p_params->aabb.intersects( bvh->aabb ))
-		return;
+		if (overlaps) {
 
-	if (bvh->face_index>=0) {
+			if (n.count) {
 
-		const Face *f=&p_params->faces[ bvh->face_index ];
-		FaceShapeSW *face=p_params->face;
-		face->normal=f->normal;
-		face->vertex[0]=p_params->vertices[f->indices[0]];
-		face->vertex[1]=p_params->vertices[f->indices[1]];
-		face->vertex[2]=p_params->vertices[f->indices[2]];
-		p_params->callback(p_params->userdata,face);
+				for(uint32_t i=n.index;i<n.index+n.count;i++) {
 
-	} else {
+					const Face &face=f[i];
+					const Vector3 &v0=v[face.indices[0]];
+					const Vector3 &v1=v[face.indices[1]];
+					const Vector3 &v2=v[face.indices[2]];
 
-		if (bvh->left>=0) {
+					Vector3 res;
+					if (!Geometry::segment_intersects_triangle(p_begin,p_end,v0,v1,v2,&res))
+						continue;
 
-			_cull(bvh->left,p_params);
+					real_t d=dir.dot(res) - dir.dot(p_begin);
+					//TODO, seems segmen/triangle intersection is broken :(
+					if (d>0 && d<min_d) {
 
-		}
+						min_d=d;
+						max_t=d/len;
+						r_result=res;
+						r_normal=Plane(v0,v1,v2).normal;
+						if (r_normal.dot(dir)>0)
+							r_normal=-r_normal;
+						collided=true;
+					}
+				}
 
-		if (bvh->right>=0) {
+			} else {
+
+				ERR_FAIL_COND_V(sp>=BVH_MAX_DEPTH,collided);
 
-			_cull(bvh->right,p_params);
+				// nearest child first, so the far one is more likely to be clipped away
+				if (seg_q[n.axis]<0) {
+					stack[sp++]=idx+1;
+					idx=n.index;
+				} else {
+					stack[sp++]=n.index;
+					idx=idx+1;
+				}
+				continue;
+			}
 		}
 
+		if (sp==0)
+			break;
+		idx=stack[--sp];
 	}
+
+	return collided;
 }
 
 void ConcavePolygonShapeSW::cull(const AABB& p_local_aabb,Callback p_callback,void* p_userdata) const {
@@ -1185,27 +1176,64 @@ void ConcavePolygonShapeSW::cull(const AABB& p_local_aabb,Callback p_callback,vo
 	if (faces.size()==0)
 		return;
 
-	AABB local_aabb=p_local_aabb;
-
 	// unlock data
 	DVector<Face>::Read fr=faces.read();
 	DVector<Vector3>::Read vr=vertices.read();
 	DVector<BVH>::Read br=bvh.read();
 
+	const Face *f=fr.ptr();
+	const Vector3 *v=vr.ptr();
+	const BVH *nodes=br.ptr();
+
+	Vector3 qmin=(p_local_aabb.pos-bvh_aabb.pos)*bvh_inv_scale;
+	Vector3 qmax=(p_local_aabb.pos+p_local_aabb.size-bvh_aabb.pos)*bvh_inv_scale;
+
 	FaceShapeSW face; // use this to send in the callback
 
-	_CullParams params;
-	params.aabb=local_aabb;
-	params.face=&face;
-	params.faces=fr.ptr();
-	params.vertices=vr.ptr();
-	params.bvh=br.ptr();
-	params.callback=p_callback;
-	params.userdata=p_userdata;
+	uint32_t stack[BVH_MAX_DEPTH];
+	int sp=0;
+	uint32_t idx=0;
+
+	while(true) {
+
+		const BVH &n=nodes[idx];
+
+		if (	n.min[0]<=qmax.x && n.max[0]>=qmin.x &&
+			n.min[1]<=qmax.y && n.max[1]>=qmin.y &&
+			n.min[2]<=qmax.z && n.max[2]>=qmin.z) {
+
+			if (n.count) {
+
+				for(uint32_t i=n.index;i<n.index+n.count;i++) {
+
+					const Face &src=f[i];
+					face.vertex[0]=v[src.indices[0]];
+					face.vertex[1]=v[src.indices[1]];
+					face.vertex[2]=v[src.indices[2]];
+
+					AABB face_aabb(face.vertex[0],Vector3());
+					face_aabb.expand_to(face.vertex[1]);
+					face_aabb.expand_to(face.vertex[2]);
+					if (!p_local_aabb.intersects(face_aabb))
+						continue;
+
+					face.normal=src.normal;
+					p_callback(p_userdata,&face);
+				}
+
+			} else {
 
-	// cull
-	_cull(0,&params);
+				ERR_FAIL_COND(sp>=BVH_MAX_DEPTH);
+				stack[sp++]=n.index;
+				idx=idx+1;
+				continue;
+			}
+		}
 
+		if (sp==0)
+			break;
+		idx=stack[--sp];
+	}
 }
 
 Vector3 ConcavePolygonShapeSW::get_moment_of_inertia(float p_mass) const {
@@ -1220,374 +1248,657 @@ Vector3 ConcavePolygonShapeSW::get_moment_of_inertia(float p_mass) const {
 	);
 }
 
+/* BVH build: binned surface area heuristic, median split when binning can't separate the faces or the
+   tree gets too deep */
+
+#define _CONCAVE_BVH_BINS 16
+#define _CONCAVE_BVH_TRAVERSAL_COST 1.0
+#define _CONCAVE_BVH_BLOB_MAGIC 0x31485642 // "BVH1"
 
-struct _VolumeSW_BVH_Element {
+struct _ConcaveBVHElement {
 
 	AABB aabb;
 	Vector3 center;
-	int face_index;
+	int face;
 };
 
-struct _VolumeSW_BVH_CompareX {
+struct _ConcaveBVHCompare {
 
-	_FORCE_INLINE_ bool operator ()(const _VolumeSW_BVH_Element& a, const _VolumeSW_BVH_Element& b) const {
+	int axis;
 
-		return a.center.x<b.center.x;
+	_FORCE_INLINE_ bool operator ()(const _ConcaveBVHElement& a, const _ConcaveBVHElement& b) const {
+
+		return a.center[axis]<b.center[axis];
 	}
 };
 
+struct _ConcaveBVHBuild {
 
-struct _VolumeSW_BVH_CompareY {
+	_ConcaveBVHElement *elements;
+	ConcavePolygonShapeSW::BVH *nodes;
+	AABB *node_aabbs;
+	int node_count;
 
-	_FORCE_INLINE_ bool operator ()(const _VolumeSW_BVH_Element& a, const _VolumeSW_BVH_Element& b) const {
+	static _FORCE_INLINE_ real_t _cost(const AABB& p_aabb) {
 
-		return a.center.y<b.center.y;
+		// half the surface area
+		const Vector3 &s=p_aabb.size;
+		return s.x*s.y + s.y*s.z + s.z*s.x;
 	}
-};
 
-struct _VolumeSW_BVH_CompareZ {
+	int _split_median(int p_from,int p_to,const AABB& p_centers) {
 
-	_FORCE_INLINE_ bool operator ()(const _VolumeSW_BVH_Element& a, const _VolumeSW_BVH_Element& b) const {
-
-		return a.center.z<b.center.z;
+		SortArray<_ConcaveBVHElement,_ConcaveBVHCompare> sort;
+		sort.compare.axis=p_centers.get_longest_axis_index();
+		int mid=(p_from+p_to)/2;
+		sort.nth_element(p_from,p_to,mid,elements);
+		return mid;
 	}
-};
 
-struct _VolumeSW_BVH {
+	int build(int p_from,int p_to,int p_depth) {
 
-	AABB aabb;
-	_VolumeSW_BVH *left;
-	_VolumeSW_BVH *right;
+		int idx=node_count++;
+		ConcavePolygonShapeSW::BVH &node=nodes[idx];
+		int count=p_to-p_from;
 
-	int face_index;
-};
+		AABB bounds=elements[p_from].aabb;
+		AABB centers(elements[p_from].center,Vector3());
+		for(int i=p_from+1;i<p_to;i++) {
+			bounds.merge_with(elements[i].aabb);
+			centers.expand_to(elements[i].center);
+		}
+		node_aabbs[idx]=bounds;
 
+		if (count==1) {
+			node.index=p_from;
+			node.count=1;
+			node.axis=0;
+			return idx;
+		}
 
-_VolumeSW_BVH* _volume_sw_build_bvh(_VolumeSW_BVH_Element *p_elements,int p_size,int &count) {
+		int best_axis=-1;
+		int best_split=0;
+		real_t best_cost=1e20;
 
-	_VolumeSW_BVH* bvh = memnew( _VolumeSW_BVH );
+		if (p_depth<ConcavePolygonShapeSW::BVH_MAX_DEPTH-24) {
 
-	if (p_size==1) {
-		//leaf
-		bvh->aabb=p_elements[0].aabb;
-		bvh->left=NULL;
-		bvh->right=NULL;
-		bvh->face_index=p_elements->face_index;
-		count++;
-		return bvh;
-	} else {
+			real_t inv_area=1.0/MAX(_cost(bounds),CMP_EPSILON);
 
-		bvh->face_index=-1;
-	}
+			for(int axis=0;axis<3;axis++) {
 
-	AABB aabb;
-	for(int i=0;i<p_size;i++) {
+				real_t extent=centers.size[axis];
+				if (extent<CMP_EPSILON)
+					continue;
 
-		if (i==0)
-			aabb=p_elements[i].aabb;
-		else
-			aabb.merge_with(p_elements[i].aabb);
-	}
-	bvh->aabb=aabb;
-	switch(aabb.get_longest_axis_index()) {
+				int bin_count[_CONCAVE_BVH_BINS];
+				AABB bin_aabb[_CONCAVE_BVH_BINS];
+				for(int i=0;i<_CONCAVE_BVH_BINS;i++)
+					bin_count[i]=0;
 
-		case 0: {
+				real_t bin_scale=_CONCAVE_BVH_BINS/extent;
+				for(int i=p_from;i<p_to;i++) {
 
-			SortArray<_VolumeSW_BVH_Element,_VolumeSW_BVH_CompareX> sort_x;
-			sort_x.sort(p_elements,p_size);
+					int b=CLAMP(int((elements[i].center[axis]-centers.pos[axis])*bin_scale),0,_CONCAVE_BVH_BINS-1);
+					if (bin_count[b]==0)
+						bin_aabb[b]=elements[i].aabb;
+					else
+						bin_aabb[b].merge_with(elements[i].aabb);
+					bin_count[b]++;
+				}
 
-		} break;
-		case 1: {
+				// right side costs, swept from the end
+				real_t right_cost[_CONCAVE_BVH_BINS];
+				AABB accum;
+				int accum_count=0;
+				for(int i=_CONCAVE_BVH_BINS-1;i>0;i--) {
+
+					if (bin_count[i]) {
+						if (accum_count==0)
+							accum=bin_aabb[i];
+						else
+							accum.merge_with(bin_aabb[i]);
+						accum_count+=bin_count[i];
+					}
+					right_cost[i]=accum_count?_cost(accum)*accum_count:0;
+				}
 
-			SortArray<_VolumeSW_BVH_Element,_VolumeSW_BVH_CompareY> sort_y;
-			sort_y.sort(p_elements,p_size);
-		} break;
-		case 2: {
+				accum_count=0;
+				for(int i=0;i<_CONCAVE_BVH_BINS-1;i++) {
+
+					if (bin_count[i]) {
+						if (accum_count==0)
+							accum=bin_aabb[i];
+						else
+							accum.merge_with(bin_aabb[i]);
+						accum_count+=bin_count[i];
+					}
+
+					if (accum_count==0 || accum_count==count)
+						continue;
+
+					real_t cost=_CONCAVE_BVH_TRAVERSAL_COST+(_cost(accum)*accum_count+right_cost[i+1])*inv_area;
+					if (cost<best_cost) {
+						best_cost=cost;
+						best_axis=axis;
+						best_split=i+1;
+					}
+				}
+			}
+		}
 
-			SortArray<_VolumeSW_BVH_Element,_VolumeSW_BVH_CompareZ> sort_z;
-			sort_z.sort(p_elements,p_size);
-		} break;
-	}
+		if (count<=ConcavePolygonShapeSW::BVH_MAX_LEAF_FACES && (best_axis==-1 || best_cost>=count)) {
+			node.index=p_from;
+			node.count=count;
+			node.axis=0;
+			return idx;
+		}
 
-	int split=p_size/2;
-	bvh->left=_volume_sw_build_bvh(p_elements,split,count);
-	bvh->right=_volume_sw_build_bvh(&p_elements[split],p_size-split,count);
+		int mid;
 
-//	printf("branch at %p - %i: %i\n",bvh,count,bvh->face_index);
-	count++;
-	return bvh;
-}
+		if (best_axis!=-1) {
 
+			real_t bin_scale=_CONCAVE_BVH_BINS/centers.size[best_axis];
+			int i=p_from;
+			int j=p_to-1;
+			while(i<=j) {
 
-void ConcavePolygonShapeSW::_fill_bvh(_VolumeSW_BVH* p_bvh_tree,BVH* p_bvh_array,int& p_idx) {
+				int b=CLAMP(int((elements[i].center[best_axis]-centers.pos[best_axis])*bin_scale),0,_CONCAVE_BVH_BINS-1);
+				if (b<best_split) {
+					i++;
+				} else {
+					SWAP(elements[i],elements[j]);
+					j--;
+				}
+			}
+			mid=i;
+			node.axis=best_axis;
+		} else {
 
-	int idx=p_idx;
+			mid=_split_median(p_from,p_to,centers);
+			node.axis=centers.get_longest_axis_index();
+		}
 
+		if (mid==p_from || mid==p_to) {
+			mid=_split_median(p_from,p_to,centers);
+			node.axis=centers.get_longest_axis_index();
+		}
 
-	p_bvh_array[idx].aabb=p_bvh_tree->aabb;
-	p_bvh_array[idx].face_index=p_bvh_tree->face_index;
-//	printf("%p - %i: %i(%p)  -- %p:%p\n",%p_bvh_array[idx],p_idx,p_bvh_array[i]->face_index,&p_bvh_tree->face_index,p_bvh_tree->left,p_bvh_tree->right);
+		node.count=0;
+		build(p_from,mid,p_depth+1);
+		uint32_t right=build(mid,p_to,p_depth+1);
+		nodes[idx].index=right; // node may not be referenced across the recursion
+		return idx;
+	}
+};
 
+void ConcavePolygonShapeSW::_build_bvh() {
 
-	if (p_bvh_tree->left) {
-		p_bvh_array[idx].left=++p_idx;
-		_fill_bvh(p_bvh_tree->left,p_bvh_array,p_idx);
+	int fc=faces.size();
 
-	} else {
+	Vector<_ConcaveBVHElement> elements;
+	elements.resize(fc);
 
-		p_bvh_array[p_idx].left=-1;
-	}
+	{
+		DVector<Face>::Read fr=faces.read();
+		DVector<Vector3>::Read vr=vertices.read();
 
-	if (p_bvh_tree->right) {
-		p_bvh_array[idx].right=++p_idx;
-		_fill_bvh(p_bvh_tree->right,p_bvh_array,p_idx);
+		for(int i=0;i<fc;i++) {
 
-	} else {
+			const Face &f=fr[i];
+			AABB aabb(vr[f.indices[0]],Vector3());
+			aabb.expand_to(vr[f.indices[1]]);
+			aabb.expand_to(vr[f.indices[2]]);
+			elements[i].aabb=aabb;
+			elements[i].center=aabb.pos+aabb.size*0.5;
+			elements[i].face=i;
+		}
+	}
 
-		p_bvh_array[p_idx].right=-1;
+	// a binary tree with at least one face per leaf
+	bvh.resize(fc*2-1);
+	Vector<AABB> node_aabbs;
+	node_aabbs.resize(fc*2-1);
+
+	_ConcaveBVHBuild build;
+	build.elements=elements.ptr();
+	build.node_aabbs=node_aabbs.ptr();
+	build.node_count=0;
+
+	{
+		DVector<BVH>::Write bw=bvh.write();
+		build.nodes=bw.ptr();
+		build.build(0,fc,0);
+
+		// quantize, rounding outwards
+		for(int i=0;i<build.node_count;i++) {
+
+			const AABB &aabb=node_aabbs[i];
+			Vector3 qmin=(aabb.pos-bvh_aabb.pos)*bvh_inv_scale;
+			Vector3 qmax=(aabb.pos+aabb.size-bvh_aabb.pos)*bvh_inv_scale;
+			for(int j=0;j<3;j++) {
+				bw[i].min[j]=CLAMP(int(Math::floor(qmin[j]))-1,0,BVH_QUANTIZE_MAX);
+				bw[i].max[j]=CLAMP(int(Math::ceil(qmax[j]))+1,0,BVH_QUANTIZE_MAX);
+			}
+		}
 	}
 
-	memdelete(p_bvh_tree);
+	bvh.resize(build.node_count);
+
+	// store faces in leaf order
+	DVector<Face> sorted_faces;
+	DVector<Vector3> sorted_vertices;
+	sorted_faces.resize(fc);
+	sorted_vertices.resize(fc*3);
+	{
+		DVector<Face>::Read fr=faces.read();
+		DVector<Vector3>::Read vr=vertices.read();
+		DVector<Face>::Write fw=sorted_faces.write();
+		DVector<Vector3>::Write vw=sorted_vertices.write();
+
+		for(int i=0;i<fc;i++) {
+
+			const Face &src=fr[elements[i].face];
+			fw[i].normal=src.normal;
+			for(int j=0;j<3;j++) {
+				vw[i*3+j]=vr[src.indices[j]];
+				fw[i].indices[j]=i*3+j;
+			}
+		}
+	}
 
+	faces=sorted_faces;
+	vertices=sorted_vertices;
 }
 
-void ConcavePolygonShapeSW::_setup(DVector<Vector3> p_faces) {
+uint32_t ConcavePolygonShapeSW::_hash_faces() const {
 
-	int src_face_count=p_faces.size();
-	ERR_FAIL_COND(src_face_count%3);
-	src_face_count/=3;
+	DVector<Vector3>::Read vr=vertices.read();
+	return hash_djb2_buffer((const uint8_t*)vr.ptr(),vertices.size()*sizeof(Vector3));
+}
 
-	DVector<Vector3>::Read r = p_faces.read();
-	const Vector3 * facesr= r.ptr();
+/* precomputed BVH, so big meshes load without rebuilding. Only valid for the faces in the order
+   get_faces() returns them, and for the same real_t; anything else is rejected and rebuilt */
 
-#if 0
-	Map<Vector3,int> point_map;
-	List<Face> face_list;
+struct _ConcaveBVHBlobHeader {
 
+	uint32_t magic;
+	uint32_t node_size;
+	uint32_t face_count;
+	uint32_t node_count;
+	uint32_t hash;
+	real_t aabb[6];
+};
 
-	for(int i=0;i<src_face_count;i++) {
+DVector<uint8_t> ConcavePolygonShapeSW::_save_bvh() const {
+
+	DVector<uint8_t> data;
+	if (bvh.size()==0)
+		return data;
+
+	_ConcaveBVHBlobHeader header;
+	header.magic=_CONCAVE_BVH_BLOB_MAGIC;
+	header.node_size=sizeof(BVH);
+	header.face_count=faces.size();
+	header.node_count=bvh.size();
+	header.hash=_hash_faces();
+	for(int i=0;i<3;i++) {
+		header.aabb[i]=bvh_aabb.pos[i];
+		header.aabb[i+3]=bvh_aabb.size[i];
+	}
 
-		Face3 faceaux;
+	data.resize(sizeof(header)+bvh.size()*sizeof(BVH));
+	DVector<uint8_t>::Write w=data.write();
+	DVector<BVH>::Read br=bvh.read();
+	copymem(w.ptr(),&header,sizeof(header));
+	copymem(w.ptr()+sizeof(header),br.ptr(),bvh.size()*sizeof(BVH));
 
-		for(int j=0;j<3;j++) {
+	return data;
+}
 
-			faceaux.vertex[j]=facesr[i*3+j].snapped(_POINT_SNAP);
-			//faceaux.vertex[j]=facesr[i*3+j];//facesr[i*3+j].snapped(_POINT_SNAP);
-		}
+bool ConcavePolygonShapeSW::_load_bvh(const DVector<uint8_t>& p_data) {
 
-		ERR_CONTINUE( faceaux.is_degenerate() );
+	if (p_data.size()<(int)sizeof(_ConcaveBVHBlobHeader))
+		return false;
 
-		Face face;
+	DVector<uint8_t>::Read r=p_data.read();
+	_ConcaveBVHBlobHeader header;
+	copymem(&header,r.ptr(),sizeof(header));
 
-		for(int j=0;j<3;j++) {
+	if (header.magic!=_CONCAVE_BVH_BLOB_MAGIC || header.node_size!=sizeof(BVH))
+		return false;
+	if (header.face_count!=(uint32_t)faces.size() || header.node_count==0 || header.node_count>header.face_count*2)
+		return false;
+	if (p_data.size()!=(int)(sizeof(header)+header.node_count*sizeof(BVH)))
+		return false;
+	if (header.hash!=_hash_faces())
+		return false;
 
+	// every index must point forward and leaves must cover the faces once, so traversal can't misbehave
+	const BVH *nodes=(const BVH*)(r.ptr()+sizeof(header));
+	uint32_t faces_covered=0;
+	for(uint32_t i=0;i<header.node_count;i++) {
 
-			Map<Vector3,int>::Element *E=point_map.find(faceaux.vertex[j]);
-			if (E) {
+		const BVH &n=nodes[i];
+		if (n.count) {
+			if (n.index!=faces_covered || n.count>BVH_MAX_LEAF_FACES)
+				return false;
+			faces_covered+=n.count;
+		} else {
+			if (i+1>=header.node_count || n.index<=i+1 || n.index>=header.node_count || n.axis>2)
+				return false;
+		}
+	}
 
-				face.indices[j]=E->value();
-			} else {
+	if (faces_covered!=header.face_count)
+		return false;
 
-				face.indices[j]=point_map.size();
-				point_map.insert(faceaux.vertex[j],point_map.size());
+	AABB aabb(Vector3(header.aabb[0],header.aabb[1],header.aabb[2]),Vector3(header.aabb[3],header.aabb[4],header.aabb[5]));
+	if (aabb.size.x<=0 || aabb.size.y<=0 || aabb.size.z<=0 || !aabb.encloses(get_aabb()))
+		return false;
 
-			}
-		}
+	bvh.resize(header.node_count);
+	DVector<BVH>::Write bw=bvh.write();
+	copymem(bw.ptr(),nodes,header.node_count*sizeof(BVH));
 
-		face_list.push_back(face);
+	bvh_aabb=aabb;
+	for(int i=0;i<3;i++) {
+		bvh_scale[i]=bvh_aabb.size[i]/BVH_QUANTIZE_MAX;
+		bvh_inv_scale[i]=BVH_QUANTIZE_MAX/bvh_aabb.size[i];
 	}
 
-	vertices.resize( point_map.size() );
+	return true;
+}
 
-	DVector<Vector3>::Write vw = vertices.write();
-	Vector3 *verticesw=vw.ptr();
+void ConcavePolygonShapeSW::_setup(DVector<Vector3> p_faces,const DVector<uint8_t>& p_bvh) {
+
+	int src_face_count=p_faces.size();
+	ERR_FAIL_COND(src_face_count%3);
+	src_face_count/=3;
+
+	faces.resize(src_face_count);
+	vertices.resize(src_face_count*3);
+	bvh.resize(0);
+
+	if (src_face_count==0) {
+		configure(AABB());
+		return;
+	}
 
 	AABB _aabb;
 
-	for( Map<Vector3,int>::Element *E=point_map.front();E;E=E->next()) {
+	{
+		DVector<Vector3>::Read r = p_faces.read();
+		const Vector3 * facesr= r.ptr();
 
-		if (E==point_map.front()) {
-			_aabb.pos=E->key();
-		} else {
+		DVector<Face>::Write w = faces.write();
+		Face *facesw=w.ptr();
+
+		DVector<Vector3>::Write vw = vertices.write();
+		Vector3 *verticesw=vw.ptr();
+
+		for(int i=0;i<src_face_count;i++) {
+
+			Face3 face( facesr[i*3+0], facesr[i*3+1], facesr[i*3+2] );
+
+			facesw[i].indices[0]=i*3+0;
+			facesw[i].indices[1]=i*3+1;
+			facesw[i].indices[2]=i*3+2;
+			facesw[i].normal=face.get_plane().normal;
+			verticesw[i*3+0]=face.vertex[0];
+			verticesw[i*3+1]=face.vertex[1];
+			verticesw[i*3+2]=face.vertex[2];
+			if (i==0)
+				_aabb=face.get_aabb();
+			else
+				_aabb.merge_with(face.get_aabb());
 
-			_aabb.expand_to(E->key());
 		}
-		verticesw[E->value()]=E->key();
 	}
 
-	point_map.clear(); // not needed anymore
+	configure(_aabb); // this type of shape has no margin
 
-	faces.resize(face_list.size());
-	DVector<Face>::Write w = faces.write();
-	Face *facesw=w.ptr();
+	if (p_bvh.size() && _load_bvh(p_bvh))
+		return;
 
-	int fc=0;
+	// quantization space, padded so flat meshes still have some extent on every axis
+	bvh_aabb=_aabb.grow(MAX(_aabb.get_longest_axis_size(),1.0)*0.0001);
+	for(int i=0;i<3;i++) {
+		bvh_scale[i]=bvh_aabb.size[i]/BVH_QUANTIZE_MAX;
+		bvh_inv_scale[i]=BVH_QUANTIZE_MAX/bvh_aabb.size[i];
+	}
 
-	for( List<Face>::Element *E=face_list.front();E;E=E->next()) {
+	_build_bvh();
+}
 
-		facesw[fc++]=E->get();
-	}
 
-	face_list.clear();
+void ConcavePolygonShapeSW::set_data(const Variant& p_data) {
 
+	if (p_data.get_type()==Variant::DICTIONARY) {
 
-	DVector<_VolumeSW_BVH_Element> bvh_array;
-	bvh_array.resize( fc );
+		Dictionary d=p_data;
+		ERR_FAIL_COND(!d.has("faces"));
+		_setup(d["faces"],d.has("bvh")?DVector<uint8_t>(d["bvh"]):DVector<uint8_t>());
+	} else {
 
-	DVector<_VolumeSW_BVH_Element>::Write bvhw = bvh_array.write();
-	_VolumeSW_BVH_Element *bvh_arrayw=bvhw.ptr();
+		_setup(p_data);
+	}
+}
 
+Variant ConcavePolygonShapeSW::get_data() const {
 
-	for(int i=0;i<fc;i++) {
+	Dictionary d;
+	d["faces"]=get_faces();
+	d["bvh"]=_save_bvh();
+	return d;
+}
 
-		AABB face_aabb;
-		face_aabb.pos=verticesw[facesw[i].indices[0]];
-		face_aabb.expand_to( verticesw[facesw[i].indices[1]] );
-		face_aabb.expand_to( verticesw[facesw[i].indices[2]] );
+ConcavePolygonShapeSW::ConcavePolygonShapeSW() {
 
-		bvh_arrayw[i].face_index=i;
-		bvh_arrayw[i].aabb=face_aabb;
-		bvh_arrayw[i].center=face_aabb.pos+face_aabb.size*0.5;
 
-	}
+}
 
-	w=DVector<Face>::Write();
-	vw=DVector<Vector3>::Write();
 
 
-	int count=0;
-	_VolumeSW_BVH *bvh_tree=_volume_sw_build_bvh(bvh_arrayw,fc,count);
+/* HEIGHT MAP SHAPE */
 
-	ERR_FAIL_COND(count==0);
+DVector<float> HeightMapShapeSW::get_heights() const {
 
-	bvhw=DVector<_VolumeSW_BVH_Element>::Write();
+	return heights;
+}
+int HeightMapShapeSW::get_width() const {
 
-	bvh.resize( count+1 );
+	return width;
+}
+int HeightMapShapeSW::get_depth() const {
 
-	DVector<BVH>::Write bvhw2 = bvh.write();
-	BVH*bvh_arrayw2=bvhw2.ptr();
+	return depth;
+}
+float HeightMapShapeSW::get_cell_size() const {
 
-	int idx=0;
-	_fill_bvh(bvh_tree,bvh_arrayw2,idx);
+	return cell_size;
+}
 
-	set_aabb(_aabb);
 
-#else
-	DVector<_VolumeSW_BVH_Element> bvh_array;
-	bvh_array.resize( src_face_count );
+void HeightMapShapeSW::project_range(const Vector3& p_normal, const Transform& p_transform, real_t &r_min, real_t &r_max) const {
 
-	DVector<_VolumeSW_BVH_Element>::Write bvhw = bvh_array.write();
-	_VolumeSW_BVH_Element *bvh_arrayw=bvhw.ptr();
+	//not very useful, but not very used either
+	p_transform.xform(get_aabb()).project_range_in_plane( Plane(p_normal,0),r_min,r_max );
 
-	faces.resize(src_face_count);
-	DVector<Face>::Write w = faces.write();
-	Face *facesw=w.ptr();
+}
 
-	vertices.resize( src_face_count*3 );
+Vector3 HeightMapShapeSW::get_support(const Vector3& p_normal) const {
 
-	DVector<Vector3>::Write vw = vertices.write();
-	Vector3 *verticesw=vw.ptr();
+	if (width==0 || depth==0)
+		return Vector3();
 
-	AABB _aabb;
+	DVector<real_t>::Read r=heights.read();
+	const real_t *h=r.ptr();
 
+	Vector3 support;
+	float support_max;
 
-	for(int i=0;i<src_face_count;i++) {
+	for(int i=0;i<depth;i++) {
 
-		Face3 face( facesr[i*3+0], facesr[i*3+1], facesr[i*3+2] );
+		for(int j=0;j<width;j++) {
 
-		bvh_arrayw[i].aabb=face.get_aabb();
-		bvh_arrayw[i].center = bvh_arrayw[i].aabb.pos + bvh_arrayw[i].aabb.size * 0.5;
-		bvh_arrayw[i].face_index=i;
-		facesw[i].indices[0]=i*3+0;
-		facesw[i].indices[1]=i*3+1;
-		facesw[i].indices[2]=i*3+2;
-		facesw[i].normal=face.get_plane().normal;
-		verticesw[i*3+0]=face.vertex[0];
-		verticesw[i*3+1]=face.vertex[1];
-		verticesw[i*3+2]=face.vertex[2];
-		if (i==0)
-			_aabb=bvh_arrayw[i].aabb;
-		else
-			_aabb.merge_with(bvh_arrayw[i].aabb);
+			Vector3 v( j*cell_size, h[i*width+j], i*cell_size );
+			float d=p_normal.dot(v);
 
+			if ((i==0 && j==0) || d > support_max) {
+				support_max=d;
+				support=v;
+			}
+		}
 	}
 
-	w=DVector<Face>::Write();
-	vw=DVector<Vector3>::Write();
+	return support;
 
-	int count=0;
-	_VolumeSW_BVH *bvh_tree=_volume_sw_build_bvh(bvh_arrayw,src_face_count,count);
-
-	bvh.resize( count+1 );
+}
 
-	DVector<BVH>::Write bvhw2 = bvh.write();
-	BVH*bvh_arrayw2=bvhw2.ptr();
+bool HeightMapShapeSW::_intersect_cell(int p_x,int p_z,const real_t *p_heights,const Vector3& p_begin,const Vector3& p_end,Vector3 &r_point, Vector3 &r_normal) const {
 
-	int idx=0;
-	_fill_bvh(bvh_tree,bvh_arrayw2,idx);
+	Vector3 v00( p_x*cell_size, p_heights[p_z*width+p_x], p_z*cell_size );
+	Vector3 v10( (p_x+1)*cell_size, p_heights[p_z*width+p_x+1], p_z*cell_size );
+	Vector3 v01( p_x*cell_size, p_heights[(p_z+1)*width+p_x], (p_z+1)*cell_size );
+	Vector3 v11( (p_x+1)*cell_size, p_heights[(p_z+1)*width+p_x+1], (p_z+1)*cell_size );
 
-	configure(_aabb); // this type of shape has no margin
+	Vector3 dir=p_end-p_begin;
+	Vector3 res;
+	bool found=false;
+	float min_d=1e20;
 
+	if (Geometry::segment_intersects_triangle(p_begin,p_end,v00,v10,v01,&res)) {
 
-#endif
-}
+		min_d=dir.dot(res-p_begin);
+		r_point=res;
+		r_normal=Plane(v00,v10,v01).normal;
+		found=true;
+	}
 
+	if (Geometry::segment_intersects_triangle(p_begin,p_end,v10,v11,v01,&res)) {
 
-void ConcavePolygonShapeSW::set_data(const Variant& p_data) {
+		float d=dir.dot(res-p_begin);
+		if (d<min_d) {
+			r_point=res;
+			r_normal=Plane(v10,v11,v01).normal;
+			found=true;
+		}
+	}
 
+	if (found && r_normal.dot(dir)>0)
+		r_normal=-r_normal;
 
-	_setup(p_data);
+	return found;
 }
 
-Variant ConcavePolygonShapeSW::get_data() const {
+bool HeightMapShapeSW::intersect_segment(const Vector3& p_begin,const Vector3& p_end,Vector3 &r_point, Vector3 &r_normal) const {
 
-	return get_faces();
-}
+	if (width<2 || depth<2)
+		return false;
 
-ConcavePolygonShapeSW::ConcavePolygonShapeSW() {
+	Vector3 rel=p_end-p_begin;
+	AABB bounds=get_aabb();
 
+	// clip the segment to the bounds first, slab by slab
+	real_t t_from=0;
+	real_t t_to=1;
 
-}
+	for(int i=0;i<3;i++) {
 
+		real_t lo=bounds.pos[i];
+		real_t hi=bounds.pos[i]+bounds.size[i];
 
+		if (rel[i]==0) {
+			if (p_begin[i]<lo || p_begin[i]>hi)
+				return false;
+			continue;
+		}
 
-/* HEIGHT MAP SHAPE */
+		real_t t0=(lo-p_begin[i])/rel[i];
+		real_t t1=(hi-p_begin[i])/rel[i];
+		if (t0>t1)
+			SWAP(t0,t1);
 
-DVector<float> HeightMapShapeSW::get_heights() const {
+		t_from=MAX(t_from,t0);
+		t_to=MIN(t_to,t1);
+		if (t_from>t_to)
+			return false;
+	}
 
-	return heights;
-}
-int HeightMapShapeSW::get_width() const {
+	DVector<real_t>::Read r=heights.read();
+	const real_t *h=r.ptr();
 
-	return width;
-}
-int HeightMapShapeSW::get_depth() const {
+	// walk the cells under the segment in order (2D DDA), so the first hit is the closest
 
-	return depth;
-}
-float HeightMapShapeSW::get_cell_size() const {
+	Vector3 start=p_begin+rel*t_from;
+	int x=CLAMP(int(Math::floor(start.x/cell_size)),0,width-2);
+	int z=CLAMP(int(Math::floor(start.z/cell_size)),0,depth-2);
 
-	return cell_size;
-}
+	int step_x=0;
+	real_t t_max_x=1e20;
+	real_t t_delta_x=1e20;
 
+	if (rel.x>0) {
+		step_x=1;
+		t_max_x=((x+1)*cell_size-p_begin.x)/rel.x;
+		t_delta_x=cell_size/rel.x;
+	} else if (rel.x<0) {
+		step_x=-1;
+		t_max_x=(x*cell_size-p_begin.x)/rel.x;
+		t_delta_x=-cell_size/rel.x;
+	}
 
-void HeightMapShapeSW::project_range(const Vector3& p_normal, const Transform& p_transform, real_t &r_min, real_t &r_max) const {
+	int step_z=0;
+	real_t t_max_z=1e20;
+	real_t t_delta_z=1e20;
+
+	if (rel.z>0) {
+		step_z=1;
+		t_max_z=((z+1)*cell_size-p_begin.z)/rel.z;
+		t_delta_z=cell_size/rel.z;
+	} else if (rel.z<0) {
+		step_z=-1;
+		t_max_z=(z*cell_size-p_begin.z)/rel.z;
+		t_delta_z=-cell_size/rel.z;
+	}
 
-	//not very useful, but not very used either
-	p_transform.xform(get_aabb()).project_range_in_plane( Plane(p_normal,0),r_min,r_max );
+	real_t t=t_from;
 
-}
+	while(true) {
 
-Vector3 HeightMapShapeSW::get_support(const Vector3& p_normal) const {
+		real_t t_exit=MIN(MIN(t_max_x,t_max_z),t_to);
 
+		// skip the cell unless the part of the segment over it spans its heights
+		real_t y_enter=p_begin.y+rel.y*t;
+		real_t y_exit=p_begin.y+rel.y*t_exit;
 
-	//not very useful, but not very used either
-	return get_aabb().get_support(p_normal);
+		const real_t *row=&h[z*width+x];
+		real_t cell_min=MIN(MIN(row[0],row[1]),MIN(row[width],row[width+1]));
+		real_t cell_max=MAX(MAX(row[0],row[1]),MAX(row[width],row[width+1]));
 
-}
+		if (MAX(y_enter,y_exit)>=cell_min && MIN(y_enter,y_exit)<=cell_max) {
 
-bool HeightMapShapeSW::intersect_segment(const Vector3& p_begin,const Vector3& p_end,Vector3 &r_point, Vector3 &r_normal) const {
+			if (_intersect_cell(x,z,h,p_begin,p_end,r_point,r_normal))
+				return true;
+		}
 
+		if (t_exit>=t_to)
+			break;
+
+		if (t_max_x<t_max_z) {
+			x+=step_x;
+			if (x<0 || x>width-2)
+				break;
+			t=t_max_x;
+			t_max_x+=t_delta_x;
+		} else {
+			z+=step_z;
+			if (z<0 || z>depth-2)
+				break;
+			t=t_max_z;
+			t_max_z+=t_delta_z;
+		}
+	}
 
 	return false;
 }
@@ -1595,7 +1906,60 @@ bool HeightMapShapeSW::intersect_segment(const Vector3& p_begin,const Vector3& p
 
 void HeightMapShapeSW::cull(const AABB& p_local_aabb,Callback p_callback,void* p_userdata) const {
 
+	if (width<2 || depth<2)
+		return;
+
+	if (!get_aabb().intersects(p_local_aabb))
+		return;
 
+	// only visit the cells under the aabb, building their triangles as they are sent
+
+	int from_x=CLAMP(int(Math::floor(p_local_aabb.pos.x/cell_size)),0,width-2);
+	int to_x=CLAMP(int(Math::floor((p_local_aabb.pos.x+p_local_aabb.size.x)/cell_size)),0,width-2);
+	int from_z=CLAMP(int(Math::floor(p_local_aabb.pos.z/cell_size)),0,depth-2);
+	int to_z=CLAMP(int(Math::floor((p_local_aabb.pos.z+p_local_aabb.size.z)/cell_size)),0,depth-2);
+
+	real_t min_y=p_local_aabb.pos.y;
+	real_t max_y=p_local_aabb.pos.y+p_local_aabb.size.y;
+
+	DVector<real_t>::Read r=heights.read();
+	const real_t *h=r.ptr();
+
+	FaceShapeSW face; // use this to send in the callback
+
+	for(int i=from_z;i<=to_z;i++) {
+
+		const real_t *row=&h[i*width];
+		const real_t *next_row=&h[(i+1)*width];
+
+		for(int j=from_x;j<=to_x;j++) {
+
+			real_t h00=row[j];
+			real_t h10=row[j+1];
+			real_t h01=next_row[j];
+			real_t h11=next_row[j+1];
+
+			if (MIN(MIN(h00,h10),MIN(h01,h11))>max_y || MAX(MAX(h00,h10),MAX(h01,h11))<min_y)
+				continue;
+
+			Vector3 v00( j*cell_size, h00, i*cell_size );
+			Vector3 v10( (j+1)*cell_size, h10, i*cell_size );
+			Vector3 v01( j*cell_size, h01, (i+1)*cell_size );
+			Vector3 v11( (j+1)*cell_size, h11, (i+1)*cell_size );
+
+			face.vertex[0]=v00;
+			face.vertex[1]=v10;
+			face.vertex[2]=v01;
+			face.normal=Plane(v00,v10,v01).normal;
+			p_callback(p_userdata,&face);
+
+			face.vertex[0]=v10;
+			face.vertex[1]=v11;
+			face.vertex[2]=v01;
+			face.normal=Plane(v10,v11,v01).normal;
+			p_callback(p_userdata,&face);
+		}
+	}
 
 }
 
@@ -1632,7 +1996,7 @@ void HeightMapShapeSW::_setup(DVector<real_t> p_heights,int p_width,int p_depth,
 			float h = r[i*width+j];
 
 			Vector3 pos( j*cell_size, h, i*cell_size );
-			if (i==0 || j==0)
+			if (i==0 && j==0)
 				aabb.pos=pos;
 			else
 				aabb.expand_to(pos);
@@ -1668,7 +2032,12 @@ void HeightMapShapeSW::set_data(const Variant& p_data) {
 
 Variant HeightMapShapeSW::get_data() const {
 
-	ERR_FAIL_V(Variant());
+	Dictionary d;
+	d["width"]=width;
+	d["depth"]=depth;
+	d["cell_size"]=cell_size;
+	d["heights"]=heights;
+	return d;
 
 }
 
@@ -39,7 +39,7 @@ SHAPE_SEGMENT, ///< float:"length"
 SHAPE_CIRCLE, ///< float:"radius"
 SHAPE_RECTANGLE, ///< vec3:"extents"
 SHAPE_CONVEX_POLYGON, ///< array of planes:"planes"
-SHAPE_CONCAVE_POLYGON, ///< Vector3 array:"triangles" , or Dictionary with "indices" (int array) and "triangles" (Vector3 array)
+SHAPE_CONCAVE_POLYGON, ///< Vector3 array:"triangles" , or Dictionary with "faces" (Vector3 array) and optionally "bvh" (raw array returned by shape_get_data)
 SHAPE_CUSTOM, ///< Server-Implementation based custom shape, calling shape_create() with this value will result in an error
 
 */
@@ -267,7 +267,6 @@ public:
 };
 
 
-struct _VolumeSW_BVH;
 struct FaceShapeSW;
 
 struct ConcavePolygonShapeSW : public ConcaveShapeSW {
@@ -279,54 +278,37 @@ struct ConcavePolygonShapeSW : public ConcaveShapeSW {
 		int indices[3];
 	};
 
-	DVector<Face> faces;
+	DVector<Face> faces; // sorted so every BVH leaf holds a contiguous range
 	DVector<Vector3> vertices;
 
-	struct BVH {
-
-		AABB aabb;
-		int left;
-		int right;
-
-		int face_index;
-	};
-
-	DVector<BVH> bvh;
-
-	struct _CullParams {
-
-		AABB aabb;
-		Callback callback;
-		void *userdata;
-		const Face *faces;
-		const Vector3 *vertices;
-		const BVH *bvh;
-		FaceShapeSW *face;
+	enum {
+		BVH_MAX_LEAF_FACES=4,
+		BVH_MAX_DEPTH=64,
+		BVH_QUANTIZE_MAX=65535
 	};
 
-	struct _SegmentCullParams {
-
-		Vector3 from;
-		Vector3 to;
-		const Face *faces;
-		const Vector3 *vertices;
-		const BVH *bvh;
-		Vector3 dir;
-
-		Vector3 result;
-		Vector3 normal;
-		real_t min_d;
-		int collisions;
+	/* nodes are stored depth first, the left child of a branch is the node right after it. Bounds are
+	   quantized to 16 bits inside bvh_aabb, rounded outwards */
+	struct BVH {
 
+		uint16_t min[3];
+		uint16_t max[3];
+		uint32_t index; // first face for leaves, right child for branches
+		uint16_t count; // faces in a leaf, 0 for branches
+		uint16_t axis; // split axis of a branch, to visit the nearest child first
 	};
 
-	void _cull_segment(int p_idx,_SegmentCullParams *p_params) const;
-	void _cull(int p_idx,_CullParams *p_params) const;
-
-	void _fill_bvh(_VolumeSW_BVH* p_bvh_tree,BVH* p_bvh_array,int& p_idx);
+	DVector<BVH> bvh;
+	AABB bvh_aabb; // quantization space
+	Vector3 bvh_scale; // quantized units to local
+	Vector3 bvh_inv_scale;
 
+	void _build_bvh();
+	bool _load_bvh(const DVector<uint8_t>& p_data);
+	DVector<uint8_t> _save_bvh() const;
+	uint32_t _hash_faces() const;
 
-	void _setup(DVector<Vector3> p_faces);
+	void _setup(DVector<Vector3> p_faces,const DVector<uint8_t>& p_bvh=DVector<uint8_t>());
 public:
 
 	DVector<Vector3> get_faces() const;
@@ -357,8 +339,7 @@ struct HeightMapShapeSW : public ConcaveShapeSW {
 	int depth;
 	float cell_size;
 
-//	void _cull_segment(int p_idx,_SegmentCullParams *p_params) const;
-//	void _cull(int p_idx,_CullParams *p_params) const;
+	bool _intersect_cell(int p_x,int p_z,const real_t *p_heights,const Vector3& p_begin,const Vector3& p_end,Vector3 &r_point, Vector3 &r_normal) const;
 
 	void _setup(DVector<float> p_heights,int p_width,int p_depth,float p_cell_size);
 public:
@@ -47,20 +47,12 @@ _FORCE_INLINE_ static bool _match_object_type_query(CollisionObjectSW *p_object,
 }
 
 
-bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3& p_from, const Vector3& p_to,RayResult &r_result,const Set<RID>& p_exclude,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
-
-
-	ERR_FAIL_COND_V(space->locked,false);
+/* narrow phase over culled candidates, shared by the single and batched queries. p_check_aabb is set when
+   the candidates were culled for more than this query */
 
-	Vector3 begin,end;
-	Vector3 normal;
-	begin=p_from;
-	end=p_to;
-	normal=(end-begin).normalized();
-
-
-	int amount = space->broadphase->cull_segment(begin,end,space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
+static bool _intersect_ray_candidates(const Vector3& p_from, const Vector3& p_to,CollisionObjectSW **p_objects,const int *p_shapes,int p_amount,bool p_check_aabb,PhysicsDirectSpaceState::RayResult &r_result) {
 
+	Vector3 normal=(p_to-p_from).normalized();
 
 	//todo, create another array tha references results, compute AABBs and check closest point to ray origin, sort, and stop evaluating results when beyond first collision
 
@@ -70,26 +62,18 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3& p_from, const Vecto
 	const CollisionObjectSW *res_obj;
 	real_t min_d=1e10;
 
+	for(int i=0;i<p_amount;i++) {
 
+		const CollisionObjectSW *col_obj=p_objects[i];
+		int shape_idx=p_shapes[i];
 
-	for(int i=0;i<amount;i++) {
-
-		if (!_match_object_type_query(space->intersection_query_results[i],p_layer_mask,p_object_type_mask))
-			continue;
-
-		if (!(static_cast<CollisionObjectSW*>(space->intersection_query_results[i])->is_ray_pickable()))
-			continue;
-
-		if (p_exclude.has( space->intersection_query_results[i]->get_self()))
+		if (p_check_aabb && !col_obj->get_shape_aabb(shape_idx).intersects_segment(p_from,p_to))
 			continue;
 
-		const CollisionObjectSW *col_obj=space->intersection_query_results[i];
-
-		int shape_idx=space->intersection_query_subindex_results[i];
 		Transform inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
 
-		Vector3 local_from = inv_xform.xform(begin);
-		Vector3 local_to = inv_xform.xform(end);
+		Vector3 local_from = inv_xform.xform(p_from);
+		Vector3 local_to = inv_xform.xform(p_to);
 
 		const ShapeSW *shape = col_obj->get_shape(shape_idx);
 
@@ -122,18 +106,78 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3& p_from, const Vecto
 	if (!collided)
 		return false;
 
-
 	r_result.collider_id=res_obj->get_instance_id();
-	if (r_result.collider_id!=0)
-		r_result.collider=ObjectDB::get_instance(r_result.collider_id);
-	else
-		r_result.collider=NULL;
+	r_result.collider=NULL; // looked up by the caller, ObjectDB locks
 	r_result.normal=res_normal;
 	r_result.position=res_point;
 	r_result.rid=res_obj->get_self();
 	r_result.shape=res_shape;
 
 	return true;
+}
+
+static int _intersect_shape_candidates(const ShapeSW *p_shape, const Transform& p_xform,float p_margin,const AABB *p_check_aabb,CollisionObjectSW **p_objects,const int *p_shapes,int p_amount,PhysicsDirectSpaceState::ShapeResult *r_results,int p_result_max) {
+
+	int cc=0;
+
+	for(int i=0;i<p_amount;i++) {
+
+		if (cc>=p_result_max)
+			break;
+
+		const CollisionObjectSW *col_obj=p_objects[i];
+		int shape_idx=p_shapes[i];
+
+		if (p_check_aabb && !col_obj->get_shape_aabb(shape_idx).intersects(*p_check_aabb))
+			continue;
+
+		if (!CollisionSolverSW::solve_static(p_shape,p_xform,col_obj->get_shape(shape_idx),col_obj->get_transform() * col_obj->get_shape_transform(shape_idx), NULL,NULL,NULL,p_margin,0))
+			continue;
+
+		r_results[cc].collider_id=col_obj->get_instance_id();
+		r_results[cc].collider=NULL; // looked up by the caller
+		r_results[cc].rid=col_obj->get_self();
+		r_results[cc].shape=shape_idx;
+
+		cc++;
+
+	}
+
+	return cc;
+}
+
+bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3& p_from, const Vector3& p_to,RayResult &r_result,const Set<RID>& p_exclude,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
+
+
+	ERR_FAIL_COND_V(space->locked,false);
+
+	int amount = space->broadphase->cull_segment(p_from,p_to,space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
+
+	int count=0;
+
+	for(int i=0;i<amount;i++) {
+
+		if (!_match_object_type_query(space->intersection_query_results[i],p_layer_mask,p_object_type_mask))
+			continue;
+
+		if (!(static_cast<CollisionObjectSW*>(space->intersection_query_results[i])->is_ray_pickable()))
+			continue;
+
+		if (p_exclude.has( space->intersection_query_results[i]->get_self()))
+			continue;
+
+		space->intersection_query_results[count]=space->intersection_query_results[i];
+		space->intersection_query_subindex_results[count]=space->intersection_query_subindex_results[i];
+		count++;
+	}
+
+	if (!_intersect_ray_candidates(p_from,p_to,space->intersection_query_results,space->intersection_query_subindex_results,count,false,r_result))
+		return false;
+
+	if (r_result.collider_id!=0)
+		r_result.collider=ObjectDB::get_instance(r_result.collider_id);
+
+	return true;
 
 }
 
@@ -143,23 +187,17 @@ int PhysicsDirectSpaceStateSW::intersect_shape(const RID& p_shape, const Transfo
 	if (p_result_max<=0)
 		return 0;
 
-	ShapeSW *shape = static_cast<PhysicsServerSW*>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape,0);
 
 	AABB aabb = p_xform.xform(shape->get_aabb());
 
 	int amount = space->broadphase->cull_aabb(aabb,space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
 
-	bool collided=false;
-	int cc=0;
-
-	//Transform ai = p_xform.affine_inverse();
+	int count=0;
 
 	for(int i=0;i<amount;i++) {
 
-		if (cc>=p_result_max)
-			break;
-
 		if (!_match_object_type_query(space->intersection_query_results[i],p_layer_mask,p_object_type_mask))
 			continue;
 
@@ -168,27 +206,302 @@ int PhysicsDirectSpaceStateSW::intersect_shape(const RID& p_shape, const Transfo
 		if (p_exclude.has( space->intersection_query_results[i]->get_self()))
 			continue;
 
+		space->intersection_query_results[count]=space->intersection_query_results[i];
+		space->intersection_query_subindex_results[count]=space->intersection_query_subindex_results[i];
+		count++;
+	}
 
-		const CollisionObjectSW *col_obj=space->intersection_query_results[i];
-		int shape_idx=space->intersection_query_subindex_results[i];
+	int cc=_intersect_shape_candidates(shape,p_xform,p_margin,NULL,space->intersection_query_results,space->intersection_query_subindex_results,count,r_results,p_result_max);
 
-		if (!CollisionSolverSW::solve_static(shape,p_xform,col_obj->get_shape(shape_idx),col_obj->get_transform() * col_obj->get_shape_transform(shape_idx), NULL,NULL,NULL,p_margin,0))
-			continue;
+	for(int i=0;i<cc;i++) {
 
-		r_results[cc].collider_id=col_obj->get_instance_id();
-		if (r_results[cc].collider_id!=0)
-			r_results[cc].collider=ObjectDB::get_instance(r_results[cc].collider_id);
+		if (r_results[i].collider_id!=0)
+			r_results[i].collider=ObjectDB::get_instance(r_results[i].collider_id);
+	}
+
+	return cc;
+
+}
+
+/* batched queries: culls run serially (broadphases are not safe to query from several threads), the
+   narrow phase of each group of queries runs on the worker threads */
+
+void PhysicsDirectSpaceStateSW::_batch_begin(const RID *p_exclude,int p_exclude_count) {
+
+	batch_exclude.resize(p_exclude_count);
+	for(int i=0;i<p_exclude_count;i++)
+		batch_exclude[i]=p_exclude[i];
+	batch_exclude.sort();
+
+	batch_candidate_count=0;
+	batch_group_count=0;
+}
+
+bool PhysicsDirectSpaceStateSW::_batch_is_excluded(const RID& p_rid) const {
+
+	int lo=0;
+	int hi=batch_exclude.size();
+	const RID *e=batch_exclude.ptr();
+
+	while(lo<hi) {
+
+		int mid=(lo+hi)>>1;
+		if (e[mid]<p_rid)
+			lo=mid+1;
 		else
-			r_results[cc].collider=NULL;
-		r_results[cc].rid=col_obj->get_self();
-		r_results[cc].shape=shape_idx;
+			hi=mid;
+	}
 
-		cc++;
+	return lo<batch_exclude.size() && e[lo]==p_rid;
+}
+
+void PhysicsDirectSpaceStateSW::_batch_add_candidates(int p_amount,bool p_rays,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
 
+	if (batch_candidate_count+p_amount>batch_candidates.size()) {
+		int size=MAX(batch_candidates.size()*2,batch_candidate_count+p_amount);
+		batch_candidates.resize(size);
+		batch_candidate_shapes.resize(size);
 	}
 
-	return cc;
+	CollisionObjectSW **c=batch_candidates.ptr();
+	int *cs=batch_candidate_shapes.ptr();
+
+	for(int i=0;i<p_amount;i++) {
+
+		CollisionObjectSW *col_obj=space->intersection_query_results[i];
+
+		if (!_match_object_type_query(col_obj,p_layer_mask,p_object_type_mask))
+			continue;
+
+		if (p_rays && !col_obj->is_ray_pickable())
+			continue;
+
+		if (batch_exclude.size() && _batch_is_excluded(col_obj->get_self()))
+			continue;
+
+		c[batch_candidate_count]=col_obj;
+		cs[batch_candidate_count]=space->intersection_query_subindex_results[i];
+		batch_candidate_count++;
+	}
+}
+
+void PhysicsDirectSpaceStateSW::_batch_add_group(int p_from,int p_to,int p_candidates_from,bool p_shared) {
+
+	if (batch_group_count==batch_groups.size())
+		batch_groups.resize(MAX(batch_group_count*2,16));
+
+	BatchGroup &g=batch_groups[batch_group_count++];
+	g.from=p_from;
+	g.to=p_to;
+	g.candidates_from=p_candidates_from;
+	g.candidates_to=batch_candidate_count;
+	g.shared=p_shared;
+}
+
+void PhysicsDirectSpaceStateSW::_batch_run(WorkerThreadPool::TaskFunc p_func) {
+
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	if (pool && batch_group_count>BATCH_GRANULARITY)
+		pool->parallel_for(0,batch_group_count,p_func,this,BATCH_GRANULARITY);
+	else
+		p_func(this,0,batch_group_count);
+}
+
+void PhysicsDirectSpaceStateSW::_intersect_rays_task(void *p_self,int p_from,int p_to) {
+
+	PhysicsDirectSpaceStateSW *self=(PhysicsDirectSpaceStateSW*)p_self;
+	const BatchGroup *groups=self->batch_groups.ptr();
+	CollisionObjectSW **candidates=self->batch_candidates.ptr();
+	const int *candidate_shapes=self->batch_candidate_shapes.ptr();
+
+	for(int i=p_from;i<p_to;i++) {
+
+		const BatchGroup &g=groups[i];
+		int amount=g.candidates_to-g.candidates_from;
+
+		for(int j=g.from;j<g.to;j++) {
+
+			const RayQuery &ray=self->batch_rays[j];
+			self->batch_hits[j]=_intersect_ray_candidates(ray.from,ray.to,&candidates[g.candidates_from],&candidate_shapes[g.candidates_from],amount,g.shared,self->batch_ray_results[j]);
+		}
+	}
+}
+
+int PhysicsDirectSpaceStateSW::intersect_rays(const RayQuery *p_rays,int p_ray_count,RayResult *r_results,bool *r_hits,const RID *p_exclude,int p_exclude_count,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
+
+	ERR_FAIL_COND_V(space->locked,0);
+
+	_batch_begin(p_exclude,p_exclude_count);
+
+	for(int i=0;i<p_ray_count;i+=BATCH_GROUP_SIZE) {
+
+		int to=MIN(i+BATCH_GROUP_SIZE,p_ray_count);
+
+		// rays going roughly the same place (from one origin, or parallel and close) are culled once
+		AABB group_aabb(p_rays[i].from,Vector3());
+		real_t largest=0;
+		for(int j=i;j<to;j++) {
+
+			AABB ray_aabb(p_rays[j].from,Vector3());
+			ray_aabb.expand_to(p_rays[j].to);
+			largest=MAX(largest,ray_aabb.get_longest_axis_size());
+			group_aabb.merge_with(ray_aabb);
+		}
+
+		if (to-i>1 && group_aabb.get_longest_axis_size()<=largest*BATCH_COHERENCE) {
+
+			int amount = space->broadphase->cull_aabb(group_aabb,space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
+			if (amount<SpaceSW::INTERSECTION_QUERY_MAX && amount<=(to-i)*BATCH_GROUP_CANDIDATES) {
+
+				int candidates_from=batch_candidate_count;
+				_batch_add_candidates(amount,true,p_layer_mask,p_object_type_mask);
+				_batch_add_group(i,to,candidates_from,true);
+				continue;
+			}
+		}
+
+		for(int j=i;j<to;j++) {
+
+			int amount = space->broadphase->cull_segment(p_rays[j].from,p_rays[j].to,space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
+			int candidates_from=batch_candidate_count;
+			_batch_add_candidates(amount,true,p_layer_mask,p_object_type_mask);
+			_batch_add_group(j,j+1,candidates_from,false);
+		}
+	}
+
+	batch_rays=p_rays;
+	batch_ray_results=r_results;
+	batch_hits=r_hits;
+
+	_batch_run(_intersect_rays_task);
+
+	int hits=0;
+	for(int i=0;i<p_ray_count;i++) {
+
+		if (!r_hits[i])
+			continue;
+
+		if (r_results[i].collider_id!=0)
+			r_results[i].collider=ObjectDB::get_instance(r_results[i].collider_id);
+		hits++;
+	}
+
+	return hits;
+}
+
+void PhysicsDirectSpaceStateSW::_intersect_shapes_task(void *p_self,int p_from,int p_to) {
+
+	PhysicsDirectSpaceStateSW *self=(PhysicsDirectSpaceStateSW*)p_self;
+	const BatchGroup *groups=self->batch_groups.ptr();
+	CollisionObjectSW **candidates=self->batch_candidates.ptr();
+	const int *candidate_shapes=self->batch_candidate_shapes.ptr();
+	const AABB *aabbs=self->batch_aabbs.ptr();
+	ShapeSW **shapes=self->batch_shapes.ptr();
+
+	for(int i=p_from;i<p_to;i++) {
+
+		const BatchGroup &g=groups[i];
+		int amount=g.candidates_to-g.candidates_from;
+
+		for(int j=g.from;j<g.to;j++) {
+
+			const ShapeQuery &query=self->batch_shape_queries[j];
+			self->batch_result_counts[j]=0;
+			if (!shapes[j])
+				continue;
+
+			self->batch_result_counts[j]=_intersect_shape_candidates(shapes[j],query.transform,query.margin,g.shared?&aabbs[j]:NULL,&candidates[g.candidates_from],&candidate_shapes[g.candidates_from],amount,&self->batch_shape_results[j*self->batch_result_max],self->batch_result_max);
+		}
+	}
+}
+
+int PhysicsDirectSpaceStateSW::intersect_shapes(const ShapeQuery *p_queries,int p_query_count,ShapeResult *r_results,int p_result_max,int *r_result_counts,const RID *p_exclude,int p_exclude_count,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
+
+	ERR_FAIL_COND_V(space->locked,0);
+
+	if (p_result_max<=0)
+		return 0;
+
+	_batch_begin(p_exclude,p_exclude_count);
+
+	if (batch_shapes.size()<p_query_count) {
+		batch_shapes.resize(p_query_count);
+		batch_aabbs.resize(p_query_count);
+	}
+
+	ShapeSW **shapes=batch_shapes.ptr();
+	AABB *aabbs=batch_aabbs.ptr();
+	PhysicsServerSW *ps=PhysicsServerSW::singleton;
+
+	for(int i=0;i<p_query_count;i++) {
+
+		shapes[i]=ps->shape_owner.get(p_queries[i].shape);
+		ERR_CONTINUE(!shapes[i]);
+		aabbs[i]=p_queries[i].transform.xform(shapes[i]->get_aabb());
+	}
+
+	for(int i=0;i<p_query_count;i+=BATCH_GROUP_SIZE) {
+
+		int to=MIN(i+BATCH_GROUP_SIZE,p_query_count);
+
+		AABB group_aabb;
+		real_t largest=0;
+		bool first=true;
+		for(int j=i;j<to;j++) {
+
+			if (!shapes[j])
+				continue;
+			largest=MAX(largest,aabbs[j].get_longest_axis_size());
+			if (first)
+				group_aabb=aabbs[j];
+			else
+				group_aabb.merge_with(aabbs[j]);
+			first=false;
+		}
+
+		if (to-i>1 && !first && group_aabb.get_longest_axis_size()<=largest*BATCH_COHERENCE) {
+
+			int amount = space->broadphase->cull_aabb(group_aabb,space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
+			if (amount<SpaceSW::INTERSECTION_QUERY_MAX && amount<=(to-i)*BATCH_GROUP_CANDIDATES) {
+
+				int candidates_from=batch_candidate_count;
+				_batch_add_candidates(amount,false,p_layer_mask,p_object_type_mask);
+				_batch_add_group(i,to,candidates_from,true);
+				continue;
+			}
+		}
+
+		for(int j=i;j<to;j++) {
+
+			int candidates_from=batch_candidate_count;
+			if (shapes[j]) {
+				int amount = space->broadphase->cull_aabb(aabbs[j],space->intersection_query_results,SpaceSW::INTERSECTION_QUERY_MAX,space->intersection_query_subindex_results);
+				_batch_add_candidates(amount,false,p_layer_mask,p_object_type_mask);
+			}
+			_batch_add_group(j,j+1,candidates_from,false);
+		}
+	}
+
+	batch_shape_queries=p_queries;
+	batch_shape_results=r_results;
+	batch_result_max=p_result_max;
+	batch_result_counts=r_result_counts;
+
+	_batch_run(_intersect_shapes_task);
+
+	int total=0;
+	for(int i=0;i<p_query_count;i++) {
+
+		ShapeResult *r=&r_results[i*p_result_max];
+		for(int j=0;j<r_result_counts[i];j++) {
+
+			if (r[j].collider_id!=0)
+				r[j].collider=ObjectDB::get_instance(r[j].collider_id);
+		}
+		total+=r_result_counts[i];
+	}
 
+	return total;
 }
 
 
@@ -196,7 +509,7 @@ bool PhysicsDirectSpaceStateSW::cast_motion(const RID& p_shape, const Transform&
 
 
 
-	ShapeSW *shape = static_cast<PhysicsServerSW*>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape,false);
 
 	AABB aabb = p_xform.xform(shape->get_aabb());
@@ -326,7 +639,7 @@ bool PhysicsDirectSpaceStateSW::collide_shape(RID p_shape, const Transform& p_sh
 	if (p_result_max<=0)
 		return 0;
 
-	ShapeSW *shape = static_cast<PhysicsServerSW*>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape,0);
 
 	AABB aabb = p_shape_xform.xform(shape->get_aabb());
@@ -410,7 +723,7 @@ static void _rest_cbk_result(const Vector3& p_point_A,const Vector3& p_point_B,v
 bool PhysicsDirectSpaceStateSW::rest_info(RID p_shape, const Transform& p_shape_xform,float p_margin,ShapeRestInfo *r_info, const Set<RID>& p_exclude,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
 
 
-	ShapeSW *shape = static_cast<PhysicsServerSW*>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape,0);
 
 	AABB aabb = p_shape_xform.xform(shape->get_aabb());
@@ -472,6 +785,15 @@ PhysicsDirectSpaceStateSW::PhysicsDirectSpaceStateSW() {
 
 
 	space=NULL;
+	batch_candidate_count=0;
+	batch_group_count=0;
+	batch_rays=NULL;
+	batch_ray_results=NULL;
+	batch_hits=NULL;
+	batch_shape_queries=NULL;
+	batch_shape_results=NULL;
+	batch_result_max=0;
+	batch_result_counts=NULL;
 }
 
 
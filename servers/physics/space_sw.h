@@ -37,11 +37,53 @@
 #include "area_pair_sw.h"
 #include "broad_phase_sw.h"
 #include "collision_object_sw.h"
+#include "os/worker_thread_pool.h"
 
 
 class PhysicsDirectSpaceStateSW : public PhysicsDirectSpaceState {
 
 	OBJ_TYPE( PhysicsDirectSpaceStateSW, PhysicsDirectSpaceState );
+
+	enum {
+		BATCH_GROUP_SIZE=16, // consecutive queries that may share a broadphase cull
+		BATCH_GROUP_CANDIDATES=16, // per query, a shared cull returning more than this is redone per query
+		BATCH_COHERENCE=2, // a group is coherent if its AABB is at most this times the largest query
+		BATCH_GRANULARITY=4 // groups per worker task
+	};
+
+	struct BatchGroup {
+
+		int from,to;
+		int candidates_from,candidates_to;
+		bool shared; // candidates come from a cull of the whole group
+	};
+
+	Vector<RID> batch_exclude; // sorted
+	Vector<CollisionObjectSW*> batch_candidates;
+	Vector<int> batch_candidate_shapes;
+	int batch_candidate_count;
+	Vector<BatchGroup> batch_groups;
+	int batch_group_count;
+	Vector<AABB> batch_aabbs;
+	Vector<ShapeSW*> batch_shapes;
+
+	const RayQuery *batch_rays;
+	RayResult *batch_ray_results;
+	bool *batch_hits;
+	const ShapeQuery *batch_shape_queries;
+	ShapeResult *batch_shape_results;
+	int batch_result_max;
+	int *batch_result_counts;
+
+	void _batch_begin(const RID *p_exclude,int p_exclude_count);
+	bool _batch_is_excluded(const RID& p_rid) const;
+	void _batch_add_candidates(int p_amount,bool p_rays,uint32_t p_layer_mask,uint32_t p_object_type_mask);
+	void _batch_add_group(int p_from,int p_to,int p_candidates_from,bool p_shared);
+	void _batch_run(WorkerThreadPool::TaskFunc p_func);
+
+	static void _intersect_rays_task(void *p_self,int p_from,int p_to);
+	static void _intersect_shapes_task(void *p_self,int p_from,int p_to);
+
 public:
 
 	SpaceSW *space;
@@ -52,6 +94,9 @@ public:
 	virtual bool collide_shape(RID p_shape, const Transform& p_shape_xform,float p_margin,Vector3 *r_results,int p_result_max,int &r_result_count, const Set<RID>& p_exclude=Set<RID>(),uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION);
 	virtual bool rest_info(RID p_shape, const Transform& p_shape_xform,float p_margin,ShapeRestInfo *r_info, const Set<RID>& p_exclude=Set<RID>(),uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION);
 
+	virtual int intersect_rays(const RayQuery *p_rays,int p_ray_count,RayResult *r_results,bool *r_hits,const RID *p_exclude=NULL,int p_exclude_count=0,uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION);
+	virtual int intersect_shapes(const ShapeQuery *p_queries,int p_query_count,ShapeResult *r_results,int p_result_max,int *r_result_counts,const RID *p_exclude=NULL,int p_exclude_count=0,uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION);
+
 	PhysicsDirectSpaceStateSW();
 };
 
@@ -45,6 +45,8 @@ public:
 	bool setup(float p_step);
 	void solve(float p_step);
 
+	virtual bool is_setup_shared() const { return true; }
+
 	AreaPair2DSW(Body2DSW *p_body,int p_body_shape, Area2DSW *p_area,int p_area_shape);
 	~AreaPair2DSW();
 };
@@ -62,6 +64,8 @@ public:
 	bool setup(float p_step);
 	void solve(float p_step);
 
+	virtual bool is_setup_shared() const { return true; }
+
 	Area2Pair2DSW(Area2DSW *p_area_a,int p_shape_a, Area2DSW *p_area_b,int p_shape_b);
 	~Area2Pair2DSW();
 };
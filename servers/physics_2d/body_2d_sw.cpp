@@ -395,7 +395,7 @@ void Body2DSW::_compute_area_gravity(const Area2DSW *p_area) {
 
 }
 
-void Body2DSW::integrate_forces(real_t p_step) {
+void Body2DSW::integrate_forces(real_t p_step,bool p_defer) {
 
 	if (mode==Physics2DServer::BODY_MODE_STATIC)
 		return;
@@ -493,29 +493,36 @@ void Body2DSW::integrate_forces(real_t p_step) {
 	biased_linear_velocity=Vector2();
 
 	if (do_motion) {//shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
+		deferred_updates|=DEFERRED_SHAPES_WITH_MOTION;
+		deferred_motion=motion;
 	}
 
 	damp_area=NULL; // clear the area, so it is set in the next frame
 	def_area=NULL; // clear the area, so it is set in the next frame
 	contact_count=0;	
 
+	if (!p_defer)
+		apply_deferred_updates();
+
 }
 
-void Body2DSW::integrate_velocities(real_t p_step) {
+void Body2DSW::integrate_velocities(real_t p_step,bool p_defer) {
 
 	if (mode==Physics2DServer::BODY_MODE_STATIC)
 		return;
 
 	if (fi_callback)
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+		deferred_updates|=DEFERRED_STATE_QUERY;
 
 	if (mode==Physics2DServer::BODY_MODE_KINEMATIC) {
 
 		_set_transform(new_transform,false);
 		_set_inv_transform(new_transform.affine_inverse());
 		if (contacts.size()==0 && linear_velocity==Vector2() && angular_velocity==0)
-			set_active(false); //stopped moving, deactivate
+			deferred_updates|=DEFERRED_DEACTIVATE; //stopped moving, deactivate
+
+		if (!p_defer)
+			apply_deferred_updates();
 		return;
 	}
 
@@ -525,13 +532,38 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	real_t angle = get_transform().get_rotation() - total_angular_velocity * p_step;
 	Vector2 pos = get_transform().get_origin() + total_linear_velocity * p_step;
 
-	_set_transform(Matrix32(angle,pos),continuous_cd_mode==Physics2DServer::CCD_MODE_DISABLED);
+	_set_transform(Matrix32(angle,pos),false);
 	_set_inv_transform(get_transform().inverse());
 
 	if (continuous_cd_mode!=Physics2DServer::CCD_MODE_DISABLED)
 		new_transform=get_transform();
+	else
+		deferred_updates|=DEFERRED_SHAPES;
 
 	//_update_inertia_tensor();
+
+	if (!p_defer)
+		apply_deferred_updates();
+}
+
+void Body2DSW::apply_deferred_updates() {
+
+	if (!deferred_updates)
+		return;
+
+	if (deferred_updates&DEFERRED_STATE_QUERY)
+		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+
+	if (deferred_updates&DEFERRED_SHAPES_WITH_MOTION)
+		_update_shapes_with_motion(deferred_motion);
+
+	if (deferred_updates&DEFERRED_SHAPES)
+		_update_shapes();
+
+	if (deferred_updates&DEFERRED_DEACTIVATE)
+		set_active(false);
+
+	deferred_updates=0;
 }
 
 
@@ -654,6 +686,7 @@ Body2DSW::Body2DSW() : CollisionObject2DSW(TYPE_BODY), active_list(this), inerti
 	island_step=0;
 	island_next=NULL;
 	island_list_next=NULL;
+	deferred_updates=0;
 	_set_static(false);
 	first_time_kinematic=false;
 	linear_damp=-1;
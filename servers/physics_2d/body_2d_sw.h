@@ -132,6 +132,16 @@ class Body2DSW : public CollisionObject2DSW {
 	Body2DSW *island_next;
 	Body2DSW *island_list_next;
 
+	enum {
+		DEFERRED_SHAPES=1,
+		DEFERRED_SHAPES_WITH_MOTION=2,
+		DEFERRED_STATE_QUERY=4,
+		DEFERRED_DEACTIVATE=8
+	};
+
+	int deferred_updates; // space changes left by integration, applied by apply_deferred_updates()
+	Vector2 deferred_motion;
+
 	_FORCE_INLINE_ void _compute_area_gravity(const Area2DSW *p_area);
 
 friend class Physics2DDirectBodyStateSW; // i give up, too many functions to expose
@@ -189,12 +199,18 @@ public:
 
 	_FORCE_INLINE_ void apply_impulse(const Vector2& p_pos, const Vector2& p_j) {
 
+		if (mode<=Physics2DServer::BODY_MODE_KINEMATIC)
+			return; //no effect, and static bodies are shared by islands solved in parallel
+
 		linear_velocity += p_j * _inv_mass;
 		angular_velocity += _inv_inertia * p_pos.cross(p_j);
 	}
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector2& p_pos, const Vector2& p_j) {
 
+		if (mode<=Physics2DServer::BODY_MODE_KINEMATIC)
+			return; //no effect, and static bodies are shared by islands solved in parallel
+
 		biased_linear_velocity += p_j * _inv_mass;
 		biased_angular_velocity += _inv_inertia * p_pos.cross(p_j);
 	}
@@ -254,8 +270,11 @@ public:
 	_FORCE_INLINE_ real_t get_angular_damp() const { return angular_damp; }
 
 
-	void integrate_forces(real_t p_step);
-	void integrate_velocities(real_t p_step);
+	/* with p_defer, the broadphase and space lists are not touched, so bodies can be integrated
+	   from several threads; apply_deferred_updates() must then be called from the stepping thread */
+	void integrate_forces(real_t p_step,bool p_defer=false);
+	void integrate_velocities(real_t p_step,bool p_defer=false);
+	void apply_deferred_updates();
 
 	_FORCE_INLINE_ Vector2 get_motion() const {
 
@@ -522,6 +522,17 @@ void BodyPair2DSW::solve(float p_step) {
 }
 
 
+bool BodyPair2DSW::is_setup_shared() const {
+
+	//contacts are reported to the static or kinematic body, which other islands may touch too
+	if (A->get_mode()<=Physics2DServer::BODY_MODE_KINEMATIC && A->can_report_contacts())
+		return true;
+	if (B->get_mode()<=Physics2DServer::BODY_MODE_KINEMATIC && B->can_report_contacts())
+		return true;
+
+	return false;
+}
+
 BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A,Body2DSW *p_B, int p_shape_B) : Constraint2DSW(_arr,2) {
 
 	A=p_A;
@@ -90,6 +90,8 @@ public:
 	bool setup(float p_step);
 	void solve(float p_step);
 
+	virtual bool is_setup_shared() const;
+
 	BodyPair2DSW(Body2DSW *p_A, int p_shape_A,Body2DSW *p_B, int p_shape_B);
 	~BodyPair2DSW();
 
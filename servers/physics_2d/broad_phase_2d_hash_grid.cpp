@@ -29,45 +29,80 @@
 #include "broad_phase_2d_hash_grid.h"
 #include "globals.h"
 
-void BroadPhase2DHashGrid::_pair_attempt(Element *p_elem, Element* p_with) {
+BroadPhase2DHashGrid::PairData *BroadPhase2DHashGrid::_pair_attempt(Element *p_elem, Element* p_with) {
 
-	Map<Element*,PairData*>::Element *E=p_elem->paired.find(p_with);
+	ERR_FAIL_COND_V(p_elem->_static && p_with->_static,NULL);
 
-	ERR_FAIL_COND(p_elem->_static && p_with->_static);
+	PairKey pk(p_elem->self,p_with->self);
+	PairData **pdp=pair_map.getptr(pk);
 
-	if (!E) {
+	if (pdp) {
+		(*pdp)->rc++;
+		return *pdp;
+	}
 
-		PairData *pd = memnew( PairData );
-		p_elem->paired[p_with]=pd;
-		p_with->paired[p_elem]=pd;
+	PairData *pd;
+	if (free_pairs) {
+		pd=free_pairs;
+		free_pairs=pd->next_free;
 	} else {
-		E->get()->rc++;
+		pd=memnew( PairData );
 	}
 
+	pd->a=p_elem;
+	pd->b=p_with;
+	pd->a_index=p_elem->paired.count;
+	pd->b_index=p_with->paired.count;
+	pd->colliding=false;
+	pd->large_ref=false;
+	pd->rc=1;
+	pd->ud=NULL;
+	p_elem->paired.push_back(pd);
+	p_with->paired.push_back(pd);
+	pair_map.set(pk,pd);
+	return pd;
 }
 
 void BroadPhase2DHashGrid::_unpair_attempt(Element *p_elem, Element* p_with) {
 
-	Map<Element*,PairData*>::Element *E=p_elem->paired.find(p_with);
+	PairKey pk(p_elem->self,p_with->self);
+	PairData **pdp=pair_map.getptr(pk);
 
-	ERR_FAIL_COND(!E); //this should really be paired..
+	ERR_FAIL_COND(!pdp); //this should really be paired..
 
-	E->get()->rc--;
+	PairData *pd=*pdp;
+	pd->rc--;
 
-	if (E->get()->rc==0) {
+	if (pd->rc==0) {
 
-		if (E->get()->colliding) {
+		if (pd->colliding) {
 			//uncollide
 			if (unpair_callback) {
-				unpair_callback(p_elem->owner,p_elem->subindex,p_with->owner,p_with->subindex,E->get()->ud,unpair_userdata);
+				unpair_callback(p_elem->owner,p_elem->subindex,p_with->owner,p_with->subindex,pd->ud,unpair_userdata);
 			}
 
 
 		}
 
-		memdelete(E->get());
-		p_elem->paired.erase(E);
-		p_with->paired.erase(p_elem);
+		// swap remove from both lists, fixing the index of the pair moved in
+		Element *elems[2]={pd->a,pd->b};
+		int indices[2]={pd->a_index,pd->b_index};
+		for(int i=0;i<2;i++) {
+
+			Element *e=elems[i];
+			e->paired.remove(indices[i]);
+			if (indices[i]<e->paired.count) {
+				PairData *moved=e->paired.entries[indices[i]];
+				if (moved->a==e)
+					moved->a_index=indices[i];
+				else
+					moved->b_index=indices[i];
+			}
+		}
+
+		pair_map.erase(pk);
+		pd->next_free=free_pairs;
+		free_pairs=pd;
 	}
 
 
@@ -75,205 +110,241 @@ void BroadPhase2DHashGrid::_unpair_attempt(Element *p_elem, Element* p_with) {
 
 void BroadPhase2DHashGrid::_check_motion(Element *p_elem) {
 
-	for (Map<Element*,PairData*>::Element *E=p_elem->paired.front();E;E=E->next()) {
+	for (int i=0;i<p_elem->paired.count;i++) {
 
-		bool pairing = p_elem->aabb.intersects( E->key()->aabb );
+		PairData *pd=p_elem->paired.entries[i];
+		Element *other=pd->a==p_elem?pd->b:pd->a;
 
-		if (pairing!=E->get()->colliding) {
+		bool pairing = p_elem->aabb.intersects( other->aabb );
+
+		if (pairing!=pd->colliding) {
 
 			if (pairing) {
 
 				if (pair_callback) {
-					E->get()->ud=pair_callback(p_elem->owner,p_elem->subindex,E->key()->owner,E->key()->subindex,pair_userdata);
+					pd->ud=pair_callback(p_elem->owner,p_elem->subindex,other->owner,other->subindex,pair_userdata);
 				}
 			} else {
 
 				if (unpair_callback) {
-					unpair_callback(p_elem->owner,p_elem->subindex,E->key()->owner,E->key()->subindex,E->get()->ud,unpair_userdata);
+					unpair_callback(p_elem->owner,p_elem->subindex,other->owner,other->subindex,pd->ud,unpair_userdata);
 				}
 
 			}
 
-			E->get()->colliding=pairing;
+			pd->colliding=pairing;
 		}
 	}
 }
 
-void BroadPhase2DHashGrid::_enter_grid( Element* p_elem, const Rect2& p_rect,bool p_static) {
+void BroadPhase2DHashGrid::_get_cells(const Rect2& p_rect,Point2i &r_from,Point2i &r_to) const {
 
+	r_from = (p_rect.pos/cell_size).floor();
+	r_to = ((p_rect.pos+p_rect.size)/cell_size).floor();
+}
 
-	Point2i from = (p_rect.pos/cell_size).floor();
-	Point2i to = ((p_rect.pos+p_rect.size)/cell_size).floor();
+void BroadPhase2DHashGrid::_enter_grid( Element* p_elem, const Point2i& p_from, const Point2i& p_to, const Point2i* p_skip_from, const Point2i* p_skip_to) {
 
-	for(int i=from.x;i<=to.x;i++) {
+	bool is_static=p_elem->_static;
 
+	for(int i=p_from.x;i<=p_to.x;i++) {
 
-		for(int j=from.y;j<=to.y;j++) {
+
+		for(int j=p_from.y;j<=p_to.y;j++) {
+
+			// already there from the previous position
+			if (p_skip_from && i>=p_skip_from->x && i<=p_skip_to->x && j>=p_skip_from->y && j<=p_skip_to->y)
+				continue;
 
 			PosKey pk;
 			pk.x=i;
 			pk.y=j;
 
-			uint32_t idx = pk.hash() % hash_table_size;
-			PosBin *pb = hash_table[idx];
-
-			while (pb) {
+			PosBin **pbp = bin_map.getptr(pk);
+			PosBin *pb;
 
-				if (pb->key == pk) {
-					break;
+			if (pbp) {
+				pb=*pbp;
+			} else {
+				//does not exist, create!
+				if (free_bins) {
+					pb=free_bins;
+					free_bins=pb->next_free;
+				} else {
+					pb = memnew( PosBin );
 				}
-
-				pb=pb->next;
+				bin_map.set(pk,pb);
 			}
 
+			for(int k=0;k<pb->object_set.count;k++) {
 
-			bool entered=false;
-
-			if (!pb) {
-				//does not exist, create!
-				pb = memnew( PosBin );
-				pb->key=pk;
-				pb->next=hash_table[idx];
-				hash_table[idx]=pb;
+				Element *E=pb->object_set.entries[k];
+				if (E->owner==p_elem->owner)
+					continue;
+				_pair_attempt(p_elem,E);
 			}
 
+			if (is_static) {
 
-
-			if (p_static) {
-				if (pb->static_object_set[p_elem].inc()==1) {
-					entered=true;
-				}
+				pb->static_object_set.push_back(p_elem);
 			} else {
-				if (pb->object_set[p_elem].inc()==1) {
 
-					entered=true;
-				}
-			}
+				for(int k=0;k<pb->static_object_set.count;k++) {
 
-			if (entered) {
-
-				for(Map<Element*,RC>::Element *E=pb->object_set.front();E;E=E->next()) {
-
-					if (E->key()->owner==p_elem->owner)
+					Element *E=pb->static_object_set.entries[k];
+					if (E->owner==p_elem->owner)
 						continue;
-					_pair_attempt(p_elem,E->key());
+					_pair_attempt(p_elem,E);
 				}
 
-				if (!p_static) {
-
-					for(Map<Element*,RC>::Element *E=pb->static_object_set.front();E;E=E->next()) {
-
-						if (E->key()->owner==p_elem->owner)
-							continue;
-						_pair_attempt(p_elem,E->key());
-					}
-				}
+				pb->object_set.push_back(p_elem);
 			}
 
 		}
 
 	}
 
-
 }
 
 
-void BroadPhase2DHashGrid::_exit_grid( Element* p_elem, const Rect2& p_rect,bool p_static) {
+void BroadPhase2DHashGrid::_exit_grid( Element* p_elem, const Point2i& p_from, const Point2i& p_to, const Point2i* p_skip_from, const Point2i* p_skip_to) {
 
+	bool is_static=p_elem->_static;
 
-	Point2i from = (p_rect.pos/cell_size).floor();
-	Point2i to = ((p_rect.pos+p_rect.size)/cell_size).floor();
+	for(int i=p_from.x;i<=p_to.x;i++) {
 
-	for(int i=from.x;i<=to.x;i++) {
+		for(int j=p_from.y;j<=p_to.y;j++) {
 
-		for(int j=from.y;j<=to.y;j++) {
+			// still there in the new position
+			if (p_skip_from && i>=p_skip_from->x && i<=p_skip_to->x && j>=p_skip_from->y && j<=p_skip_to->y)
+				continue;
 
 			PosKey pk;
 			pk.x=i;
 			pk.y=j;
 
-			uint32_t idx = pk.hash() % hash_table_size;
-			PosBin *pb = hash_table[idx];
+			PosBin **pbp = bin_map.getptr(pk);
 
-			while (pb) {
+			ERR_CONTINUE(!pbp); //should exist!!
 
-				if (pb->key == pk) {
-					break;
-				}
+			PosBin *pb=*pbp;
 
-				pb=pb->next;
+			if (is_static) {
+				ERR_CONTINUE(!pb->static_object_set.erase(p_elem));
+			} else {
+				ERR_CONTINUE(!pb->object_set.erase(p_elem));
 			}
 
-			ERR_CONTINUE(!pb); //should exist!!
+			for(int k=0;k<pb->object_set.count;k++) {
 
-			bool exited=false;
+				Element *E=pb->object_set.entries[k];
+				if (E->owner==p_elem->owner)
+					continue;
+				_unpair_attempt(p_elem,E);
 
+			}
 
-			if (p_static) {
-				if (pb->static_object_set[p_elem].dec()==0) {
+			if (!is_static) {
 
-					pb->static_object_set.erase(p_elem);
-					exited=true;
+				for(int k=0;k<pb->static_object_set.count;k++) {
 
+					Element *E=pb->static_object_set.entries[k];
+					if (E->owner==p_elem->owner)
+						continue;
+					_unpair_attempt(p_elem,E);
 				}
-			} else {
-				if (pb->object_set[p_elem].dec()==0) {
+			}
 
-					pb->object_set.erase(p_elem);
-					exited=true;
+			if (pb->object_set.count==0 && pb->static_object_set.count==0) {
 
-				}
+				bin_map.erase(pk);
+				pb->next_free=free_bins;
+				free_bins=pb;
 			}
+		}
 
-			if (exited) {
+	}
 
-				for(Map<Element*,RC>::Element *E=pb->object_set.front();E;E=E->next()) {
+}
 
-					if (E->key()->owner==p_elem->owner)
-						continue;
-					_unpair_attempt(p_elem,E->key());
+void BroadPhase2DHashGrid::_enter_large(Element* p_elem) {
 
-				}
+	p_elem->large_index=large_elements.size();
+	large_elements.push_back(p_elem);
+}
 
-				if (!p_static) {
+void BroadPhase2DHashGrid::_exit_large(Element* p_elem) {
 
-					for(Map<Element*,RC>::Element *E=pb->static_object_set.front();E;E=E->next()) {
+	ERR_FAIL_INDEX(p_elem->large_index,large_elements.size());
 
-						if (E->key()->owner==p_elem->owner)
-							continue;
-						_unpair_attempt(p_elem,E->key());
-					}
-				}
-			}
+	Element **large=large_elements.ptr();
+	int last=large_elements.size()-1;
+	large[p_elem->large_index]=large[last];
+	large[p_elem->large_index]->large_index=p_elem->large_index;
+	large_elements.resize(last);
+	p_elem->large_index=-1;
+}
 
-			if (pb->object_set.empty() && pb->static_object_set.empty()) {
+void BroadPhase2DHashGrid::_insert(Element* p_elem, const Point2i& p_from, const Point2i& p_to, bool p_large) {
 
-				if (hash_table[idx]==pb) {
-					hash_table[idx]=pb->next;
-				} else {
+	if (p_large)
+		_enter_large(p_elem);
+	else
+		_enter_grid(p_elem,p_from,p_to);
+}
 
-					PosBin *px = hash_table[idx];
+void BroadPhase2DHashGrid::_remove(Element* p_elem, const Point2i& p_from, const Point2i& p_to, bool p_large) {
 
-					while (px) {
+	if (p_large)
+		_exit_large(p_elem);
+	else
+		_exit_grid(p_elem,p_from,p_to);
+}
 
-						if (px->next==pb) {
-							px->next=pb->next;
-							break;
-						}
+void BroadPhase2DHashGrid::_update_large_pairs(Element* p_elem) {
 
-						px=px->next;
-					}
+	// drop the pairs with large elements that stopped overlapping, backwards since unpairing swaps the last one in
+	for(int i=p_elem->paired.count-1;i>=0;i--) {
 
-					ERR_CONTINUE(!px);
-				}
+		PairData *pd=p_elem->paired.entries[i];
+		if (!pd->large_ref)
+			continue;
+		Element *other=pd->a==p_elem?pd->b:pd->a;
+		if (_needs_large_pair(p_elem,other))
+			continue;
+		pd->large_ref=false;
+		_unpair_attempt(p_elem,other);
+	}
 
-				memdelete(pb);
+	if (p_elem->aabb==Rect2())
+		return;
 
-			}
+	// and add the new ones, a large element has to look at everything, the rest only at the large ones
+	if (p_elem->large) {
+
+		for(const ID *k=element_map.next(NULL);k;k=element_map.next(k)) {
+
+			Element *E=element_map.get(*k);
+			if (!_needs_large_pair(p_elem,E))
+				continue;
+			PairData **pdp=pair_map.getptr(PairKey(p_elem->self,E->self));
+			if (pdp && (*pdp)->large_ref)
+				continue;
+			_pair_attempt(p_elem,E)->large_ref=true;
 		}
+	} else {
 
-	}
+		for(int i=0;i<large_elements.size();i++) {
 
+			Element *E=large_elements[i];
+			if (!_needs_large_pair(p_elem,E))
+				continue;
+			PairData **pdp=pair_map.getptr(PairKey(p_elem->self,E->self));
+			if (pdp && (*pdp)->large_ref)
+				continue;
+			_pair_attempt(p_elem,E)->large_ref=true;
+		}
+	}
 }
 
 
@@ -281,14 +352,16 @@ BroadPhase2DHashGrid::ID BroadPhase2DHashGrid::create(CollisionObject2DSW *p_obj
 
 	current++;
 
-	Element e;
-	e.owner=p_object;
-	e._static=false;
-	e.subindex=p_subindex;
-	e.self=current;
-	e.pass=0;
+	Element *e = memnew( Element );
+	e->owner=p_object;
+	e->_static=false;
+	e->large=false;
+	e->subindex=p_subindex;
+	e->self=current;
+	e->pass=0;
+	e->large_index=-1;
 
-	element_map[current]=e;
+	element_map.set(current,e);
 	return current;
 
 }
@@ -296,86 +369,120 @@ BroadPhase2DHashGrid::ID BroadPhase2DHashGrid::create(CollisionObject2DSW *p_obj
 void BroadPhase2DHashGrid::move(ID p_id, const Rect2& p_aabb) {
 
 
-	Map<ID,Element>::Element *E=element_map.find(p_id);
-	ERR_FAIL_COND(!E);
+	Element **ep=element_map.getptr(p_id);
+	ERR_FAIL_COND(!ep);
 
-	Element &e=E->get();
+	Element &e=**ep;
 
 	if (p_aabb==e.aabb)
 		return;
 
+	Point2i from,to;
+	bool large=false;
 
 	if (p_aabb!=Rect2()) {
-
-		_enter_grid(&e,p_aabb,e._static);
+		_get_cells(p_aabb,from,to);
+		large=_is_large(from,to);
 	}
 
-	if (e.aabb!=Rect2()) {
+	Point2i old_from=e.cell_from;
+	Point2i old_to=e.cell_to;
+	bool old_large=e.large;
+	bool remove_old=false;
+
+	if (p_aabb!=Rect2() && e.aabb!=Rect2() && large && e.large) {
 
-		_exit_grid(&e,e.aabb,e._static);
+		// not in the grid, only the pairs change
+	} else if (p_aabb!=Rect2() && e.aabb!=Rect2() && !large && !e.large) {
+
+		// only the cells that changed, entering first so pairs in both places are kept
+		if (from!=e.cell_from || to!=e.cell_to) {
+			_enter_grid(&e,from,to,&e.cell_from,&e.cell_to);
+			_exit_grid(&e,e.cell_from,e.cell_to,&from,&to);
+		}
+	} else {
+
+		if (p_aabb!=Rect2()) {
+
+			_insert(&e,from,to,large);
+		}
+
+		// the old place goes after the large pairs are updated, for the same reason
+		remove_old=e.aabb!=Rect2();
 	}
 
 	e.aabb=p_aabb;
+	e.cell_from=from;
+	e.cell_to=to;
+	e.large=large;
 
-	_check_motion(&e);
+	_update_large_pairs(&e);
 
-	e.aabb=p_aabb;
+	if (remove_old)
+		_remove(&e,old_from,old_to,old_large);
+
+	_check_motion(&e);
 
 }
 void BroadPhase2DHashGrid::set_static(ID p_id, bool p_static) {
 
-	Map<ID,Element>::Element *E=element_map.find(p_id);
-	ERR_FAIL_COND(!E);
+	Element **ep=element_map.getptr(p_id);
+	ERR_FAIL_COND(!ep);
 
-	Element &e=E->get();
+	Element &e=**ep;
 
 	if (e._static==p_static)
 		return;
 
 	if (e.aabb!=Rect2())
-		_exit_grid(&e,e.aabb,e._static);
+		_remove(&e,e.cell_from,e.cell_to,e.large);
 
 	e._static=p_static;
 
 	if (e.aabb!=Rect2()) {
-		_enter_grid(&e,e.aabb,e._static);
+		_insert(&e,e.cell_from,e.cell_to,e.large);
+		_update_large_pairs(&e);
 		_check_motion(&e);
 	}
 
 }
 void BroadPhase2DHashGrid::remove(ID p_id) {
 
-	Map<ID,Element>::Element *E=element_map.find(p_id);
-	ERR_FAIL_COND(!E);
+	Element **ep=element_map.getptr(p_id);
+	ERR_FAIL_COND(!ep);
 
-	Element &e=E->get();
+	Element *e=*ep;
 
-	if (e.aabb!=Rect2())
-		_exit_grid(&e,e.aabb,e._static);
+	if (e->aabb!=Rect2()) {
+		_remove(e,e->cell_from,e->cell_to,e->large);
+		e->aabb=Rect2();
+		_update_large_pairs(e); // drops the ones left
+	}
 
 	element_map.erase(p_id);
+	memdelete(e);
 
 }
 
 CollisionObject2DSW *BroadPhase2DHashGrid::get_object(ID p_id) const {
 
-	const Map<ID,Element>::Element *E=element_map.find(p_id);
-	ERR_FAIL_COND_V(!E,NULL);
-	return E->get().owner;
+	Element * const *ep=element_map.getptr(p_id);
+	ERR_FAIL_COND_V(!ep,NULL);
+	return (*ep)->owner;
 
 }
 bool BroadPhase2DHashGrid::is_static(ID p_id) const {
 
-	const Map<ID,Element>::Element *E=element_map.find(p_id);
-	ERR_FAIL_COND_V(!E,false);
-	return E->get()._static;
+	Element * const *ep=element_map.getptr(p_id);
+	ERR_FAIL_COND_V(!ep,false);
+	return (*ep)->_static;
 
 }
 int BroadPhase2DHashGrid::get_subindex(ID p_id) const {
 
-	const Map<ID,Element>::Element *E=element_map.find(p_id);
-	ERR_FAIL_COND_V(!E,-1);
-	return E->get().subindex;
+	Element * const *ep=element_map.getptr(p_id);
+	ERR_FAIL_COND_V(!ep,-1);
+	return (*ep)->subindex;
 }
 
 template<bool use_aabb,bool use_segment>
@@ -386,66 +493,60 @@ void BroadPhase2DHashGrid::_cull(const Point2i p_cell,const Rect2& p_aabb,const
 	pk.x=p_cell.x;
 	pk.y=p_cell.y;
 
-	uint32_t idx = pk.hash() % hash_table_size;
-	PosBin *pb = hash_table[idx];
+	PosBin **pbp = bin_map.getptr(pk);
 
-	while (pb) {
-
-		if (pb->key == pk) {
-			break;
-		}
-
-		pb=pb->next;
-	}
-
-	if (!pb)
+	if (!pbp)
 		return;
 
+	PosBin *pb=*pbp;
 
+	for(int i=0;i<2;i++) {
 
-	for(Map<Element*,RC>::Element *E=pb->object_set.front();E;E=E->next()) {
+		const InlineList<Element*,4> &set = i==0?pb->object_set:pb->static_object_set;
 
+		for(int k=0;k<set.count;k++) {
 
-		if (index>=p_max_results)
-			break;
-		if (E->key()->pass==pass)
-			continue;
+			if (index>=p_max_results)
+				return;
 
-		E->key()->pass=pass;
+			Element *E=set.entries[k];
+			if (E->pass==pass)
+				continue;
 
-		if (use_aabb && !p_aabb.intersects(E->key()->aabb))
-			continue;
+			E->pass=pass;
 
-		if (use_segment && !E->key()->aabb.intersects_segment(p_from,p_to))
-			continue;
-
-		p_results[index]=E->key()->owner;
-		p_result_indices[index]=E->key()->subindex;
-		index++;
+			if (use_aabb && !p_aabb.intersects(E->aabb))
+				continue;
 
+			if (use_segment && !E->aabb.intersects_segment(p_from,p_to))
+				continue;
 
+			p_results[index]=E->owner;
+			p_result_indices[index]=E->subindex;
+			index++;
+		}
 	}
+}
 
-	for(Map<Element*,RC>::Element *E=pb->static_object_set.front();E;E=E->next()) {
+template<bool use_aabb,bool use_segment>
+void BroadPhase2DHashGrid::_cull_large(const Rect2& p_aabb,const Point2& p_from, const Point2& p_to,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index) {
 
+	for(int i=0;i<large_elements.size();i++) {
 
 		if (index>=p_max_results)
-			break;
-		if (E->key()->pass==pass)
-			continue;
+			return;
 
-		if (use_aabb && !p_aabb.intersects(E->key()->aabb)) {
+		Element *E=large_elements[i];
+
+		if (use_aabb && !p_aabb.intersects(E->aabb))
 			continue;
-		}
 
-		if (use_segment && !E->key()->aabb.intersects_segment(p_from,p_to))
+		if (use_segment && !E->aabb.intersects_segment(p_from,p_to))
 			continue;
 
-		E->key()->pass=pass;
-		p_results[index]=E->key()->owner;
-		p_result_indices[index]=E->key()->subindex;
+		p_results[index]=E->owner;
+		p_result_indices[index]=E->subindex;
 		index++;
-
 	}
 }
 
@@ -485,6 +586,7 @@ int BroadPhase2DHashGrid::cull_segment(const Vector2& p_from, const Vector2& p_t
 		max.y= (Math::floor(pos.y + 1)*cell_size - p_from.y) / dir.y;
 
 	int cullcount=0;
+	_cull_large<false,true>(Rect2(),p_from,p_to,p_results,p_max_results,p_result_indices,cullcount);
 	_cull<false,true>(pos,Rect2(),p_from,p_to,p_results,p_max_results,p_result_indices,cullcount);
 
 	bool reached_x=false;
@@ -538,6 +640,8 @@ int BroadPhase2DHashGrid::cull_aabb(const Rect2& p_aabb,CollisionObject2DSW** p_
 	Point2i to = ((p_aabb.pos+p_aabb.size)/cell_size).floor();
 	int cullcount=0;
 
+	_cull_large<true,false>(p_aabb,Point2(),Point2(),p_results,p_max_results,p_result_indices,cullcount);
+
 	for(int i=from.x;i<=to.x;i++) {
 
 		for(int j=from.y;j<=to.y;j++) {
@@ -576,14 +680,13 @@ BroadPhase2DSW *BroadPhase2DHashGrid::_create() {
 
 BroadPhase2DHashGrid::BroadPhase2DHashGrid() {
 
-	hash_table_size = GLOBAL_DEF("physics_2d/bp_hash_table_size",4096);
-	hash_table_size = Math::larger_prime(hash_table_size);
-	hash_table = memnew_arr( PosBin*, hash_table_size);
+	bin_map.reserve( GLOBAL_DEF("physics_2d/bp_hash_table_size",4096) );
 
 	cell_size = GLOBAL_DEF("physics_2d/cell_size",128);
+	large_object_cells = GLOBAL_DEF("physics_2d/large_object_cells",512);
 
-	for(int i=0;i<hash_table_size;i++)
-		hash_table[i]=NULL;
+	free_pairs=NULL;
+	free_bins=NULL;
 	pass=1;
 
 	current=0;
@@ -591,16 +694,29 @@ BroadPhase2DHashGrid::BroadPhase2DHashGrid() {
 
 BroadPhase2DHashGrid::~BroadPhase2DHashGrid() {
 
-	for(int i=0;i<hash_table_size;i++) {
-		while(hash_table[i]) {
-			PosBin *pb=hash_table[i];
-			hash_table[i]=pb->next;
-			memdelete(pb);
-		}
+	for(const PairKey *k=pair_map.next(NULL);k;k=pair_map.next(k)) {
+		memdelete( pair_map.get(*k) );
 	}
 
-	memdelete_arr( hash_table );
+	while(free_pairs) {
+		PairData *pd=free_pairs;
+		free_pairs=pd->next_free;
+		memdelete(pd);
+	}
+
+	for(const PosKey *k=bin_map.next(NULL);k;k=bin_map.next(k)) {
+		memdelete( bin_map.get(*k) );
+	}
 
+	while(free_bins) {
+		PosBin *pb=free_bins;
+		free_bins=pb->next_free;
+		memdelete(pb);
+	}
+
+	for(const ID *k=element_map.next(NULL);k;k=element_map.next(k)) {
+		memdelete( element_map.get(*k) );
+	}
 
 }
 
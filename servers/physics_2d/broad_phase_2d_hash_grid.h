@@ -30,17 +30,74 @@
 #define BROAD_PHASE_2D_HASH_GRID_H
 
 #include "broad_phase_2d_sw.h"
-#include "map.h"
+#include "oa_hash_map.h"
+#include "os/copymem.h"
+#include "vector.h"
 
 class BroadPhase2DHashGrid : public BroadPhase2DSW {
 
 
+	/* small array that only goes to the heap once it outgrows its inline storage,
+	   most cells and most elements only hold a handful of entries */
+
+	template<class T,int INLINE_SIZE>
+	struct InlineList {
+
+		T inline_entries[INLINE_SIZE];
+		T *entries;
+		int count;
+		int capacity;
+
+		_FORCE_INLINE_ void push_back(const T& p_entry) {
+
+			if (count==capacity)
+				_grow();
+			entries[count++]=p_entry;
+		}
+
+		_FORCE_INLINE_ void remove(int p_index) { // swaps the last entry in
+
+			entries[p_index]=entries[--count];
+		}
+
+		_FORCE_INLINE_ bool erase(const T& p_entry) {
+
+			for(int i=0;i<count;i++) {
+				if (entries[i]==p_entry) {
+					remove(i);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void _grow() {
+
+			capacity*=2;
+			T *new_entries=(T*)memalloc(sizeof(T)*capacity);
+			copymem(new_entries,entries,sizeof(T)*count);
+			if (entries!=inline_entries)
+				memfree(entries);
+			entries=new_entries;
+		}
+
+		InlineList() { entries=inline_entries; count=0; capacity=INLINE_SIZE; }
+		~InlineList() { if (entries!=inline_entries) memfree(entries); }
+	};
+
+	struct Element;
+
 	struct PairData {
 
+		Element *a;
+		Element *b;
+		int a_index; // position in a->paired
+		int b_index; // position in b->paired
 		bool colliding;
+		bool large_ref; // one of the references is held by _update_large_pairs
 		int rc;
 		void *ud;
-		PairData() { colliding=false; rc=1; ud=NULL; }
+		PairData *next_free;
 	};
 
 	struct Element {
@@ -48,15 +105,19 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 		ID self;
 		CollisionObject2DSW *owner;
 		bool _static;
+		bool large;
 		Rect2 aabb;
+		Point2i cell_from;
+		Point2i cell_to;
 		int subindex;
 		uint64_t pass;
-		Map<Element*,PairData*> paired;
+		int large_index; // position in large_elements
+		InlineList<PairData*,8> paired;
 
 	};
 
 
-	Map<ID,Element> element_map;
+	OAHashMap<ID,Element*> element_map;
 
 	ID current;
 
@@ -73,8 +134,8 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 			uint64_t key;
 		};
 
-		_FORCE_INLINE_ bool operator<(const PairKey& p_key) const {
-			return key < p_key.key;
+		_FORCE_INLINE_ bool operator==(const PairKey& p_key) const {
+			return key == p_key.key;
 		}
 
 		PairKey() { key=0; }
@@ -82,21 +143,23 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 
 	};
 
+	struct PairKeyHasher {
+
+		static _FORCE_INLINE_ uint32_t hash(const PairKey& p_key) { return HashMapHahserDefault::hash(p_key.key); }
+	};
+
 
-	Map<PairKey,PairData> pair_map;
+	OAHashMap<PairKey,PairData*,PairKeyHasher> pair_map;
+	PairData *free_pairs;
 
 	int cell_size;
+	int large_object_cells;
 
 	PairCallback pair_callback;
 	void *pair_userdata;
 	UnpairCallback unpair_callback;
 	void *unpair_userdata;
 
-	void _enter_grid(Element* p_elem, const Rect2& p_rect,bool p_static);
-	void _exit_grid(Element* p_elem, const Rect2& p_rect,bool p_static);
-	template<bool use_aabb,bool use_segment>
-	_FORCE_INLINE_ void _cull(const Point2i p_cell,const Rect2& p_aabb,const Point2& p_from, const Point2& p_to,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index);
-
 
 	struct PosKey {
 
@@ -127,37 +190,58 @@ class BroadPhase2DHashGrid : public BroadPhase2DSW {
 
 	};
 
-	struct RC {
+	struct PosKeyHasher {
 
-		int ref;
-
-		_FORCE_INLINE_ int inc() {
-			ref++;
-			return ref;
-		}
-		_FORCE_INLINE_ int dec() {
-			ref--;
-			return ref;
-		}
-
-		_FORCE_INLINE_ RC() {
-			ref=0;
-		}
+		static _FORCE_INLINE_ uint32_t hash(const PosKey& p_key) { return p_key.hash(); }
 	};
 
 	struct PosBin {
 
-		PosKey key;
-		Map<Element*,RC> object_set;
-		Map<Element*,RC> static_object_set;
-		PosBin *next;
+		InlineList<Element*,4> object_set;
+		InlineList<Element*,4> static_object_set;
+		PosBin *next_free;
 	};
 
 
-	uint32_t hash_table_size;
-	PosBin **hash_table;
+	OAHashMap<PosKey,PosBin*,PosKeyHasher> bin_map;
+	PosBin *free_bins;
+
+	/* objects covering more than large_object_cells cells skip the grid,
+	   they are only paired while their aabb overlaps, found by checking this list
+	   when something moves (or every element when a large one moves) */
+	Vector<Element*> large_elements;
+
+	_FORCE_INLINE_ bool _is_large(const Point2i& p_from,const Point2i& p_to) const {
+
+		return int64_t(p_to.x-p_from.x+1)*int64_t(p_to.y-p_from.y+1) > large_object_cells;
+	}
+
+	void _get_cells(const Rect2& p_rect,Point2i &r_from,Point2i &r_to) const;
+
+	void _enter_grid(Element* p_elem, const Point2i& p_from, const Point2i& p_to, const Point2i* p_skip_from=NULL, const Point2i* p_skip_to=NULL);
+	void _exit_grid(Element* p_elem, const Point2i& p_from, const Point2i& p_to, const Point2i* p_skip_from=NULL, const Point2i* p_skip_to=NULL);
+	void _enter_large(Element* p_elem);
+	void _exit_large(Element* p_elem);
+	void _insert(Element* p_elem, const Point2i& p_from, const Point2i& p_to, bool p_large);
+	void _remove(Element* p_elem, const Point2i& p_from, const Point2i& p_to, bool p_large);
+	void _update_large_pairs(Element* p_elem);
+
+	template<bool use_aabb,bool use_segment>
+	_FORCE_INLINE_ void _cull(const Point2i p_cell,const Rect2& p_aabb,const Point2& p_from, const Point2& p_to,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index);
+	template<bool use_aabb,bool use_segment>
+	_FORCE_INLINE_ void _cull_large(const Rect2& p_aabb,const Point2& p_from, const Point2& p_to,CollisionObject2DSW** p_results,int p_max_results,int *p_result_indices,int &index);
+
+	_FORCE_INLINE_ bool _can_pair(Element *p_elem, Element* p_with) const {
+
+		return p_elem!=p_with && p_elem->owner!=p_with->owner && !(p_elem->_static && p_with->_static);
+	}
+
+	_FORCE_INLINE_ bool _needs_large_pair(Element *p_elem, Element* p_with) const {
+
+		return (p_elem->large || p_with->large) && p_elem->aabb!=Rect2() && p_with->aabb!=Rect2() && _can_pair(p_elem,p_with) && p_elem->aabb.intersects(p_with->aabb);
+	}
 
-	void _pair_attempt(Element *p_elem, Element* p_with);
+	PairData *_pair_attempt(Element *p_elem, Element* p_with);
 	void _unpair_attempt(Element *p_elem, Element* p_with);
 	void _check_motion(Element *p_elem);
 
@@ -69,11 +69,10 @@ private:
 	uint32_t layer_mask;
 	bool _static;
 
-	void _update_shapes();
-
 protected:
 
 
+	void _update_shapes();
 	void _update_shapes_with_motion(const Vector2& p_motion);
 	void _unregister_shapes();
 
@@ -14,6 +14,10 @@ void Physics2DServerWrapMT::thread_step(float p_delta) {
 
 }
 
+void Physics2DServerWrapMT::thread_flush() {
+
+}
+
 void Physics2DServerWrapMT::_thread_callback(void *_instance) {
 
 	Physics2DServerWrapMT *vsmt = reinterpret_cast<Physics2DServerWrapMT*>(_instance);
@@ -52,6 +56,7 @@ void Physics2DServerWrapMT::step(float p_step) {
 	if (create_thread) {
 
 		command_queue.push( this, &Physics2DServerWrapMT::thread_step,p_step);
+		step_pending=1; //runs while the main thread does idle processing, until sync()
 	} else {
 
 		command_queue.flush_all(); //flush all pending from other threads
@@ -61,15 +66,24 @@ void Physics2DServerWrapMT::step(float p_step) {
 
 void Physics2DServerWrapMT::sync() {
 
-	if (step_sem) {
-		if (first_frame)
-			first_frame=false;
-		else
-			step_sem->wait(); //must not wait if a step was not issued
+	if (step_sem && step_pending) {
+		step_sem->wait(); //must not wait if a step was not issued
+		step_pending=0;
 	}
 	physics_2d_server->sync();;
 }
 
+void Physics2DServerWrapMT::_wait_step() {
+
+	//functions that bypass the command queue must not run while the step does
+	if (!step_pending)
+		return;
+
+	command_queue.push_and_sync( this, &Physics2DServerWrapMT::thread_flush);
+	step_sem->wait(); //already posted, the step ran before the flush
+	step_pending=0;
+}
+
 void Physics2DServerWrapMT::flush_queries(){
 
 	physics_2d_server->flush_queries();
@@ -154,7 +168,6 @@ Physics2DServerWrapMT::Physics2DServerWrapMT(Physics2DServer* p_contained,bool p
 	}
 
 	main_thread = Thread::get_caller_ID();
-	first_frame=true;
 }
 
 
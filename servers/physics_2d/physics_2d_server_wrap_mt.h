@@ -31,14 +31,15 @@ class Physics2DServerWrapMT : public Physics2DServer {
 	bool create_thread;
 
 	Semaphore *step_sem;
-	int step_pending;
+	int step_pending; // a step was issued to the server thread and not synced yet
 	void thread_step(float p_delta);
 	void thread_flush();
 
 	void thread_exit();
 
+	void _wait_step();
+
 	Mutex*alloc_mutex;
-	bool first_frame;
 
 	int shape_pool_max_size;
 	List<RID> shape_id_pool;
@@ -75,6 +76,7 @@ public:
 	bool shape_collide(RID p_shape_A, const Matrix32& p_xform_A,const Vector2& p_motion_A,RID p_shape_B, const Matrix32& p_xform_B, const Vector2& p_motion_B,Vector2 *r_results,int p_result_max,int &r_result_count) {
 
 		ERR_FAIL_COND_V(main_thread!=Thread::get_caller_ID(),false);
+		_wait_step();
 		return physics_2d_server->shape_collide(p_shape_A,p_xform_A,p_motion_A,p_shape_B,p_xform_B,p_motion_B,r_results,p_result_max,r_result_count);
 	}
 
@@ -91,6 +93,7 @@ public:
 	Physics2DDirectSpaceState* space_get_direct_state(RID p_space) {
 
 		ERR_FAIL_COND_V(main_thread!=Thread::get_caller_ID(),NULL);
+		_wait_step();
 		return physics_2d_server->space_get_direct_state(p_space);
 	}
 
@@ -216,6 +219,7 @@ public:
 
 
 	bool body_collide_shape(RID p_body, int p_body_shape,RID p_shape, const Matrix32& p_shape_xform,const Vector2& p_motion,Vector2 *r_results,int p_result_max,int &r_result_count) {
+		_wait_step();
 		return physics_2d_server->body_collide_shape(p_body,p_body_shape,p_shape,p_shape_xform,p_motion,r_results,p_result_max,r_result_count);
 	}
 
@@ -224,6 +228,7 @@ public:
 	bool body_test_motion(RID p_body,const Vector2& p_motion,float p_margin=0.001,MotionResult *r_result=NULL) {
 
 		ERR_FAIL_COND_V(main_thread!=Thread::get_caller_ID(),false);
+		_wait_step();
 		return physics_2d_server->body_test_motion(p_body,p_motion,p_margin,r_result);
 	}
 
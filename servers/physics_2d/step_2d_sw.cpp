@@ -27,6 +27,7 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 #include "step_2d_sw.h"
+#include "os/worker_thread_pool.h"
 
 
 void Step2DSW::_populate_island(Body2DSW* p_body,Body2DSW** p_island,Constraint2DSW **p_constraint_island) {
@@ -60,8 +61,10 @@ void Step2DSW::_setup_island(Constraint2DSW *p_island,float p_delta) {
 
 	Constraint2DSW *ci=p_island;
 	while(ci) {
-		bool process = ci->setup(p_delta);
-		//todo remove from island if process fails
+		if (!ci->is_setup_shared()) { //shared ones were set up before solving
+			bool process = ci->setup(p_delta);
+			//todo remove from island if process fails
+		}
 		ci=ci->get_island_next();
 	}
 }
@@ -79,6 +82,114 @@ void Step2DSW::_solve_island(Constraint2DSW *p_island,int p_iterations,float p_d
 	}
 }
 
+void Step2DSW::_solve_islands_task(void *p_step,int p_from,int p_to) {
+
+	Step2DSW *step=(Step2DSW*)p_step;
+	const Island *il=step->island_order.ptr();
+
+	for(int i=p_from;i<p_to;i++) {
+
+		step->_setup_island(il[i].constraints,step->step_delta);
+		step->_solve_island(il[i].constraints,step->step_iterations,step->step_delta);
+	}
+}
+
+void Step2DSW::_solve_islands() {
+
+	int island_count=islands.size();
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	int workers=pool?pool->get_worker_count():0;
+
+	if (workers==0 || island_count<2) {
+
+		const Island *il=islands.ptr();
+		for(int i=0;i<island_count;i++) {
+
+			_setup_island(il[i].constraints,step_delta);
+			_solve_island(il[i].constraints,step_iterations,step_delta);
+		}
+		return;
+	}
+
+	/* longest processing time first: hand the most expensive islands out first, each one to the
+	   least loaded job. Islands don't share state, so the result does not depend on the split. */
+
+	islands.sort_custom<IslandCostCmp>();
+
+	int bucket_count=MIN(workers+1,island_count);
+	bucket_load.resize(bucket_count);
+	bucket_size.resize(bucket_count);
+	int *load=bucket_load.ptr();
+	int *size=bucket_size.ptr();
+
+	for(int i=0;i<bucket_count;i++) {
+		load[i]=0;
+		size[i]=0;
+	}
+
+	Island *il=islands.ptr();
+
+	for(int i=0;i<island_count;i++) {
+
+		int best=0;
+		for(int j=1;j<bucket_count;j++) {
+			if (load[j]<load[best])
+				best=j;
+		}
+
+		load[best]+=il[i].cost;
+		size[best]++;
+		il[i].bucket=best;
+	}
+
+	//group by job, keeping the cost order inside each; load is reused as the write offset
+	int ofs=0;
+	for(int i=0;i<bucket_count;i++) {
+		load[i]=ofs;
+		ofs+=size[i];
+	}
+
+	island_order.resize(island_count);
+	Island *order=island_order.ptr();
+	for(int i=0;i<island_count;i++) {
+		order[load[il[i].bucket]++]=il[i];
+	}
+
+	WorkerThreadPool::Group *group=pool->group_create();
+
+	int from=0;
+	for(int i=0;i<bucket_count;i++) {
+
+		if (size[i]==0)
+			continue;
+		pool->group_add_task(group,_solve_islands_task,this,from,from+size[i]);
+		from+=size[i];
+	}
+
+	pool->group_commit(group);
+	pool->group_wait(group);
+}
+
+void Step2DSW::_integrate_forces_task(void *p_step,int p_from,int p_to) {
+
+	Step2DSW *step=(Step2DSW*)p_step;
+	Body2DSW **b=step->bodies.ptr();
+
+	for(int i=p_from;i<p_to;i++) {
+		b[i]->integrate_forces(step->step_delta,true);
+	}
+}
+
+void Step2DSW::_integrate_velocities_task(void *p_step,int p_from,int p_to) {
+
+	Step2DSW *step=(Step2DSW*)p_step;
+	Body2DSW **b=step->bodies.ptr();
+
+	for(int i=p_from;i<p_to;i++) {
+		b[i]->integrate_velocities(step->step_delta,true);
+	}
+}
+
 void Step2DSW::_check_suspend(Body2DSW *p_island,float p_delta) {
 
 
@@ -126,15 +237,36 @@ void Step2DSW::step(Space2DSW* p_space,float p_delta,int p_iterations) {
 
 	const SelfList<Body2DSW>::List * body_list = &p_space->get_active_body_list();
 
+	WorkerThreadPool *pool=WorkerThreadPool::get_singleton();
+	step_delta=p_delta;
+	step_iterations=p_iterations;
+
 	/* INTEGRATE FORCES */
 	int active_count=0;
 
 	const SelfList<Body2DSW>*b = body_list->first();
 	while(b) {
-
-		b->self()->integrate_forces(p_delta);
-		b=b->next();
 		active_count++;
+		b=b->next();
+	}
+
+	bodies.resize(active_count);
+	{
+		Body2DSW **ba=bodies.ptr();
+		int idx=0;
+		for(b=body_list->first();b;b=b->next()) {
+			ba[idx++]=b->self();
+		}
+	}
+
+	//bodies only touch themselves, changes to the space are applied afterwards in list order
+	if (pool)
+		pool->parallel_for(0,active_count,_integrate_forces_task,this,INTEGRATE_GRANULARITY);
+	else
+		_integrate_forces_task(this,0,active_count);
+
+	for(int i=0;i<active_count;i++) {
+		bodies[i]->apply_deferred_updates();
 	}
 
 	p_space->set_active_objects(active_count);
@@ -191,36 +323,46 @@ void Step2DSW::step(Space2DSW* p_space,float p_delta,int p_iterations) {
 	}
 
 //	print_line("island count: "+itos(island_count)+" active count: "+itos(active_count));
-	/* SETUP CONSTRAINT ISLANDS */
+	/* SETUP SHARED CONSTRAINTS */
 
+	islands.clear();
 	{
 		Constraint2DSW *ci=constraint_island_list;
 		while(ci) {
 
-			_setup_island(ci,p_delta);
-			ci=ci->get_island_list_next();
-		}
-	}
+			Island island;
+			island.constraints=ci;
+			island.cost=0;
+			island.index=islands.size();
+			island.bucket=0;
 
-	/* SOLVE CONSTRAINT ISLANDS */
+			for(Constraint2DSW *c=ci;c;c=c->get_island_next()) {
 
-	{
-		Constraint2DSW *ci=constraint_island_list;
-		while(ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci,p_iterations,p_delta);
+				if (c->is_setup_shared())
+					c->setup(p_delta);
+				island.cost++;
+			}
+
+			islands.push_back(island);
 			ci=ci->get_island_list_next();
 		}
 	}
 
+	/* SETUP AND SOLVE CONSTRAINT ISLANDS */
+
+	//iterating each island separatedly improves cache efficiency
+	_solve_islands();
+
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while(b) {
+	//the active list is the same as when integrating forces, bodies that shut themselves down leave it afterwards
+	if (pool)
+		pool->parallel_for(0,active_count,_integrate_velocities_task,this,INTEGRATE_GRANULARITY);
+	else
+		_integrate_velocities_task(this,0,active_count);
 
-		const SelfList<Body2DSW>*n=b->next();
-		b->self()->integrate_velocities(p_delta);
-		b=n;  // in case it shuts itself down
+	for(int i=0;i<active_count;i++) {
+		bodies[i]->apply_deferred_updates();
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
@@ -245,4 +387,6 @@ void Step2DSW::step(Space2DSW* p_space,float p_delta,int p_iterations) {
 Step2DSW::Step2DSW() {
 
 	_step=1;
+	step_delta=0;
+	step_iterations=0;
 }
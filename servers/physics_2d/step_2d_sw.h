@@ -33,11 +33,46 @@
 
 class Step2DSW {
 
+	enum {
+		INTEGRATE_GRANULARITY=64 // bodies per job when integrating in parallel
+	};
+
+	struct Island {
+
+		Constraint2DSW *constraints;
+		int cost;
+		int index;
+		int bucket;
+	};
+
+	struct IslandCostCmp {
+
+		_FORCE_INLINE_ bool operator()(const Island& p_a,const Island& p_b) const {
+			// most expensive first, list order between equals so the split does not depend on the sort
+			return p_a.cost > p_b.cost || (p_a.cost==p_b.cost && p_a.index < p_b.index);
+		}
+	};
+
 	uint64_t _step;
 
+	/* scratch kept between steps to avoid allocating */
+	Vector<Body2DSW*> bodies;
+	Vector<Island> islands;
+	Vector<Island> island_order; // islands grouped by the job that solves them
+	Vector<int> bucket_load;
+	Vector<int> bucket_size;
+	float step_delta;
+	int step_iterations;
+
+	static void _integrate_forces_task(void *p_step,int p_from,int p_to);
+	static void _integrate_velocities_task(void *p_step,int p_from,int p_to);
+	static void _solve_islands_task(void *p_step,int p_from,int p_to);
+
+
 	void _populate_island(Body2DSW* p_body,Body2DSW** p_island,Constraint2DSW **p_constraint_island);
 	void _setup_island(Constraint2DSW *p_island,float p_delta);
 	void _solve_island(Constraint2DSW *p_island,int p_iterations,float p_delta);
+	void _solve_islands();
 	void _check_suspend(Body2DSW *p_island,float p_delta);
 public:
 
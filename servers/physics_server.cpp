@@ -343,6 +343,40 @@ Dictionary PhysicsDirectSpaceState::_get_rest_info(const Ref<PhysicsShapeQueryPa
 
 
 
+int PhysicsDirectSpaceState::intersect_rays(const RayQuery *p_rays,int p_ray_count,RayResult *r_results,bool *r_hits,const RID *p_exclude,int p_exclude_count,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
+
+	Set<RID> exclude;
+	for(int i=0;i<p_exclude_count;i++)
+		exclude.insert(p_exclude[i]);
+
+	int hits=0;
+	for(int i=0;i<p_ray_count;i++) {
+
+		r_hits[i]=intersect_ray(p_rays[i].from,p_rays[i].to,r_results[i],exclude,p_layer_mask,p_object_type_mask);
+		if (r_hits[i])
+			hits++;
+	}
+
+	return hits;
+}
+
+int PhysicsDirectSpaceState::intersect_shapes(const ShapeQuery *p_queries,int p_query_count,ShapeResult *r_results,int p_result_max,int *r_result_counts,const RID *p_exclude,int p_exclude_count,uint32_t p_layer_mask,uint32_t p_object_type_mask) {
+
+	Set<RID> exclude;
+	for(int i=0;i<p_exclude_count;i++)
+		exclude.insert(p_exclude[i]);
+
+	int total=0;
+	for(int i=0;i<p_query_count;i++) {
+
+		r_result_counts[i]=intersect_shape(p_queries[i].shape,p_queries[i].transform,p_queries[i].margin,&r_results[i*p_result_max],p_result_max,exclude,p_layer_mask,p_object_type_mask);
+		total+=r_result_counts[i];
+	}
+
+	return total;
+}
+
+
 PhysicsDirectSpaceState::PhysicsDirectSpaceState() {
 
 
@@ -731,7 +765,7 @@ void PhysicsServer::_bind_methods() {
 
 PhysicsServer::PhysicsServer() {
 
-	ERR_FAIL_COND( singleton!=NULL );
+	//ERR_FAIL_COND( singleton!=NULL ); a wrapper is created after the server it contains
 	singleton=this;
 }
 
@@ -199,6 +199,27 @@ public:
 
 	virtual bool rest_info(RID p_shape, const Transform& p_shape_xform,float p_margin,ShapeRestInfo *r_info, const Set<RID>& p_exclude=Set<RID>(),uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION)=0;
 
+	/* batched queries, excludes are a plain list and results go to caller provided buffers */
+
+	struct RayQuery {
+
+		Vector3 from;
+		Vector3 to;
+	};
+
+	// r_hits[i] tells whether r_results[i] is valid, returns the amount of hits
+	virtual int intersect_rays(const RayQuery *p_rays,int p_ray_count,RayResult *r_results,bool *r_hits,const RID *p_exclude=NULL,int p_exclude_count=0,uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION);
+
+	struct ShapeQuery {
+
+		RID shape;
+		Transform transform;
+		float margin;
+	};
+
+	// query i writes up to p_result_max results from r_results[i*p_result_max] and their amount to r_result_counts[i], returns the total
+	virtual int intersect_shapes(const ShapeQuery *p_queries,int p_query_count,ShapeResult *r_results,int p_result_max,int *r_result_counts,const RID *p_exclude=NULL,int p_exclude_count=0,uint32_t p_layer_mask=0xFFFFFFFF,uint32_t p_object_type_mask=TYPE_MASK_COLLISION);
+
 
 	PhysicsDirectSpaceState();
 };
@@ -247,7 +268,7 @@ public:
 		SHAPE_BOX, ///< vec3:"extents"
 		SHAPE_CAPSULE, ///< dict( float:"radius", float:"height"):capsule
 		SHAPE_CONVEX_POLYGON, ///< array of planes:"planes"
-		SHAPE_CONCAVE_POLYGON, ///< vector3 array:"triangles" , or Dictionary with "indices" (int array) and "triangles" (Vector3 array)
+		SHAPE_CONCAVE_POLYGON, ///< vector3 array:"triangles" , or Dictionary with "faces" (Vector3 array) and optionally "bvh" (raw array returned by shape_get_data)
 		SHAPE_HEIGHTMAP, ///< dict( int:"width", int:"depth",float:"cell_size", float_array:"heights"
 		SHAPE_CUSTOM, ///< Server-Implementation based custom shape, calling shape_create() with this value will result in an error
 	};
@@ -1655,6 +1655,11 @@ void EditorImportExport::load_config() {
 
 			script_key = cf->get_value("script","encrypt_key");
 		}
+
+		if (cf->has_section_key("script","precompile")) {
+
+			script_precompile = cf->get_value("script","precompile");
+		}
 	}
 
 }
@@ -1765,6 +1770,7 @@ void EditorImportExport::save_config() {
 	}
 
 	cf->set_value("script","encrypt_key",script_key);
+	cf->set_value("script","precompile",script_precompile);
 
 	cf->save("res://export.cfg");
 
@@ -1790,6 +1796,16 @@ String EditorImportExport::script_get_encryption_key() const{
 	return script_key;
 }
 
+void EditorImportExport::script_set_precompile(bool p_enable) {
+
+	script_precompile=p_enable;
+}
+
+bool EditorImportExport::script_get_precompile() const{
+
+	return script_precompile;
+}
+
 
 void EditorImportExport::_bind_methods() {
 
@@ -1806,6 +1822,8 @@ void EditorImportExport::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("script_set_encryption_key"),&EditorImportExport::script_set_encryption_key);
 	ObjectTypeDB::bind_method(_MD("script_get_action"),&EditorImportExport::script_get_action);
 	ObjectTypeDB::bind_method(_MD("script_get_encryption_key"),&EditorImportExport::script_get_encryption_key);
+	ObjectTypeDB::bind_method(_MD("script_set_precompile","enable"),&EditorImportExport::script_set_precompile);
+	ObjectTypeDB::bind_method(_MD("script_get_precompile"),&EditorImportExport::script_get_precompile);
 
 }
 
@@ -1819,6 +1837,7 @@ EditorImportExport::EditorImportExport() {
 	image_shrink=1;
 
 	script_action=SCRIPT_ACTION_COMPILE;
+	script_precompile=false;
 
 }
 
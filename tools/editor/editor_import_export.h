@@ -263,6 +263,7 @@ protected:
 
 	ScriptAction script_action;
 	String script_key;
+	bool script_precompile;
 
 	static EditorImportExport* singleton;
 
@@ -333,6 +334,9 @@ public:
 	void script_set_encryption_key(const String& p_key);
 	String script_get_encryption_key() const;
 
+	void script_set_precompile(bool p_enable);
+	bool script_get_precompile() const;
+
 	void load_config();
 	void save_config();
 
@@ -242,6 +242,8 @@ void ProjectExportDialog::_script_edited(Variant v) {
 	EditorNode::get_undo_redo()->add_undo_method(EditorImportExport::get_singleton(),"script_set_action",EditorImportExport::get_singleton()->script_get_action());
 	EditorNode::get_undo_redo()->add_do_method(EditorImportExport::get_singleton(),"script_set_encryption_key",script_key->get_text());
 	EditorNode::get_undo_redo()->add_undo_method(EditorImportExport::get_singleton(),"script_set_encryption_key",EditorImportExport::get_singleton()->script_get_encryption_key());
+	EditorNode::get_undo_redo()->add_do_method(EditorImportExport::get_singleton(),"script_set_precompile",script_precompile->is_pressed());
+	EditorNode::get_undo_redo()->add_undo_method(EditorImportExport::get_singleton(),"script_set_precompile",EditorImportExport::get_singleton()->script_get_precompile());
 	EditorNode::get_undo_redo()->add_do_method(this,"_update_script");
 	EditorNode::get_undo_redo()->add_undo_method(this,"_update_script");
 	EditorNode::get_undo_redo()->add_do_method(this,"_save_export_cfg");
@@ -306,6 +308,7 @@ void ProjectExportDialog::_notification(int p_what) {
 
 			script_mode->connect("item_selected",this,"_script_edited");
 			script_key->connect("text_changed",this,"_script_edited");
+			script_precompile->connect("toggled",this,"_script_edited");
 
 			for(int i=0;i<formats.size();i++) {
 				if (EditorImportExport::get_singleton()->get_image_formats().has(formats[i]->get_text(0)))
@@ -1004,6 +1007,7 @@ void ProjectExportDialog::_update_script() {
 	updating_script=true;
 	script_mode->select(EditorImportExport::get_singleton()->script_get_action());
 	script_key->set_text(EditorImportExport::get_singleton()->script_get_encryption_key());
+	script_precompile->set_pressed(EditorImportExport::get_singleton()->script_get_precompile());
 	updating_script=false;
 
 }
@@ -1325,6 +1329,9 @@ ProjectExportDialog::ProjectExportDialog(EditorNode *p_editor) {
 	script_mode->add_item("Encrypted (Provide Key Below)");
 	script_key = memnew( LineEdit );
 	script_vbox->add_margin_child("Script Encryption Key (256-bits as hex):",script_key);
+	script_precompile = memnew( CheckButton );
+	script_precompile->set_text("Store Compiled Code (Faster Startup)");
+	script_vbox->add_child(script_precompile);
 
 
 
@@ -138,6 +138,7 @@ private:
 	VBoxContainer *script_vbox;
 	OptionButton *script_mode;
 	LineEdit *script_key;
+	CheckButton *script_precompile;
 
 
 
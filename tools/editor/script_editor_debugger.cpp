@@ -146,6 +146,27 @@ void ScriptEditorDebugger::debug_break() {
 
 }
 
+void ScriptEditorDebugger::profiling_start(bool p_sample_stacks) {
+
+	ERR_FAIL_COND(connection.is_null());
+	ERR_FAIL_COND(!connection->is_connected());
+
+	Array msg;
+	msg.push_back("start_profiling");
+	msg.push_back(p_sample_stacks);
+	ppeer->put_var(msg);
+}
+
+void ScriptEditorDebugger::profiling_stop() {
+
+	ERR_FAIL_COND(connection.is_null());
+	ERR_FAIL_COND(!connection->is_connected());
+
+	Array msg;
+	msg.push_back("stop_profiling");
+	ppeer->put_var(msg);
+}
+
 void ScriptEditorDebugger::debug_continue() {
 
 	ERR_FAIL_COND(!breaked);
@@ -344,6 +365,15 @@ void ScriptEditorDebugger::_parse_message(const String& p_msg,const Array& p_dat
 		perf_history.push_front(p);
 		perf_draw->update();
 
+	} else if (p_msg=="profile_frame") {
+
+		//frame number, flattened functions (signature, calls, total usec, self usec) and sampled stacks (stack, count)
+		emit_signal("profile_frame",p_data[0],p_data[1],p_data[2]);
+
+	} else if (p_msg=="profile_total") {
+
+		emit_signal("profile_total",p_data[0]);
+
 	} else if (p_msg=="error") {
 
 		Array err = p_data[0];
@@ -1131,6 +1161,8 @@ void ScriptEditorDebugger::_bind_methods() {
 	ObjectTypeDB::bind_method(_MD("debug_step"),&ScriptEditorDebugger::debug_step);
 	ObjectTypeDB::bind_method(_MD("debug_break"),&ScriptEditorDebugger::debug_break);
 	ObjectTypeDB::bind_method(_MD("debug_continue"),&ScriptEditorDebugger::debug_continue);
+	ObjectTypeDB::bind_method(_MD("profiling_start","sample_stacks"),&ScriptEditorDebugger::profiling_start,DEFVAL(false));
+	ObjectTypeDB::bind_method(_MD("profiling_stop"),&ScriptEditorDebugger::profiling_stop);
 	ObjectTypeDB::bind_method(_MD("_output_clear"),&ScriptEditorDebugger::_output_clear);
 	ObjectTypeDB::bind_method(_MD("_hide_request"),&ScriptEditorDebugger::_hide_request);
 	ObjectTypeDB::bind_method(_MD("_performance_draw"),&ScriptEditorDebugger::_performance_draw);
@@ -1153,6 +1185,8 @@ void ScriptEditorDebugger::_bind_methods() {
 	ADD_SIGNAL(MethodInfo("goto_script_line"));
 	ADD_SIGNAL(MethodInfo("breaked",PropertyInfo(Variant::BOOL,"reallydid")));
 	ADD_SIGNAL(MethodInfo("show_debugger",PropertyInfo(Variant::BOOL,"reallydid")));
+	ADD_SIGNAL(MethodInfo("profile_frame",PropertyInfo(Variant::INT,"frame"),PropertyInfo(Variant::ARRAY,"functions"),PropertyInfo(Variant::ARRAY,"samples")));
+	ADD_SIGNAL(MethodInfo("profile_total",PropertyInfo(Variant::ARRAY,"functions")));
 }
 
 ScriptEditorDebugger::ScriptEditorDebugger(EditorNode *p_editor){
@@ -161,6 +161,9 @@ public:
 	void debug_break();
 	void debug_continue();
 
+	void profiling_start(bool p_sample_stacks=false);
+	void profiling_stop();
+
 	String get_var_value(const String& p_var) const;
 
 	void set_live_debugging(bool p_enable);